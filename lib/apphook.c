@@ -41,6 +41,7 @@
 #include "crypto.h"
 #include "value-pairs/value-pairs.h"
 #include "scratch-buffers.h"
+#include "transport/transport-tls.h"
 #include "mainloop.h"
 #include "secret-storage/nondumpable-allocator.h"
 #include "secret-storage/secret-storage.h"
@@ -239,6 +240,7 @@ app_startup(void)
   nondumpable_setlogger(nondumpable_allocator_msg_debug, nondumpable_allocator_msg_fatal);
   secret_storage_init();
   scratch_buffers_global_init();
+  log_transport_tls_global_init();
   msg_stats_init();
   timeutils_global_init();
   multi_line_global_init();
@@ -276,6 +278,7 @@ app_shutdown(void)
   secret_storage_deinit();
   scratch_buffers_allocator_deinit();
   scratch_buffers_global_deinit();
+  log_transport_tls_global_deinit();
   value_pairs_global_deinit();
   log_template_global_deinit();
   log_msg_global_deinit();
@@ -267,6 +267,8 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_SYSLOG_STATS                10405
 %token KW_HEALTHCHECK_FREQ            10406
 %token KW_WORKER_PARTITION_KEY        10407
+%token KW_PROMETHEUS_ADDRESS          10408
+%token KW_PROMETHEUS_PORT             10409
 
 %token KW_CHAIN_HOSTNAMES             10090
 %token KW_NORMALIZE_HOSTNAMES         10091
@@ -307,6 +309,9 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 
 %token KW_THROTTLE                    10170
 %token KW_THREADED                    10171
+%token KW_DEDICATED_THREAD            10172
+%token KW_CPU_AFFINITY                10173
+%token KW_NUMA_NODE                   10174
 
 %token KW_PASS_UNIX_CREDENTIALS       10180
 %token KW_PERSIST_NAME                10181
@@ -1164,6 +1169,17 @@ stats_group_option
 	| KW_MAX_DYNAMIC '(' nonnegative_integer ')'   { last_stats_options->max_dynamic = $3; }
 	| KW_SYSLOG_STATS '(' yesnoauto ')'     { last_stats_options->syslog_stats = $3; }
 	| KW_HEALTHCHECK_FREQ '(' nonnegative_integer ')' { last_healthcheck_options->freq = $3; }
+	| KW_PROMETHEUS_ADDRESS '(' string ')'
+	  {
+	    g_free(last_stats_options->prometheus_address);
+	    last_stats_options->prometheus_address = g_strdup($3);
+	    free($3);
+	  }
+	| KW_PROMETHEUS_PORT '(' nonnegative_integer ')'
+	  {
+	    CHECK_ERROR($3 <= 65535, @3, "Invalid prometheus-port(), it must be between 0 and 65535");
+	    last_stats_options->prometheus_port = $3;
+	  }
 	;
 
 dns_cache_option
@@ -1490,6 +1506,14 @@ source_reader_option
   | KW_CHECK_PROGRAM '(' yesno ')' { last_reader_options->check_program = $3; }
 	| KW_FLAGS '(' source_reader_option_flags ')'
 	| KW_LOG_FETCH_LIMIT '(' positive_integer ')'	{ last_reader_options->fetch_limit = $3; }
+	| KW_DEDICATED_THREAD '(' yesno ')'	{ last_reader_options->dedicated_thread.enabled = $3; }
+	| KW_CPU_AFFINITY '(' string ')'
+	  {
+	    CHECK_ERROR(log_reader_options_set_cpu_affinity(last_reader_options, $3), @3,
+	                "Invalid cpu-affinity() value \"%s\", expecting a CPU list like \"0-3,8\"", $3);
+	    free($3);
+	  }
+	| KW_NUMA_NODE '(' nonnegative_integer ')'	{ last_reader_options->dedicated_thread.numa_node = $3; }
         | KW_FORMAT '(' string ')'              { last_reader_options->parse_options.format = g_strdup($3); free($3); }
         | { last_source_options = &last_reader_options->super; } source_option
         | { last_proto_server_options = &last_reader_options->proto_options.super; } source_proto_option
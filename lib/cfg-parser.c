@@ -105,6 +105,8 @@ static CfgLexerKeyword main_keywords[] =
   { "max_dynamics",       KW_MAX_DYNAMIC },
   { "syslog_stats",       KW_SYSLOG_STATS },
   { "healthcheck_freq",   KW_HEALTHCHECK_FREQ},
+  { "prometheus_address", KW_PROMETHEUS_ADDRESS },
+  { "prometheus_port",    KW_PROMETHEUS_PORT },
   { "min_iw_size_per_reader", KW_MIN_IW_SIZE_PER_READER },
   { "flush_lines",        KW_FLUSH_LINES },
   { "flush_timeout",      KW_FLUSH_TIMEOUT, KWS_OBSOLETE, "Some drivers support batch-timeout() instead that you can specify at the destination level." },
@@ -142,6 +144,9 @@ static CfgLexerKeyword main_keywords[] =
   { "default_facility",   KW_DEFAULT_FACILITY },
   { "sdata_prefix",       KW_SDATA_PREFIX },
   { "threaded",           KW_THREADED },
+  { "dedicated_thread",   KW_DEDICATED_THREAD },
+  { "cpu_affinity",       KW_CPU_AFFINITY },
+  { "numa_node",          KW_NUMA_NODE },
   { "use_rcptid",         KW_USE_RCPTID, KWS_OBSOLETE, "This has been deprecated, try use_uniqid() instead" },
   { "use_uniqid",         KW_USE_UNIQID },
   { "log_level",          KW_LOG_LEVEL },
@@ -698,6 +698,7 @@ cfg_free(GlobalConfig *self)
   g_free(self->recv_time_zone);
   g_free(self->bad_hostname_re);
   dns_cache_options_destroy(&self->dns_cache_options);
+  stats_options_destroy(&self->stats_options);
   g_free(self->custom_domain);
   plugin_context_deinit_instance(&self->plugin_context);
   cfg_tree_free_instance(&self->tree);
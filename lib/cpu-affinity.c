@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "cpu-affinity.h"
+#include "messages.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define NUMA_NODE_CPULIST_FORMAT "/sys/devices/system/node/node%d/cpulist"
+#define CPU_AFFINITY_MAX_CPU 65535
+
+static gint
+_compare_cpus(gconstpointer a, gconstpointer b)
+{
+  return *(const gint *) a - *(const gint *) b;
+}
+
+static gboolean
+_parse_cpu_number(const gchar *str, gint *cpu)
+{
+  gchar *end;
+
+  if (!g_ascii_isdigit(*str))
+    return FALSE;
+
+  gint64 value = g_ascii_strtoll(str, &end, 10);
+  if (*end != '\0' || value > CPU_AFFINITY_MAX_CPU)
+    return FALSE;
+
+  *cpu = (gint) value;
+  return TRUE;
+}
+
+static gboolean
+_append_cpu_range(GArray *cpus, const gchar *range)
+{
+  gchar **bounds = g_strsplit(range, "-", 2);
+  gint first, last;
+  gboolean result = FALSE;
+
+  if (!_parse_cpu_number(g_strstrip(bounds[0]), &first))
+    goto exit;
+
+  last = first;
+  if (bounds[1] && !_parse_cpu_number(g_strstrip(bounds[1]), &last))
+    goto exit;
+
+  if (last < first)
+    goto exit;
+
+  for (gint cpu = first; cpu <= last; cpu++)
+    g_array_append_val(cpus, cpu);
+  result = TRUE;
+
+exit:
+  g_strfreev(bounds);
+  return result;
+}
+
+/* returns NULL if the list cannot be parsed */
+GArray *
+cpu_affinity_parse_cpu_list(const gchar *cpu_list)
+{
+  GArray *cpus = g_array_new(FALSE, FALSE, sizeof(gint));
+  gchar **ranges = g_strsplit(cpu_list, ",", -1);
+
+  for (gint i = 0; ranges[i]; i++)
+    {
+      if (!_append_cpu_range(cpus, ranges[i]))
+        {
+          g_array_free(cpus, TRUE);
+          cpus = NULL;
+          break;
+        }
+    }
+  g_strfreev(ranges);
+
+  if (!cpus)
+    return NULL;
+
+  if (cpus->len == 0)
+    {
+      g_array_free(cpus, TRUE);
+      return NULL;
+    }
+
+  g_array_sort(cpus, _compare_cpus);
+
+  /* drop duplicates, e.g. from overlapping ranges */
+  guint unique = 1;
+  for (guint i = 1; i < cpus->len; i++)
+    {
+      if (g_array_index(cpus, gint, i) != g_array_index(cpus, gint, unique - 1))
+        g_array_index(cpus, gint, unique++) = g_array_index(cpus, gint, i);
+    }
+  g_array_set_size(cpus, unique);
+  return cpus;
+}
+
+/* returns NULL if the node does not exist or its CPU list cannot be read */
+GArray *
+cpu_affinity_get_numa_node_cpus(gint numa_node)
+{
+  gchar *filename = g_strdup_printf(NUMA_NODE_CPULIST_FORMAT, numa_node);
+  gchar *contents = NULL;
+  GArray *cpus = NULL;
+
+  if (g_file_get_contents(filename, &contents, NULL, NULL))
+    cpus = cpu_affinity_parse_cpu_list(g_strstrip(contents));
+
+  g_free(contents);
+  g_free(filename);
+  return cpus;
+}
+
+/* both arrays must be sorted, returns NULL if the intersection is empty */
+GArray *
+cpu_affinity_intersect(GArray *a, GArray *b)
+{
+  GArray *result = g_array_new(FALSE, FALSE, sizeof(gint));
+  guint i = 0, j = 0;
+
+  while (i < a->len && j < b->len)
+    {
+      gint cpu_a = g_array_index(a, gint, i);
+      gint cpu_b = g_array_index(b, gint, j);
+
+      if (cpu_a == cpu_b)
+        {
+          g_array_append_val(result, cpu_a);
+          i++;
+          j++;
+        }
+      else if (cpu_a < cpu_b)
+        i++;
+      else
+        j++;
+    }
+
+  if (result->len == 0)
+    {
+      g_array_free(result, TRUE);
+      return NULL;
+    }
+  return result;
+}
+
+gboolean
+cpu_affinity_pin_current_thread(gint cpu)
+{
+#if defined(__linux__)
+  cpu_set_t cpuset;
+
+  if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+      errno = EINVAL;
+      return FALSE;
+    }
+
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+
+  gint rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+  if (rc != 0)
+    {
+      errno = rc;
+      return FALSE;
+    }
+  return TRUE;
+#else
+  errno = ENOSYS;
+  return FALSE;
+#endif
+}
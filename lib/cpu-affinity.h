@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef CPU_AFFINITY_H_INCLUDED
+#define CPU_AFFINITY_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * CPU sets are represented as sorted GArrays of gint CPU numbers, parsed
+ * from the usual Linux CPU list notation (e.g. "0-3,8,10-11").
+ */
+
+GArray *cpu_affinity_parse_cpu_list(const gchar *cpu_list);
+GArray *cpu_affinity_get_numa_node_cpus(gint numa_node);
+GArray *cpu_affinity_intersect(GArray *a, GArray *b);
+gboolean cpu_affinity_pin_current_thread(gint cpu);
+
+#endif
@@ -180,10 +180,10 @@ _log_src_driver_register_counters(LogSrcDriver *self)
   stats_lock();
   StatsClusterKey sc_key;
   stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_SOURCE | SCS_GROUP, self->super.group, NULL );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED,
-                         &self->super.processed_group_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED,
+                                 &self->super.processed_group_messages);
   stats_cluster_logpipe_key_legacy_set(&sc_key,  SCS_CENTER, NULL, "received" );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->received_global_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->received_global_messages);
   stats_unlock();
 }
 
@@ -348,10 +348,10 @@ _log_dest_driver_register_counters(LogDestDriver *self)
   stats_lock();
   StatsClusterKey sc_key;
   stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_DESTINATION | SCS_GROUP, self->super.group, NULL );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED,
-                         &self->super.processed_group_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED,
+                                 &self->super.processed_group_messages);
   stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_CENTER, NULL, "queued" );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->queued_global_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->queued_global_messages);
   stats_unlock();
 }
 
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "latency-sampler.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-histogram.h"
+#include "timeutils/unixtime.h"
+#include "atomic-gssize.h"
+
+/* samples waiting for their acknowledgement, newer ones are not taken
+ * while a destination does not acknowledge anything */
+#define LATENCY_SAMPLER_MAX_PENDING 64
+
+typedef struct _LatencyHistograms
+{
+  StatsClusterKey *queue_latency_key;
+  StatsClusterKey *e2e_latency_key;
+  StatsCounterItem *queue_latency;
+  StatsCounterItem *e2e_latency;
+} LatencyHistograms;
+
+typedef struct _LatencySample
+{
+  gssize position;
+  UnixTime recvd;
+  LatencyHistograms *histograms;
+} LatencySample;
+
+struct _LatencySampler
+{
+  gint stats_level;
+  StatsClusterKeyBuilder *kb;
+
+  /* positions in the backlog, counting from the start of the sampler */
+  atomic_gssize popped;
+  atomic_gssize acked;
+  /* the position of the oldest pending sample, acked() only takes the lock once it is reached */
+  atomic_gssize next_due;
+  gint64 last_sampled_sec;
+
+  GMutex lock;
+  GQueue pending;
+  GHashTable *histograms;
+};
+
+static LatencyHistograms *
+_register_histograms(LatencySampler *self, const gchar *source)
+{
+  LatencyHistograms *histograms = g_new0(LatencyHistograms, 1);
+
+  stats_cluster_key_builder_push(self->kb);
+  {
+    stats_cluster_key_builder_add_label(self->kb, stats_cluster_label("source", source));
+    stats_cluster_key_builder_set_unit(self->kb, SCU_MILLISECONDS);
+
+    stats_cluster_key_builder_set_name(self->kb, "output_event_queue_latency_seconds");
+    histograms->queue_latency_key = stats_cluster_key_builder_build_histogram(self->kb);
+
+    stats_cluster_key_builder_set_name(self->kb, "output_event_e2e_latency_seconds");
+    histograms->e2e_latency_key = stats_cluster_key_builder_build_histogram(self->kb);
+  }
+  stats_cluster_key_builder_pop(self->kb);
+
+  stats_lock();
+  stats_register_histogram(self->stats_level, histograms->queue_latency_key, &histograms->queue_latency);
+  stats_register_histogram(self->stats_level, histograms->e2e_latency_key, &histograms->e2e_latency);
+  stats_unlock();
+
+  return histograms;
+}
+
+static void
+_unregister_histograms(LatencyHistograms *histograms)
+{
+  stats_lock();
+  stats_unregister_histogram(histograms->queue_latency_key, &histograms->queue_latency);
+  stats_unregister_histogram(histograms->e2e_latency_key, &histograms->e2e_latency);
+  stats_unlock();
+
+  stats_cluster_key_free(histograms->queue_latency_key);
+  stats_cluster_key_free(histograms->e2e_latency_key);
+  g_free(histograms);
+}
+
+static LatencyHistograms *
+_lookup_histograms(LatencySampler *self, LogMessage *msg)
+{
+  gssize source_len;
+  const gchar *source_value = log_msg_get_value(msg, LM_V_SOURCE, &source_len);
+  gchar *source = g_strndup(source_value, source_len);
+
+  LatencyHistograms *histograms = g_hash_table_lookup(self->histograms, source);
+  if (histograms)
+    {
+      g_free(source);
+      return histograms;
+    }
+
+  histograms = _register_histograms(self, source);
+  g_hash_table_insert(self->histograms, source, histograms);
+  return histograms;
+}
+
+static inline gsize
+_elapsed_msec(const UnixTime *now, const UnixTime *recvd)
+{
+  return MAX(unix_time_diff_in_msec(now, recvd), 0);
+}
+
+/* must be called with self->lock held */
+static void
+_update_next_due(LatencySampler *self)
+{
+  LatencySample *oldest = g_queue_peek_head(&self->pending);
+
+  atomic_gssize_set(&self->next_due, oldest ? oldest->position : G_MAXSSIZE);
+}
+
+/* must be called with self->lock held */
+static void
+_drop_samples_after(LatencySampler *self, gssize position)
+{
+  LatencySample *sample;
+
+  while ((sample = g_queue_peek_tail(&self->pending)) && sample->position > position)
+    g_free(g_queue_pop_tail(&self->pending));
+
+  _update_next_due(self);
+}
+
+void
+latency_sampler_popped(LatencySampler *self, LogMessage *msg)
+{
+  if (!self)
+    return;
+
+  gssize position = atomic_gssize_inc(&self->popped) + 1;
+  const UnixTime *recvd = &msg->timestamps[LM_TS_RECVD];
+
+  if (recvd->ut_sec == self->last_sampled_sec)
+    return;
+  self->last_sampled_sec = recvd->ut_sec;
+
+  g_mutex_lock(&self->lock);
+  if (self->pending.length < LATENCY_SAMPLER_MAX_PENDING)
+    {
+      LatencySample *sample = g_new(LatencySample, 1);
+      sample->position = position;
+      sample->recvd = *recvd;
+      sample->histograms = _lookup_histograms(self, msg);
+
+      UnixTime now;
+      unix_time_set_now(&now);
+      stats_histogram_observe(sample->histograms->queue_latency, _elapsed_msec(&now, recvd));
+
+      g_queue_push_tail(&self->pending, sample);
+      _update_next_due(self);
+    }
+  g_mutex_unlock(&self->lock);
+}
+
+static void
+_advance_acked(LatencySampler *self, gint n, gboolean delivered)
+{
+  if (!self)
+    return;
+
+  gssize acked = atomic_gssize_add(&self->acked, n) + n;
+  if (acked < atomic_gssize_get(&self->next_due))
+    return;
+
+  UnixTime now;
+  unix_time_set_now(&now);
+
+  g_mutex_lock(&self->lock);
+  LatencySample *sample;
+  while ((sample = g_queue_peek_head(&self->pending)) && sample->position <= acked)
+    {
+      g_queue_pop_head(&self->pending);
+      if (delivered)
+        stats_histogram_observe(sample->histograms->e2e_latency, _elapsed_msec(&now, &sample->recvd));
+      g_free(sample);
+    }
+  _update_next_due(self);
+  g_mutex_unlock(&self->lock);
+}
+
+void
+latency_sampler_acked(LatencySampler *self, gint n)
+{
+  _advance_acked(self, n, TRUE);
+}
+
+/* the messages left the queue without being delivered, e.g. they were dropped */
+void
+latency_sampler_skipped(LatencySampler *self, gint n)
+{
+  _advance_acked(self, n, FALSE);
+}
+
+/* the last @n popped messages are put back to the queue, they are sampled again when popped */
+void
+latency_sampler_rewound(LatencySampler *self, gint n)
+{
+  if (!self)
+    return;
+
+  gssize popped = atomic_gssize_sub(&self->popped, n) - n;
+  self->last_sampled_sec = -1;
+
+  g_mutex_lock(&self->lock);
+  _drop_samples_after(self, popped);
+  g_mutex_unlock(&self->lock);
+}
+
+void
+latency_sampler_rewound_all(LatencySampler *self)
+{
+  if (!self)
+    return;
+
+  gssize popped = atomic_gssize_get(&self->acked);
+  atomic_gssize_set(&self->popped, popped);
+  self->last_sampled_sec = -1;
+
+  g_mutex_lock(&self->lock);
+  _drop_samples_after(self, popped);
+  g_mutex_unlock(&self->lock);
+}
+
+/* takes over the ownership of @kb, which should describe the destination */
+LatencySampler *
+latency_sampler_new(gint stats_level, StatsClusterKeyBuilder *kb)
+{
+  if (!stats_check_level(stats_level))
+    {
+      stats_cluster_key_builder_free(kb);
+      return NULL;
+    }
+
+  LatencySampler *self = g_new0(LatencySampler, 1);
+
+  self->stats_level = stats_level;
+  self->kb = kb;
+  self->last_sampled_sec = -1;
+  atomic_gssize_set(&self->next_due, G_MAXSSIZE);
+
+  g_mutex_init(&self->lock);
+  g_queue_init(&self->pending);
+  self->histograms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) _unregister_histograms);
+
+  return self;
+}
+
+void
+latency_sampler_free(LatencySampler *self)
+{
+  if (!self)
+    return;
+
+  g_queue_foreach(&self->pending, (GFunc) g_free, NULL);
+  g_queue_clear(&self->pending);
+  g_hash_table_destroy(self->histograms);
+  g_mutex_clear(&self->lock);
+  stats_cluster_key_builder_free(self->kb);
+  g_free(self);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LATENCY_SAMPLER_H_INCLUDED
+#define LATENCY_SAMPLER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "logmsg/logmsg.h"
+#include "stats/stats-cluster-key-builder.h"
+
+/*
+ * LatencySampler measures how long messages spend in the pipeline, on the
+ * consumer side of a destination queue.
+ *
+ * At most one message per second of receive time is sampled when it is
+ * popped from the queue, its position in the backlog is remembered, and
+ * once the backlog is acknowledged up to that position the time since
+ * LM_TS_RECVD is recorded.  Two histograms are maintained for each source
+ * group sending to the destination:
+ *
+ *   - output_event_queue_latency_seconds: from receive to leaving the
+ *     destination queue,
+ *   - output_event_e2e_latency_seconds: from receive to the acknowledgement
+ *     of the destination.
+ *
+ * popped() and rewound() have to be called by the thread consuming the
+ * queue, acked() and skipped() are safe to be called from any thread.  All
+ * functions accept a NULL sampler, which is what latency_sampler_new()
+ * returns if the stats level is too low.
+ */
+typedef struct _LatencySampler LatencySampler;
+
+LatencySampler *latency_sampler_new(gint stats_level, StatsClusterKeyBuilder *kb);
+void latency_sampler_free(LatencySampler *self);
+
+void latency_sampler_popped(LatencySampler *self, LogMessage *msg);
+void latency_sampler_acked(LatencySampler *self, gint n);
+void latency_sampler_skipped(LatencySampler *self, gint n);
+void latency_sampler_rewound(LatencySampler *self, gint n);
+void latency_sampler_rewound_all(LatencySampler *self);
+
+#endif
@@ -277,8 +277,16 @@ static StatsCounterItem *count_msg_clones;
 static StatsCounterItem *count_payload_reallocs;
 static StatsCounterItem *count_sdata_updates;
 static StatsCounterItem *count_allocated_bytes;
+static StatsCounterItem *count_referenced_bytes;
 static GPrivate priv_macro_value = G_PRIVATE_INIT(__free_macro_value);
 
+/* registered once by plugins and never removed, lookups run in parallel
+ * with registration, so the count is only incremented after the slot is
+ * filled in */
+#define LOG_MSG_MAX_LAZY_VALUES 8
+static LogMessageLazyValues *lazy_values[LOG_MSG_MAX_LAZY_VALUES];
+static gint num_lazy_values;
+
 void
 log_msg_write_protect(LogMessage *self)
 {
@@ -475,6 +483,52 @@ log_msg_get_macro_value(const LogMessage *self, gint id, gssize *value_len, LogM
   return value->str;
 }
 
+void
+log_msg_register_lazy_values(LogMessageLazyValues *lv)
+{
+  gint index_ = g_atomic_int_get(&num_lazy_values);
+
+  g_assert(index_ < LOG_MSG_MAX_LAZY_VALUES);
+  lazy_values[index_] = lv;
+  g_atomic_int_set(&num_lazy_values, index_ + 1);
+}
+
+NVHandle
+log_msg_get_lazy_storage_handle(const gchar *storage_name)
+{
+  NVHandle handle = log_msg_get_value_handle(storage_name);
+
+  nv_registry_set_handle_flags(logmsg_registry, handle, LM_VF_LAZY_STORAGE);
+  return handle;
+}
+
+const gchar *
+log_msg_get_lazy_value(const LogMessage *self, NVHandle handle, gssize *value_len, LogMessageValueType *type)
+{
+  ScratchBuffersMarker marker;
+  LogMessageValueType lazy_type = LM_VT_STRING;
+  gint n = g_atomic_int_get(&num_lazy_values);
+
+  /* explicitly unset in the payload */
+  if (nv_table_is_value_set(self->payload, handle))
+    return NULL;
+
+  GString *value = scratch_buffers_alloc_and_mark(&marker);
+  for (gint i = 0; i < n; i++)
+    {
+      if (lazy_values[i]->get_value(lazy_values[i], self, handle, value, &lazy_type))
+        {
+          if (value_len)
+            *value_len = value->len;
+          if (type)
+            *type = lazy_type;
+          return value->str;
+        }
+    }
+  scratch_buffers_reclaim_marked(marker);
+  return NULL;
+}
+
 static void
 log_msg_init_queue_node(LogMessage *msg, LogMessageQueueNode *node, const LogPathOptions *path_options)
 {
@@ -749,6 +803,7 @@ log_msg_set_value_indirect_with_type(LogMessage *self, NVHandle handle,
         }
       stats_counter_inc(count_payload_reallocs);
     }
+  stats_counter_add(count_referenced_bytes, len);
 
   if (new_entry)
     log_msg_update_sdata(self, handle, name, name_len);
@@ -762,10 +817,125 @@ log_msg_set_value_indirect(LogMessage *self, NVHandle handle, NVHandle ref_handl
   log_msg_set_value_indirect_with_type(self, handle, ref_handle, ofs, len, LM_VT_STRING);
 }
 
+void
+log_msg_value_source_init(LogMessageValueSource *source, const LogMessage *msg, NVHandle handle,
+                          const gchar *value, gsize value_len)
+{
+  source->handle = LM_V_NONE;
+  source->value = value;
+  source->value_len = value_len;
+
+  if (!log_msg_is_handle_referencable_from_an_indirect_value(handle))
+    return;
+
+  gssize current_value_len;
+  const gchar *current_value = log_msg_get_value_if_set(msg, handle, &current_value_len);
+
+  /* the input was formatted from a template or has been changed since, a
+   * part of the current value (e.g. with a prefix removed) is fine though */
+  if (!current_value || value < current_value || value + value_len > current_value + current_value_len)
+    return;
+
+  source->handle = handle;
+  source->value = current_value;
+  source->value_len = current_value_len;
+}
+
+static inline gboolean
+_value_source_can_reference(LogMessageValueSource *source, NVHandle handle, const gchar *value, gsize value_len)
+{
+  if (source->handle == LM_V_NONE || handle == source->handle)
+    return FALSE;
+
+  if (value_len == 0 || !log_msg_is_handle_settable_with_an_indirect_value(handle))
+    return FALSE;
+
+  if (value < source->value || value + value_len > source->value + source->value_len)
+    return FALSE;
+
+  /* NVReferencedSlice is wider, but the LogMessage API takes 16 bit offsets */
+  gsize ofs = value - source->value;
+  return ofs <= G_MAXUINT16 && value_len <= G_MAXUINT16;
+}
+
+void
+log_msg_set_value_from_source_with_type(LogMessage *self, NVHandle handle, LogMessageValueSource *source,
+                                        const gchar *value, gssize value_len, LogMessageValueType type)
+{
+  if (value_len < 0)
+    value_len = strlen(value);
+
+  if (_value_source_can_reference(source, handle, value, value_len))
+    {
+      log_msg_set_value_indirect_with_type(self, handle, source->handle, value - source->value, value_len, type);
+      return;
+    }
+
+  log_msg_set_value_with_type(self, handle, value, value_len, type);
+
+  /* the referenced value has just been overwritten, the rest of the input
+   * is not a slice of it anymore */
+  if (handle == source->handle)
+    source->handle = LM_V_NONE;
+}
+
+void
+log_msg_set_value_from_source(LogMessage *self, NVHandle handle, LogMessageValueSource *source,
+                              const gchar *value, gssize value_len)
+{
+  log_msg_set_value_from_source_with_type(self, handle, source, value, value_len, LM_VT_STRING);
+}
+
+typedef struct _LogMessageValuesForeachState
+{
+  const LogMessage *msg;
+  NVTableForeachFunc func;
+  gpointer user_data;
+} LogMessageValuesForeachState;
+
+static gboolean
+_foreach_payload_value(NVHandle handle, const gchar *name,
+                       const gchar *value, gssize value_len,
+                       NVType type, gpointer user_data)
+{
+  LogMessageValuesForeachState *state = (LogMessageValuesForeachState *) user_data;
+
+  if (nv_registry_get_handle_flags(logmsg_registry, handle) & LM_VF_LAZY_STORAGE)
+    return FALSE;
+  return state->func(handle, name, value, value_len, type, state->user_data);
+}
+
+static gboolean
+_foreach_lazy_value(NVHandle handle, const gchar *name,
+                    const gchar *value, gssize value_len,
+                    NVType type, gpointer user_data)
+{
+  LogMessageValuesForeachState *state = (LogMessageValuesForeachState *) user_data;
+
+  /* overridden in the payload, already visited */
+  if (nv_table_is_value_set(state->msg->payload, handle))
+    return FALSE;
+  return state->func(handle, name, value, value_len, type, state->user_data);
+}
+
 gboolean
 log_msg_values_foreach(const LogMessage *self, NVTableForeachFunc func, gpointer user_data)
 {
-  return nv_table_foreach(self->payload, logmsg_registry, func, user_data);
+  if (G_LIKELY(!(self->flags & LF_LAZY_VALUES)))
+    return nv_table_foreach(self->payload, logmsg_registry, func, user_data);
+
+  LogMessageValuesForeachState state = { self, func, user_data };
+  gint n = g_atomic_int_get(&num_lazy_values);
+
+  if (nv_table_foreach(self->payload, logmsg_registry, _foreach_payload_value, &state))
+    return TRUE;
+
+  for (gint i = 0; i < n; i++)
+    {
+      if (lazy_values[i]->foreach(lazy_values[i], self, _foreach_lazy_value, &state))
+        return TRUE;
+    }
+  return FALSE;
 }
 
 NVHandle
@@ -2090,6 +2260,9 @@ log_msg_register_stats(void)
   stats_cluster_single_key_set(&sc_key, "events_allocated_bytes", NULL, 0);
   stats_cluster_single_key_add_legacy_alias(&sc_key, SCS_GLOBAL, "msg_allocated_bytes", NULL);
   stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &count_allocated_bytes);
+
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, "payload_referenced_bytes", NULL );
+  stats_register_counter(1, &sc_key, SC_TYPE_PROCESSED, &count_referenced_bytes);
   stats_unlock();
 }
 
@@ -145,6 +145,8 @@ enum
   LM_VF_SDATA = 0x0001,
   LM_VF_MATCH = 0x0002,
   LM_VF_MACRO = 0x0004,
+  /* internal storage of lazy values, see LogMessageLazyValues */
+  LM_VF_LAZY_STORAGE = 0x0008,
 };
 
 enum
@@ -188,6 +190,10 @@ enum
    * The flag remains here for documentation, and also because it is serialized in disk-buffers
    */
   __UNUSED_LF_LEGACY_MSGHDR    = 0x00020000,
+
+  /* some of the name-value pairs are only decoded when looked up, see
+   * LogMessageLazyValues */
+  LF_LAZY_VALUES       = 0x00040000,
 };
 
 typedef NVType LogMessageValueType;
@@ -397,6 +403,8 @@ log_msg_is_handle_settable_with_an_indirect_value(NVHandle handle)
 }
 
 const gchar *log_msg_get_macro_value(const LogMessage *self, gint id, gssize *value_len, LogMessageValueType *type);
+const gchar *log_msg_get_lazy_value(const LogMessage *self, NVHandle handle, gssize *value_len,
+                                    LogMessageValueType *type);
 const gchar *log_msg_get_match_with_type(const LogMessage *self, gint index_,
                                          gssize *value_len, LogMessageValueType *type);
 const gchar *log_msg_get_match_if_set_with_type(const LogMessage *self, gint index_,
@@ -410,18 +418,26 @@ log_msg_get_value_if_set_with_type(const LogMessage *self, NVHandle handle,
                                    LogMessageValueType *type)
 {
   guint16 flags;
+  const gchar *value;
 
   flags = nv_registry_get_handle_flags(logmsg_registry, handle);
   if (G_UNLIKELY((flags & LM_VF_MACRO)))
     return log_msg_get_macro_value(self, flags >> 8, value_len, type);
-  else
-    return nv_table_get_value(self->payload, handle, value_len, type);
+
+  value = nv_table_get_value(self->payload, handle, value_len, type);
+  if (G_UNLIKELY(!value && (self->flags & LF_LAZY_VALUES)))
+    return log_msg_get_lazy_value(self, handle, value_len, type);
+  return value;
 }
 
 static inline gboolean
 log_msg_is_value_set(const LogMessage *self, NVHandle handle)
 {
-  return nv_table_is_value_set(self->payload, handle);
+  if (nv_table_is_value_set(self->payload, handle))
+    return TRUE;
+  if (G_UNLIKELY(self->flags & LF_LAZY_VALUES))
+    return log_msg_get_lazy_value(self, handle, NULL, NULL) != NULL;
+  return FALSE;
 }
 
 static inline const gchar *
@@ -484,9 +500,60 @@ void log_msg_set_value_indirect(LogMessage *self, NVHandle handle, NVHandle ref_
                                 guint16 ofs, guint16 len);
 void log_msg_set_value_indirect_with_type(LogMessage *self, NVHandle handle, NVHandle ref_handle,
                                           guint16 ofs, guint16 len, LogMessageValueType type);
+
+/*
+ * Value sources
+ *
+ * Parsers extract substrings of their input and store them as new
+ * name-value pairs.  If the input is the value of a name-value pair (e.g.
+ * $MSG) and an extracted value is a verbatim slice of it (i.e. it needed no
+ * unescaping), the value can be stored as an indirect entry that
+ * references the slice instead of copying it.  log_msg_value_source_init()
+ * checks whether the input is indeed (a part of) the current value of
+ * @handle, if it is not, every value is copied.
+ */
+typedef struct _LogMessageValueSource
+{
+  NVHandle handle;
+  const gchar *value;
+  gsize value_len;
+} LogMessageValueSource;
+
+void log_msg_value_source_init(LogMessageValueSource *source, const LogMessage *msg, NVHandle handle,
+                               const gchar *value, gsize value_len);
+void log_msg_set_value_from_source_with_type(LogMessage *self, NVHandle handle, LogMessageValueSource *source,
+                                             const gchar *value, gssize value_len, LogMessageValueType type);
+void log_msg_set_value_from_source(LogMessage *self, NVHandle handle, LogMessageValueSource *source,
+                                   const gchar *value, gssize value_len);
+
 void log_msg_unset_value(LogMessage *self, NVHandle handle);
 void log_msg_unset_value_by_name(LogMessage *self, const gchar *name);
 gboolean log_msg_values_foreach(const LogMessage *self, NVTableForeachFunc func, gpointer user_data);
+
+/*
+ * Lazy values
+ *
+ * A parser may defer decoding the name-value pairs it extracts until they
+ * are actually looked up.  It keeps whatever it needs in a value of its
+ * own (allocated with log_msg_get_lazy_storage_handle(), these are hidden
+ * from log_msg_values_foreach()) and sets LF_LAZY_VALUES on the message.
+ * Lookups that miss the payload are then resolved by the registered
+ * LogMessageLazyValues instances, decoding the value into a scratch
+ * buffer.  Values set (or unset) in the payload take precedence.
+ */
+typedef struct _LogMessageLazyValues LogMessageLazyValues;
+struct _LogMessageLazyValues
+{
+  /* decode the value of @handle into @value, returns FALSE if @msg has no such value */
+  gboolean (*get_value)(LogMessageLazyValues *self, const LogMessage *msg, NVHandle handle,
+                        GString *value, LogMessageValueType *type);
+  /* call @func for all lazy values of @msg, returns TRUE if @func stopped the iteration */
+  gboolean (*foreach)(LogMessageLazyValues *self, const LogMessage *msg,
+                      NVTableForeachFunc func, gpointer user_data);
+};
+
+void log_msg_register_lazy_values(LogMessageLazyValues *lazy_values);
+NVHandle log_msg_get_lazy_storage_handle(const gchar *storage_name);
 NVHandle log_msg_get_match_handle(gint index_);
 gint log_msg_get_match_index(NVHandle handle);
 void log_msg_set_match(LogMessage *self, gint index, const gchar *value, gssize value_len);
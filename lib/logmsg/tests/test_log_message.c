@@ -946,3 +946,177 @@ Test(log_message, test_cow_unset_value)
   log_msg_unref(orig_msg);
   log_msg_unref(msg);
 }
+
+static NVHandle lazy_storage_handle;
+
+static gboolean
+_test_lazy_get_value(LogMessageLazyValues *s, const LogMessage *msg, NVHandle handle,
+                     GString *value, LogMessageValueType *type)
+{
+  gssize len;
+  const gchar *stored = nv_table_get_value(msg->payload, lazy_storage_handle, &len, NULL);
+
+  if (!stored || handle != log_msg_get_value_handle("lazy"))
+    return FALSE;
+
+  g_string_assign(value, "decoded:");
+  g_string_append_len(value, stored, len);
+  *type = LM_VT_STRING;
+  return TRUE;
+}
+
+static gboolean
+_test_lazy_foreach(LogMessageLazyValues *s, const LogMessage *msg, NVTableForeachFunc func, gpointer user_data)
+{
+  GString *value = g_string_new("");
+  LogMessageValueType type;
+  NVHandle handle = log_msg_get_value_handle("lazy");
+  gboolean result = FALSE;
+
+  if (_test_lazy_get_value(s, msg, handle, value, &type))
+    result = func(handle, "lazy", value->str, value->len, type, user_data);
+  g_string_free(value, TRUE);
+  return result;
+}
+
+static LogMessageLazyValues test_lazy_values =
+{
+  .get_value = _test_lazy_get_value,
+  .foreach = _test_lazy_foreach,
+};
+
+static LogMessage *
+_construct_message_with_lazy_values(void)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  lazy_storage_handle = log_msg_get_lazy_storage_handle("._test_lazy");
+  log_msg_register_lazy_values(&test_lazy_values);
+
+  log_msg_set_value_by_name(msg, "direct", "direct-value", -1);
+  log_msg_set_value_with_type(msg, lazy_storage_handle, "raw", -1, LM_VT_BYTES);
+  msg->flags |= LF_LAZY_VALUES;
+  return msg;
+}
+
+static gboolean
+_append_name_value(NVHandle handle, const gchar *name, const gchar *value, gssize value_len,
+                   LogMessageValueType type, gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  g_string_append_printf(result, "%s=%.*s;", name, (gint) value_len, value);
+  return FALSE;
+}
+
+Test(log_message, test_lazy_values_are_resolved_on_access)
+{
+  LogMessage *msg = _construct_message_with_lazy_values();
+
+  assert_log_message_value_and_type_by_name(msg, "lazy", "decoded:raw", LM_VT_STRING);
+  assert_log_message_value_by_name(msg, "direct", "direct-value");
+  assert_log_message_value_unset_by_name(msg, "nonexistent");
+  cr_assert(log_msg_is_value_set(msg, log_msg_get_value_handle("lazy")));
+
+  log_msg_unref(msg);
+}
+
+Test(log_message, test_lazy_values_are_overridden_by_the_payload)
+{
+  LogMessage *msg = _construct_message_with_lazy_values();
+
+  log_msg_set_value_by_name(msg, "lazy", "set-value", -1);
+  assert_log_message_value_by_name(msg, "lazy", "set-value");
+
+  log_msg_unset_value_by_name(msg, "lazy");
+  assert_log_message_value_unset_by_name(msg, "lazy");
+
+  log_msg_unref(msg);
+}
+
+Test(log_message, test_lazy_values_are_enumerated_without_their_storage)
+{
+  LogMessage *msg = _construct_message_with_lazy_values();
+  GString *result = g_string_new("");
+
+  log_msg_values_foreach(msg, _append_name_value, result);
+  cr_assert_str_eq(result->str, "direct=direct-value;lazy=decoded:raw;");
+
+  log_msg_set_value_by_name(msg, "lazy", "set-value", -1);
+  g_string_truncate(result, 0);
+  log_msg_values_foreach(msg, _append_name_value, result);
+  cr_assert_str_eq(result->str, "direct=direct-value;lazy=set-value;");
+
+  g_string_free(result, TRUE);
+  log_msg_unref(msg);
+}
+
+static gboolean
+_is_value_indirect(LogMessage *msg, const gchar *name)
+{
+  NVEntry *entry = nv_table_get_entry(msg->payload, log_msg_get_value_handle(name), NULL, NULL);
+
+  cr_assert(entry != NULL, "value is not set: %s", name);
+  return entry->indirect;
+}
+
+Test(log_message, test_values_from_source_reference_the_source_value)
+{
+  LogMessage *msg = log_msg_new_empty();
+  LogMessageValueSource source;
+  gssize input_len;
+
+  log_msg_set_value(msg, LM_V_MESSAGE, "foo=bar baz=bat", -1);
+  const gchar *input = log_msg_get_value(msg, LM_V_MESSAGE, &input_len);
+
+  log_msg_value_source_init(&source, msg, LM_V_MESSAGE, input, input_len);
+  log_msg_set_value_from_source(msg, log_msg_get_value_handle("foo"), &source, input + 4, 3);
+  log_msg_set_value_from_source(msg, log_msg_get_value_handle("baz"), &source, "bat", 3);
+
+  assert_log_message_value_by_name(msg, "foo", "bar");
+  cr_assert(_is_value_indirect(msg, "foo"));
+  assert_log_message_value_by_name(msg, "baz", "bat");
+  cr_assert_not(_is_value_indirect(msg, "baz"));
+
+  log_msg_unref(msg);
+}
+
+Test(log_message, test_values_from_source_are_copied_if_the_input_is_not_the_source_value)
+{
+  LogMessage *msg = log_msg_new_empty();
+  LogMessageValueSource source;
+  const gchar *input = "foo=bar";
+
+  log_msg_set_value(msg, LM_V_MESSAGE, input, -1);
+
+  log_msg_value_source_init(&source, msg, LM_V_MESSAGE, input, strlen(input));
+  log_msg_set_value_from_source(msg, log_msg_get_value_handle("foo"), &source, input + 4, 3);
+
+  assert_log_message_value_by_name(msg, "foo", "bar");
+  cr_assert_not(_is_value_indirect(msg, "foo"));
+
+  log_msg_unref(msg);
+}
+
+Test(log_message, test_values_from_source_are_copied_after_the_source_value_is_overwritten)
+{
+  LogMessage *msg = log_msg_new_empty();
+  LogMessageValueSource source;
+  gssize input_len;
+
+  log_msg_set_value(msg, LM_V_MESSAGE, "foo=bar", -1);
+  const gchar *input = log_msg_get_value(msg, LM_V_MESSAGE, &input_len);
+  NVTable *payload = nv_table_ref(msg->payload);
+
+  /* the new value does not fit in place, so the input stays intact */
+  log_msg_value_source_init(&source, msg, LM_V_MESSAGE, input, input_len);
+  log_msg_set_value_from_source(msg, LM_V_MESSAGE, &source, "a-value-longer-than-the-input", -1);
+  log_msg_set_value_from_source(msg, log_msg_get_value_handle("foo"), &source, input + 4, 3);
+
+  assert_log_message_value(msg, LM_V_MESSAGE, "a-value-longer-than-the-input");
+  assert_log_message_value_by_name(msg, "foo", "bar");
+  cr_assert_not(_is_value_indirect(msg, "foo"));
+
+  nv_table_unref(payload);
+  log_msg_unref(msg);
+}
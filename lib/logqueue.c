@@ -253,12 +253,12 @@ _register_shared_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuild
 
   stats_lock();
   {
-    stats_register_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_QUEUED,
-                           &self->metrics.shared.queued_messages);
-    stats_register_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_DROPPED,
-                           &self->metrics.shared.dropped_messages);
-    stats_register_counter(stats_level, self->metrics.shared.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
-                           &self->metrics.shared.memory_usage);
+    stats_register_sharded_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_QUEUED,
+                                   &self->metrics.shared.queued_messages);
+    stats_register_sharded_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_DROPPED,
+                                   &self->metrics.shared.dropped_messages);
+    stats_register_sharded_counter(stats_level, self->metrics.shared.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
+                                   &self->metrics.shared.memory_usage);
   }
   stats_unlock();
 }
@@ -281,10 +281,10 @@ _register_owned_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilde
 
   stats_lock();
   {
-    stats_register_counter(stats_level, self->metrics.owned.events_sc_key, SC_TYPE_SINGLE_VALUE,
-                           &self->metrics.owned.queued_messages);
-    stats_register_counter(stats_level, self->metrics.owned.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
-                           &self->metrics.owned.memory_usage);
+    stats_register_sharded_counter(stats_level, self->metrics.owned.events_sc_key, SC_TYPE_SINGLE_VALUE,
+                                   &self->metrics.owned.queued_messages);
+    stats_register_sharded_counter(stats_level, self->metrics.owned.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
+                                   &self->metrics.owned.memory_usage);
   }
   stats_unlock();
 }
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logreader-thread.h"
+#include "mainloop.h"
+#include "mainloop-call.h"
+#include "mainloop-worker.h"
+#include "cpu-affinity.h"
+#include "messages.h"
+#include "atomic.h"
+
+#include <iv.h>
+#include <iv_event.h>
+
+typedef struct _LogReaderThreadCall
+{
+  LogReaderThreadFunc func;
+  gpointer user_data;
+} LogReaderThreadCall;
+
+struct _LogReaderThread
+{
+  GAtomicCounter ref_cnt;
+  gchar *name;
+  gint cpu;
+  GThread *thread;
+
+  /* main thread state */
+  gboolean stopping;
+  gboolean exit_callback_registered;
+
+  /* protects "calls" and "running" */
+  GMutex lock;
+  GQueue calls;
+  gboolean running;
+  struct iv_event calls_posted;
+
+  /* only accessed from the thread itself */
+  gint users;
+  gboolean stop_requested;
+};
+
+static void
+_quit_if_unused(LogReaderThread *self)
+{
+  if (self->stop_requested && self->users == 0)
+    iv_quit();
+}
+
+static void
+_request_stop(gpointer s)
+{
+  LogReaderThread *self = (LogReaderThread *) s;
+
+  self->stop_requested = TRUE;
+}
+
+/* runs in the thread */
+static void
+_run_calls(gpointer s)
+{
+  LogReaderThread *self = (LogReaderThread *) s;
+  GQueue calls = G_QUEUE_INIT;
+
+  g_mutex_lock(&self->lock);
+  calls = self->calls;
+  g_queue_init(&self->calls);
+  g_mutex_unlock(&self->lock);
+
+  LogReaderThreadCall *call;
+  while ((call = g_queue_pop_head(&calls)))
+    {
+      call->func(call->user_data);
+      g_free(call);
+    }
+
+  _quit_if_unused(self);
+}
+
+void
+log_reader_thread_add_user(LogReaderThread *self)
+{
+  self->users++;
+}
+
+void
+log_reader_thread_remove_user(LogReaderThread *self)
+{
+  g_assert(self->users > 0);
+
+  self->users--;
+  _quit_if_unused(self);
+}
+
+gboolean
+log_reader_thread_call(LogReaderThread *self, LogReaderThreadFunc func, gpointer user_data)
+{
+  main_loop_assert_main_thread();
+
+  /* a stopping thread does not accept new users, they would keep it alive */
+  if (self->stopping)
+    return FALSE;
+
+  LogReaderThreadCall *call = g_new(LogReaderThreadCall, 1);
+  call->func = func;
+  call->user_data = user_data;
+
+  g_mutex_lock(&self->lock);
+  g_queue_push_tail(&self->calls, call);
+  if (self->running)
+    iv_event_post(&self->calls_posted);
+  g_mutex_unlock(&self->lock);
+  return TRUE;
+}
+
+/* runs in the main thread */
+static gpointer
+_thread_exited(gpointer s)
+{
+  LogReaderThread *self = (LogReaderThread *) s;
+
+  g_thread_join(self->thread);
+  self->thread = NULL;
+
+  main_loop_worker_job_complete();
+  log_reader_thread_unref(self);
+  return NULL;
+}
+
+static gpointer
+_thread_func(gpointer s)
+{
+  LogReaderThread *self = (LogReaderThread *) s;
+
+  iv_init();
+  main_loop_worker_thread_start(MLW_THREADED_INPUT_WORKER);
+
+  if (self->cpu >= 0 && !cpu_affinity_pin_current_thread(self->cpu))
+    {
+      msg_warning("Error pinning the reader thread to the requested CPU, continuing unpinned",
+                  evt_tag_str("thread", self->name),
+                  evt_tag_int("cpu", self->cpu),
+                  evt_tag_error("error"));
+    }
+
+  iv_event_register(&self->calls_posted);
+
+  g_mutex_lock(&self->lock);
+  self->running = TRUE;
+  if (!g_queue_is_empty(&self->calls))
+    iv_event_post(&self->calls_posted);
+  g_mutex_unlock(&self->lock);
+
+  iv_main();
+
+  g_mutex_lock(&self->lock);
+  self->running = FALSE;
+  g_mutex_unlock(&self->lock);
+  iv_event_unregister(&self->calls_posted);
+
+  main_loop_call(_thread_exited, self, FALSE);
+  main_loop_worker_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+/* called by main_loop_worker_sync_call() in the main thread, the
+ * notification list is freed by our caller */
+static void
+_request_exit(gpointer s)
+{
+  LogReaderThread *self = (LogReaderThread *) s;
+
+  self->exit_callback_registered = FALSE;
+  log_reader_thread_stop(self);
+}
+
+void
+log_reader_thread_start(LogReaderThread *self)
+{
+  main_loop_assert_main_thread();
+  g_assert(!self->thread);
+
+  self->stopping = FALSE;
+  self->stop_requested = FALSE;
+  self->users = 0;
+
+  log_reader_thread_ref(self);
+  main_loop_worker_job_start();
+  main_loop_worker_register_exit_notification_callback(_request_exit, self);
+  self->exit_callback_registered = TRUE;
+
+  self->thread = g_thread_new(self->name, _thread_func, self);
+}
+
+void
+log_reader_thread_stop(LogReaderThread *self)
+{
+  main_loop_assert_main_thread();
+
+  if (!self->thread || self->stopping)
+    return;
+
+  if (self->exit_callback_registered)
+    {
+      main_loop_worker_unregister_exit_notification_callback(_request_exit, self);
+      self->exit_callback_registered = FALSE;
+    }
+  log_reader_thread_call(self, _request_stop, self);
+  self->stopping = TRUE;
+}
+
+LogReaderThread *
+log_reader_thread_new(const gchar *name, gint cpu)
+{
+  LogReaderThread *self = g_new0(LogReaderThread, 1);
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->name = g_strdup(name);
+  self->cpu = cpu;
+  g_mutex_init(&self->lock);
+  g_queue_init(&self->calls);
+
+  IV_EVENT_INIT(&self->calls_posted);
+  self->calls_posted.cookie = self;
+  self->calls_posted.handler = _run_calls;
+
+  return self;
+}
+
+LogReaderThread *
+log_reader_thread_ref(LogReaderThread *self)
+{
+  g_assert(!self || g_atomic_counter_get(&self->ref_cnt) > 0);
+
+  if (self)
+    g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+void
+log_reader_thread_unref(LogReaderThread *self)
+{
+  g_assert(!self || g_atomic_counter_get(&self->ref_cnt));
+
+  if (self && g_atomic_counter_dec_and_test(&self->ref_cnt))
+    {
+      g_assert(!self->thread);
+      g_assert(g_queue_is_empty(&self->calls));
+
+      g_mutex_clear(&self->lock);
+      g_free(self->name);
+      g_free(self);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGREADER_THREAD_H_INCLUDED
+#define LOGREADER_THREAD_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * An event loop thread shared by a number of LogReaders in the
+ * dedicated-thread mode, instead of each of them running a thread of its
+ * own.  Readers attach themselves by running a function in the thread
+ * (log_reader_thread_call()) and keep the thread alive as long as they
+ * are attached (log_reader_thread_add_user()/remove_user()).
+ *
+ * The thread exits once it is stopped and all of its users are gone.
+ */
+typedef struct _LogReaderThread LogReaderThread;
+typedef void (*LogReaderThreadFunc)(gpointer user_data);
+
+LogReaderThread *log_reader_thread_new(const gchar *name, gint cpu);
+LogReaderThread *log_reader_thread_ref(LogReaderThread *self);
+void log_reader_thread_unref(LogReaderThread *self);
+
+void log_reader_thread_start(LogReaderThread *self);
+void log_reader_thread_stop(LogReaderThread *self);
+gboolean log_reader_thread_call(LogReaderThread *self, LogReaderThreadFunc func, gpointer user_data);
+
+/* can only be called from the thread itself */
+void log_reader_thread_add_user(LogReaderThread *self);
+void log_reader_thread_remove_user(LogReaderThread *self);
+
+#endif
@@ -27,10 +27,15 @@
 #include "mainloop-call.h"
 #include "ack-tracker/ack_tracker.h"
 #include "ack-tracker/ack_tracker_factory.h"
+#include "cpu-affinity.h"
 
 static void log_reader_io_handle_in(gpointer s);
 static gboolean log_reader_fetch_log(LogReader *self);
 static void log_reader_update_watches(LogReader *self);
+static void log_reader_dedicated_thread_notify(LogReader *self, gint notify_code);
+static void log_reader_dedicated_thread_wakeup(LogReader *self);
+static void log_reader_dedicated_thread_close_proto(LogReader *self);
+static void log_reader_dedicated_thread_realloc_window(LogReader *self);
 
 /*****************************************************************************
  * LogReader setters
@@ -55,6 +60,19 @@ log_reader_set_local_addr(LogReader *s, GSockAddr *local_addr)
   self->local_addr = g_sockaddr_ref(local_addr);
 }
 
+/* run the reader in a thread shared with other readers, which implies the
+ * dedicated-thread mode */
+void
+log_reader_set_shared_thread(LogReader *s, LogReaderThread *thread)
+{
+  LogReader *self = (LogReader *) s;
+
+  log_reader_thread_unref(self->dedicated_thread.shared);
+  self->dedicated_thread.shared = log_reader_thread_ref(thread);
+  if (thread)
+    self->dedicated_thread.enabled = TRUE;
+}
+
 void
 log_reader_set_options(LogReader *s, LogPipe *control, LogReaderOptions *options,
                        const gchar *stats_id, StatsClusterKeyBuilder *kb)
@@ -77,6 +95,8 @@ log_reader_set_options(LogReader *s, LogPipe *control, LogReaderOptions *options
   self->control = log_pipe_ref(control);
 
   self->options = options;
+  self->dedicated_thread.enabled = log_reader_options_is_dedicated_thread_enabled(options) ||
+                                   self->dedicated_thread.shared;
   log_proto_server_set_options(self->proto, &self->options->proto_options.super);
 }
 
@@ -105,6 +125,13 @@ log_reader_idle_timeout(void *cookie)
   msg_notice("Source timeout has elapsed, closing connection",
              evt_tag_int("fd", log_proto_server_get_fd(self->proto)));
 
+  if (self->dedicated_thread.enabled)
+    {
+      log_reader_disable_watches(self);
+      log_reader_dedicated_thread_notify(self, NC_CLOSE);
+      return;
+    }
+
   log_pipe_notify(self->control, NC_CLOSE, self);
 }
 
@@ -173,12 +200,13 @@ log_reader_wakeup_triggered(gpointer s)
 {
   LogReader *self = (LogReader *) s;
 
-  if (!self->io_job.working && self->suspended)
+  if (!self->io_job.working && !self->dedicated_thread.notify_pending && self->suspended)
     {
       /* NOTE: by the time working is set to FALSE we're over an
        * update_watches call.  So it is called either here (when
        * work_finished has done its work) or from work_finished above. The
-       * two are not racing as both run in the main thread
+       * two are not racing as both run in the main thread (or in the
+       * dedicated thread of the reader, see below).
        */
       log_reader_update_watches(self);
     }
@@ -202,7 +230,12 @@ log_reader_wakeup(LogSource *s)
    *
    */
 
-  if (self->super.super.flags & PIF_INITIALIZED)
+  if (!(self->super.super.flags & PIF_INITIALIZED))
+    return;
+
+  if (self->dedicated_thread.enabled)
+    log_reader_dedicated_thread_wakeup(self);
+  else
     iv_event_post(&self->schedule_wakeup);
 }
 
@@ -250,6 +283,12 @@ log_reader_close_proto_deferred(gpointer s)
 void
 log_reader_close_proto(LogReader *self)
 {
+  if (self->dedicated_thread.enabled)
+    {
+      log_reader_dedicated_thread_close_proto(self);
+      return;
+    }
+
   g_assert(self->watches_running);
   main_loop_call((MainLoopTaskFunc) log_reader_close_proto_deferred, self, TRUE);
 
@@ -289,7 +328,8 @@ log_reader_update_watches(LogReader *self)
   GIOCondition cond;
   gint idle_timeout = -1;
 
-  main_loop_assert_main_thread();
+  if (!self->dedicated_thread.enabled)
+    main_loop_assert_main_thread();
   g_assert(self->watches_running);
 
   log_reader_disable_watches(self);
@@ -346,6 +386,20 @@ log_reader_work_perform(void *s, gpointer arg)
   self->notify_code = log_reader_fetch_log(self);
 }
 
+static void
+log_reader_forward_notify(LogReader *self)
+{
+  gint notify_code = self->notify_code;
+
+  self->notify_code = 0;
+  log_pipe_notify(self->control, notify_code, self);
+
+  if (notify_code == NC_CLOSE && (self->options->flags & LR_EXIT_ON_EOF))
+    {
+      cfg_shutdown(log_pipe_get_config(&self->super.super));
+    }
+}
+
 static void
 log_reader_work_finished(void *s, gpointer arg)
 {
@@ -368,17 +422,8 @@ log_reader_work_finished(void *s, gpointer arg)
     }
 
   if (self->notify_code)
-    {
-      gint notify_code = self->notify_code;
+    log_reader_forward_notify(self);
 
-      self->notify_code = 0;
-      log_pipe_notify(self->control, notify_code, self);
-
-      if (notify_code == NC_CLOSE && (self->options->flags & LR_EXIT_ON_EOF))
-        {
-          cfg_shutdown(log_pipe_get_config(s));
-        }
-    }
   if ((self->super.super.flags & PIF_INITIALIZED) && self->proto)
     {
       /* reenable polling the source assuming that we're still in
@@ -394,6 +439,331 @@ log_reader_work_finished(void *s, gpointer arg)
     }
 }
 
+/*****************************************************************************
+ * Dedicated thread mode
+ *
+ * Instead of polling in the main thread and handing over each fetch to the
+ * MainLoopIOWorker pool, the LogReader runs its own ivykis loop in a
+ * thread of its own, optionally pinned to a CPU.  All watches (poll
+ * events, idle timer, restart task, wakeup event) are registered in that
+ * loop, so fetching and posting messages does not need a round trip
+ * through the main thread.
+ *
+ * Whatever has to happen in the main thread (notifications towards our
+ * control pipe and the teardown of the thread) is passed there using
+ * asynchronous main_loop_call()s, while the main thread sends requests to
+ * the reader thread through the "control" event.  The main thread never
+ * waits for the reader thread, that could deadlock with a destination
+ * calling main_loop_call() synchronously from the reader thread.
+ *
+ * The thread holds a main loop job during its lifetime, so reload and
+ * shutdown wait for it to stop, the same way as for threaded sources.
+ *****************************************************************************/
+
+#define LR_DT_STOP            0x0001
+#define LR_DT_CLOSE_PROTO     0x0002
+#define LR_DT_RESUME          0x0004
+#define LR_DT_REALLOC_WINDOW  0x0008
+
+/* NOTE: may be called from any thread */
+static void
+log_reader_dedicated_thread_request(LogReader *self, guint32 request)
+{
+  g_mutex_lock(&self->dedicated_thread.lock);
+  self->dedicated_thread.requests |= request;
+  if (self->dedicated_thread.running)
+    iv_event_post(&self->dedicated_thread.control);
+  g_mutex_unlock(&self->dedicated_thread.lock);
+}
+
+/* NOTE: may be called from any thread, the wakeup event is only
+ * registered while the thread is running */
+static void
+log_reader_dedicated_thread_wakeup(LogReader *self)
+{
+  g_mutex_lock(&self->dedicated_thread.lock);
+  if (self->dedicated_thread.running)
+    iv_event_post(&self->schedule_wakeup);
+  g_mutex_unlock(&self->dedicated_thread.lock);
+}
+
+static void
+log_reader_dedicated_thread_close_proto(LogReader *self)
+{
+  /* the proto is closed asynchronously by the reader thread, nothing
+   * waits for pending_close in this mode */
+  g_mutex_lock(&self->pending_close_lock);
+  self->pending_close = TRUE;
+  g_mutex_unlock(&self->pending_close_lock);
+
+  log_reader_dedicated_thread_request(self, LR_DT_CLOSE_PROTO);
+}
+
+static void
+log_reader_dedicated_thread_realloc_window(LogReader *self)
+{
+  log_reader_dedicated_thread_request(self, LR_DT_REALLOC_WINDOW);
+}
+
+/* runs in the main thread */
+static gpointer
+log_reader_dedicated_thread_notify_in_main(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  log_reader_forward_notify(self);
+
+  /* resume polling, unless our control pipe has stopped us in response */
+  if ((self->super.super.flags & PIF_INITIALIZED) && !self->dedicated_thread.stop_requested)
+    log_reader_dedicated_thread_request(self, LR_DT_RESUME);
+
+  log_pipe_unref(&self->super.super);
+  return NULL;
+}
+
+/* runs in the reader thread with the watches disabled, they are kept that
+ * way until the main thread has processed the notification */
+static void
+log_reader_dedicated_thread_notify(LogReader *self, gint notify_code)
+{
+  self->notify_code = notify_code;
+  self->dedicated_thread.notify_pending = TRUE;
+
+  log_pipe_ref(&self->super.super);
+  main_loop_call(log_reader_dedicated_thread_notify_in_main, self, FALSE);
+}
+
+/* runs in the reader thread, in place of the MainLoopIOWorker job */
+static void
+log_reader_dedicated_thread_fetch(LogReader *self)
+{
+  /* NOTE: no main_loop_worker_job_quit() check here, the fetch loop
+   * already stops once a reload is requested */
+  gint notify_code = log_reader_fetch_log(self);
+
+  main_loop_worker_invoke_batch_callbacks();
+  main_loop_worker_run_gc();
+
+  if (notify_code)
+    {
+      log_reader_dedicated_thread_notify(self, notify_code);
+      return;
+    }
+
+  log_proto_server_reset_error(self->proto);
+  log_reader_update_watches(self);
+}
+
+static void
+log_reader_dedicated_thread_stop_watches(LogReader *self)
+{
+  g_mutex_lock(&self->dedicated_thread.lock);
+  self->dedicated_thread.running = FALSE;
+  g_mutex_unlock(&self->dedicated_thread.lock);
+
+  iv_event_unregister(&self->dedicated_thread.control);
+  iv_event_unregister(&self->schedule_wakeup);
+  if (iv_task_registered(&self->restart_task))
+    iv_task_unregister(&self->restart_task);
+
+  log_reader_stop_watches(self);
+}
+
+/*
+ * A reader attached to a LogReaderThread shares the event loop of that
+ * thread with other readers: instead of starting and exiting a thread, it
+ * starts its watches in it and stops them, keeping the thread alive in
+ * between.
+ */
+
+/* runs in the main thread */
+static gpointer
+log_reader_dedicated_thread_detached(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  self->dedicated_thread.attached = FALSE;
+
+  main_loop_worker_job_complete();
+  log_pipe_unref(&self->super.super);
+  return NULL;
+}
+
+/* runs in the shared thread, with our watches stopped */
+static void
+log_reader_dedicated_thread_detach(LogReader *self)
+{
+  main_loop_call(log_reader_dedicated_thread_detached, self, FALSE);
+  log_reader_thread_remove_user(self->dedicated_thread.shared);
+}
+
+/* runs in the reader thread */
+static void
+log_reader_dedicated_thread_handle_requests(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  g_mutex_lock(&self->dedicated_thread.lock);
+  guint32 requests = self->dedicated_thread.requests;
+  self->dedicated_thread.requests = 0;
+  g_mutex_unlock(&self->dedicated_thread.lock);
+
+  if (requests & LR_DT_CLOSE_PROTO)
+    {
+      log_reader_stop_watches(self);
+      log_reader_apply_proto_and_poll_events(self, NULL, NULL);
+      log_reader_start_watches(self);
+
+      g_mutex_lock(&self->pending_close_lock);
+      self->pending_close = FALSE;
+      g_cond_signal(&self->pending_close_cond);
+      g_mutex_unlock(&self->pending_close_lock);
+    }
+
+  if (requests & LR_DT_STOP)
+    {
+      log_reader_dedicated_thread_stop_watches(self);
+      if (self->dedicated_thread.attached)
+        log_reader_dedicated_thread_detach(self);
+      else
+        iv_quit();
+      return;
+    }
+
+  if (requests & LR_DT_REALLOC_WINDOW)
+    log_source_dynamic_window_realloc(&self->super);
+
+  if (requests & LR_DT_RESUME)
+    {
+      self->dedicated_thread.notify_pending = FALSE;
+      if (self->proto)
+        log_proto_server_reset_error(self->proto);
+      log_reader_update_watches(self);
+    }
+}
+
+/* runs in the main thread */
+static gpointer
+log_reader_dedicated_thread_exited(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  g_thread_join(self->dedicated_thread.thread);
+  self->dedicated_thread.thread = NULL;
+
+  main_loop_worker_job_complete();
+  log_pipe_unref(&self->super.super);
+  return NULL;
+}
+
+/* runs in the reader thread */
+static void
+log_reader_dedicated_thread_start_watches(LogReader *self)
+{
+  iv_event_register(&self->dedicated_thread.control);
+  iv_event_register(&self->schedule_wakeup);
+  log_reader_start_watches(self);
+
+  g_mutex_lock(&self->dedicated_thread.lock);
+  self->dedicated_thread.running = TRUE;
+  if (self->dedicated_thread.requests)
+    iv_event_post(&self->dedicated_thread.control);
+  g_mutex_unlock(&self->dedicated_thread.lock);
+}
+
+static gpointer
+log_reader_dedicated_thread_func(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  iv_init();
+  main_loop_worker_thread_start(MLW_THREADED_INPUT_WORKER);
+
+  if (self->dedicated_thread.cpu >= 0 && !cpu_affinity_pin_current_thread(self->dedicated_thread.cpu))
+    {
+      msg_warning("Error pinning the reader thread to the requested CPU, continuing unpinned",
+                  evt_tag_int("cpu", self->dedicated_thread.cpu),
+                  evt_tag_error("error"));
+    }
+
+  log_reader_dedicated_thread_start_watches(self);
+
+  iv_main();
+
+  main_loop_call(log_reader_dedicated_thread_exited, self, FALSE);
+  main_loop_worker_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+/* runs in the shared thread */
+static void
+log_reader_dedicated_thread_attach(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  log_reader_thread_add_user(self->dedicated_thread.shared);
+  log_reader_dedicated_thread_start_watches(self);
+}
+
+static void log_reader_dedicated_thread_stop(LogReader *self);
+
+/* called by main_loop_worker_sync_call() in the main thread, the
+ * notification list is freed by our caller */
+static void
+log_reader_dedicated_thread_request_exit(gpointer s)
+{
+  LogReader *self = (LogReader *) s;
+
+  self->dedicated_thread.exit_callback_registered = FALSE;
+  log_reader_dedicated_thread_stop(self);
+}
+
+static void
+log_reader_dedicated_thread_start(LogReader *self)
+{
+  /* the thread of a previous init is gone by now: reload waits for its
+   * main loop job to complete */
+  g_assert(!self->dedicated_thread.thread && !self->dedicated_thread.attached);
+
+  self->dedicated_thread.running = FALSE;
+  self->dedicated_thread.requests = 0;
+  self->dedicated_thread.stop_requested = FALSE;
+  self->dedicated_thread.notify_pending = FALSE;
+
+  log_pipe_ref(&self->super.super);
+  main_loop_worker_job_start();
+  main_loop_worker_register_exit_notification_callback(log_reader_dedicated_thread_request_exit, self);
+  self->dedicated_thread.exit_callback_registered = TRUE;
+
+  /* a shared thread that is being stopped does not take new readers, we
+   * run in a thread of our own in that case */
+  if (self->dedicated_thread.shared &&
+      log_reader_thread_call(self->dedicated_thread.shared, log_reader_dedicated_thread_attach, self))
+    {
+      self->dedicated_thread.attached = TRUE;
+      return;
+    }
+
+  self->dedicated_thread.cpu = log_reader_options_pick_cpu(self->options);
+  self->dedicated_thread.thread = g_thread_new("log-reader", log_reader_dedicated_thread_func, self);
+}
+
+static void
+log_reader_dedicated_thread_stop(LogReader *self)
+{
+  if ((!self->dedicated_thread.thread && !self->dedicated_thread.attached) || self->dedicated_thread.stop_requested)
+    return;
+
+  self->dedicated_thread.stop_requested = TRUE;
+  if (self->dedicated_thread.exit_callback_registered)
+    {
+      main_loop_worker_unregister_exit_notification_callback(log_reader_dedicated_thread_request_exit, self);
+      self->dedicated_thread.exit_callback_registered = FALSE;
+    }
+  log_reader_dedicated_thread_request(self, LR_DT_STOP);
+}
+
 /*****************************************************************************
  * Input processing, the main function of LogReader
  *****************************************************************************/
@@ -567,7 +937,11 @@ log_reader_io_handle_in(gpointer s)
   LogReader *self = (LogReader *) s;
 
   log_reader_disable_watches(self);
-  if ((self->options->flags & LR_THREADED))
+  if (self->dedicated_thread.enabled)
+    {
+      log_reader_dedicated_thread_fetch(self);
+    }
+  else if ((self->options->flags & LR_THREADED))
     {
       main_loop_io_worker_job_submit(&self->io_job, NULL);
     }
@@ -664,12 +1038,20 @@ log_reader_init(LogPipe *s)
       return FALSE;
     }
 
+  /* registered first, the dedicated thread may start posting messages
+   * right away */
+  _register_aggregated_stats(self);
+
+  if (self->dedicated_thread.enabled)
+    {
+      log_reader_dedicated_thread_start(self);
+      return TRUE;
+    }
+
   iv_event_register(&self->schedule_wakeup);
 
   log_reader_start_watches(self);
 
-  _register_aggregated_stats(self);
-
   return TRUE;
 }
 
@@ -680,11 +1062,19 @@ log_reader_deinit(LogPipe *s)
 
   main_loop_assert_main_thread();
 
-  iv_event_unregister(&self->schedule_wakeup);
-  if (iv_task_registered(&self->restart_task))
-    iv_task_unregister(&self->restart_task);
+  if (self->dedicated_thread.enabled)
+    {
+      /* the watches are stopped by the thread itself, asynchronously */
+      log_reader_dedicated_thread_stop(self);
+    }
+  else
+    {
+      iv_event_unregister(&self->schedule_wakeup);
+      if (iv_task_registered(&self->restart_task))
+        iv_task_unregister(&self->restart_task);
 
-  log_reader_stop_watches(self);
+      log_reader_stop_watches(self);
+    }
 
   _unregister_aggregated_stats(self);
   if (!log_source_deinit(s))
@@ -709,6 +1099,10 @@ log_reader_init_watches(LogReader *self)
   self->idle_timer.cookie = self;
   self->idle_timer.handler = log_reader_idle_timeout;
 
+  IV_EVENT_INIT(&self->dedicated_thread.control);
+  self->dedicated_thread.control.cookie = self;
+  self->dedicated_thread.control.handler = log_reader_dedicated_thread_handle_requests;
+
   main_loop_io_worker_job_init(&self->io_job);
   self->io_job.user_data = self;
   self->io_job.work = log_reader_work_perform;
@@ -735,6 +1129,8 @@ log_reader_free(LogPipe *s)
   g_sockaddr_unref(self->local_addr);
   g_mutex_clear(&self->pending_close_lock);
   g_cond_clear(&self->pending_close_cond);
+  g_mutex_clear(&self->dedicated_thread.lock);
+  log_reader_thread_unref(self->dedicated_thread.shared);
   log_source_free(s);
 }
 
@@ -745,6 +1141,12 @@ _schedule_dynamic_window_realloc(LogSource *s)
 
   msg_trace("LogReader::dynamic_window_realloc called");
 
+  if (self->dedicated_thread.enabled)
+    {
+      log_reader_dedicated_thread_realloc_window(self);
+      return;
+    }
+
   if (self->io_job.working)
     {
       self->realloc_window_after_fetch = TRUE;
@@ -771,6 +1173,7 @@ log_reader_new(GlobalConfig *cfg)
   log_reader_init_watches(self);
   g_mutex_init(&self->pending_close_lock);
   g_cond_init(&self->pending_close_cond);
+  g_mutex_init(&self->dedicated_thread.lock);
   return self;
 }
 
@@ -785,6 +1188,78 @@ log_reader_options_defaults(LogReaderOptions *options)
   log_proto_server_options_defaults(&options->proto_options.super);
   msg_format_options_defaults(&options->parse_options);
   options->fetch_limit = 10;
+  options->dedicated_thread.numa_node = -1;
+}
+
+gboolean
+log_reader_options_set_cpu_affinity(LogReaderOptions *options, const gchar *cpu_list)
+{
+  GArray *cpus = cpu_affinity_parse_cpu_list(cpu_list);
+
+  if (!cpus)
+    return FALSE;
+
+  if (options->dedicated_thread.cpu_affinity)
+    g_array_unref(options->dedicated_thread.cpu_affinity);
+  options->dedicated_thread.cpu_affinity = cpus;
+  return TRUE;
+}
+
+/* cpu-affinity() and numa-node() imply dedicated-thread(yes) */
+gboolean
+log_reader_options_is_dedicated_thread_enabled(LogReaderOptions *options)
+{
+  return options->dedicated_thread.enabled ||
+         options->dedicated_thread.cpu_affinity ||
+         options->dedicated_thread.numa_node >= 0;
+}
+
+/* distributes the reader threads round-robin among the allowed CPUs,
+ * returns -1 if threads are not to be pinned */
+gint
+log_reader_options_pick_cpu(LogReaderOptions *options)
+{
+  GArray *cpus = options->dedicated_thread.cpus;
+
+  if (!cpus)
+    return -1;
+
+  guint index = (guint) g_atomic_int_add(&options->dedicated_thread.next_cpu, 1);
+  return g_array_index(cpus, gint, index % cpus->len);
+}
+
+static void
+_resolve_dedicated_thread_cpus(LogReaderOptions *options)
+{
+  GArray *numa_cpus = NULL;
+
+  if (options->dedicated_thread.numa_node >= 0)
+    {
+      numa_cpus = cpu_affinity_get_numa_node_cpus(options->dedicated_thread.numa_node);
+      if (!numa_cpus)
+        msg_warning("WARNING: unable to query the CPUs of the NUMA node specified in numa-node(), "
+                    "reader threads are not pinned to it",
+                    evt_tag_int("numa_node", options->dedicated_thread.numa_node));
+    }
+
+  if (numa_cpus && options->dedicated_thread.cpu_affinity)
+    {
+      options->dedicated_thread.cpus = cpu_affinity_intersect(numa_cpus, options->dedicated_thread.cpu_affinity);
+      g_array_unref(numa_cpus);
+
+      if (!options->dedicated_thread.cpus)
+        msg_warning("WARNING: none of the CPUs in cpu-affinity() belong to the NUMA node specified in numa-node(), "
+                    "reader threads are not pinned",
+                    evt_tag_int("numa_node", options->dedicated_thread.numa_node));
+    }
+  else if (numa_cpus)
+    {
+      options->dedicated_thread.cpus = numa_cpus;
+    }
+  else if (options->dedicated_thread.cpu_affinity)
+    {
+      options->dedicated_thread.cpus = g_array_ref(options->dedicated_thread.cpu_affinity);
+    }
 }
 
 /*
@@ -847,6 +1322,9 @@ log_reader_options_init(LogReaderOptions *options, GlobalConfig *cfg, const gcha
   if (options->check_program)
     options->parse_options.flags |= LP_CHECK_PROGRAM;
 
+  if (log_reader_options_is_dedicated_thread_enabled(options))
+    _resolve_dedicated_thread_cpus(options);
+
   options->initialized = TRUE;
 }
 
@@ -856,6 +1334,12 @@ log_reader_options_destroy(LogReaderOptions *options)
   log_source_options_destroy(&options->super);
   log_proto_server_options_destroy(&options->proto_options.super);
   msg_format_options_destroy(&options->parse_options);
+  if (options->dedicated_thread.cpu_affinity)
+    g_array_unref(options->dedicated_thread.cpu_affinity);
+  if (options->dedicated_thread.cpus)
+    g_array_unref(options->dedicated_thread.cpus);
+  options->dedicated_thread.cpu_affinity = NULL;
+  options->dedicated_thread.cpus = NULL;
   options->initialized = FALSE;
 }
 
@@ -32,6 +32,7 @@
 #include "poll-events.h"
 #include "mainloop-io-worker.h"
 #include "msg-format.h"
+#include "logreader-thread.h"
 #include <iv_event.h>
 
 /* flags */
@@ -54,6 +55,17 @@ typedef struct _LogReaderOptions
   const gchar *group_name;
   gboolean check_hostname;
   gboolean check_program;
+
+  /* run each LogReader in its own event loop thread, optionally pinned
+   * to one of a set of CPUs, see log_reader_options_pick_cpu() */
+  struct
+  {
+    gboolean enabled;
+    GArray *cpu_affinity;
+    gint numa_node;
+    GArray *cpus;
+    gint next_cpu;
+  } dedicated_thread;
 } LogReaderOptions;
 
 typedef struct _LogReader LogReader;
@@ -91,6 +103,25 @@ struct _LogReader
   GMutex pending_close_lock;
 
   struct iv_timer idle_timer;
+
+  /* state of the dedicated thread mode, the "lock" protects "running" and
+   * "requests", which are used to pass requests from the main thread */
+  struct
+  {
+    gboolean enabled;
+    GThread *thread;
+    gint cpu;
+    /* the thread shared with other readers, in place of our own "thread" */
+    LogReaderThread *shared;
+    gboolean attached;
+    GMutex lock;
+    gboolean running;
+    guint32 requests;
+    struct iv_event control;
+    gboolean stop_requested;
+    gboolean exit_callback_registered;
+    gboolean notify_pending;
+  } dedicated_thread;
 };
 
 void log_reader_set_options(LogReader *s, LogPipe *control, LogReaderOptions *options, const gchar *stats_id,
@@ -99,6 +130,7 @@ void log_reader_set_follow_filename(LogReader *self, const gchar *follow_filenam
 void log_reader_set_name(LogReader *s, const gchar *name);
 void log_reader_set_peer_addr(LogReader *s, GSockAddr *peer_addr);
 void log_reader_set_local_addr(LogReader *s, GSockAddr *local_addr);
+void log_reader_set_shared_thread(LogReader *s, LogReaderThread *thread);
 void log_reader_disable_bookmark_saving(LogReader *s);
 void log_reader_open(LogReader *s, LogProtoServer *proto, PollEvents *poll_events);
 void log_reader_close_proto(LogReader *s);
@@ -109,5 +141,8 @@ void log_reader_options_init(LogReaderOptions *options, GlobalConfig *cfg, const
 void log_reader_options_destroy(LogReaderOptions *options);
 void log_reader_options_set_tags(LogReaderOptions *options, GList *tags);
 gboolean log_reader_options_process_flag(LogReaderOptions *options, const gchar *flag);
+gboolean log_reader_options_set_cpu_affinity(LogReaderOptions *options, const gchar *cpu_list);
+gboolean log_reader_options_is_dedicated_thread_enabled(LogReaderOptions *options);
+gint log_reader_options_pick_cpu(LogReaderOptions *options);
 
 #endif
@@ -480,7 +480,8 @@ _register_counters(LogSource *self)
 
   gint level = log_pipe_is_internal(&self->super) ? STATS_LEVEL3 : self->options->stats_level;
 
-  stats_register_counter(level, self->metrics.recvd_messages_key, SC_TYPE_SINGLE_VALUE, &self->metrics.recvd_messages);
+  stats_register_sharded_counter(level, self->metrics.recvd_messages_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.recvd_messages);
 
   StatsClusterKey sc_key;
   gchar stats_instance[1024];
@@ -103,6 +103,7 @@ void
 log_threaded_dest_worker_ack_messages(LogThreadedDestWorker *self, gint batch_size)
 {
   log_queue_ack_backlog(self->queue, batch_size);
+  latency_sampler_acked(self->metrics.latency_sampler, batch_size);
   stats_counter_add(self->owner->metrics.written_messages, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
@@ -112,6 +113,7 @@ void
 log_threaded_dest_worker_drop_messages(LogThreadedDestWorker *self, gint batch_size)
 {
   log_queue_ack_backlog(self->queue, batch_size);
+  latency_sampler_skipped(self->metrics.latency_sampler, batch_size);
   stats_counter_add(self->owner->metrics.dropped_messages, batch_size);
   self->retries_on_error_counter = 0;
   self->batch_size -= batch_size;
@@ -121,6 +123,7 @@ void
 log_threaded_dest_worker_rewind_messages(LogThreadedDestWorker *self, gint batch_size)
 {
   log_queue_rewind_backlog(self->queue, batch_size);
+  latency_sampler_rewound(self->metrics.latency_sampler, batch_size);
   self->rewound_batch_size = self->batch_size;
   self->batch_size -= batch_size;
 }
@@ -484,6 +487,7 @@ _perform_inserts(LogThreadedDestWorker *self)
           break;
         }
 
+      latency_sampler_popped(self->metrics.latency_sampler, msg);
       msg_set_context(msg);
       log_msg_refcache_start_consumer(msg, &path_options);
 
@@ -735,6 +739,7 @@ _perform_final_flush(LogThreadedDestWorker *self)
   result = log_threaded_dest_worker_flush(self, mode);
   _process_result(self, result);
   log_queue_rewind_backlog_all(self->queue);
+  latency_sampler_rewound_all(self->metrics.latency_sampler);
 }
 
 static gboolean
@@ -773,6 +778,7 @@ _worker_thread(MainLoopThreadedWorker *s)
    * not-flushed batch.  Rewind it, so we start with that */
 
   log_queue_rewind_backlog_all(self->queue);
+  latency_sampler_rewound_all(self->metrics.latency_sampler);
 
   _schedule_restart(self);
   iv_main();
@@ -864,6 +870,8 @@ static void
 _register_worker_stats(LogThreadedDestWorker *self)
 {
   gint level = log_pipe_is_internal(&self->owner->super.super.super) ? STATS_LEVEL3 : STATS_LEVEL1;
+  /* each histogram is a few dozen series, keep them out of the default output */
+  gint histogram_level = log_pipe_is_internal(&self->owner->super.super.super) ? STATS_LEVEL3 : STATS_LEVEL2;
 
   StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
   stats_cluster_key_builder_push(kb);
@@ -909,6 +917,35 @@ _register_worker_stats(LogThreadedDestWorker *self)
   }
   stats_cluster_key_builder_pop(kb);
 
+  stats_cluster_key_builder_push(kb);
+  {
+    _init_worker_sck_builder(self, kb);
+
+    stats_lock();
+    {
+      stats_cluster_key_builder_set_name(kb, "output_request_latency_seconds");
+      stats_cluster_key_builder_set_unit(kb, SCU_MICROSECONDS);
+      self->metrics.request_latency_key = stats_cluster_key_builder_build_histogram(kb);
+      stats_register_histogram(histogram_level, self->metrics.request_latency_key, &self->metrics.request_latency);
+
+      stats_cluster_key_builder_set_name(kb, "output_batch_size_events");
+      stats_cluster_key_builder_set_unit(kb, SCU_NONE);
+      self->metrics.batch_size_key = stats_cluster_key_builder_build_histogram(kb);
+      stats_register_histogram(histogram_level, self->metrics.batch_size_key, &self->metrics.batch_size);
+
+      stats_cluster_key_builder_set_name(kb, "output_event_delay_seconds");
+      stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+      self->metrics.message_delay_key = stats_cluster_key_builder_build_histogram(kb);
+      stats_register_histogram(histogram_level, self->metrics.message_delay_key, &self->metrics.message_delay);
+    }
+    stats_unlock();
+  }
+  stats_cluster_key_builder_pop(kb);
+
+  StatsClusterKeyBuilder *latency_kb = stats_cluster_key_builder_new();
+  _init_worker_sck_builder(self, latency_kb);
+  self->metrics.latency_sampler = latency_sampler_new(histogram_level, latency_kb);
+
   UnixTime now;
   unix_time_set_now(&now);
   stats_counter_set_time(self->metrics.message_delay_sample_age, now.ut_sec);
@@ -920,6 +957,9 @@ _register_worker_stats(LogThreadedDestWorker *self)
 static void
 _unregister_worker_stats(LogThreadedDestWorker *self)
 {
+  latency_sampler_free(self->metrics.latency_sampler);
+  self->metrics.latency_sampler = NULL;
+
   if (self->metrics.output_event_bytes_sc_key)
     {
       stats_byte_counter_deinit(&self->metrics.written_bytes, self->metrics.output_event_bytes_sc_key);
@@ -952,6 +992,27 @@ _unregister_worker_stats(LogThreadedDestWorker *self)
         stats_cluster_key_free(self->metrics.message_delay_sample_age_key);
         self->metrics.message_delay_sample_age_key = NULL;
       }
+
+    if (self->metrics.request_latency_key)
+      {
+        stats_unregister_histogram(self->metrics.request_latency_key, &self->metrics.request_latency);
+        stats_cluster_key_free(self->metrics.request_latency_key);
+        self->metrics.request_latency_key = NULL;
+      }
+
+    if (self->metrics.batch_size_key)
+      {
+        stats_unregister_histogram(self->metrics.batch_size_key, &self->metrics.batch_size);
+        stats_cluster_key_free(self->metrics.batch_size_key);
+        self->metrics.batch_size_key = NULL;
+      }
+
+    if (self->metrics.message_delay_key)
+      {
+        stats_unregister_histogram(self->metrics.message_delay_key, &self->metrics.message_delay);
+        stats_cluster_key_free(self->metrics.message_delay_key);
+        self->metrics.message_delay_key = NULL;
+      }
   }
   stats_unlock();
 
@@ -31,6 +31,8 @@
 #include "stats/aggregator/stats-aggregator.h"
 #include "stats/stats-compat.h"
 #include "stats/stats-cluster-key-builder.h"
+#include "stats/stats-cluster-histogram.h"
+#include "latency-sampler.h"
 #include "logqueue.h"
 #include "seqnum.h"
 #include "mainloop-threaded-worker.h"
@@ -110,12 +112,22 @@ struct _LogThreadedDestWorker
     StatsClusterKey *output_unreachable_key;
     StatsClusterKey *message_delay_sample_key;
     StatsClusterKey *message_delay_sample_age_key;
+    StatsClusterKey *request_latency_key;
+    StatsClusterKey *batch_size_key;
+    StatsClusterKey *message_delay_key;
 
     StatsByteCounter written_bytes;
     StatsCounterItem *output_unreachable;
     StatsCounterItem *message_delay_sample;
     StatsCounterItem *message_delay_sample_age;
 
+    /* histograms, see stats_histogram_observe() */
+    StatsCounterItem *request_latency;
+    StatsCounterItem *batch_size;
+    StatsCounterItem *message_delay;
+
+    LatencySampler *latency_sampler;
+
     gint64 last_delay_update;
   } metrics;
 
@@ -249,9 +261,16 @@ log_threaded_dest_worker_insert(LogThreadedDestWorker *self, LogMessage *msg)
   else
     self->seq_num = 0;
 
+  /* without batching, insert() performs the request itself */
+  gboolean measure_request = self->metrics.request_latency && !self->enable_batching;
+  gint64 request_start = measure_request ? g_get_monotonic_time() : 0;
+
   LogThreadedResult result = self->insert(self, msg);
 
-  if (self->metrics.message_delay_sample
+  if (measure_request && result != LTR_QUEUED && result != LTR_EXPLICIT_ACK_MGMT)
+    stats_histogram_observe(self->metrics.request_latency, g_get_monotonic_time() - request_start);
+
+  if ((self->metrics.message_delay_sample || self->metrics.message_delay)
       && (result == LTR_QUEUED || result == LTR_SUCCESS || result == LTR_EXPLICIT_ACK_MGMT))
     {
       UnixTime now;
@@ -259,7 +278,9 @@ log_threaded_dest_worker_insert(LogThreadedDestWorker *self, LogMessage *msg)
       unix_time_set_now(&now);
       gint64 diff_msec = unix_time_diff_in_msec(&now, &msg->timestamps[LM_TS_RECVD]);
 
-      if (self->metrics.last_delay_update != now.ut_sec)
+      stats_histogram_observe(self->metrics.message_delay, MAX(diff_msec, 0));
+
+      if (self->metrics.message_delay_sample && self->metrics.last_delay_update != now.ut_sec)
         {
           stats_counter_set_time(self->metrics.message_delay_sample, diff_msec);
           stats_counter_set_time(self->metrics.message_delay_sample_age, now.ut_sec);
@@ -275,8 +296,18 @@ log_threaded_dest_worker_flush(LogThreadedDestWorker *self, LogThreadedFlushMode
 {
   LogThreadedResult result = LTR_SUCCESS;
 
+  /* flush() is called even if there is nothing to send, only measure actual batches */
+  gboolean measure_request = self->metrics.request_latency && self->batch_size > 0;
+  gint64 request_start = measure_request ? g_get_monotonic_time() : 0;
+
   if (self->flush)
     result = self->flush(self, mode);
+
+  if (measure_request)
+    {
+      stats_histogram_observe(self->metrics.request_latency, g_get_monotonic_time() - request_start);
+      stats_histogram_observe(self->metrics.batch_size, self->batch_size);
+    }
   iv_validate_now();
   self->last_flush_time = iv_now;
   return result;
@@ -29,6 +29,7 @@
 #include "stats/stats-cluster-single.h"
 #include "stats/aggregator/stats-aggregator.h"
 #include "stats/stats-compat.h"
+#include "latency-sampler.h"
 #include "hostname.h"
 #include "host-resolve.h"
 #include "seqnum.h"
@@ -91,6 +92,7 @@ struct _LogWriter
     StatsCounterItem *message_delay;
     StatsClusterKey *message_delay_sample_age_key;
     StatsCounterItem *message_delay_sample_age;
+    LatencySampler *latency_sampler;
 
     struct
     {
@@ -168,12 +170,14 @@ log_writer_msg_ack(gint num_msg_acked, gpointer user_data)
 {
   LogWriter *self = (LogWriter *)user_data;
   log_queue_ack_backlog(self->queue, num_msg_acked);
+  latency_sampler_acked(self->metrics.latency_sampler, num_msg_acked);
 }
 
 void
 log_writer_msg_rewind(LogWriter *self)
 {
   log_queue_rewind_backlog_all(self->queue);
+  latency_sampler_rewound_all(self->metrics.latency_sampler);
 }
 
 static void
@@ -1284,6 +1288,7 @@ log_writer_write_message(LogWriter *self, LogMessage *msg, LogPathOptions *path_
                 evt_tag_printf("message", "%s", self->line_buffer->str));
 
       log_queue_rewind_backlog(self->queue, 1);
+      latency_sampler_rewound(self->metrics.latency_sampler, 1);
 
       log_msg_unref(msg);
       msg_set_context(NULL);
@@ -1349,6 +1354,8 @@ log_writer_flush(LogWriter *self, LogWriterFlushMode flush_mode)
       if (!msg)
         break;
 
+      latency_sampler_popped(self->metrics.latency_sampler, msg);
+
       ScratchBuffersMarker mark;
       scratch_buffers_mark(&mark);
       if (!log_writer_write_message(self, msg, &path_options, &write_error))
@@ -1551,6 +1558,11 @@ _register_counters(LogWriter *self)
 
   level = log_pipe_is_internal(&self->super) ? STATS_LEVEL3 : STATS_LEVEL1;
   _register_raw_bytes_stats(self, level);
+
+  level = log_pipe_is_internal(&self->super) ? STATS_LEVEL3 : STATS_LEVEL2;
+  StatsClusterKeyBuilder *latency_kb = stats_cluster_key_builder_clone(self->metrics.stats_kb);
+  stats_cluster_key_builder_add_label(latency_kb, stats_cluster_label("id", self->stats_id));
+  self->metrics.latency_sampler = latency_sampler_new(level, latency_kb);
 }
 
 static gboolean
@@ -1582,6 +1594,9 @@ log_writer_init(LogPipe *s)
 static void
 _unregister_counters(LogWriter *self)
 {
+  latency_sampler_free(self->metrics.latency_sampler);
+  self->metrics.latency_sampler = NULL;
+
   stats_lock();
   {
     stats_unregister_counter(self->metrics.output_events_key, SC_TYPE_DROPPED, &self->metrics.dropped_messages);
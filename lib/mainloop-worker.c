@@ -173,6 +173,22 @@ main_loop_worker_register_exit_notification_callback(WorkerExitNotificationFunc
   exit_notification_list = g_list_append(exit_notification_list, cfunc);
 }
 
+void
+main_loop_worker_unregister_exit_notification_callback(WorkerExitNotificationFunc func, gpointer user_data)
+{
+  for (GList *l = exit_notification_list; l; l = l->next)
+    {
+      WorkerExitNotification *cfunc = (WorkerExitNotification *) l->data;
+
+      if (cfunc->func == func && cfunc->user_data == user_data)
+        {
+          exit_notification_list = g_list_delete_link(exit_notification_list, l);
+          g_free(cfunc);
+          return;
+        }
+    }
+}
+
 static void
 _invoke_worker_exit_callback(WorkerExitNotification *func)
 {
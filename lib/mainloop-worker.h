@@ -77,6 +77,7 @@ void main_loop_worker_thread_start(MainLoopWorkerType worker_type);
 void main_loop_worker_thread_stop(void);
 void main_loop_worker_run_gc(void);
 void main_loop_worker_register_exit_notification_callback(WorkerExitNotificationFunc func, gpointer user_data);
+void main_loop_worker_unregister_exit_notification_callback(WorkerExitNotificationFunc func, gpointer user_data);
 gboolean main_loop_worker_is_worker_thread(void);
 
 void main_loop_worker_sync_call(void (*func)(void *user_data), void *user_data);
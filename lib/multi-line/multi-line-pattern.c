@@ -67,6 +67,7 @@ multi_line_pattern_compile(const gchar *regexp, GError **error)
                 evt_tag_str("error", (gchar *) error_message));
     }
 
+  multi_line_prefilter_init(&self->prefilter, regexp, self->pattern);
   return self;
 error:
   if (self->pattern)
@@ -87,6 +88,9 @@ multi_line_pattern_find(MultiLinePattern *re, const guchar *str, gsize len, gint
   if (!re)
     return FALSE;
 
+  if (multi_line_prefilter_rejects(&re->prefilter, str, len))
+    return FALSE;
+
   gboolean result = FALSE;
   pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re->pattern, NULL);
 
@@ -114,6 +118,9 @@ multi_line_pattern_match(MultiLinePattern *re, const guchar *str, gsize len)
   if (!re)
     return FALSE;
 
+  if (multi_line_prefilter_rejects(&re->prefilter, str, len))
+    return FALSE;
+
   gboolean result = FALSE;
   pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re->pattern, NULL);
 
@@ -145,6 +152,7 @@ multi_line_pattern_unref(MultiLinePattern *self)
     {
       if (self->pattern)
         pcre2_code_free(self->pattern);
+      multi_line_prefilter_clear(&self->prefilter);
       g_free(self);
     }
 }
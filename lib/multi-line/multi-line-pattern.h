@@ -28,12 +28,14 @@
 
 #include "syslog-ng.h"
 #include "compat/pcre.h"
+#include "multi-line/multi-line-prefilter.h"
 
 typedef struct _MultiLinePattern MultiLinePattern;
 struct _MultiLinePattern
 {
   gint ref_cnt;
   pcre2_code *pattern;
+  MultiLinePrefilter prefilter;
 };
 
 gboolean multi_line_pattern_find(MultiLinePattern *re, const guchar *str, gsize len, gint *start, gint *end);
@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "multi-line/multi-line-prefilter.h"
+
+#include <string.h>
+
+static inline void
+_set_first_byte(MultiLinePrefilter *self, guchar c)
+{
+  self->first_bytes[c / 8] |= 1 << (c % 8);
+}
+
+static inline gboolean
+_is_first_byte(const MultiLinePrefilter *self, guchar c)
+{
+  return self->first_bytes[c / 8] & (1 << (c % 8));
+}
+
+static void
+_collect_first_byte_chars(MultiLinePrefilter *self)
+{
+  self->first_bytes_count = 0;
+  for (gint c = 0; c < 256; c++)
+    {
+      if (!_is_first_byte(self, c))
+        continue;
+
+      if (self->first_bytes_count < G_N_ELEMENTS(self->first_byte_chars))
+        self->first_byte_chars[self->first_bytes_count] = c;
+      self->first_bytes_count++;
+    }
+}
+
+static void
+_init_from_pattern_info(MultiLinePrefilter *self, pcre2_code *pattern)
+{
+  uint32_t value;
+
+  if (pcre2_pattern_info(pattern, PCRE2_INFO_ALLOPTIONS, &value) == 0)
+    self->anchored = !!(value & PCRE2_ANCHORED);
+
+  if (pcre2_pattern_info(pattern, PCRE2_INFO_MINLENGTH, &value) == 0)
+    self->min_length = value;
+
+  /* PCRE2 does not tell whether the first/last code units are caseless,
+   * so we always accept both cases */
+  if (pcre2_pattern_info(pattern, PCRE2_INFO_FIRSTCODETYPE, &value) == 0 && value == 1)
+    {
+      pcre2_pattern_info(pattern, PCRE2_INFO_FIRSTCODEUNIT, &value);
+      self->first_bytes_known = TRUE;
+      _set_first_byte(self, g_ascii_tolower(value));
+      _set_first_byte(self, g_ascii_toupper(value));
+    }
+  else
+    {
+      const uint8_t *bitmap = NULL;
+
+      if (pcre2_pattern_info(pattern, PCRE2_INFO_FIRSTBITMAP, &bitmap) == 0 && bitmap)
+        {
+          self->first_bytes_known = TRUE;
+          memcpy(self->first_bytes, bitmap, sizeof(self->first_bytes));
+        }
+    }
+  if (self->first_bytes_known)
+    _collect_first_byte_chars(self);
+
+  if (pcre2_pattern_info(pattern, PCRE2_INFO_LASTCODETYPE, &value) == 0 && value == 1)
+    {
+      pcre2_pattern_info(pattern, PCRE2_INFO_LASTCODEUNIT, &value);
+      self->required_byte = g_ascii_tolower(value);
+      self->required_byte_other_case = g_ascii_toupper(value);
+    }
+}
+
+/*
+ * Literal extraction
+ *
+ * We look at the top level sequence of the regexp only: runs of literal
+ * characters are collected, anything else (groups, classes, escapes
+ * matching a class of characters, quantifiers, ...) terminates a run.  As
+ * long as there is no top level alternation, every run has to be present
+ * in a match, and if the pattern is anchored, the run right after the '^'
+ * is a prefix of the match.  We use the prefix if there is one, the
+ * longest run otherwise.  Patterns that change the matching semantics
+ * (inline options, \Q..\E, verbs) are not analyzed at all.
+ */
+
+static gboolean
+_has_inline_options(const gchar *regexp)
+{
+  for (const gchar *p = regexp; *p; p++)
+    {
+      if (*p == '\\' && p[1])
+        {
+          p++;
+          continue;
+        }
+      if (*p == '(' && (p[1] == '*' || (p[1] == '?' && p[2] && strchr("imnsxJU-^", p[2]))))
+        return TRUE;
+    }
+  return FALSE;
+}
+
+static const gchar *
+_skip_class(const gchar *p)
+{
+  /* p points to the opening '[' */
+  p++;
+  if (*p == '^')
+    p++;
+  if (*p == ']')
+    p++;
+  while (*p && *p != ']')
+    {
+      if (*p == '\\' && p[1])
+        p++;
+      p++;
+    }
+  return *p ? p + 1 : p;
+}
+
+static const gchar *
+_skip_group(const gchar *p)
+{
+  gint depth = 0;
+
+  do
+    {
+      if (*p == '\\' && p[1])
+        p += 2;
+      else if (*p == '[')
+        p = _skip_class(p);
+      else
+        {
+          if (*p == '(')
+            depth++;
+          else if (*p == ')')
+            depth--;
+          p++;
+        }
+    }
+  while (*p && depth > 0);
+  return p;
+}
+
+static const gchar *
+_skip_counted_repeat(const gchar *p)
+{
+  /* p points to the opening '{', which is a literal if it does not start
+   * a valid repeat, in which case we just step over it */
+  const gchar *q = p + 1;
+
+  while (g_ascii_isdigit(*q) || *q == ',' || *q == ' ')
+    q++;
+  if (*q == '}' && q > p + 1)
+    return q + 1;
+  return p + 1;
+}
+
+/* returns the literal character for an escape sequence, 0 if it matches
+ * something else, -1 if we can't tell */
+static gint
+_decode_escape(gchar c)
+{
+  if (!g_ascii_isalnum(c))
+    return c;
+
+  switch (c)
+    {
+    case 't':
+      return '\t';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 'f':
+      return '\f';
+    case 'e':
+      return '\x1b';
+    case 'a':
+      return '\a';
+    default:
+      break;
+    }
+
+  if (strchr("dDsSwWbBhHvVAzZGRXK", c))
+    return 0;
+  return -1;
+}
+
+typedef struct _LiteralRuns
+{
+  gboolean in_prefix;
+  GString *run;
+  GString *prefix;
+  GString *longest;
+} LiteralRuns;
+
+static void
+_end_run(LiteralRuns *runs)
+{
+  if (runs->in_prefix)
+    {
+      g_string_assign(runs->prefix, runs->run->str);
+      runs->in_prefix = FALSE;
+    }
+  if (runs->run->len > runs->longest->len)
+    g_string_assign(runs->longest, runs->run->str);
+  g_string_truncate(runs->run, 0);
+}
+
+static gboolean
+_scan_literal_runs(LiteralRuns *runs, const gchar *regexp, gboolean anchored)
+{
+  const gchar *p = regexp;
+
+  if (anchored && *p == '^')
+    {
+      p++;
+      runs->in_prefix = TRUE;
+    }
+
+  while (*p)
+    {
+      switch (*p)
+        {
+        case '|':
+          return FALSE;
+        case '\\':
+        {
+          gint c = _decode_escape(p[1]);
+
+          if (c < 0 || p[1] == 0)
+            return FALSE;
+          /* NUL bytes would terminate our literal */
+          if (c == 0)
+            _end_run(runs);
+          else
+            g_string_append_c(runs->run, c);
+          p += 2;
+          break;
+        }
+        case '[':
+          _end_run(runs);
+          p = _skip_class(p);
+          break;
+        case '(':
+          _end_run(runs);
+          p = _skip_group(p);
+          break;
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+          /* the preceding character is optional or repeated */
+          if (runs->run->len > 0)
+            g_string_truncate(runs->run, runs->run->len - 1);
+          _end_run(runs);
+          p = (*p == '{') ? _skip_counted_repeat(p) : p + 1;
+          break;
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+          _end_run(runs);
+          p++;
+          break;
+        default:
+          g_string_append_c(runs->run, *p);
+          p++;
+          break;
+        }
+    }
+  _end_run(runs);
+  return TRUE;
+}
+
+static void
+_init_literal(MultiLinePrefilter *self, const gchar *regexp)
+{
+  if (_has_inline_options(regexp))
+    return;
+
+  LiteralRuns runs =
+  {
+    .run = g_string_new(NULL),
+    .prefix = g_string_new(NULL),
+    .longest = g_string_new(NULL),
+  };
+
+  if (_scan_literal_runs(&runs, regexp, self->anchored))
+    {
+      GString *literal = runs.prefix->len > 0 ? runs.prefix : runs.longest;
+
+      self->literal_is_prefix = runs.prefix->len > 0;
+      self->literal_len = literal->len;
+      self->literal = self->literal_len > 0 ? g_strndup(literal->str, literal->len) : NULL;
+    }
+  g_string_free(runs.run, TRUE);
+  g_string_free(runs.prefix, TRUE);
+  g_string_free(runs.longest, TRUE);
+}
+
+void
+multi_line_prefilter_init(MultiLinePrefilter *self, const gchar *regexp, pcre2_code *pattern)
+{
+  memset(self, 0, sizeof(*self));
+  self->required_byte = -1;
+  self->required_byte_other_case = -1;
+
+  _init_from_pattern_info(self, pattern);
+  _init_literal(self, regexp);
+}
+
+void
+multi_line_prefilter_clear(MultiLinePrefilter *self)
+{
+  g_free(self->literal);
+  self->literal = NULL;
+  self->literal_len = 0;
+  self->literal_is_prefix = FALSE;
+}
+
+static gboolean
+_contains_literal(const MultiLinePrefilter *self, const guchar *str, gsize len)
+{
+  const guchar *end = str + len;
+  const guchar *p = str;
+
+  while ((gsize) (end - p) >= self->literal_len)
+    {
+      p = memchr(p, self->literal[0], end - p - self->literal_len + 1);
+      if (!p)
+        return FALSE;
+      if (memcmp(p + 1, self->literal + 1, self->literal_len - 1) == 0)
+        return TRUE;
+      p++;
+    }
+  return FALSE;
+}
+
+static gboolean
+_contains_first_byte(const MultiLinePrefilter *self, const guchar *str, gsize len)
+{
+  switch (self->first_bytes_count)
+    {
+    case 1:
+      return memchr(str, self->first_byte_chars[0], len) != NULL;
+    case 2:
+      return memchr(str, self->first_byte_chars[0], len) || memchr(str, self->first_byte_chars[1], len);
+    default:
+      for (gsize i = 0; i < len; i++)
+        {
+          if (_is_first_byte(self, str[i]))
+            return TRUE;
+        }
+      return FALSE;
+    }
+}
+
+static gboolean
+_contains_required_byte(const MultiLinePrefilter *self, const guchar *str, gsize len)
+{
+  return memchr(str, self->required_byte, len) ||
+         (self->required_byte_other_case != self->required_byte && memchr(str, self->required_byte_other_case, len));
+}
+
+gboolean
+multi_line_prefilter_rejects(const MultiLinePrefilter *self, const guchar *str, gsize len)
+{
+  if (len < self->min_length)
+    return TRUE;
+
+  if (self->literal_is_prefix)
+    {
+      if (len < self->literal_len || memcmp(str, self->literal, self->literal_len) != 0)
+        return TRUE;
+    }
+  else if (self->literal_len > 0 && !_contains_literal(self, str, len))
+    {
+      return TRUE;
+    }
+
+  if (self->first_bytes_known && len > 0)
+    {
+      if (self->anchored && !_is_first_byte(self, str[0]))
+        return TRUE;
+      if (!self->anchored && self->literal_len == 0 && !_contains_first_byte(self, str, len))
+        return TRUE;
+    }
+
+  if (self->required_byte >= 0 && !_contains_required_byte(self, str, len))
+    return TRUE;
+
+  return FALSE;
+}
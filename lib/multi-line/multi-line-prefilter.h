@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef MULTI_LINE_MULTI_LINE_PREFILTER_H_INCLUDED
+#define MULTI_LINE_MULTI_LINE_PREFILTER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "compat/pcre.h"
+
+/*
+ * Cheap checks derived from a multi-line regexp, so that most of the lines
+ * that can't match are rejected with a few memcmp()/memchr() calls,
+ * without setting up a PCRE2 match.  A prefilter never rejects a line
+ * that the regexp would match, it may accept lines that it won't.
+ */
+typedef struct _MultiLinePrefilter
+{
+  /* matches can only start at the beginning of the line */
+  gboolean anchored;
+  gsize min_length;
+
+  /* literal that every match starts with (literal_is_prefix), or
+   * contains somewhere otherwise */
+  gchar *literal;
+  gsize literal_len;
+  gboolean literal_is_prefix;
+
+  /* the set of bytes a match may start with */
+  gboolean first_bytes_known;
+  guint8 first_bytes[32];
+  /* the members of first_bytes if there are at most two of them */
+  gint first_bytes_count;
+  guchar first_byte_chars[2];
+
+  /* a byte every match contains (in either case), -1 if unknown */
+  gint required_byte;
+  gint required_byte_other_case;
+} MultiLinePrefilter;
+
+void multi_line_prefilter_init(MultiLinePrefilter *self, const gchar *regexp, pcre2_code *pattern);
+void multi_line_prefilter_clear(MultiLinePrefilter *self);
+
+gboolean multi_line_prefilter_rejects(const MultiLinePrefilter *self, const guchar *str, gsize len);
+
+#endif
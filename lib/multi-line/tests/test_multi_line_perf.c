@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "multi-line/smart-multi-line.h"
+#include "multi-line/regexp-multi-line.h"
+#include "timeutils/misc.h"
+#include "apphook.h"
+#include "reloc.h"
+
+#include <stdio.h>
+
+/* mostly regular log lines, with a few backtraces in between, which is
+ * what a multi-line source usually sees */
+static const gchar *corpus[] =
+{
+  "Jan  1 00:00:00 localhost sshd[1234]: Accepted publickey for root from 10.0.0.1 port 51234 ssh2",
+  "2024-01-01T00:00:01.123Z INFO  [main] com.example.Server - listening on port 8080",
+  "2024-01-01T00:00:02.456Z DEBUG [worker-1] com.example.Handler - request processed in 12ms",
+  "Exception in thread \"main\" java.lang.IllegalStateException: something went wrong",
+  "\tat com.example.Foo.bar(Foo.java:12)",
+  "\tat com.example.Foo.main(Foo.java:5)",
+  "Caused by: java.lang.NullPointerException",
+  "\tat com.example.Bar.baz(Bar.java:42)",
+  "\t... 2 more",
+  "2024-01-01T00:00:03.789Z WARN  [worker-2] com.example.Handler - slow request, took 1234ms",
+  "10.100.20.1 - - [31/Dec/2007:00:17:10 +0100] \"GET /index.html HTTP/1.1\" 200 2708 \"-\" \"curl/7.15.5\"",
+  "Traceback (most recent call last):",
+  "  File \"/usr/lib/python3/dist-packages/foo.py\", line 12, in <module>",
+  "    main()",
+  "  File \"/usr/lib/python3/dist-packages/foo.py\", line 8, in main",
+  "    raise ValueError(\"boom\")",
+  "ValueError: boom",
+  "2024-01-01T00:00:04.012Z INFO  [main] com.example.Server - shutting down",
+  "Jan  1 00:00:05 localhost kernel: [12345.678901] eth0: link up, 1000Mbps, full-duplex",
+  "Jan  1 00:00:06 localhost systemd[1]: Started Session 42 of user root.",
+  NULL
+};
+
+#define ITERATIONS 20000
+
+static void
+_feed_corpus(MultiLineLogic *mll, GString *buffer)
+{
+  for (gint i = 0; corpus[i]; i++)
+    {
+      const gchar *line = corpus[i];
+      gsize line_len = strlen(line);
+      gboolean repeat;
+
+      do
+        {
+          gint verdict = multi_line_logic_accumulate_line(mll, (const guchar *) buffer->str, buffer->len,
+                                                          (const guchar *) line, line_len);
+          repeat = FALSE;
+
+          if (verdict & MLL_CONSUME_SEGMENT)
+            {
+              g_string_append_len(buffer, line, line_len);
+              if (verdict & MLL_EXTRACTED)
+                g_string_truncate(buffer, 0);
+            }
+          else if (verdict & MLL_REWIND_SEGMENT)
+            {
+              g_string_truncate(buffer, 0);
+              repeat = TRUE;
+            }
+        }
+      while (repeat);
+    }
+}
+
+static void
+_perftest(const gchar *name, MultiLineLogic *mll)
+{
+  GString *buffer = g_string_sized_new(4096);
+  struct timespec start, end;
+  gint lines = 0;
+
+  for (gint i = 0; corpus[i]; i++)
+    lines++;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (gint i = 0; i < ITERATIONS; i++)
+    _feed_corpus(mll, buffer);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("      %-40s speed: %12.3f lines/sec\n", name, (gdouble) lines * ITERATIONS * 1e6 / timespec_diff_usec(&end, &start));
+
+  g_string_free(buffer, TRUE);
+  multi_line_logic_free(mll);
+}
+
+static MultiLineLogic *
+_construct_regexp_multi_line(gint mode, const gchar *prefix, const gchar *garbage_or_suffix)
+{
+  MultiLinePattern *prefix_pattern = multi_line_pattern_compile(prefix, NULL);
+  MultiLinePattern *garbage_pattern = garbage_or_suffix ? multi_line_pattern_compile(garbage_or_suffix, NULL) : NULL;
+  MultiLineLogic *mll = regexp_multi_line_new(mode, prefix_pattern, garbage_pattern);
+
+  multi_line_pattern_unref(prefix_pattern);
+  multi_line_pattern_unref(garbage_pattern);
+  return mll;
+}
+
+Test(multi_line_perf, test_smart_multi_line_performance)
+{
+  _perftest("smart-multi-line", smart_multi_line_new());
+}
+
+Test(multi_line_perf, test_regexp_multi_line_performance)
+{
+  _perftest("prefix-garbage, literal prefix",
+            _construct_regexp_multi_line(RML_PREFIX_GARBAGE, "^Traceback \\(most recent call last\\):$", "^ValueError: "));
+  _perftest("prefix-garbage, timestamp prefix",
+            _construct_regexp_multi_line(RML_PREFIX_GARBAGE, "^\\d{4}-\\d{2}-\\d{2}T", NULL));
+  _perftest("prefix-suffix, unanchored literals",
+            _construct_regexp_multi_line(RML_PREFIX_SUFFIX, "Exception in thread ", "\\.\\.\\. \\d+ more"));
+}
+
+static void
+setup(void)
+{
+  override_installation_path_for("${pkgdatadir}/smart-multi-line.fsm", TOP_SRCDIR "/lib/multi-line/smart-multi-line.fsm");
+  app_startup();
+}
+
+TestSuite(multi_line_perf, .init = setup, .fini = app_shutdown);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "multi-line/multi-line-pattern.h"
+#include "apphook.h"
+
+static MultiLinePattern *
+_compile(const gchar *regexp)
+{
+  GError *error = NULL;
+  MultiLinePattern *pattern = multi_line_pattern_compile(regexp, &error);
+
+  cr_assert_not_null(pattern, "error compiling pattern %s: %s", regexp, error ? error->message : "n/a");
+  return pattern;
+}
+
+static void
+_assert_literal(const gchar *regexp, const gchar *expected_literal, gboolean expected_is_prefix)
+{
+  MultiLinePattern *pattern = _compile(regexp);
+  MultiLinePrefilter *prefilter = &pattern->prefilter;
+
+  if (!expected_literal)
+    {
+      cr_assert_eq(prefilter->literal_len, 0, "unexpected literal extracted from %s: %s", regexp, prefilter->literal);
+    }
+  else
+    {
+      cr_assert_eq(prefilter->literal_len, strlen(expected_literal), "bad literal extracted from %s", regexp);
+      cr_assert(memcmp(prefilter->literal, expected_literal, prefilter->literal_len) == 0,
+                "bad literal extracted from %s: %.*s, expected: %s",
+                regexp, (gint) prefilter->literal_len, prefilter->literal, expected_literal);
+      cr_assert_eq(prefilter->literal_is_prefix, expected_is_prefix, "bad literal position for %s", regexp);
+    }
+  multi_line_pattern_unref(pattern);
+}
+
+Test(multi_line_prefilter, test_literal_extraction)
+{
+  _assert_literal("^Traceback \\(most recent call last\\):$", "Traceback (most recent call last):", TRUE);
+  _assert_literal("^Stack trace:", "Stack trace:", TRUE);
+  _assert_literal("^goroutine \\d+ \\[[^\\]]+\\]:$", "goroutine ", TRUE);
+  _assert_literal("^[\\t ]*File ", "File ", FALSE);
+  _assert_literal("\\bpanic: ", "panic: ", FALSE);
+  _assert_literal("http: panic serving", "http: panic serving", FALSE);
+  _assert_literal("Error \\(.*\\):$", "Error (", FALSE);
+
+  /* quantifiers apply to the preceding character only */
+  _assert_literal("^abc*d", "ab", TRUE);
+  _assert_literal("^a?bcd", "bcd", FALSE);
+  _assert_literal("^a{2}bc", "bc", FALSE);
+  _assert_literal("^(?:foo)+bar", "bar", FALSE);
+
+  /* alternatives, inline options and unknown escapes disable extraction */
+  _assert_literal("^foo|^bar", NULL, FALSE);
+  _assert_literal("(?i)foo", NULL, FALSE);
+  _assert_literal("(*UTF)foo", NULL, FALSE);
+  _assert_literal("foo\\x41bar", NULL, FALSE);
+  _assert_literal("\\Qfoo\\E", NULL, FALSE);
+
+  /* alternatives within groups don't matter */
+  _assert_literal("^(?:Caused by|Suppressed): ", ": ", FALSE);
+  _assert_literal("^[\\r\\n]*$", NULL, FALSE);
+}
+
+static void
+_assert_prefilter_is_consistent(const gchar *regexp, const gchar *lines[])
+{
+  MultiLinePattern *pattern = _compile(regexp);
+
+  for (gint i = 0; lines[i]; i++)
+    {
+      const guchar *line = (const guchar *) lines[i];
+      gsize line_len = strlen(lines[i]);
+      pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(pattern->pattern, NULL);
+      gboolean expected = pcre2_match(pattern->pattern, line, line_len, 0, 0, match_data, NULL) >= 0;
+
+      pcre2_match_data_free(match_data);
+      cr_assert_eq(multi_line_pattern_match(pattern, line, line_len), expected,
+                   "prefilter changed the result of matching %s against %s", regexp, lines[i]);
+      if (expected)
+        cr_assert_not(multi_line_prefilter_rejects(&pattern->prefilter, line, line_len),
+                      "prefilter rejected a matching line, regexp: %s, line: %s", regexp, lines[i]);
+    }
+  multi_line_pattern_unref(pattern);
+}
+
+Test(multi_line_prefilter, test_prefilter_never_rejects_a_match)
+{
+  const gchar *lines[] =
+  {
+    "",
+    " ",
+    "Traceback (most recent call last):",
+    "traceback (most recent call last):",
+    "  File \"/usr/lib/python3/foo.py\", line 12, in <module>",
+    "\tat com.example.Foo.bar(Foo.java:12)",
+    "Caused by: java.lang.NullPointerException",
+    "\t... 12 more",
+    "panic: runtime error: index out of range",
+    "goroutine 1 [running]:",
+    "Stack trace:",
+    "#0 /var/www/index.php(12): foo()",
+    "Exception in thread \"main\" java.lang.RuntimeException: boom",
+    "ERROR in foo",
+    "error in foo",
+    "Jan 1 00:00:00 localhost sshd[123]: Accepted publickey for root",
+    NULL
+  };
+
+  _assert_prefilter_is_consistent("^Traceback \\(most recent call last\\):$", lines);
+  _assert_prefilter_is_consistent("^[\\t ]*File ", lines);
+  _assert_prefilter_is_consistent("^[\\t ]+(?:eval )?at ", lines);
+  _assert_prefilter_is_consistent("^[\\t ]*(?:Caused by|Suppressed):", lines);
+  _assert_prefilter_is_consistent("^[\\t ]*... \\d+ (?:more|common frames omitted)", lines);
+  _assert_prefilter_is_consistent("\\bpanic: ", lines);
+  _assert_prefilter_is_consistent("^goroutine \\d+ \\[[^\\]]+\\]:$", lines);
+  _assert_prefilter_is_consistent("^#\\d", lines);
+  _assert_prefilter_is_consistent("(?:Exception|Error|Throwable)[:\\r\\n]", lines);
+  _assert_prefilter_is_consistent("(?i)error", lines);
+  _assert_prefilter_is_consistent("[Ee]rror", lines);
+  _assert_prefilter_is_consistent("^$", lines);
+  _assert_prefilter_is_consistent("^\\s", lines);
+  _assert_prefilter_is_consistent("[^\\t ]", lines);
+}
+
+TestSuite(multi_line_prefilter, .init = app_startup, .fini = app_shutdown);
@@ -126,8 +126,8 @@ _register_counters(LogParser *self)
   StatsClusterLabel labels[] = { stats_cluster_label("id", self->name) };
   stats_cluster_logpipe_key_set(&sc_key, "parsed_events_total", labels, G_N_ELEMENTS(labels));
   stats_cluster_logpipe_key_add_legacy_alias(&sc_key, SCS_PARSER, self->name, NULL );
-  stats_register_counter(level, &sc_key, SC_TYPE_DISCARDED, &self->super.discarded_messages);
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->processed_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_DISCARDED, &self->super.discarded_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->processed_messages);
   stats_unlock();
 }
 
@@ -33,6 +33,35 @@
  * CSVScannerOptions
  ************************************************************************/
 
+static void
+_update_unquoted_stop_chars(CSVScannerOptions *options)
+{
+  g_free(options->unquoted_stop_chars);
+  options->unquoted_stop_chars = NULL;
+
+  if (!options->delimiters)
+    return;
+
+  GString *stop_chars = g_string_new(options->delimiters);
+  for (GList *l = options->string_delimiters; l; l = l->next)
+    {
+      const gchar *string_delimiter = (const gchar *) l->data;
+
+      /* an empty delimiter matches anywhere */
+      if (!string_delimiter[0])
+        {
+          g_string_free(stop_chars, TRUE);
+          return;
+        }
+      g_string_append_c(stop_chars, string_delimiter[0]);
+    }
+
+  if (options->dialect == CSV_SCANNER_ESCAPE_UNQUOTED_DELIMITER)
+    g_string_append_c(stop_chars, '\\');
+
+  options->unquoted_stop_chars = g_string_free(stop_chars, FALSE);
+}
+
 void
 csv_scanner_options_set_flags(CSVScannerOptions *options, guint32 flags)
 {
@@ -43,6 +72,7 @@ void
 csv_scanner_options_set_dialect(CSVScannerOptions *options, CSVScannerDialect dialect)
 {
   options->dialect = dialect;
+  _update_unquoted_stop_chars(options);
 }
 
 void
@@ -50,6 +80,7 @@ csv_scanner_options_set_delimiters(CSVScannerOptions *options, const gchar *deli
 {
   g_free(options->delimiters);
   options->delimiters = g_strdup(delimiters);
+  _update_unquoted_stop_chars(options);
 }
 
 void
@@ -57,6 +88,7 @@ csv_scanner_options_set_string_delimiters(CSVScannerOptions *options, GList *str
 {
   string_list_free(options->string_delimiters);
   options->string_delimiters = string_delimiters;
+  _update_unquoted_stop_chars(options);
 }
 
 void
@@ -117,7 +149,7 @@ csv_scanner_options_copy(CSVScannerOptions *dst, CSVScannerOptions *src)
   csv_scanner_options_set_null_value(dst, src->null_value);
   csv_scanner_options_set_string_delimiters(dst, string_list_clone(src->string_delimiters));
   csv_scanner_options_set_expected_columns(dst, src->expected_columns);
-  dst->dialect = src->dialect;
+  csv_scanner_options_set_dialect(dst, src->dialect);
   dst->flags = src->flags;
 }
 
@@ -128,6 +160,7 @@ csv_scanner_options_clean(CSVScannerOptions *options)
   g_free(options->quotes_end);
   g_free(options->null_value);
   g_free(options->delimiters);
+  g_free(options->unquoted_stop_chars);
   string_list_free(options->string_delimiters);
 }
 
@@ -228,6 +261,30 @@ _decode_xbyte(gchar xdigit1, gchar xdigit2)
   return (nibble_hi << 4) + nibble_lo;
 }
 
+/* Literal characters are copied in runs, up to the next character that
+ * needs attention.  strcspn() is vectorized in most libcs, which makes
+ * this a lot faster than going through the characters one by one.  */
+static inline void
+_append_literal_run(CSVScanner *self, const gchar *stop_chars)
+{
+  gsize len = 1 + strcspn(self->src + 1, stop_chars);
+
+  g_string_append_len(self->current_value, self->src, len);
+  self->src += len;
+}
+
+static void
+_parse_quoted_literal_characters(CSVScanner *self)
+{
+  gchar stop_chars[] = { self->current_quote, 0, 0 };
+
+  if (self->options->dialect == CSV_SCANNER_ESCAPE_BACKSLASH ||
+      self->options->dialect == CSV_SCANNER_ESCAPE_BACKSLASH_WITH_SEQUENCES)
+    stop_chars[1] = '\\';
+
+  _append_literal_run(self, stop_chars);
+}
+
 static void
 _parse_character_with_quotation(CSVScanner *self)
 {
@@ -298,7 +355,8 @@ _parse_character_with_quotation(CSVScanner *self)
     }
   else
     {
-      ch = *self->src;
+      _parse_quoted_literal_characters(self);
+      return;
     }
   g_string_append_c(self->current_value, ch);
   self->src++;
@@ -377,10 +435,16 @@ _parse_delimiter(CSVScanner *self)
 }
 
 static void
-_parse_unquoted_literal_character(CSVScanner *self)
+_parse_unquoted_literal_characters(CSVScanner *self)
 {
-  g_string_append_c(self->current_value, *self->src);
-  self->src++;
+  if (!self->options->unquoted_stop_chars)
+    {
+      g_string_append_c(self->current_value, *self->src);
+      self->src++;
+      return;
+    }
+
+  _append_literal_run(self, self->options->unquoted_stop_chars);
 }
 
 static void
@@ -398,7 +462,7 @@ _parse_value_with_whitespace_and_delimiter(CSVScanner *self)
           /* unquoted value */
           if (_parse_delimiter(self))
             break;
-          _parse_unquoted_literal_character(self);
+          _parse_unquoted_literal_characters(self);
         }
     }
 }
@@ -489,6 +553,7 @@ gboolean
 csv_scanner_take_rest(CSVScanner *self)
 {
   _parse_left_whitespace(self);
+  self->current_value_start = self->src;
   g_string_assign(self->current_value, self->src);
   self->src += self->current_value->len;
   self->state = CSV_STATE_GREEDY_COLUMN;
@@ -516,6 +581,7 @@ csv_scanner_scan_next(CSVScanner *self)
     {
       _parse_opening_quote_character(self);
       _parse_left_whitespace(self);
+      self->current_value_start = self->src;
       _parse_value_with_whitespace_and_delimiter(self);
       _translate_value(self);
       return TRUE;
@@ -566,6 +632,21 @@ csv_scanner_get_current_value_len(CSVScanner *self)
   return self->current_value->len;
 }
 
+/* returns the current value within the input if the input contains it
+ * verbatim (e.g. there were no escapes to decode), NULL otherwise */
+const gchar *
+csv_scanner_get_current_value_slice(CSVScanner *self)
+{
+  const gchar *value_start = self->current_value_start;
+
+  /* comparing against the consumed part of the input catches the escapes
+   * that were decoded and the null-value() translation */
+  if (value_start && value_start + self->current_value->len <= self->src &&
+      memcmp(value_start, self->current_value->str, self->current_value->len) == 0)
+    return value_start;
+  return NULL;
+}
+
 gchar *
 csv_scanner_dup_current_value(CSVScanner *self)
 {
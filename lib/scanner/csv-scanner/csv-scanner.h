@@ -50,6 +50,10 @@ typedef struct _CSVScannerOptions
   CSVScannerDialect dialect;
   gint expected_columns;
   guint32 flags;
+
+  /* characters that may end a run of unquoted literals, derived from the
+   * options above, NULL if unknown */
+  gchar *unquoted_stop_chars;
 } CSVScannerOptions;
 
 void csv_scanner_options_clean(CSVScannerOptions *options);
@@ -80,6 +84,8 @@ typedef struct
   } state;
   const gchar *src;
   GString *current_value;
+  /* where the current value starts in the input */
+  const gchar *current_value_start;
   gint current_column;
   gchar current_quote;
 } CSVScanner;
@@ -87,6 +93,7 @@ typedef struct
 gint csv_scanner_get_current_column(CSVScanner *self);
 const gchar *csv_scanner_get_current_value(CSVScanner *pstate);
 gint csv_scanner_get_current_value_len(CSVScanner *self);
+const gchar *csv_scanner_get_current_value_slice(CSVScanner *self);
 gboolean csv_scanner_scan_next(CSVScanner *pstate);
 gboolean csv_scanner_is_scan_complete(CSVScanner *pstate);
 gchar *csv_scanner_dup_current_value(CSVScanner *self);
@@ -21,6 +21,7 @@
  *
  */
 #include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
 #include <stdio.h>
 
 #include "scratch-buffers.h"
@@ -506,6 +507,61 @@ Test(csv_scanner, escaped_unquoted_delimiter)
   csv_scanner_deinit(&scanner);
 }
 
+Test(csv_scanner, string_delimiters_are_found_within_long_values)
+{
+  _default_options_with_flags(3, CSV_SCANNER_STRIP_WHITESPACE);
+
+  csv_scanner_options_set_string_delimiters(&options, string_vargs_to_list("::", NULL));
+  csv_scanner_init(&scanner, &options, "first value:with:colons::second value,\"third, quoted::\"");
+
+  cr_expect(_scan_next());
+  cr_expect(_column_equals(0, "first value:with:colons"));
+
+  cr_expect(_scan_next());
+  cr_expect(_column_equals(1, "second value"));
+
+  cr_expect(_scan_next());
+  cr_expect(_column_equals(2, "third, quoted::"));
+
+  cr_expect(!_scan_next());
+  cr_expect(_scan_complete());
+  csv_scanner_deinit(&scanner);
+}
+
+static const gchar *performance_corpus[] =
+{
+  "127.0.0.1,-,frank,[10/Oct/2000:13:55:36 -0700],\"GET /apache_pb.gif HTTP/1.0\",200,2326,"
+  "\"http://www.example.com/start.html\",\"Mozilla/4.08 [en] (Win98; I ;Nav)\"",
+  "192.168.10.215,-,-,[08/Jul/2016:13:42:58 +0200],\"POST /api/v1/sessions?user=demo HTTP/1.1\",201,512,"
+  "\"-\",\"curl/7.47.0\"",
+  "10.2.3.64,-,\"DEMO\"\"primarystudent\",[08/Jul/2016:13:42:58 +0200],"
+  "\"GET /search?q=a%2Cb%2Cc&page=2 HTTP/1.1\",404,0,\"https://sls.update.microsoft.com/\","
+  "\"Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/51.0.2704.103 Safari/537.36\"",
+  NULL
+};
+
+#define ITERATION_NUMBER 100000
+
+Test(csv_scanner, performance_tests)
+{
+  for (const gchar **input = performance_corpus; *input; input++)
+    {
+      gint iteration_index;
+
+      start_stopwatch();
+      for (iteration_index = 0; iteration_index < ITERATION_NUMBER; iteration_index++)
+        {
+          csv_scanner_init(&scanner, _default_options(9), *input);
+          while (_scan_next())
+            ;
+          cr_assert(_scan_complete(), "scanning performance test input failed: %s", *input);
+          csv_scanner_deinit(&scanner);
+          scratch_buffers_explicit_gc();
+        }
+      stop_stopwatch_and_display_result(iteration_index, "%.64s...", *input);
+    }
+}
+
 static void
 setup(void)
 {
@@ -289,7 +289,10 @@ _extract_value(KVScanner *self)
 {
   self->value_was_quoted = FALSE;
   _skip_initial_spaces(self);
+  self->value_start = &self->input[self->input_pos];
   _decode_value(self);
+  if (self->value_was_quoted)
+    self->value_start++;
 }
 
 static inline void
@@ -322,6 +325,21 @@ kv_scanner_scan_next(KVScanner *s)
   return TRUE;
 }
 
+/* returns the current value within the input if the input contains it
+ * verbatim (e.g. there were no escapes to decode), NULL otherwise */
+const gchar *
+kv_scanner_get_current_value_slice(KVScanner *self)
+{
+  const gchar *value_end = &self->input[self->input_pos];
+
+  /* comparing against the consumed part of the input catches anything the
+   * decoder or the transform function has changed */
+  if (self->value_start + self->value->len <= value_end &&
+      memcmp(self->value_start, self->value->str, self->value->len) == 0)
+    return self->value_start;
+  return NULL;
+}
+
 void
 kv_scanner_deinit(KVScanner *self)
 {
@@ -39,6 +39,8 @@ struct _KVScanner
   gsize input_pos;
   GString *key;
   GString *value;
+  /* where the current value starts in the input */
+  const gchar *value_start;
   GString *decoded_value;
   GString *stray_words;
   gboolean value_was_quoted;
@@ -125,5 +127,6 @@ kv_scanner_set_stop_character(KVScanner *self, gchar stop_char)
 }
 
 gboolean kv_scanner_scan_next(KVScanner *self);
+const gchar *kv_scanner_get_current_value_slice(KVScanner *self);
 
 #endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-cluster-histogram.h"
+#include "stats/stats-cluster.h"
+
+static const gchar *tag_names[SC_TYPE_HISTOGRAM_MAX] =
+{
+  "le_1", "le_2", "le_5",
+  "le_10", "le_20", "le_50",
+  "le_100", "le_200", "le_500",
+  "le_1000", "le_2000", "le_5000",
+  "le_10000", "le_20000", "le_50000",
+  "le_100000", "le_200000", "le_500000",
+  "le_1000000", "le_2000000", "le_5000000",
+  "le_10000000", "le_20000000", "le_50000000",
+  /* [SC_TYPE_HISTOGRAM_BUCKET_INF] = */ "le_inf",
+  /* [SC_TYPE_HISTOGRAM_SUM]        = */ "sum",
+  /* [SC_TYPE_HISTOGRAM_COUNT]      = */ "count",
+};
+
+static const gsize bucket_bounds[STATS_HISTOGRAM_BOUNDS] =
+{
+  1, 2, 5,
+  10, 20, 50,
+  100, 200, 500,
+  1000, 2000, 5000,
+  10000, 20000, 50000,
+  100000, 200000, 500000,
+  1000000, 2000000, 5000000,
+  10000000, 20000000, 50000000,
+};
+
+static void
+_counter_group_free(StatsCounterGroup *counter_group)
+{
+  g_free(counter_group->counters);
+}
+
+static void
+_counter_group_init(StatsCounterGroupInit *self, StatsCounterGroup *counter_group)
+{
+  counter_group->counters = g_new0(StatsCounterItem, SC_TYPE_HISTOGRAM_MAX);
+  counter_group->capacity = SC_TYPE_HISTOGRAM_MAX;
+  counter_group->counter_names = self->counter.names;
+  counter_group->free_fn = _counter_group_free;
+}
+
+void
+stats_cluster_histogram_key_set(StatsClusterKey *key, const gchar *name, StatsClusterLabel *labels, gsize labels_len)
+{
+  stats_cluster_key_set(key, name, labels, labels_len, (StatsCounterGroupInit)
+  {
+    .counter.names = tag_names, .init = _counter_group_init, .equals = NULL
+  });
+}
+
+gboolean
+stats_cluster_is_histogram(StatsCluster *self)
+{
+  return self->key.counter_group_init.init == _counter_group_init;
+}
+
+gsize
+stats_cluster_histogram_get_bucket_bound(gint type)
+{
+  g_assert(type >= SC_TYPE_HISTOGRAM_BUCKET_FIRST && type < SC_TYPE_HISTOGRAM_BUCKET_INF);
+
+  return bucket_bounds[type - SC_TYPE_HISTOGRAM_BUCKET_FIRST];
+}
+
+/* buckets are stored individually, exporters usually need the number of
+ * observations less than or equal to the bound of @type */
+gsize
+stats_cluster_histogram_get_cumulative_count(StatsCluster *self, gint type)
+{
+  g_assert(type >= SC_TYPE_HISTOGRAM_BUCKET_FIRST && type <= SC_TYPE_HISTOGRAM_BUCKET_INF);
+
+  gsize cumulative = 0;
+  for (gint bucket = SC_TYPE_HISTOGRAM_BUCKET_FIRST; bucket <= type; bucket++)
+    cumulative += stats_counter_get(&self->counter_group.counters[bucket]);
+
+  return cumulative;
+}
+
+static inline gint
+_find_bucket(gsize value)
+{
+  gint low = 0;
+  gint high = STATS_HISTOGRAM_BOUNDS;
+
+  while (low < high)
+    {
+      gint mid = (low + high) / 2;
+
+      if (value <= bucket_bounds[mid])
+        high = mid;
+      else
+        low = mid + 1;
+    }
+
+  /* STATS_HISTOGRAM_BOUNDS is the +Inf bucket */
+  return SC_TYPE_HISTOGRAM_BUCKET_FIRST + low;
+}
+
+void
+stats_histogram_observe(StatsCounterItem *histogram, gsize value)
+{
+  if (!histogram)
+    return;
+
+  stats_counter_inc(&histogram[_find_bucket(value)]);
+  stats_counter_add(&histogram[SC_TYPE_HISTOGRAM_SUM], value);
+  stats_counter_inc(&histogram[SC_TYPE_HISTOGRAM_COUNT]);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_CLUSTER_HISTOGRAM_H_INCLUDED
+#define STATS_CLUSTER_HISTOGRAM_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "stats-cluster.h"
+
+/*
+ * Fixed-bucket histograms.
+ *
+ * Bucket upper bounds follow a log-linear 1-2-5 series over 8 decades (1,
+ * 2, 5, 10, 20, 50, ... 50000000), in the stored unit of the key, plus a
+ * final +Inf bucket.  Each bucket is a separate non-cumulative counter of
+ * the cluster, followed by the sum and the number of observations, so the
+ * whole histogram is updated with atomic increments only.
+ */
+#define STATS_HISTOGRAM_BOUNDS 24
+
+typedef enum
+{
+  SC_TYPE_HISTOGRAM_BUCKET_FIRST = 0,
+  SC_TYPE_HISTOGRAM_BUCKET_INF = SC_TYPE_HISTOGRAM_BUCKET_FIRST + STATS_HISTOGRAM_BOUNDS,
+  SC_TYPE_HISTOGRAM_SUM,
+  SC_TYPE_HISTOGRAM_COUNT,
+  SC_TYPE_HISTOGRAM_MAX
+} StatsCounterGroupHistogram;
+
+void stats_cluster_histogram_key_set(StatsClusterKey *key, const gchar *name, StatsClusterLabel *labels,
+                                     gsize labels_len);
+
+gboolean stats_cluster_is_histogram(StatsCluster *self);
+gsize stats_cluster_histogram_get_bucket_bound(gint type);
+gsize stats_cluster_histogram_get_cumulative_count(StatsCluster *self, gint type);
+
+/* @histogram is the counter array returned by stats_register_histogram(), NULL is accepted */
+void stats_histogram_observe(StatsCounterItem *histogram, gsize value);
+
+#endif
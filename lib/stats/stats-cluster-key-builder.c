@@ -24,6 +24,7 @@
 #include "stats/stats-cluster-key-builder.h"
 #include "stats/stats-cluster-single.h"
 #include "stats/stats-cluster-logpipe.h"
+#include "stats/stats-cluster-histogram.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -126,6 +127,56 @@ stats_cluster_key_builder_free(StatsClusterKeyBuilder *self)
   g_free(self);
 }
 
+static void
+_labels_copy(GArray *dst, const GArray *src)
+{
+  for (guint i = 0; i < src->len; i++)
+    {
+      const StatsClusterLabel *label = &g_array_index(src, StatsClusterLabel, i);
+      StatsClusterLabel own_label = stats_cluster_label(g_strdup(label->name), g_strdup(label->value));
+      g_array_append_vals(dst, &own_label, 1);
+    }
+}
+
+static BuilderOptions *
+_options_clone(const BuilderOptions *other)
+{
+  BuilderOptions *self = _options_new();
+
+  self->name = g_strdup(other->name);
+  self->name_prefix = g_strdup(other->name_prefix);
+  self->name_suffix = g_strdup(other->name_suffix);
+  _labels_copy(self->labels, other->labels);
+
+  if (other->legacy_labels)
+    {
+      self->legacy_labels = g_array_sized_new(FALSE, FALSE, sizeof(StatsClusterLabel), other->legacy_labels->len);
+      g_array_set_clear_func(self->legacy_labels, (GDestroyNotify) _label_free);
+      _labels_copy(self->legacy_labels, other->legacy_labels);
+    }
+
+  self->unit = other->unit;
+  self->frame_of_reference = other->frame_of_reference;
+
+  self->legacy.component = other->legacy.component;
+  self->legacy.id = g_strdup(other->legacy.id);
+  self->legacy.instance = g_strdup(other->legacy.instance);
+  self->legacy.name = g_strdup(other->legacy.name);
+
+  return self;
+}
+
+StatsClusterKeyBuilder *
+stats_cluster_key_builder_clone(const StatsClusterKeyBuilder *other)
+{
+  StatsClusterKeyBuilder *self = g_new0(StatsClusterKeyBuilder, 1);
+
+  for (const GList *link = g_list_first(other->options_stack); link; link = link->next)
+    self->options_stack = g_list_append(self->options_stack, _options_clone((const BuilderOptions *) link->data));
+
+  return self;
+}
+
 static BuilderOptions *
 _get_last_options(StatsClusterKeyBuilder *self)
 {
@@ -432,6 +483,29 @@ stats_cluster_key_builder_build_single(const StatsClusterKeyBuilder *self)
   return sc_key;
 }
 
+/* histograms have no legacy representation, legacy options are ignored */
+StatsClusterKey *
+stats_cluster_key_builder_build_histogram(const StatsClusterKeyBuilder *self)
+{
+  g_assert(_has_new_style_values(self));
+
+  StatsClusterKey *sc_key = g_new0(StatsClusterKey, 1);
+  StatsClusterKey temp_key;
+
+  gchar *name = _format_name(self);
+  GArray *merged_labels = _construct_merged_labels(self);
+
+  stats_cluster_histogram_key_set(&temp_key, name, (StatsClusterLabel *) merged_labels->data, merged_labels->len);
+  temp_key.formatting.stored_unit = _get_unit(self);
+
+  stats_cluster_key_clone(sc_key, &temp_key);
+
+  g_array_free(merged_labels, TRUE);
+  g_free(name);
+
+  return sc_key;
+}
+
 StatsClusterKey *
 stats_cluster_key_builder_build_logpipe(const StatsClusterKeyBuilder *self)
 {
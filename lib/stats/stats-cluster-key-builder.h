@@ -30,6 +30,7 @@
 typedef struct _StatsClusterKeyBuilder StatsClusterKeyBuilder;
 
 StatsClusterKeyBuilder *stats_cluster_key_builder_new(void);
+StatsClusterKeyBuilder *stats_cluster_key_builder_clone(const StatsClusterKeyBuilder *other);
 void stats_cluster_key_builder_push(StatsClusterKeyBuilder *self);
 void stats_cluster_key_builder_pop(StatsClusterKeyBuilder *self);
 void stats_cluster_key_builder_free(StatsClusterKeyBuilder *self);
@@ -47,6 +48,7 @@ void stats_cluster_key_builder_set_legacy_alias_name(StatsClusterKeyBuilder *sel
 
 StatsClusterKey *stats_cluster_key_builder_build_single(const StatsClusterKeyBuilder *self);
 StatsClusterKey *stats_cluster_key_builder_build_logpipe(const StatsClusterKeyBuilder *self);
+StatsClusterKey *stats_cluster_key_builder_build_histogram(const StatsClusterKeyBuilder *self);
 
 /* Compatibility functions for reproducing stats_instance names based on unsorted labels */
 void stats_cluster_key_builder_add_legacy_label(StatsClusterKeyBuilder *self, const StatsClusterLabel label);
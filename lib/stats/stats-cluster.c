@@ -461,6 +461,8 @@ stats_cluster_free(StatsCluster *self)
   stats_cluster_foreach_counter(self, stats_cluster_free_counter, NULL);
   stats_cluster_key_cloned_free(&self->key);
   g_free(self->query_key);
+  g_free(self->prometheus_name);
+  g_free(self->prometheus_labels);
   stats_counter_group_free(&self->counter_group);
   g_free(self);
 }
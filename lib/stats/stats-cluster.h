@@ -55,6 +55,7 @@ typedef enum _StatsClusterUnit
   SCU_HOURS,
   SCU_MILLISECONDS,
   SCU_NANOSECONDS,
+  SCU_MICROSECONDS,
 
   SCU_BYTES,
   SCU_KIB,
@@ -156,9 +157,14 @@ typedef struct _StatsCluster
   StatsClusterKey key;
   StatsCounterGroup counter_group;
   guint16 use_count;
-  guint16 live_mask;
+  guint32 live_mask;
   guint16 dynamic:1;
+  /* pinned clusters are not removed from the registry even if orphaned */
+  guint16 pin_count;
   gchar *query_key;
+  /* rendered by the prometheus exporter on first use */
+  gchar *prometheus_name;
+  gchar *prometheus_labels;
 } StatsCluster;
 
 typedef void (*StatsForeachCounterFunc)(StatsCluster *sc, gint type, StatsCounterItem *counter, gpointer user_data);
@@ -190,6 +196,26 @@ stats_cluster_is_orphaned(StatsCluster *self)
   return self->use_count == 0;
 }
 
+/* called with stats_lock() held */
+static inline void
+stats_cluster_pin(StatsCluster *self)
+{
+  self->pin_count++;
+}
+
+static inline void
+stats_cluster_unpin(StatsCluster *self)
+{
+  g_assert(self->pin_count > 0);
+  self->pin_count--;
+}
+
+static inline gboolean
+stats_cluster_is_removable(StatsCluster *self)
+{
+  return stats_cluster_is_orphaned(self) && self->pin_count == 0;
+}
+
 static inline gboolean
 stats_cluster_get_type_label(StatsCluster *self, gint type, StatsClusterLabel *label)
 {
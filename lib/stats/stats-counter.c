@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-counter.h"
+#include "tls-support.h"
+
+#include <unistd.h>
+
+#define STATS_COUNTER_MAX_SHARDS 64
+
+TLS_BLOCK_START
+{
+  /* shifted by one, 0 means that the thread has not been assigned a slot yet */
+  gint stats_counter_shard_index;
+}
+TLS_BLOCK_END;
+
+#define stats_counter_shard_index __tls_deref(stats_counter_shard_index)
+
+/* set once, when the first counter is sharded, every sharded counter has
+ * the same number of slots */
+static gint stats_counter_num_shards;
+static gint stats_counter_next_shard_index;
+
+static gint
+_get_num_shards(void)
+{
+  gint num_shards = g_atomic_int_get(&stats_counter_num_shards);
+
+  if (num_shards)
+    return num_shards;
+
+  long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  num_shards = CLAMP(num_cpus, 1, STATS_COUNTER_MAX_SHARDS);
+
+  if (!g_atomic_int_compare_and_exchange(&stats_counter_num_shards, 0, num_shards))
+    num_shards = g_atomic_int_get(&stats_counter_num_shards);
+  return num_shards;
+}
+
+void
+stats_counter_make_sharded(StatsCounterItem *counter)
+{
+  g_assert(!counter->external);
+
+  if (counter->shards)
+    return;
+
+  /* the shards are allocated with g_new0(), so they are only 16 byte
+   * aligned, but being STATS_COUNTER_SHARD_SIZE apart, each value is in a
+   * cache line of its own anyway */
+  StatsCounterShard *shards = g_new0(StatsCounterShard, _get_num_shards());
+  g_atomic_pointer_set(&counter->shards, shards);
+}
+
+/* threads are assigned to slots in a round-robin fashion, when they first
+ * update a sharded counter */
+atomic_gssize *
+stats_counter_get_shard_value(StatsCounterItem *counter)
+{
+  gint shard_index = stats_counter_shard_index;
+
+  if (G_UNLIKELY(!shard_index))
+    {
+      shard_index = ((guint) g_atomic_int_add(&stats_counter_next_shard_index, 1) % stats_counter_num_shards) + 1;
+      stats_counter_shard_index = shard_index;
+    }
+
+  return &counter->shards[shard_index - 1].value;
+}
+
+gssize
+stats_counter_sum_shards(StatsCounterItem *counter)
+{
+  gssize sum = 0;
+
+  for (gint i = 0; i < stats_counter_num_shards; i++)
+    sum += atomic_gssize_get(&counter->shards[i].value);
+  return sum;
+}
+
+void
+stats_counter_reset_shards(StatsCounterItem *counter)
+{
+  for (gint i = 0; i < stats_counter_num_shards; i++)
+    atomic_gssize_set(&counter->shards[i].value, 0);
+}
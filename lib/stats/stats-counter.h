@@ -29,6 +29,16 @@
 
 #define STATS_COUNTER_MAX_VALUE G_MAXSIZE
 
+/* the slots of a sharded counter are a cache line apart, so that threads
+ * updating different slots do not contend */
+#define STATS_COUNTER_SHARD_SIZE 64
+
+typedef struct _StatsCounterShard
+{
+  atomic_gssize value;
+  gchar __padding[STATS_COUNTER_SHARD_SIZE - sizeof(atomic_gssize)];
+} StatsCounterShard;
+
 typedef struct _StatsCounterItem
 {
   union
@@ -36,11 +46,37 @@ typedef struct _StatsCounterItem
     atomic_gssize value;
     atomic_gssize *value_ref;
   };
+  /* per-thread slots, only allocated for sharded counters, see
+   * stats_counter_make_sharded() */
+  StatsCounterShard *shards;
   gchar *name;
   gint type;
   gboolean external;
 } StatsCounterItem;
 
+/*
+ * Sharded counters
+ *
+ * Updating a counter is an atomic read-modify-write on a single value,
+ * which bounces its cache line between the threads updating it.  A sharded
+ * counter is updated in a per-thread slot instead, the slots are only
+ * summed when the counter is read.  This makes reads more expensive and
+ * uses a cache line per slot, so it is only worth it for counters that are
+ * updated by multiple threads for each message.
+ */
+void stats_counter_make_sharded(StatsCounterItem *counter);
+atomic_gssize *stats_counter_get_shard_value(StatsCounterItem *counter);
+gssize stats_counter_sum_shards(StatsCounterItem *counter);
+void stats_counter_reset_shards(StatsCounterItem *counter);
+
+static inline atomic_gssize *
+_stats_counter_get_value_to_update(StatsCounterItem *counter)
+{
+  if (counter->shards)
+    return stats_counter_get_shard_value(counter);
+  return &counter->value;
+}
+
 
 static gboolean
 stats_counter_read_only(StatsCounterItem *counter)
@@ -54,7 +90,7 @@ stats_counter_add(StatsCounterItem *counter, gssize add)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_add(&counter->value, add);
+      atomic_gssize_add(_stats_counter_get_value_to_update(counter), add);
     }
 }
 
@@ -64,7 +100,7 @@ stats_counter_sub(StatsCounterItem *counter, gssize sub)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_sub(&counter->value, sub);
+      atomic_gssize_sub(_stats_counter_get_value_to_update(counter), sub);
     }
 }
 
@@ -74,7 +110,7 @@ stats_counter_inc(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_inc(&counter->value);
+      atomic_gssize_inc(_stats_counter_get_value_to_update(counter));
     }
 }
 
@@ -84,7 +120,7 @@ stats_counter_dec(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_dec(&counter->value);
+      atomic_gssize_dec(_stats_counter_get_value_to_update(counter));
     }
 }
 
@@ -93,7 +129,10 @@ stats_counter_set(StatsCounterItem *counter, gsize value)
 {
   if (counter && !stats_counter_read_only(counter))
     {
+      /* not atomic with respect to concurrent updates of a sharded counter */
       atomic_gssize_set(&counter->value, value);
+      if (counter->shards)
+        stats_counter_reset_shards(counter);
     }
 }
 
@@ -104,10 +143,12 @@ stats_counter_get(StatsCounterItem *counter)
 
   if (counter)
     {
-      if (!counter->external)
-        result = atomic_gssize_get_unsigned(&counter->value);
-      else
+      if (counter->external)
         result = atomic_gssize_get_unsigned(counter->value_ref);
+      else if (counter->shards)
+        result = (gsize) (atomic_gssize_get(&counter->value) + stats_counter_sum_shards(counter));
+      else
+        result = atomic_gssize_get_unsigned(&counter->value);
     }
   return result;
 }
@@ -131,6 +172,7 @@ static inline void
 stats_counter_clear(StatsCounterItem *counter)
 {
   g_free(counter->name);
+  g_free(counter->shards);
   memset(counter, 0, sizeof(*counter));
 }
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-dynamic-cache.h"
+#include "apphook.h"
+#include "tls-support.h"
+
+typedef struct _StatsDynamicCacheEntry
+{
+  StatsCluster *cluster;
+  StatsCounterItem *processed;
+  StatsCounterItem *stamp;
+} StatsDynamicCacheEntry;
+
+TLS_BLOCK_START
+{
+  GHashTable *dynamic_cache;
+  gint dynamic_cache_generation;
+}
+TLS_BLOCK_END;
+
+#define dynamic_cache __tls_deref(dynamic_cache)
+#define dynamic_cache_generation __tls_deref(dynamic_cache_generation)
+
+static gint global_generation;
+
+/* runs with stats_lock() held */
+static void
+_entry_free(StatsDynamicCacheEntry *entry)
+{
+  stats_unregister_dynamic_counter(entry->cluster, SC_TYPE_PROCESSED, &entry->processed);
+  g_free(entry);
+}
+
+static void
+_release_entries(GHashTable *cache)
+{
+  if (g_hash_table_size(cache) == 0)
+    return;
+
+  stats_lock();
+  g_hash_table_remove_all(cache);
+  stats_unlock();
+}
+
+static StatsDynamicCacheEntry *
+_register_entry(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp)
+{
+  StatsDynamicCacheEntry *entry = NULL;
+  StatsCounterItem *processed, *stamp;
+
+  stats_lock();
+  StatsCluster *sc = stats_register_dynamic_counter(stats_level, sc_key, SC_TYPE_PROCESSED, &processed);
+  if (sc)
+    {
+      /* the reference to the processed counter keeps the cluster alive,
+       * the stamp only needs to be live */
+      if (timestamp >= 0)
+        {
+          stats_register_associated_counter(sc, SC_TYPE_STAMP, &stamp);
+          stats_unregister_dynamic_counter(sc, SC_TYPE_STAMP, &stamp);
+        }
+
+      entry = g_new0(StatsDynamicCacheEntry, 1);
+      entry->cluster = sc;
+      entry->processed = processed;
+      entry->stamp = stats_cluster_get_counter(sc, SC_TYPE_STAMP);
+      g_hash_table_insert(dynamic_cache, &sc->key, entry);
+    }
+  stats_unlock();
+
+  return entry;
+}
+
+static StatsDynamicCacheEntry *
+_lookup_entry(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp)
+{
+  gint generation = g_atomic_int_get(&global_generation);
+
+  if (G_UNLIKELY(dynamic_cache_generation != generation))
+    {
+      _release_entries(dynamic_cache);
+      dynamic_cache_generation = generation;
+    }
+
+  StatsDynamicCacheEntry *entry = g_hash_table_lookup(dynamic_cache, sc_key);
+  if (G_LIKELY(entry))
+    return entry;
+
+  return _register_entry(stats_level, sc_key, timestamp);
+}
+
+/*
+ * stats_dynamic_cache_increment:
+ *
+ * Same as stats_register_and_increment_dynamic_counter(), but it must be
+ * called without holding stats_lock(), which is only taken when a cluster
+ * is first used by the current thread.
+ */
+void
+stats_dynamic_cache_increment(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp)
+{
+  if (!stats_check_level(stats_level))
+    return;
+
+  /* threads not started by us have no cache */
+  if (G_UNLIKELY(!dynamic_cache))
+    {
+      stats_lock();
+      stats_register_and_increment_dynamic_counter(stats_level, sc_key, timestamp);
+      stats_unlock();
+      return;
+    }
+
+  StatsDynamicCacheEntry *entry = _lookup_entry(stats_level, sc_key, timestamp);
+  if (!entry)
+    return;
+
+  stats_counter_inc(entry->processed);
+  if (timestamp >= 0)
+    stats_counter_set(entry->stamp, timestamp);
+}
+
+/* makes every thread drop its references on its next update */
+void
+stats_dynamic_cache_invalidate(void)
+{
+  g_atomic_int_inc(&global_generation);
+}
+
+static void
+_init_tls_cache(gpointer user_data)
+{
+  g_assert(!dynamic_cache);
+
+  dynamic_cache = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
+                                        (GEqualFunc) stats_cluster_key_equal,
+                                        NULL, (GDestroyNotify) _entry_free);
+  dynamic_cache_generation = g_atomic_int_get(&global_generation);
+}
+
+static void
+_deinit_tls_cache(gpointer user_data)
+{
+  if (!dynamic_cache)
+    return;
+
+  _release_entries(dynamic_cache);
+  g_hash_table_destroy(dynamic_cache);
+  dynamic_cache = NULL;
+}
+
+void
+stats_dynamic_cache_global_init(void)
+{
+  register_application_thread_init_hook(_init_tls_cache, NULL);
+  register_application_thread_deinit_hook(_deinit_tls_cache, NULL);
+
+  _init_tls_cache(NULL);
+}
+
+void
+stats_dynamic_cache_global_deinit(void)
+{
+  _deinit_tls_cache(NULL);
+}
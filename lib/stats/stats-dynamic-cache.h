@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_DYNAMIC_CACHE_H_INCLUDED
+#define STATS_DYNAMIC_CACHE_H_INCLUDED
+
+#include "stats/stats-registry.h"
+
+/*
+ * Thread-local cache of dynamic clusters.
+ *
+ * stats_register_and_increment_dynamic_counter() needs stats_lock() for
+ * every call, even if the cluster is already registered, which serializes
+ * every thread that is updating dynamic counters (e.g. the per-host
+ * counters of msg-stats) on a single mutex.
+ *
+ * This cache keeps a reference to the clusters the current thread has
+ * used, so they can be looked up and incremented without stats_lock(),
+ * only registering a new label combination takes the lock.
+ *
+ * As long as a cluster is referenced by a cache it is not orphaned and
+ * can't be pruned, so caches are invalidated whenever the counters are
+ * pruned: each thread drops its references on its next update (or when it
+ * exits), so counters not updated since then can be pruned by the next
+ * run.
+ */
+
+void stats_dynamic_cache_increment(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp);
+void stats_dynamic_cache_invalidate(void);
+
+void stats_dynamic_cache_global_init(void);
+void stats_dynamic_cache_global_deinit(void);
+
+#endif
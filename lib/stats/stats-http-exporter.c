@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-http-exporter.h"
+#include "stats/stats-prometheus.h"
+#include "host-resolve.h"
+#include "gsocket.h"
+#include "fdhelpers.h"
+#include "apphook.h"
+#include "messages.h"
+
+#include <iv.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define STATS_HTTP_EXPORTER_MAX_SCRAPES 4
+#define STATS_HTTP_EXPORTER_MAX_REQUEST 4096
+#define STATS_HTTP_EXPORTER_RECV_TIMEOUT 5
+#define STATS_HTTP_EXPORTER_SEND_TIMEOUT 30
+
+typedef struct _StatsHttpExporter
+{
+  gchar *address;
+  gint port;
+  gint listen_fd;
+  struct iv_fd listen;
+
+  GMutex lock;
+  GCond scrape_finished;
+  gint running_scrapes;
+} StatsHttpExporter;
+
+typedef struct _StatsHttpScrape
+{
+  StatsHttpExporter *exporter;
+  gint fd;
+  gboolean failed;
+} StatsHttpScrape;
+
+static StatsHttpExporter *exporter;
+
+static gboolean
+_write_all(gint fd, const gchar *buf, gsize len)
+{
+  while (len > 0)
+    {
+      gssize rc = write(fd, buf, len);
+      if (rc < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return FALSE;
+        }
+      buf += rc;
+      len -= rc;
+    }
+  return TRUE;
+}
+
+static void
+_send_chunk(const gchar *chunk, gpointer user_data)
+{
+  StatsHttpScrape *scrape = (StatsHttpScrape *) user_data;
+
+  if (!_write_all(scrape->fd, chunk, strlen(chunk)))
+    scrape->failed = TRUE;
+}
+
+/* reads the request head, we only care about the request line */
+static gboolean
+_read_request(gint fd, gchar *request, gsize request_size)
+{
+  gsize len = 0;
+
+  while (len < request_size - 1)
+    {
+      gssize rc = read(fd, request + len, request_size - 1 - len);
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc <= 0)
+        return FALSE;
+
+      len += rc;
+      request[len] = 0;
+      if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+        return TRUE;
+    }
+  return FALSE;
+}
+
+static gboolean
+_is_metrics_request(const gchar *request)
+{
+  const gchar *path = "GET /metrics";
+  gsize path_len = strlen(path);
+
+  if (strncmp(request, path, path_len) != 0)
+    return FALSE;
+
+  gchar next = request[path_len];
+  return next == ' ' || next == '?';
+}
+
+static void
+_serve_scrape(StatsHttpScrape *scrape)
+{
+  static const gchar ok_response[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Connection: close\r\n\r\n";
+  static const gchar not_found_response[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+  gchar request[STATS_HTTP_EXPORTER_MAX_REQUEST];
+  if (!_read_request(scrape->fd, request, sizeof(request)))
+    return;
+
+  if (!_is_metrics_request(request))
+    {
+      _write_all(scrape->fd, not_found_response, sizeof(not_found_response) - 1);
+      return;
+    }
+
+  if (!_write_all(scrape->fd, ok_response, sizeof(ok_response) - 1))
+    return;
+
+  /* the body is terminated by closing the connection */
+  stats_generate_prometheus(_send_chunk, scrape, FALSE, &scrape->failed);
+}
+
+static gpointer
+_scrape_thread(gpointer user_data)
+{
+  StatsHttpScrape *scrape = (StatsHttpScrape *) user_data;
+  StatsHttpExporter *self = scrape->exporter;
+
+  app_thread_start();
+  _serve_scrape(scrape);
+  close(scrape->fd);
+  app_thread_stop();
+  g_free(scrape);
+
+  g_mutex_lock(&self->lock);
+  self->running_scrapes--;
+  g_cond_signal(&self->scrape_finished);
+  g_mutex_unlock(&self->lock);
+  return NULL;
+}
+
+static gboolean
+_reserve_scrape_slot(StatsHttpExporter *self)
+{
+  gboolean reserved = FALSE;
+
+  g_mutex_lock(&self->lock);
+  if (self->running_scrapes < STATS_HTTP_EXPORTER_MAX_SCRAPES)
+    {
+      self->running_scrapes++;
+      reserved = TRUE;
+    }
+  g_mutex_unlock(&self->lock);
+  return reserved;
+}
+
+static void
+_set_timeout(gint fd, gint optname, glong seconds)
+{
+  struct timeval tv = { .tv_sec = seconds, .tv_usec = 0 };
+
+  setsockopt(fd, SOL_SOCKET, optname, &tv, sizeof(tv));
+}
+
+static void
+_accept_scrape(gpointer cookie)
+{
+  StatsHttpExporter *self = (StatsHttpExporter *) cookie;
+  GSockAddr *peer_addr;
+  gint fd;
+
+  while (g_accept(self->listen_fd, &fd, &peer_addr) == G_IO_STATUS_NORMAL)
+    {
+      g_sockaddr_unref(peer_addr);
+
+      if (!_reserve_scrape_slot(self))
+        {
+          msg_debug("Too many concurrent metrics scrapes, dropping connection",
+                    evt_tag_int("max_scrapes", STATS_HTTP_EXPORTER_MAX_SCRAPES));
+          close(fd);
+          continue;
+        }
+
+      g_fd_set_nonblock(fd, FALSE);
+      g_fd_set_cloexec(fd, TRUE);
+      _set_timeout(fd, SO_RCVTIMEO, STATS_HTTP_EXPORTER_RECV_TIMEOUT);
+      _set_timeout(fd, SO_SNDTIMEO, STATS_HTTP_EXPORTER_SEND_TIMEOUT);
+
+      StatsHttpScrape *scrape = g_new0(StatsHttpScrape, 1);
+      scrape->exporter = self;
+      scrape->fd = fd;
+      g_thread_unref(g_thread_new("stats-http", _scrape_thread, scrape));
+    }
+}
+
+static gboolean
+_open_listener(StatsHttpExporter *self)
+{
+  gint family = strchr(self->address, ':') ? AF_INET6 : AF_INET;
+  GSockAddr *addr = NULL;
+
+  if (!resolve_hostname_to_sockaddr(&addr, family, self->address))
+    return FALSE;
+  g_sockaddr_set_port(addr, self->port);
+
+  self->listen_fd = socket(family, SOCK_STREAM, 0);
+  if (self->listen_fd < 0)
+    goto error;
+
+  gint on = 1;
+  setsockopt(self->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  g_fd_set_nonblock(self->listen_fd, TRUE);
+  g_fd_set_cloexec(self->listen_fd, TRUE);
+
+  if (g_bind(self->listen_fd, addr) != G_IO_STATUS_NORMAL || listen(self->listen_fd, 16) < 0)
+    goto error;
+
+  g_sockaddr_unref(addr);
+
+  self->listen.fd = self->listen_fd;
+  self->listen.cookie = self;
+  self->listen.handler_in = _accept_scrape;
+  iv_fd_register(&self->listen);
+  return TRUE;
+
+error:
+  msg_error("Error opening the listener of the metrics exporter",
+            evt_tag_str("address", self->address),
+            evt_tag_int("port", self->port),
+            evt_tag_error("error"));
+  if (self->listen_fd >= 0)
+    close(self->listen_fd);
+  self->listen_fd = -1;
+  g_sockaddr_unref(addr);
+  return FALSE;
+}
+
+static void
+_wait_for_scrapes(StatsHttpExporter *self)
+{
+  g_mutex_lock(&self->lock);
+  while (self->running_scrapes > 0)
+    g_cond_wait(&self->scrape_finished, &self->lock);
+  g_mutex_unlock(&self->lock);
+}
+
+static StatsHttpExporter *
+_exporter_new(const gchar *address, gint port)
+{
+  StatsHttpExporter *self = g_new0(StatsHttpExporter, 1);
+
+  self->address = g_strdup(address);
+  self->port = port;
+  self->listen_fd = -1;
+  IV_FD_INIT(&self->listen);
+  g_mutex_init(&self->lock);
+  g_cond_init(&self->scrape_finished);
+  return self;
+}
+
+static void
+_exporter_free(StatsHttpExporter *self)
+{
+  if (iv_fd_registered(&self->listen))
+    iv_fd_unregister(&self->listen);
+  if (self->listen_fd >= 0)
+    close(self->listen_fd);
+
+  _wait_for_scrapes(self);
+
+  g_cond_clear(&self->scrape_finished);
+  g_mutex_clear(&self->lock);
+  g_free(self->address);
+  g_free(self);
+}
+
+void
+stats_http_exporter_stop(void)
+{
+  if (!exporter)
+    return;
+
+  _exporter_free(exporter);
+  exporter = NULL;
+}
+
+static const gchar *
+_get_address(StatsOptions *options)
+{
+  return options->prometheus_address ? : "127.0.0.1";
+}
+
+static gboolean
+_is_listening_on(StatsOptions *options)
+{
+  return exporter && exporter->port == options->prometheus_port
+         && strcmp(exporter->address, _get_address(options)) == 0;
+}
+
+void
+stats_http_exporter_reinit(StatsOptions *options)
+{
+  if (options->prometheus_port <= 0)
+    {
+      stats_http_exporter_stop();
+      return;
+    }
+
+  /* keep the listener across reloads, if it does not change */
+  if (_is_listening_on(options))
+    return;
+
+  stats_http_exporter_stop();
+
+  exporter = _exporter_new(_get_address(options), options->prometheus_port);
+  if (!_open_listener(exporter))
+    {
+      stats_http_exporter_stop();
+      return;
+    }
+
+  msg_verbose("Metrics exporter listening",
+              evt_tag_str("address", exporter->address),
+              evt_tag_int("port", exporter->port));
+}
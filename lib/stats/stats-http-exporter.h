@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STATS_HTTP_EXPORTER_H_INCLUDED
+#define STATS_HTTP_EXPORTER_H_INCLUDED
+
+#include "stats/stats.h"
+
+/*
+ * Serves the Prometheus exposition of the counters on
+ * http://<prometheus-address>:<prometheus-port>/metrics, so scrapes do not
+ * have to go through the control socket and syslog-ng-ctl.  Each scrape
+ * is served by its own thread, the output is generated by
+ * stats_generate_prometheus().
+ */
+
+void stats_http_exporter_reinit(StatsOptions *options);
+void stats_http_exporter_stop(void);
+
+#endif
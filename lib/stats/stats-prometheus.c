@@ -24,6 +24,7 @@
 #include "stats/stats-prometheus.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster.h"
+#include "stats/stats-cluster-histogram.h"
 #include "stats/stats-counter.h"
 #include "timeutils/unixtime.h"
 #include "str-utils.h"
@@ -109,13 +110,11 @@ stats_format_prometheus_sanitize_name(const gchar *name)
   return sanitized_name->str;
 }
 
-gchar *
-stats_format_prometheus_format_value(const StatsClusterKey *key, StatsCounterItem *counter)
+static gchar *
+_format_converted_value(const StatsClusterKey *key, gsize stored_value)
 {
   GString *value = scratch_buffers_alloc();
 
-  gsize stored_value = stats_counter_get(counter);
-
   guint64 converted_int = stored_value;
   gdouble converted_double = stored_value;
   gchar double_buf[G_ASCII_DTOSTR_BUF_SIZE];
@@ -150,6 +149,11 @@ stats_format_prometheus_format_value(const StatsClusterKey *key, StatsCounterIte
       g_string_assign(value, g_ascii_dtostr(double_buf, G_N_ELEMENTS(double_buf), converted_double));
       break;
 
+    case SCU_MICROSECONDS:
+      converted_double /= 1e6;
+      g_string_assign(value, g_ascii_dtostr(double_buf, G_N_ELEMENTS(double_buf), converted_double));
+      break;
+
     case SCU_MILLISECONDS:
       converted_double /= 1e3;
       g_string_assign(value, g_ascii_dtostr(double_buf, G_N_ELEMENTS(double_buf), converted_double));
@@ -164,6 +168,12 @@ stats_format_prometheus_format_value(const StatsClusterKey *key, StatsCounterIte
   return value->str;
 }
 
+gchar *
+stats_format_prometheus_format_value(const StatsClusterKey *key, StatsCounterItem *counter)
+{
+  return _format_converted_value(key, stats_counter_get(counter));
+}
+
 static inline void
 _append_formatted_label(GString *serialized_labels, const StatsClusterLabel *label, gboolean *comma_needed)
 {
@@ -187,44 +197,51 @@ _is_timestamp(StatsCluster *sc, gint type)
 }
 
 static const gchar *
-_format_labels(StatsCluster *sc, gint type)
+_format_histogram_bucket_bound(StatsCluster *sc, gint type)
 {
-  StatsClusterLabel type_label;
-  gboolean needs_type_label = stats_cluster_get_type_label(sc, type, &type_label);
+  if (type == SC_TYPE_HISTOGRAM_BUCKET_INF)
+    return "+Inf";
 
-  if (!sc->key.labels_len && !needs_type_label)
-    return NULL;
+  /* bounds are round numbers, print them as such instead of with full double precision */
+  const gchar *converted = _format_converted_value(&sc->key, stats_cluster_histogram_get_bucket_bound(type));
 
-  GString *serialized_labels = scratch_buffers_alloc();
+  GString *bound = scratch_buffers_alloc();
+  gchar double_buf[G_ASCII_DTOSTR_BUF_SIZE];
+  g_string_assign(bound, g_ascii_formatd(double_buf, G_N_ELEMENTS(double_buf), "%g", g_ascii_strtod(converted, NULL)));
 
-  gboolean comma_needed = FALSE;
-  for (gsize i = 0; i < sc->key.labels_len; ++i)
-    _append_formatted_label(serialized_labels, &sc->key.labels[i], &comma_needed);
+  return bound->str;
+}
 
-  if (needs_type_label)
-    _append_formatted_label(serialized_labels, &type_label, &comma_needed);
+static gboolean
+_get_type_label(StatsCluster *sc, gint type, StatsClusterLabel *label)
+{
+  if (!stats_cluster_is_histogram(sc))
+    return stats_cluster_get_type_label(sc, type, label);
 
-  if (serialized_labels->len == 0)
-    return NULL;
+  if (type > SC_TYPE_HISTOGRAM_BUCKET_INF)
+    return FALSE;
 
-  return serialized_labels->str;
+  *label = stats_cluster_label("le", _format_histogram_bucket_bound(sc, type));
+  return TRUE;
 }
 
-static GString *
-_format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
+/* The metric name and the labels of the key are rendered once per cluster
+ * and stored in the cluster, as keys never change after registration.
+ * Only the label of the counter type and the value is formatted for each
+ * counter on each scrape.
+ */
+static void
+_render_legacy_key(StatsCluster *sc, GString *name, GString *labels)
 {
-  GString *record = scratch_buffers_alloc();
-  GString *labels = scratch_buffers_alloc();
-
   gchar component[64];
 
-  g_string_append_printf(record, PROMETHEUS_METRIC_PREFIX "%s",
+  g_string_append_printf(name, PROMETHEUS_METRIC_PREFIX "%s",
                          stats_format_prometheus_sanitize_name(stats_cluster_get_component_name(sc, component, sizeof(component))));
 
   if (!sc->key.legacy.component || sc->key.legacy.component == SCS_GLOBAL)
     {
       if (!_is_str_empty(sc->key.legacy.id))
-        g_string_append_printf(record, "_%s", stats_format_prometheus_sanitize_name(sc->key.legacy.id));
+        g_string_append_printf(name, "_%s", stats_format_prometheus_sanitize_name(sc->key.legacy.id));
     }
   else
     {
@@ -240,13 +257,70 @@ _format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
                                  stats_format_prometheus_sanitize_label_value(sc->key.legacy.instance));
         }
     }
+}
+
+static void
+_render_key(StatsCluster *sc, GString *name, GString *labels)
+{
+  g_string_append_printf(name, PROMETHEUS_METRIC_PREFIX "%s", stats_format_prometheus_sanitize_name(sc->key.name));
+
+  gboolean comma_needed = FALSE;
+  for (gsize i = 0; i < sc->key.labels_len; ++i)
+    _append_formatted_label(labels, &sc->key.labels[i], &comma_needed);
+}
+
+static void
+_cache_rendered_key(StatsCluster *sc)
+{
+  if (sc->prometheus_name)
+    return;
+
+  GString *name = scratch_buffers_alloc();
+  GString *labels = scratch_buffers_alloc();
+
+  if (!sc->key.name)
+    _render_legacy_key(sc, name, labels);
+  else
+    _render_key(sc, name, labels);
+
+  sc->prometheus_labels = g_strdup(labels->str);
+  sc->prometheus_name = g_strdup(name->str);
+}
+
+static const gchar *
+_format_labels(StatsCluster *sc, gint type)
+{
+  StatsClusterLabel type_label;
+  gboolean needs_type_label = _get_type_label(sc, type, &type_label);
+
+  if (!needs_type_label)
+    return sc->prometheus_labels[0] ? sc->prometheus_labels : NULL;
+
+  GString *serialized_labels = scratch_buffers_alloc();
+  g_string_assign(serialized_labels, sc->prometheus_labels);
+
+  gboolean comma_needed = serialized_labels->len > 0;
+  _append_formatted_label(serialized_labels, &type_label, &comma_needed);
+
+  if (serialized_labels->len == 0)
+    return NULL;
+
+  return serialized_labels->str;
+}
+
+static GString *
+_format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
+{
+  GString *record = scratch_buffers_alloc();
+
+  g_string_append(record, sc->prometheus_name);
 
   const gchar *type_name = stats_cluster_get_type_name(sc, type);
   if (g_strcmp0(type_name, "value") != 0)
     g_string_append_printf(record, "_%s", stats_format_prometheus_sanitize_name(type_name));
 
-  if (labels->len != 0)
-    g_string_append_printf(record, "{%s}", labels->str);
+  if (sc->prometheus_labels[0])
+    g_string_append_printf(record, "{%s}", sc->prometheus_labels);
 
   const gchar *metric_value = stats_format_prometheus_format_value(&sc->key, &sc->counter_group.counters[type]);
   g_string_append_printf(record, " %s\n", metric_value);
@@ -254,17 +328,55 @@ _format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
   return record;
 }
 
+/* Histograms are exposed the Prometheus way: one cumulative
+ * <name>_bucket{le="<bound>"} series for each bucket, <name>_sum and
+ * <name>_count.  Bounds and the sum are converted according to the unit of
+ * the key, the same way as single values are.
+ */
+static GString *
+_format_histogram(StatsCluster *sc, gint type)
+{
+  GString *record = scratch_buffers_alloc();
+  g_string_append(record, sc->prometheus_name);
+
+  if (type == SC_TYPE_HISTOGRAM_SUM)
+    g_string_append(record, "_sum");
+  else if (type == SC_TYPE_HISTOGRAM_COUNT)
+    g_string_append(record, "_count");
+  else
+    g_string_append(record, "_bucket");
+
+  const gchar *labels = _format_labels(sc, type);
+  if (labels)
+    g_string_append_printf(record, "{%s}", labels);
+
+  if (type == SC_TYPE_HISTOGRAM_SUM)
+    g_string_append_printf(record, " %s\n",
+                           stats_format_prometheus_format_value(&sc->key, &sc->counter_group.counters[type]));
+  else if (type == SC_TYPE_HISTOGRAM_COUNT)
+    g_string_append_printf(record, " %"G_GSIZE_FORMAT"\n", stats_counter_get(&sc->counter_group.counters[type]));
+  else
+    g_string_append_printf(record, " %"G_GSIZE_FORMAT"\n", stats_cluster_histogram_get_cumulative_count(sc, type));
+
+  return record;
+}
+
 GString *
 stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter)
 {
   if (_is_timestamp(sc, type))
     return NULL;
 
+  _cache_rendered_key(sc);
+
   if (!sc->key.name)
     return _format_legacy(sc, type, counter);
 
+  if (stats_cluster_is_histogram(sc))
+    return _format_histogram(sc, type);
+
   GString *record = scratch_buffers_alloc();
-  g_string_append_printf(record, PROMETHEUS_METRIC_PREFIX "%s", stats_format_prometheus_sanitize_name(sc->key.name));
+  g_string_append(record, sc->prometheus_name);
 
   const gchar *labels = _format_labels(sc, type);
   if (labels)
@@ -279,13 +391,7 @@ stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *c
 static void
 stats_format_prometheus(StatsCluster *sc, gint type, StatsCounterItem *counter, gpointer user_data)
 {
-  gpointer *args = (gpointer *) user_data;
-  StatsPrometheusRecordFunc process_record = (StatsPrometheusRecordFunc) args[0];
-  gpointer process_record_arg = args[1];
-  gboolean with_legacy = GPOINTER_TO_INT(args[2]);
-
-  if (!sc->key.name && !with_legacy)
-    return;
+  GString *chunk = (GString *) user_data;
 
   if (stats_cluster_is_orphaned(sc))
     return;
@@ -294,13 +400,45 @@ stats_format_prometheus(StatsCluster *sc, gint type, StatsCounterItem *counter,
   scratch_buffers_mark(&marker);
 
   GString *record = stats_prometheus_format_counter(sc, type, counter);
-  if (!record)
-    return;
+  if (record)
+    g_string_append_len(chunk, record->str, record->len);
 
-  process_record(record->str, process_record_arg);
   scratch_buffers_reclaim_marked(marker);
 }
 
+static void
+_pin_cluster(StatsCluster *sc, gpointer user_data)
+{
+  GPtrArray *clusters = (GPtrArray *) user_data;
+
+  stats_cluster_pin(sc);
+  g_ptr_array_add(clusters, sc);
+}
+
+static void
+_unpin_clusters(GPtrArray *clusters)
+{
+  stats_lock();
+  for (guint i = 0; i < clusters->len; i++)
+    stats_cluster_unpin(g_ptr_array_index(clusters, i));
+  stats_unlock();
+}
+
+static void
+_format_chunk(GPtrArray *clusters, guint first, guint last, gboolean with_legacy, GString *chunk)
+{
+  stats_lock();
+  for (guint i = first; i < last; i++)
+    {
+      StatsCluster *sc = g_ptr_array_index(clusters, i);
+
+      if (!sc->key.name && !with_legacy)
+        continue;
+      stats_cluster_foreach_counter(sc, stats_format_prometheus, chunk);
+    }
+  stats_unlock();
+}
+
 void
 stats_prometheus_format_labels_append(StatsClusterLabel *labels, gsize labels_len, GString *buf)
 {
@@ -319,12 +457,38 @@ stats_prometheus_format_labels_append(StatsClusterLabel *labels, gsize labels_le
     g_string_append_c(buf, '}');
 }
 
+/*
+ * The registry is only locked while a chunk of clusters is formatted and
+ * not while the output is written, so a slow reader does not block the
+ * registration of counters (e.g. new label combinations of dynamic
+ * counters).  The clusters are pinned for the duration of the walk, so
+ * they are not freed in the meantime.
+ */
 void
 stats_generate_prometheus(StatsPrometheusRecordFunc process_record, gpointer user_data, gboolean with_legacy,
                           gboolean *cancelled)
 {
-  gpointer format_prometheus_args[] = {process_record, user_data, GINT_TO_POINTER(with_legacy)};
+  GPtrArray *clusters = g_ptr_array_new();
+  GString *chunk = g_string_sized_new(STATS_PROMETHEUS_CHUNK_CLUSTERS * 128);
+
   stats_lock();
-  stats_foreach_counter(stats_format_prometheus, format_prometheus_args, cancelled);
+  stats_foreach_cluster(_pin_cluster, clusters, cancelled);
   stats_unlock();
+
+  for (guint first = 0; first < clusters->len; first += STATS_PROMETHEUS_CHUNK_CLUSTERS)
+    {
+      if (cancelled && *cancelled)
+        break;
+
+      guint last = MIN(first + STATS_PROMETHEUS_CHUNK_CLUSTERS, clusters->len);
+      _format_chunk(clusters, first, last, with_legacy, chunk);
+
+      if (chunk->len > 0)
+        process_record(chunk->str, user_data);
+      g_string_truncate(chunk, 0);
+    }
+
+  _unpin_clusters(clusters);
+  g_string_free(chunk, TRUE);
+  g_ptr_array_free(clusters, TRUE);
 }
@@ -28,6 +28,10 @@
 
 #define PROMETHEUS_METRIC_PREFIX "syslogng_"
 
+/* number of clusters formatted in one go, while holding stats_lock() */
+#define STATS_PROMETHEUS_CHUNK_CLUSTERS 1024
+
+/* receives the formatted records in chunks, each holding one or more complete lines */
 typedef void (*StatsPrometheusRecordFunc)(const char *record, gpointer user_data);
 
 GString *stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter);
@@ -23,6 +23,7 @@
  */
 #include "stats/stats-registry.h"
 #include "stats/stats-query.h"
+#include "stats/stats-cluster-histogram.h"
 #include "cfg.h"
 #include <string.h>
 
@@ -228,6 +229,57 @@ stats_register_counter(gint stats_level, const StatsClusterKey *sc_key, gint typ
   return _register_counter(stats_level, sc_key, type, FALSE, counter);
 }
 
+/*
+ * stats_register_sharded_counter:
+ *
+ * Same as stats_register_counter(), but the counter is sharded (see
+ * stats_counter_make_sharded()), use it for counters that are updated by
+ * several threads for each message.
+ */
+StatsCluster *
+stats_register_sharded_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
+                               StatsCounterItem **counter)
+{
+  StatsCluster *sc = _register_counter(stats_level, sc_key, type, FALSE, counter);
+
+  if (*counter && !(*counter)->external)
+    stats_counter_make_sharded(*counter);
+  return sc;
+}
+
+/*
+ * stats_register_histogram:
+ * @histogram: returned pointer to the counters of the histogram, to be
+ *             passed to stats_histogram_observe()
+ *
+ * Registers all buckets of a histogram cluster, @sc_key has to be built with
+ * stats_cluster_key_builder_build_histogram().
+ */
+StatsCluster *
+stats_register_histogram(gint stats_level, const StatsClusterKey *sc_key, StatsCounterItem **histogram)
+{
+  StatsCluster *sc;
+  StatsCounterItem *counter;
+
+  g_assert(stats_locked);
+
+  *histogram = NULL;
+  sc = _grab_cluster(stats_level, sc_key, FALSE);
+  if (!sc)
+    return NULL;
+
+  g_assert(stats_cluster_is_histogram(sc));
+  for (gint type = 0; type < SC_TYPE_HISTOGRAM_MAX; type++)
+    {
+      counter = stats_cluster_track_counter(sc, type);
+      counter->type = type;
+      _update_counter_name_if_needed(counter, sc, type);
+    }
+
+  *histogram = &sc->counter_group.counters[0];
+  return sc;
+}
+
 StatsCluster *
 stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
                                 atomic_gssize *external_counter)
@@ -238,6 +290,8 @@ stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key,
 StatsCluster *
 stats_register_alias_counter(gint level, const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter)
 {
+  /* an alias only sees the unsharded part of the value */
+  g_assert(!aliased_counter->shards);
   return stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
 }
 
@@ -314,6 +368,26 @@ stats_unregister_counter(const StatsClusterKey *sc_key, gint type,
   stats_cluster_untrack_counter(sc, type, counter);
 }
 
+void
+stats_unregister_histogram(const StatsClusterKey *sc_key, StatsCounterItem **histogram)
+{
+  StatsCluster *sc;
+
+  g_assert(stats_locked);
+
+  if (*histogram == NULL)
+    return;
+
+  sc = g_hash_table_lookup(stats_cluster_container.static_clusters, sc_key);
+
+  for (gint type = 0; type < SC_TYPE_HISTOGRAM_MAX; type++)
+    {
+      StatsCounterItem *counter = &(*histogram)[type];
+      stats_cluster_untrack_counter(sc, type, &counter);
+    }
+  *histogram = NULL;
+}
+
 void
 stats_unregister_external_counter(const StatsClusterKey *sc_key, gint type,
                                   atomic_gssize *external_counter)
@@ -369,7 +443,7 @@ stats_remove_cluster(const StatsClusterKey *sc_key)
   sc = g_hash_table_lookup(stats_cluster_container.dynamic_clusters, sc_key);
   if (sc)
     {
-      if (stats_cluster_is_orphaned(sc))
+      if (stats_cluster_is_removable(sc))
         return g_hash_table_remove(stats_cluster_container.dynamic_clusters, sc_key);
       return FALSE;
     }
@@ -377,7 +451,7 @@ stats_remove_cluster(const StatsClusterKey *sc_key)
   sc = g_hash_table_lookup(stats_cluster_container.static_clusters, sc_key);
   if (sc)
     {
-      if (stats_cluster_is_orphaned(sc))
+      if (stats_cluster_is_removable(sc))
         return g_hash_table_remove(stats_cluster_container.static_clusters, sc_key);
       return FALSE;
     }
@@ -455,7 +529,7 @@ _foreach_cluster_remove_helper(gpointer key, gpointer value, gpointer user_data)
   gpointer func_data = args[1];
   StatsCluster *sc = (StatsCluster *) value;
 
-  gboolean should_be_removed = func(sc, func_data) && stats_cluster_is_orphaned(sc);
+  gboolean should_be_removed = func(sc, func_data) && stats_cluster_is_removable(sc);
   return should_be_removed;
 }
 
@@ -34,6 +34,10 @@ void stats_lock(void);
 void stats_unlock(void);
 gboolean stats_check_level(gint level);
 StatsCluster *stats_register_counter(gint level, const StatsClusterKey *sc_key, gint type, StatsCounterItem **counter);
+StatsCluster *stats_register_sharded_counter(gint level, const StatsClusterKey *sc_key, gint type,
+                                             StatsCounterItem **counter);
+
+StatsCluster *stats_register_histogram(gint level, const StatsClusterKey *sc_key, StatsCounterItem **histogram);
 
 StatsCluster *stats_register_external_counter(gint level, const StatsClusterKey *sc_key, gint type,
                                               atomic_gssize *external_counter);
@@ -48,6 +52,7 @@ StatsCluster *stats_register_dynamic_counter(gint stats_level, const StatsCluste
 void stats_register_and_increment_dynamic_counter(gint stats_level, const StatsClusterKey *sc_key, time_t timestamp);
 void stats_register_associated_counter(StatsCluster *handle, gint type, StatsCounterItem **counter);
 void stats_unregister_counter(const StatsClusterKey *sc_key, gint type, StatsCounterItem **counter);
+void stats_unregister_histogram(const StatsClusterKey *sc_key, StatsCounterItem **histogram);
 void stats_unregister_external_counter(const StatsClusterKey *sc_key, gint type,
                                        atomic_gssize *external_counter);
 void stats_unregister_alias_counter(const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter);
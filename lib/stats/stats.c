@@ -26,6 +26,8 @@
 #include "stats/stats-log.h"
 #include "stats/stats-query.h"
 #include "stats/stats-registry.h"
+#include "stats/stats-dynamic-cache.h"
+#include "stats/stats-http-exporter.h"
 #include "stats/aggregator/stats-aggregator-registry.h"
 #include "stats/stats.h"
 #include "timeutils/cache.h"
@@ -81,6 +83,10 @@
  *
  * Counters are updated atomically by the use of the stats_counter_inc/dec()
  * methods.
+ *
+ * Dynamic counters that are registered and incremented for each message
+ * should go through stats_dynamic_cache_increment(), which only takes
+ * stats_lock() when a thread uses a cluster for the first time.
  */
 
 
@@ -94,8 +100,8 @@ stats_cluster_is_expired(StatsOptions *options, StatsCluster *sc, time_t now)
   if (!sc->dynamic)
     return FALSE;
 
-  /* this entry is being updated, cannot be too old */
-  if (!stats_cluster_is_orphaned(sc))
+  /* this entry is being updated (or exported), cannot be too old */
+  if (!stats_cluster_is_removable(sc))
     return FALSE;
 
   /* check if timestamp is stored, no timestamp means we can't expire it.
@@ -163,6 +169,10 @@ stats_publish_and_prune_counters(StatsOptions *options)
   stats_foreach_cluster_remove(stats_format_and_prune_cluster, &st);
   stats_unlock();
 
+  /* clusters referenced by the thread-local caches can only be pruned
+   * once the threads have released them */
+  stats_dynamic_cache_invalidate();
+
   if (publish)
     msg_event_send(st.stats_event);
 
@@ -235,6 +245,8 @@ stats_reinit(StatsOptions *options)
 {
   stats_options = options;
   stats_timer_reinit(options);
+  stats_dynamic_cache_invalidate();
+  stats_http_exporter_reinit(options);
 }
 
 void
@@ -242,13 +254,16 @@ stats_init(void)
 {
   stats_cluster_init();
   stats_registry_init();
+  stats_dynamic_cache_global_init();
   stats_aggregator_registry_init();
 }
 
 void
 stats_destroy(void)
 {
+  stats_http_exporter_stop();
   stats_aggregator_registry_deinit();
+  stats_dynamic_cache_global_deinit();
   stats_registry_deinit();
   stats_cluster_deinit();
 }
@@ -261,6 +276,15 @@ stats_options_defaults(StatsOptions *options)
   options->lifetime = 600;
   options->max_dynamic = -1;
   options->syslog_stats = CYNA_AUTO;
+  options->prometheus_address = NULL;
+  options->prometheus_port = 0;
+}
+
+void
+stats_options_destroy(StatsOptions *options)
+{
+  g_free(options->prometheus_address);
+  options->prometheus_address = NULL;
 }
 
 gboolean
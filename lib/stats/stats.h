@@ -36,6 +36,8 @@ typedef struct _StatsOptions
   gint lifetime;
   gint max_dynamic;
   CfgYesNoAuto syslog_stats;
+  gchar *prometheus_address;
+  gint prometheus_port;
 } StatsOptions;
 
 enum
@@ -51,6 +53,7 @@ void stats_init(void);
 void stats_destroy(void);
 
 void stats_options_defaults(StatsOptions *options);
+void stats_options_destroy(StatsOptions *options);
 
 #endif
 
@@ -31,6 +31,7 @@
 #include "stats/stats-counter.h"
 #include "stats/stats-query.h"
 #include "stats/stats-registry.h"
+#include "stats/stats-dynamic-cache.h"
 #include <limits.h>
 #include <time.h>
 
@@ -83,3 +84,93 @@ Test(stats_dynamic_clusters, register_limited)
   stats_unlock();
 }
 
+
+static gsize
+_get_counter_value(const StatsClusterKey *sc_key, gint type)
+{
+  gsize value;
+
+  stats_lock();
+  value = stats_counter_get(stats_get_counter(sc_key, type));
+  stats_unlock();
+  return value;
+}
+
+static gboolean
+_is_orphaned(const StatsClusterKey *sc_key)
+{
+  gboolean orphaned;
+
+  stats_lock();
+  orphaned = stats_cluster_is_orphaned(stats_get_cluster(sc_key));
+  stats_unlock();
+  return orphaned;
+}
+
+Test(stats_dynamic_clusters, cached_increment)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, "testhost1");
+
+  stats_dynamic_cache_increment(0, &sc_key, 1000);
+  stats_dynamic_cache_increment(0, &sc_key, 1001);
+  stats_dynamic_cache_increment(0, &sc_key, 1002);
+
+  cr_assert_eq(_get_counter_value(&sc_key, SC_TYPE_PROCESSED), 3);
+  cr_assert_eq(_get_counter_value(&sc_key, SC_TYPE_STAMP), 1002);
+
+  /* the cache holds on to the cluster */
+  cr_assert_not(_is_orphaned(&sc_key));
+}
+
+Test(stats_dynamic_clusters, cached_clusters_are_released_after_invalidation)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key, other_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, "testhost1");
+  stats_cluster_logpipe_key_legacy_set(&other_key, SCS_HOST | SCS_SOURCE, NULL, "testhost2");
+
+  stats_dynamic_cache_increment(0, &sc_key, 1000);
+  stats_dynamic_cache_invalidate();
+  cr_assert_not(_is_orphaned(&sc_key));
+
+  /* references are dropped by the next update of the thread */
+  stats_dynamic_cache_increment(0, &other_key, 1001);
+  cr_assert(_is_orphaned(&sc_key));
+  cr_assert_not(_is_orphaned(&other_key));
+  cr_assert_eq(_get_counter_value(&sc_key, SC_TYPE_PROCESSED), 1);
+
+  stats_dynamic_cache_increment(0, &sc_key, 1002);
+  cr_assert_not(_is_orphaned(&sc_key));
+  cr_assert_eq(_get_counter_value(&sc_key, SC_TYPE_PROCESSED), 2);
+  cr_assert_eq(_get_counter_value(&sc_key, SC_TYPE_STAMP), 1002);
+}
+
+Test(stats_dynamic_clusters, cached_increment_respects_limit)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 3;
+  stats_opts.max_dynamic = 1;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey sc_key;
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, "testhost1");
+  stats_dynamic_cache_increment(0, &sc_key, 1000);
+
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, "testhost2");
+  stats_dynamic_cache_increment(0, &sc_key, 1000);
+
+  stats_lock();
+  cr_assert_null(stats_get_cluster(&sc_key));
+  stats_unlock();
+}
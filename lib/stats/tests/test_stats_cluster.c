@@ -26,6 +26,7 @@
 
 #include "stats/stats-cluster.h"
 #include "stats/stats-cluster-single.h"
+#include "stats/stats-cluster-histogram.h"
 #include "apphook.h"
 
 guint SCS_FILE;
@@ -353,6 +354,45 @@ Test(stats_cluster, test_get_counter)
   stats_cluster_free(sc);
 }
 
+Test(stats_cluster, test_histogram_observe_fills_buckets)
+{
+  StatsClusterKey sc_key;
+  stats_cluster_histogram_key_set(&sc_key, "histogram", NULL, 0);
+  StatsCluster *sc = stats_cluster_new(&sc_key);
+
+  cr_assert(stats_cluster_is_histogram(sc));
+  cr_assert_eq(sc->counter_group.capacity, SC_TYPE_HISTOGRAM_MAX);
+
+  for (gint type = 0; type < SC_TYPE_HISTOGRAM_MAX; type++)
+    stats_cluster_track_counter(sc, type);
+
+  StatsCounterItem *histogram = sc->counter_group.counters;
+  stats_histogram_observe(histogram, 0);
+  stats_histogram_observe(histogram, 1);
+  stats_histogram_observe(histogram, 2);
+  stats_histogram_observe(histogram, 3);
+  stats_histogram_observe(histogram, 50000000);
+  stats_histogram_observe(histogram, 50000001);
+  stats_histogram_observe(NULL, 1);
+
+  cr_assert_eq(stats_counter_get(&histogram[0]), 2, "le_1");
+  cr_assert_eq(stats_counter_get(&histogram[1]), 1, "le_2");
+  cr_assert_eq(stats_counter_get(&histogram[2]), 1, "le_5");
+  cr_assert_eq(stats_counter_get(&histogram[SC_TYPE_HISTOGRAM_BUCKET_INF - 1]), 1, "le_50000000");
+  cr_assert_eq(stats_counter_get(&histogram[SC_TYPE_HISTOGRAM_BUCKET_INF]), 1, "le_inf");
+  cr_assert_eq(stats_counter_get(&histogram[SC_TYPE_HISTOGRAM_SUM]), 100000007);
+  cr_assert_eq(stats_counter_get(&histogram[SC_TYPE_HISTOGRAM_COUNT]), 6);
+
+  cr_assert_eq(stats_cluster_histogram_get_cumulative_count(sc, 2), 4);
+  cr_assert_eq(stats_cluster_histogram_get_cumulative_count(sc, SC_TYPE_HISTOGRAM_BUCKET_INF), 6);
+
+  cr_assert_eq(stats_cluster_histogram_get_bucket_bound(3), 10);
+  cr_assert_str_eq(stats_cluster_get_type_name(sc, SC_TYPE_HISTOGRAM_BUCKET_INF), "le_inf");
+  cr_assert_str_eq(stats_cluster_get_type_name(sc, SC_TYPE_HISTOGRAM_COUNT), "count");
+
+  stats_cluster_free(sc);
+}
+
 Test(stats_cluster, test_register_type)
 {
   guint first = stats_register_type("HAL");
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
+
+#include "stats/stats-counter.h"
+
+#define NUM_THREADS 32
+#define NUM_UPDATES_PER_THREAD 250000
+
+static StatsCounterItem *
+_construct_counter(gboolean sharded)
+{
+  StatsCounterItem *counter = g_new0(StatsCounterItem, 1);
+
+  if (sharded)
+    stats_counter_make_sharded(counter);
+  return counter;
+}
+
+static void
+_free_counter(StatsCounterItem *counter)
+{
+  stats_counter_clear(counter);
+  g_free(counter);
+}
+
+static gpointer
+_update_counter(gpointer user_data)
+{
+  StatsCounterItem *counter = (StatsCounterItem *) user_data;
+
+  for (gint i = 0; i < NUM_UPDATES_PER_THREAD; i++)
+    {
+      stats_counter_inc(counter);
+      stats_counter_add(counter, 2);
+      stats_counter_sub(counter, 1);
+    }
+  return NULL;
+}
+
+static void
+_update_counter_from_threads(StatsCounterItem *counter)
+{
+  GThread *threads[NUM_THREADS];
+
+  for (gint i = 0; i < NUM_THREADS; i++)
+    threads[i] = g_thread_new(NULL, _update_counter, counter);
+  for (gint i = 0; i < NUM_THREADS; i++)
+    g_thread_join(threads[i]);
+}
+
+Test(stats_counter, sharded_counter_is_summed_when_read)
+{
+  StatsCounterItem *counter = _construct_counter(TRUE);
+
+  stats_counter_inc(counter);
+  stats_counter_add(counter, 10);
+  stats_counter_dec(counter);
+  stats_counter_sub(counter, 3);
+  cr_assert_eq(stats_counter_get(counter), 7);
+
+  stats_counter_set(counter, 42);
+  cr_assert_eq(stats_counter_get(counter), 42);
+  stats_counter_inc(counter);
+  cr_assert_eq(stats_counter_get(counter), 43);
+
+  _free_counter(counter);
+}
+
+Test(stats_counter, updates_before_sharding_are_kept)
+{
+  StatsCounterItem *counter = _construct_counter(FALSE);
+
+  stats_counter_add(counter, 5);
+  stats_counter_make_sharded(counter);
+  stats_counter_inc(counter);
+  cr_assert_eq(stats_counter_get(counter), 6);
+
+  _free_counter(counter);
+}
+
+Test(stats_counter, sharded_counter_updates_from_multiple_threads_are_not_lost)
+{
+  StatsCounterItem *counter = _construct_counter(TRUE);
+
+  _update_counter_from_threads(counter);
+  cr_assert_eq(stats_counter_get(counter), 2 * NUM_THREADS * NUM_UPDATES_PER_THREAD);
+
+  _free_counter(counter);
+}
+
+static void
+_measure_contention(gboolean sharded)
+{
+  StatsCounterItem *counter = _construct_counter(sharded);
+
+  start_stopwatch();
+  _update_counter_from_threads(counter);
+  stop_stopwatch_and_display_result(NUM_THREADS * NUM_UPDATES_PER_THREAD * 3,
+                                    "%s counter updated from %d threads",
+                                    sharded ? "sharded" : "shared", NUM_THREADS);
+  cr_assert_eq(stats_counter_get(counter), 2 * NUM_THREADS * NUM_UPDATES_PER_THREAD);
+
+  _free_counter(counter);
+}
+
+Test(stats_counter, contention_benchmark)
+{
+  _measure_contention(FALSE);
+  _measure_contention(TRUE);
+}
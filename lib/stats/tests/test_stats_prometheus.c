@@ -28,7 +28,9 @@
 #include "stats/stats-cluster.h"
 #include "stats/stats-cluster-single.h"
 #include "stats/stats-cluster-logpipe.h"
+#include "stats/stats-cluster-histogram.h"
 #include "stats/stats-prometheus.h"
+#include "stats/stats-registry.h"
 #include "timeutils/unixtime.h"
 #include "scratch-buffers.h"
 #include "mainloop.h"
@@ -36,6 +38,7 @@
 #include "libtest/fake-time.h"
 
 #include <float.h>
+#include <string.h>
 #include <limits.h>
 
 static void
@@ -125,6 +128,37 @@ Test(stats_prometheus, test_prometheus_format_logpipe)
   stats_cluster_free(cluster);
 }
 
+Test(stats_prometheus, test_prometheus_format_histogram)
+{
+  StatsClusterLabel labels[] = { stats_cluster_label("app", "cisco") };
+  StatsClusterKey key;
+  stats_cluster_histogram_key_set(&key, "test_latency_seconds", labels, G_N_ELEMENTS(labels));
+  stats_cluster_single_key_add_unit(&key, SCU_MILLISECONDS);
+  StatsCluster *cluster = stats_cluster_new(&key);
+
+  for (gint type = 0; type < SC_TYPE_HISTOGRAM_MAX; type++)
+    stats_cluster_track_counter(cluster, type);
+
+  stats_histogram_observe(cluster->counter_group.counters, 1);
+  stats_histogram_observe(cluster->counter_group.counters, 15);
+  stats_histogram_observe(cluster->counter_group.counters, 1500);
+  stats_histogram_observe(cluster->counter_group.counters, 59998484);
+
+  assert_prometheus_format(cluster, 0, "syslogng_test_latency_seconds_bucket{app=\"cisco\",le=\"0.001\"} 1\n");
+  assert_prometheus_format(cluster, 4, "syslogng_test_latency_seconds_bucket{app=\"cisco\",le=\"0.02\"} 2\n");
+  assert_prometheus_format(cluster, 10, "syslogng_test_latency_seconds_bucket{app=\"cisco\",le=\"2\"} 3\n");
+  assert_prometheus_format(cluster, SC_TYPE_HISTOGRAM_BUCKET_INF - 1,
+                           "syslogng_test_latency_seconds_bucket{app=\"cisco\",le=\"50000\"} 3\n");
+  assert_prometheus_format(cluster, SC_TYPE_HISTOGRAM_BUCKET_INF,
+                           "syslogng_test_latency_seconds_bucket{app=\"cisco\",le=\"+Inf\"} 4\n");
+  assert_prometheus_format(cluster, SC_TYPE_HISTOGRAM_SUM,
+                           "syslogng_test_latency_seconds_sum{app=\"cisco\"} 60000\n");
+  assert_prometheus_format(cluster, SC_TYPE_HISTOGRAM_COUNT,
+                           "syslogng_test_latency_seconds_count{app=\"cisco\"} 4\n");
+
+  stats_cluster_free(cluster);
+}
+
 Test(stats_prometheus, test_prometheus_format_empty_label_value)
 {
   StatsClusterLabel labels[] =
@@ -307,3 +341,81 @@ Test(stats_prometheus, test_prometheus_format_legacy_alias_is_ignored)
   assert_prometheus_format(cluster, SC_TYPE_SINGLE_VALUE, "syslogng_name 0\n");
   stats_cluster_free(cluster);
 }
+
+static void
+_collect_chunk(const gchar *chunk, gpointer user_data)
+{
+  GString *output = (GString *) user_data;
+  g_string_append(output, chunk);
+}
+
+Test(stats_prometheus, test_prometheus_generate_in_chunks)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  gint num_counters = STATS_PROMETHEUS_CHUNK_CLUSTERS * 2 + 1;
+  StatsCounterItem **counters = g_new0(StatsCounterItem *, num_counters);
+  StatsClusterLabel *labels = g_new0(StatsClusterLabel, num_counters);
+  StatsClusterKey key;
+
+  stats_lock();
+  for (gint i = 0; i < num_counters; i++)
+    {
+      labels[i] = stats_cluster_label("id", g_strdup_printf("%d", i));
+      stats_cluster_single_key_set(&key, "test_chunked", &labels[i], 1);
+      stats_register_counter(0, &key, SC_TYPE_SINGLE_VALUE, &counters[i]);
+      stats_counter_set(counters[i], i);
+    }
+  stats_unlock();
+
+  GString *output = g_string_new("");
+  stats_generate_prometheus(_collect_chunk, output, FALSE, NULL);
+
+  cr_assert(strstr(output->str, "syslogng_test_chunked{id=\"0\"} 0\n"));
+  cr_assert(strstr(output->str, "syslogng_test_chunked{id=\"1024\"} 1024\n"));
+  cr_assert(strstr(output->str, "syslogng_test_chunked{id=\"2048\"} 2048\n"));
+
+  /* the rendered keys are cached, a second scrape has to produce the same output */
+  GString *second_output = g_string_new("");
+  stats_generate_prometheus(_collect_chunk, second_output, FALSE, NULL);
+  cr_assert_str_eq(output->str, second_output->str);
+
+  stats_lock();
+  for (gint i = 0; i < num_counters; i++)
+    {
+      stats_cluster_single_key_set(&key, "test_chunked", &labels[i], 1);
+      stats_unregister_counter(&key, SC_TYPE_SINGLE_VALUE, &counters[i]);
+      g_free((gchar *) labels[i].value);
+    }
+  stats_unlock();
+
+  g_string_free(second_output, TRUE);
+  g_string_free(output, TRUE);
+  g_free(labels);
+  g_free(counters);
+}
+
+Test(stats_prometheus, test_prometheus_pinned_clusters_are_not_removed)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey key;
+  StatsCounterItem *counter;
+  stats_cluster_single_key_set(&key, "test_pinned", NULL, 0);
+
+  stats_lock();
+  StatsCluster *sc = stats_register_counter(0, &key, SC_TYPE_SINGLE_VALUE, &counter);
+  stats_unregister_counter(&key, SC_TYPE_SINGLE_VALUE, &counter);
+
+  stats_cluster_pin(sc);
+  cr_assert_not(stats_remove_cluster(&key));
+  stats_cluster_unpin(sc);
+  cr_assert(stats_remove_cluster(&key));
+  stats_unlock();
+}
@@ -77,8 +77,48 @@ typedef struct _StrReprDecodeState
   const gchar *cur;
   gchar quote_char;
   const StrReprDecodeOptions *options;
+  /* characters that end a run of unquoted/quoted literals, empty if
+   * any character can be a delimiter */
+  gchar unquoted_stop_chars[4];
+  gchar quoted_stop_chars[3];
 } StrReprDecodeState;
 
+static void
+_init_stop_chars(StrReprDecodeState *state)
+{
+  const StrReprDecodeOptions *options = state->options;
+  gint n = 0;
+
+  if (options->delimiter_chars[0])
+    {
+      for (gsize i = 0; i < G_N_ELEMENTS(options->delimiter_chars); i++)
+        {
+          if (options->delimiter_chars[i])
+            state->unquoted_stop_chars[n++] = options->delimiter_chars[i];
+        }
+    }
+  state->unquoted_stop_chars[n] = 0;
+}
+
+/* Appends the current character along with the characters following it,
+ * up to the next one in @stop_chars.  The string functions of the libc
+ * are vectorized on most platforms, which is a lot faster than going
+ * through the state machine one character at a time.
+ */
+static inline void
+_append_literal_run(StrReprDecodeState *state, const gchar *stop_chars)
+{
+  gsize len = 1;
+
+  if (stop_chars[0])
+    len += strcspn(state->cur + 1, stop_chars);
+
+  g_string_append_len(state->value, state->cur, len);
+
+  /* _decode() steps over the last one */
+  state->cur += len - 1;
+}
+
 static gboolean
 _invoke_match_delimiter(StrReprDecodeState *state, const gchar **new_cur)
 {
@@ -130,6 +170,9 @@ _process_initial_character(StrReprDecodeState *state)
   else if (*state->cur == '\"' || *state->cur == '\'')
     {
       state->quote_char = *state->cur;
+      state->quoted_stop_chars[0] = state->quote_char;
+      state->quoted_stop_chars[1] = '\\';
+      state->quoted_stop_chars[2] = 0;
       return KV_QUOTE_STRING;
     }
   else
@@ -147,7 +190,7 @@ _process_quoted_string_characters(StrReprDecodeState *state)
   else if (*state->cur == '\\')
     return KV_QUOTE_BACKSLASH;
 
-  g_string_append_c(state->value, *state->cur);
+  _append_literal_run(state, state->quoted_stop_chars);
   return KV_QUOTE_STRING;
 }
 
@@ -179,7 +222,7 @@ _process_unquoted_characters(StrReprDecodeState *state)
 {
   if (_match_and_skip_delimiter(state))
     return KV_FINISH_SUCCESS;
-  g_string_append_c(state->value, *state->cur);
+  _append_literal_run(state, state->unquoted_stop_chars);
   return KV_UNQUOTED_CHARACTERS;
 }
 
@@ -243,6 +286,8 @@ str_repr_decode_append_with_options(GString *value, const gchar *input, const gc
   };
   gsize initial_len = value->len;
 
+  _init_stop_chars(&state);
+
   gboolean success = _decode(&state);
   *end = state.cur;
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "cpu-affinity.h"
+
+static void
+assert_cpus(GArray *cpus, const gint *expected, guint expected_len)
+{
+  cr_assert_not_null(cpus);
+  cr_assert_eq(cpus->len, expected_len, "unexpected number of CPUs: %u, expected: %u", cpus->len, expected_len);
+  for (guint i = 0; i < expected_len; i++)
+    cr_assert_eq(g_array_index(cpus, gint, i), expected[i]);
+}
+
+Test(cpu_affinity, test_parse_cpu_list)
+{
+  GArray *cpus;
+
+  cpus = cpu_affinity_parse_cpu_list("3");
+  assert_cpus(cpus, (const gint[]) { 3 }, 1);
+  g_array_unref(cpus);
+
+  cpus = cpu_affinity_parse_cpu_list("0-3,8");
+  assert_cpus(cpus, (const gint[]) { 0, 1, 2, 3, 8 }, 5);
+  g_array_unref(cpus);
+
+  cpus = cpu_affinity_parse_cpu_list(" 10-11, 2,2,0 ");
+  assert_cpus(cpus, (const gint[]) { 0, 2, 10, 11 }, 4);
+  g_array_unref(cpus);
+}
+
+Test(cpu_affinity, test_parse_invalid_cpu_list_returns_null)
+{
+  cr_assert_null(cpu_affinity_parse_cpu_list(""));
+  cr_assert_null(cpu_affinity_parse_cpu_list(","));
+  cr_assert_null(cpu_affinity_parse_cpu_list("a"));
+  cr_assert_null(cpu_affinity_parse_cpu_list("1-"));
+  cr_assert_null(cpu_affinity_parse_cpu_list("3-1"));
+  cr_assert_null(cpu_affinity_parse_cpu_list("-1"));
+  cr_assert_null(cpu_affinity_parse_cpu_list("1,,2"));
+  cr_assert_null(cpu_affinity_parse_cpu_list("100000"));
+}
+
+Test(cpu_affinity, test_intersect)
+{
+  GArray *a = cpu_affinity_parse_cpu_list("0-7");
+  GArray *b = cpu_affinity_parse_cpu_list("4-11");
+  GArray *c = cpu_affinity_parse_cpu_list("12-15");
+
+  GArray *common = cpu_affinity_intersect(a, b);
+  assert_cpus(common, (const gint[]) { 4, 5, 6, 7 }, 4);
+  g_array_unref(common);
+
+  cr_assert_null(cpu_affinity_intersect(a, c));
+
+  g_array_unref(a);
+  g_array_unref(b);
+  g_array_unref(c);
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "latency-sampler.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-histogram.h"
+#include "apphook.h"
+
+static LatencySampler *sampler;
+static UnixTime test_start;
+
+static LogMessage *
+_create_message(const gchar *source, gint age_sec)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  log_msg_set_value(msg, LM_V_SOURCE, source, -1);
+  msg->timestamps[LM_TS_RECVD] = test_start;
+  msg->timestamps[LM_TS_RECVD].ut_sec -= age_sec;
+
+  return msg;
+}
+
+static void
+_pop(const gchar *source, gint age_sec)
+{
+  LogMessage *msg = _create_message(source, age_sec);
+  latency_sampler_popped(sampler, msg);
+  log_msg_unref(msg);
+}
+
+static StatsCounterItem *
+_get_histogram(const gchar *name, const gchar *source)
+{
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("id", "test_dest"));
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("source", source));
+  stats_cluster_key_builder_set_name(kb, name);
+  stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+  StatsClusterKey *key = stats_cluster_key_builder_build_histogram(kb);
+
+  stats_lock();
+  StatsCluster *sc = stats_get_cluster(key);
+  stats_unlock();
+
+  stats_cluster_key_free(key);
+  stats_cluster_key_builder_free(kb);
+
+  cr_assert(sc, "histogram is not registered: %s{source=\"%s\"}", name, source);
+  return sc->counter_group.counters;
+}
+
+static gsize
+_get_count(const gchar *name, const gchar *source)
+{
+  return stats_counter_get(&_get_histogram(name, source)[SC_TYPE_HISTOGRAM_COUNT]);
+}
+
+static gsize
+_get_sum(const gchar *name, const gchar *source)
+{
+  return stats_counter_get(&_get_histogram(name, source)[SC_TYPE_HISTOGRAM_SUM]);
+}
+
+Test(latency_sampler, e2e_latency_is_recorded_when_the_sampled_message_is_acked)
+{
+  _pop("s_net", 5);
+  _pop("s_net", 5);
+  _pop("s_net", 5);
+
+  cr_assert_eq(_get_count("output_event_queue_latency_seconds", "s_net"), 1);
+  cr_assert_geq(_get_sum("output_event_queue_latency_seconds", "s_net"), 5000);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 0);
+
+  latency_sampler_acked(sampler, 1);
+
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 1);
+  cr_assert_geq(_get_sum("output_event_e2e_latency_seconds", "s_net"), 5000);
+  cr_assert_lt(_get_sum("output_event_e2e_latency_seconds", "s_net"), 60000);
+}
+
+Test(latency_sampler, histograms_are_per_source)
+{
+  _pop("s_net", 2);
+  _pop("s_local", 1);
+  latency_sampler_acked(sampler, 2);
+
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 1);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_local"), 1);
+}
+
+Test(latency_sampler, sample_waits_for_its_position_in_the_backlog)
+{
+  _pop("s_net", 3);
+  _pop("s_net", 2);
+  _pop("s_net", 1);
+
+  latency_sampler_acked(sampler, 1);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 1);
+
+  latency_sampler_acked(sampler, 1);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 2);
+
+  latency_sampler_acked(sampler, 1);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 3);
+}
+
+Test(latency_sampler, rewound_messages_are_sampled_again)
+{
+  _pop("s_net", 2);
+  _pop("s_net", 1);
+  latency_sampler_rewound(sampler, 1);
+
+  _pop("s_net", 1);
+  latency_sampler_acked(sampler, 2);
+
+  cr_assert_eq(_get_count("output_event_queue_latency_seconds", "s_net"), 3);
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 2);
+
+  _pop("s_net", 0);
+  latency_sampler_rewound_all(sampler);
+  _pop("s_net", 0);
+  latency_sampler_acked(sampler, 1);
+
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 3);
+}
+
+Test(latency_sampler, skipped_messages_are_not_recorded)
+{
+  _pop("s_net", 2);
+  _pop("s_net", 1);
+  latency_sampler_skipped(sampler, 1);
+  latency_sampler_acked(sampler, 1);
+
+  cr_assert_eq(_get_count("output_event_e2e_latency_seconds", "s_net"), 1);
+}
+
+Test(latency_sampler, no_sampler_below_the_stats_level)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  cr_assert_null(latency_sampler_new(STATS_LEVEL2, stats_cluster_key_builder_new()));
+
+  latency_sampler_popped(NULL, NULL);
+  latency_sampler_acked(NULL, 1);
+  latency_sampler_rewound_all(NULL);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  unix_time_set_now(&test_start);
+
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 2;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
+  stats_cluster_key_builder_add_label(kb, stats_cluster_label("id", "test_dest"));
+  sampler = latency_sampler_new(STATS_LEVEL2, kb);
+  cr_assert(sampler);
+}
+
+static void
+teardown(void)
+{
+  latency_sampler_free(sampler);
+  app_shutdown();
+}
+
+TestSuite(latency_sampler, .init = setup, .fini = teardown);
@@ -130,6 +130,7 @@ log_transport_init_instance(LogTransport *self, const gchar *name, gint fd)
 {
   self->name = name;
   self->fd = fd;
+  self->poll_fd = fd;
   self->cond = 0;
   self->free_fn = log_transport_free_method;
 }
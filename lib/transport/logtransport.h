@@ -50,6 +50,8 @@ typedef struct _LogTransportStack LogTransportStack;
 struct _LogTransport
 {
   gint fd;
+  /* the fd to poll for I/O readiness, normally the same as fd */
+  gint poll_fd;
   GIOCondition cond;
 
   gssize (*read)(LogTransport *self, gpointer buf, gsize count, LogTransportAuxData *aux);
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport/tls-session-cache.h"
+
+#include <string.h>
+#include <time.h>
+
+static SSL_SESSION *
+_create_session(const gchar *id, glong timeout)
+{
+  SSL_SESSION *session = SSL_SESSION_new();
+
+  SSL_SESSION_set1_id(session, (const guchar *) id, strlen(id));
+  SSL_SESSION_set_time(session, time(NULL));
+  SSL_SESSION_set_timeout(session, timeout);
+  SSL_SESSION_set_protocol_version(session, TLS1_2_VERSION);
+  return session;
+}
+
+static void
+_assert_session_id(SSL_SESSION *session, const gchar *expected_id)
+{
+  guint id_length;
+  const guchar *id = SSL_SESSION_get_id(session, &id_length);
+
+  cr_assert_eq(id_length, strlen(expected_id));
+  cr_assert_arr_eq(id, expected_id, id_length);
+}
+
+Test(tls_session_cache, store_and_lookup)
+{
+  TLSSessionCache *cache = tls_session_cache_new();
+  SSL_SESSION *session = _create_session("session-id", 300);
+
+  tls_session_cache_store(cache, "127.0.0.1:6514", session);
+  SSL_SESSION_free(session);
+  cr_assert_eq(tls_session_cache_size(cache), 1);
+
+  SSL_SESSION *looked_up = tls_session_cache_lookup(cache, "127.0.0.1:6514");
+  cr_assert_not_null(looked_up);
+  _assert_session_id(looked_up, "session-id");
+  SSL_SESSION_free(looked_up);
+
+  cr_assert_null(tls_session_cache_lookup(cache, "127.0.0.2:6514"));
+
+  tls_session_cache_remove(cache, "127.0.0.1:6514");
+  cr_assert_null(tls_session_cache_lookup(cache, "127.0.0.1:6514"));
+
+  tls_session_cache_free(cache);
+}
+
+Test(tls_session_cache, expired_sessions_are_dropped)
+{
+  TLSSessionCache *cache = tls_session_cache_new();
+  SSL_SESSION *session = _create_session("session-id", 300);
+
+  tls_session_cache_store(cache, "127.0.0.1:6514", session);
+  SSL_SESSION_free(session);
+
+  session = _create_session("another-id", 300);
+  SSL_SESSION_set_time(session, time(NULL) - 600);
+  tls_session_cache_store(cache, "127.0.0.1:6514", session);
+  SSL_SESSION_free(session);
+
+  /* the expired session is not stored, the first one is kept */
+  SSL_SESSION *looked_up = tls_session_cache_lookup(cache, "127.0.0.1:6514");
+  cr_assert_not_null(looked_up);
+  _assert_session_id(looked_up, "session-id");
+  SSL_SESSION_free(looked_up);
+
+  tls_session_cache_free(cache);
+}
+
+Test(tls_session_cache, serialize_and_deserialize)
+{
+  TLSSessionCache *cache = tls_session_cache_new();
+  GString *serialized = g_string_new(NULL);
+
+  for (gint i = 0; i < 3; i++)
+    {
+      gchar key[32], id[32];
+
+      g_snprintf(key, sizeof(key), "10.0.0.%d:6514", i);
+      g_snprintf(id, sizeof(id), "session-id-%d", i);
+
+      SSL_SESSION *session = _create_session(id, 300);
+      tls_session_cache_store(cache, key, session);
+      SSL_SESSION_free(session);
+    }
+  tls_session_cache_serialize(cache, serialized);
+  tls_session_cache_free(cache);
+
+  cache = tls_session_cache_new();
+  cr_assert(tls_session_cache_deserialize(cache, serialized->str, serialized->len));
+  cr_assert_eq(tls_session_cache_size(cache), 3);
+
+  SSL_SESSION *looked_up = tls_session_cache_lookup(cache, "10.0.0.1:6514");
+  cr_assert_not_null(looked_up);
+  _assert_session_id(looked_up, "session-id-1");
+  SSL_SESSION_free(looked_up);
+
+  tls_session_cache_free(cache);
+  g_string_free(serialized, TRUE);
+}
+
+Test(tls_session_cache, deserialize_rejects_invalid_input)
+{
+  TLSSessionCache *cache = tls_session_cache_new();
+  gchar unknown_version[] = { 0x7f, 0, 0, 0, 0 };
+  gchar truncated[] = { 1, 0, 0, 0, 2 };
+
+  cr_assert_not(tls_session_cache_deserialize(cache, "", 0));
+  cr_assert_not(tls_session_cache_deserialize(cache, unknown_version, sizeof(unknown_version)));
+  cr_assert_not(tls_session_cache_deserialize(cache, truncated, sizeof(truncated)));
+  cr_assert_eq(tls_session_cache_size(cache), 0);
+
+  tls_session_cache_free(cache);
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport/transport-io-uring.h"
+#include "transport/transport-stack.h"
+#include "apphook.h"
+
+#include <sys/socket.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+static gint pair[2];
+
+static LogTransport *
+_construct_transport(void)
+{
+  cr_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+
+  LogTransport *transport = log_transport_io_uring_stream_socket_new(pair[0]);
+  if (!transport)
+    {
+      close(pair[0]);
+      close(pair[1]);
+      cr_skip_test("io_uring is not available");
+    }
+
+  cr_assert_neq(transport->poll_fd, transport->fd, "completions should be signalled on a separate fd");
+  return transport;
+}
+
+static void
+_destroy_transport(LogTransport *transport)
+{
+  log_transport_free(transport);
+  close(pair[0]);
+  close(pair[1]);
+}
+
+static gssize
+_read_when_ready(LogTransport *transport, gchar *buf, gsize buflen)
+{
+  for (gint i = 0; i < 100; i++)
+    {
+      struct pollfd pfd = { .fd = transport->poll_fd, .events = POLLIN };
+      poll(&pfd, 1, 10);
+
+      gssize rc = log_transport_read(transport, buf, buflen, NULL);
+      if (rc >= 0 || errno != EAGAIN)
+        return rc;
+    }
+  return -1;
+}
+
+Test(transport_io_uring, test_read_returns_received_data)
+{
+  LogTransport *transport = _construct_transport();
+  gchar buf[64];
+
+  cr_assert_eq(write(pair[1], "hello world\n", 12), 12);
+  cr_assert_eq(_read_when_ready(transport, buf, sizeof(buf)), 12);
+  cr_assert_arr_eq(buf, "hello world\n", 12);
+
+  errno = 0;
+  cr_assert_eq(log_transport_read(transport, buf, sizeof(buf), NULL), -1);
+  cr_assert_eq(errno, EAGAIN);
+
+  _destroy_transport(transport);
+}
+
+Test(transport_io_uring, test_completion_is_consumed_in_multiple_reads)
+{
+  LogTransport *transport = _construct_transport();
+  gchar buf[64];
+
+  cr_assert_eq(write(pair[1], "0123456789", 10), 10);
+  cr_assert_eq(_read_when_ready(transport, buf, 4), 4);
+  cr_assert_arr_eq(buf, "0123", 4);
+
+  /* the rest of the completion is available without waiting */
+  struct pollfd pfd = { .fd = transport->poll_fd, .events = POLLIN };
+  cr_assert_eq(poll(&pfd, 1, 0), 1);
+
+  cr_assert_eq(log_transport_read(transport, buf, 4, NULL), 4);
+  cr_assert_arr_eq(buf, "4567", 4);
+  cr_assert_eq(log_transport_read(transport, buf, sizeof(buf), NULL), 2);
+  cr_assert_arr_eq(buf, "89", 2);
+
+  _destroy_transport(transport);
+}
+
+Test(transport_io_uring, test_more_data_than_provided_buffers)
+{
+  LogTransport *transport = _construct_transport();
+  gchar chunk[4096];
+  gchar buf[4096];
+  gsize total = 0;
+
+  memset(chunk, 'x', sizeof(chunk));
+  for (gint i = 0; i < 64; i++)
+    {
+      cr_assert_eq(write(pair[1], chunk, sizeof(chunk)), sizeof(chunk));
+      while (TRUE)
+        {
+          gssize rc = log_transport_read(transport, buf, sizeof(buf), NULL);
+          if (rc < 0)
+            break;
+          total += rc;
+        }
+    }
+  shutdown(pair[1], SHUT_WR);
+
+  gssize rc;
+  while ((rc = _read_when_ready(transport, buf, sizeof(buf))) > 0)
+    total += rc;
+
+  cr_assert_eq(rc, 0, "EOF expected after all data was read");
+  cr_assert_eq(total, 64 * sizeof(chunk));
+
+  _destroy_transport(transport);
+}
+
+Test(transport_io_uring, test_eof)
+{
+  LogTransport *transport = _construct_transport();
+  gchar buf[64];
+
+  shutdown(pair[1], SHUT_WR);
+  cr_assert_eq(_read_when_ready(transport, buf, sizeof(buf)), 0);
+  cr_assert_eq(log_transport_read(transport, buf, sizeof(buf), NULL), 0);
+
+  _destroy_transport(transport);
+}
+
+Test(transport_io_uring, test_stack_polls_the_completion_fd)
+{
+  LogTransport *transport = _construct_transport();
+  LogTransportStack stack;
+
+  log_transport_stack_init(&stack, NULL);
+  stack.fd = pair[0];
+  log_transport_stack_add_transport(&stack, LOG_TRANSPORT_SOCKET, transport);
+
+  cr_assert_eq(log_transport_stack_get_poll_fd(&stack), transport->poll_fd);
+
+  /* closes pair[0] */
+  log_transport_stack_deinit(&stack);
+  close(pair[1]);
+}
+
+TestSuite(transport_io_uring, .init = app_startup, .fini = app_shutdown);
@@ -25,6 +25,7 @@
 #include "messages.h"
 #include "compat/openssl_support.h"
 #include "secret-storage/secret-storage.h"
+#include "gsocket.h"
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -154,6 +155,194 @@ tls_context_setup_session_tickets(TLSContext *self)
   openssl_ctx_setup_session_tickets(self->ssl_ctx);
 }
 
+/*
+ * Session resumption
+ *
+ * Clients keep the sessions of the servers they connected to in
+ * self->session_cache, keyed by the address of the server.  Servers use
+ * the internal session cache of OpenSSL and ticket keys that are kept in
+ * persist-state, so tickets remain valid after a reload or restart.
+ */
+
+static int
+_store_client_session(SSL *ssl, SSL_SESSION *ssl_session)
+{
+  TLSSession *session = SSL_get_app_data(ssl);
+
+  if (session && session->resumption_key)
+    tls_session_cache_store(session->ctx->session_cache, session->resumption_key, ssl_session);
+
+  /* we keep our own copy, the reference is not taken over */
+  return 0;
+}
+
+static void
+_checksum_update_string(GChecksum *checksum, const gchar *str)
+{
+  if (str)
+    g_checksum_update(checksum, (const guchar *) str, -1);
+  g_checksum_update(checksum, (const guchar *) "", 1);
+}
+
+/* A resumed session skips certificate verification, so sessions are only
+ * resumed with the same verification settings they were established
+ * with, even if the ticket keys are kept across configuration changes. */
+static void
+_setup_session_id_context(TLSContext *self)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  guint8 digest[32];
+  gsize digest_len = sizeof(digest);
+
+  g_checksum_update(checksum, (const guchar *) &self->verify_mode, sizeof(self->verify_mode));
+  _checksum_update_string(checksum, self->ca_file);
+  _checksum_update_string(checksum, self->ca_dir);
+  _checksum_update_string(checksum, self->crl_dir);
+  for (GList *l = self->trusted_fingerprint_list; l; l = l->next)
+    _checksum_update_string(checksum, l->data);
+  for (GList *l = self->trusted_dn_list; l; l = l->next)
+    _checksum_update_string(checksum, l->data);
+
+  g_checksum_get_digest(checksum, digest, &digest_len);
+  g_checksum_free(checksum);
+
+  SSL_CTX_set_session_id_context(self->ssl_ctx, digest, MIN(digest_len, SSL_MAX_SID_CTX_LENGTH));
+}
+
+static void
+tls_context_setup_session_resumption(TLSContext *self)
+{
+  if (self->mode == TM_CLIENT)
+    {
+      SSL_CTX_set_session_cache_mode(self->ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(self->ssl_ctx, _store_client_session);
+    }
+  else
+    {
+      /* NOTE: TLS 1.3 session tickets are left enabled here, unlike in
+       * tls_context_setup_session_tickets(): they are sent after the
+       * handshake, which may lose data with clients that close the
+       * connection without ever reading it, see the comment at
+       * openssl_ctx_setup_session_tickets() */
+      SSL_CTX_set_session_cache_mode(self->ssl_ctx, SSL_SESS_CACHE_SERVER);
+      _setup_session_id_context(self);
+    }
+}
+
+static gchar *
+_format_resumption_key(gint fd)
+{
+  GSockAddr *peer_addr = g_socket_get_peer_name(fd);
+
+  if (!peer_addr)
+    return NULL;
+
+  gchar buf[MAX_SOCKADDR_STRING];
+  g_sockaddr_format(peer_addr, buf, sizeof(buf), GSA_FULL);
+  g_sockaddr_unref(peer_addr);
+
+  return g_strdup(buf);
+}
+
+void
+tls_context_resume_session(TLSContext *self, TLSSession *session, gint fd)
+{
+  if (!self->session_resumption || self->mode != TM_CLIENT)
+    return;
+
+  session->resumption_key = _format_resumption_key(fd);
+  if (!session->resumption_key)
+    return;
+
+  SSL_SESSION *ssl_session = tls_session_cache_lookup(self->session_cache, session->resumption_key);
+  if (!ssl_session)
+    return;
+
+  if (!SSL_set_session(session->ssl, ssl_session))
+    ERR_clear_error();
+  SSL_SESSION_free(ssl_session);
+}
+
+static void
+_load_client_sessions(TLSContext *self, PersistState *state, const gchar *persist_name)
+{
+  gsize length;
+  gchar *serialized = persist_state_lookup_string(state, persist_name, &length, NULL);
+
+  if (!serialized)
+    return;
+
+  if (!tls_session_cache_deserialize(self->session_cache, serialized, length))
+    msg_warning("Error restoring cached TLS sessions from persist-state, starting with an empty cache",
+                evt_tag_str("persist_name", persist_name),
+                tls_context_format_location_tag(self));
+  g_free(serialized);
+}
+
+static gboolean
+_load_server_ticket_keys(TLSContext *self, PersistState *state, const gchar *persist_name)
+{
+  glong keys_length = SSL_CTX_get_tlsext_ticket_keys(self->ssl_ctx, NULL, 0);
+  gsize length;
+  gchar *keys = persist_state_lookup_string(state, persist_name, &length, NULL);
+
+  if (keys && length != keys_length)
+    {
+      g_free(keys);
+      keys = NULL;
+    }
+
+  if (!keys)
+    {
+      keys = g_malloc(keys_length);
+      if (RAND_bytes((guchar *) keys, keys_length) != 1)
+        {
+          g_free(keys);
+          return FALSE;
+        }
+      persist_state_alloc_string(state, persist_name, keys, keys_length);
+    }
+
+  gboolean success = SSL_CTX_set_tlsext_ticket_keys(self->ssl_ctx, keys, keys_length);
+  OPENSSL_cleanse(keys, keys_length);
+  g_free(keys);
+  return success;
+}
+
+void
+tls_context_load_session_state(TLSContext *self, PersistState *state, const gchar *persist_name)
+{
+  if (!self->session_resumption)
+    return;
+
+  if (self->mode == TM_CLIENT)
+    {
+      _load_client_sessions(self, state, persist_name);
+      return;
+    }
+
+  if (!_load_server_ticket_keys(self, state, persist_name))
+    {
+      msg_warning("Error setting up persistent TLS session ticket keys, tickets will not be valid after a restart",
+                  tls_context_format_tls_error_tag(self),
+                  tls_context_format_location_tag(self));
+      ERR_clear_error();
+    }
+}
+
+/* server side ticket keys are stored right when they are generated */
+void
+tls_context_save_session_state(TLSContext *self, PersistState *state, const gchar *persist_name)
+{
+  if (!self->session_resumption || self->mode != TM_CLIENT)
+    return;
+
+  GString *serialized = g_string_new(NULL);
+  tls_session_cache_serialize(self->session_cache, serialized);
+  persist_state_alloc_string(state, persist_name, serialized->str, serialized->len);
+  g_string_free(serialized, TRUE);
+}
+
 static void
 tls_context_setup_verify_mode(TLSContext *self)
 {
@@ -249,6 +438,18 @@ tls_context_setup_ssl_options(TLSContext *self)
     }
 }
 
+/* OpenSSL installs the session keys into the kernel after the handshake,
+ * when both the cipher and the kernel support it.  Whether that succeeded
+ * is checked by the TLS transport on a per-connection basis. */
+static void
+tls_context_setup_ktls(TLSContext *self)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+  if (self->ktls)
+    SSL_CTX_set_options(self->ssl_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+}
+
 static gboolean
 _set_optional_ecdh_curve_list(SSL_CTX *ctx, const gchar *ecdh_curve_list)
 {
@@ -591,7 +792,9 @@ tls_context_setup_context(TLSContext *self)
 
   X509_VERIFY_PARAM_set_flags(SSL_CTX_get0_param(self->ssl_ctx), verify_flags);
 
-  if (self->mode == TM_SERVER)
+  if (self->session_resumption)
+    tls_context_setup_session_resumption(self);
+  else if (self->mode == TM_SERVER)
     tls_context_setup_session_tickets(self);
 
   tls_context_setup_verify_mode(self);
@@ -599,6 +802,7 @@ tls_context_setup_context(TLSContext *self)
 
   tls_context_setup_ssl_version(self);
   tls_context_setup_ssl_options(self);
+  tls_context_setup_ktls(self);
   if (!tls_context_setup_ecdh(self))
     goto error_no_print;
 
@@ -938,6 +1142,23 @@ tls_context_set_ocsp_stapling_verify(TLSContext *self, gboolean ocsp_stapling_ve
   self->ocsp_stapling_verify = ocsp_stapling_verify;
 }
 
+void
+tls_context_set_session_resumption(TLSContext *self, gboolean session_resumption)
+{
+  self->session_resumption = session_resumption;
+}
+
+gboolean
+tls_context_set_ktls(TLSContext *self, gboolean ktls)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+  self->ktls = ktls;
+  return TRUE;
+#else
+  return !ktls;
+#endif
+}
+
 /* NOTE: location is a string description where this tls context was defined, e.g. the location in the config */
 TLSContext *
 tls_context_new(TLSMode mode, const gchar *location)
@@ -958,6 +1179,7 @@ tls_context_new(TLSMode mode, const gchar *location)
       SSL_CTX_set_session_id_context(self->ssl_ctx, (const unsigned char *) "syslog", 6);
     }
   SSL_CTX_set_app_data(self->ssl_ctx, self);
+  self->session_cache = tls_session_cache_new();
 
   return self;
 }
@@ -967,6 +1189,7 @@ _tls_context_free(TLSContext *self)
 {
   g_free(self->location);
   SSL_CTX_free(self->ssl_ctx);
+  tls_session_cache_free(self->session_cache);
   g_list_foreach(self->conf_cmds_list, (GFunc) g_free, NULL);
   g_list_foreach(self->trusted_fingerprint_list, (GFunc) g_free, NULL);
   g_list_foreach(self->trusted_dn_list, (GFunc) g_free, NULL);
@@ -26,6 +26,8 @@
 
 #include "transport/tls-verifier.h"
 #include "transport/tls-session.h"
+#include "transport/tls-session-cache.h"
+#include "persist-state.h"
 #include "messages.h"
 
 typedef enum
@@ -90,6 +92,9 @@ struct _TLSContext
   gchar *ecdh_curve_list;
   gchar *sni;
   gboolean ocsp_stapling_verify;
+  gboolean ktls;
+  gboolean session_resumption;
+  TLSSessionCache *session_cache;
 
   SSL_CTX *ssl_ctx;
   GList *conf_cmds_list;
@@ -138,12 +143,17 @@ void tls_context_set_ecdh_curve_list(TLSContext *self, const gchar *ecdh_curve_l
 void tls_context_set_dhparam_file(TLSContext *self, const gchar *dhparam_file);
 void tls_context_set_sni(TLSContext *self, const gchar *sni);
 void tls_context_set_ocsp_stapling_verify(TLSContext *self, gboolean ocsp_stapling_verify);
+gboolean tls_context_set_ktls(TLSContext *self, gboolean ktls);
+void tls_context_set_session_resumption(TLSContext *self, gboolean session_resumption);
 const gchar *tls_context_get_key_file(TLSContext *self);
 EVTTAG *tls_context_format_tls_error_tag(TLSContext *self);
 EVTTAG *tls_context_format_location_tag(TLSContext *self);
 gboolean tls_context_verify_peer(TLSContext *self, X509 *peer_cert, const gchar *peer_name);
 TLSContextSetupResult tls_context_setup_context(TLSContext *self);
 TLSSession *tls_context_setup_session(TLSContext *self);
+void tls_context_resume_session(TLSContext *self, TLSSession *session, gint fd);
+void tls_context_load_session_state(TLSContext *self, PersistState *state, const gchar *persist_name);
+void tls_context_save_session_state(TLSContext *self, PersistState *state, const gchar *persist_name);
 TLSContext *tls_context_new(TLSMode mode, const gchar *config_location);
 TLSContext *tls_context_ref(TLSContext *self);
 void tls_context_unref(TLSContext *self);
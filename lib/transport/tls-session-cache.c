@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "transport/tls-session-cache.h"
+#include "serialize.h"
+
+#include <time.h>
+
+#define TLS_SESSION_CACHE_FORMAT_VERSION 1
+
+struct _TLSSessionCache
+{
+  GMutex lock;
+  /* key -> GBytes of the DER encoded SSL_SESSION */
+  GHashTable *sessions;
+};
+
+static gboolean
+_is_session_resumable(SSL_SESSION *session)
+{
+  if ((time_t) (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)) < time(NULL))
+    return FALSE;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+  return SSL_SESSION_is_resumable(session);
+#else
+  return TRUE;
+#endif
+}
+
+static SSL_SESSION *
+_decode_session(GBytes *encoded)
+{
+  gsize length;
+  const guchar *der = g_bytes_get_data(encoded, &length);
+
+  return d2i_SSL_SESSION(NULL, &der, length);
+}
+
+static GBytes *
+_encode_session(SSL_SESSION *session)
+{
+  gint length = i2d_SSL_SESSION(session, NULL);
+
+  if (length <= 0)
+    return NULL;
+
+  guchar *der = g_malloc(length);
+  guchar *p = der;
+  i2d_SSL_SESSION(session, &p);
+
+  return g_bytes_new_take(der, length);
+}
+
+/* NOTE: may be called from any thread */
+void
+tls_session_cache_store(TLSSessionCache *self, const gchar *key, SSL_SESSION *session)
+{
+  if (!_is_session_resumable(session))
+    return;
+
+  GBytes *encoded = _encode_session(session);
+  if (!encoded)
+    return;
+
+  g_mutex_lock(&self->lock);
+  g_hash_table_replace(self->sessions, g_strdup(key), encoded);
+  g_mutex_unlock(&self->lock);
+}
+
+/* returns a new SSL_SESSION instance or NULL, expired entries are dropped */
+SSL_SESSION *
+tls_session_cache_lookup(TLSSessionCache *self, const gchar *key)
+{
+  SSL_SESSION *session = NULL;
+
+  g_mutex_lock(&self->lock);
+  GBytes *encoded = g_hash_table_lookup(self->sessions, key);
+  if (encoded)
+    {
+      session = _decode_session(encoded);
+      if (session && !_is_session_resumable(session))
+        {
+          SSL_SESSION_free(session);
+          session = NULL;
+        }
+      if (!session)
+        g_hash_table_remove(self->sessions, key);
+    }
+  g_mutex_unlock(&self->lock);
+
+  return session;
+}
+
+void
+tls_session_cache_remove(TLSSessionCache *self, const gchar *key)
+{
+  g_mutex_lock(&self->lock);
+  g_hash_table_remove(self->sessions, key);
+  g_mutex_unlock(&self->lock);
+}
+
+guint
+tls_session_cache_size(TLSSessionCache *self)
+{
+  g_mutex_lock(&self->lock);
+  guint size = g_hash_table_size(self->sessions);
+  g_mutex_unlock(&self->lock);
+
+  return size;
+}
+
+void
+tls_session_cache_serialize(TLSSessionCache *self, GString *buffer)
+{
+  SerializeArchive *sa = serialize_string_archive_new(buffer);
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_mutex_lock(&self->lock);
+  serialize_write_uint8(sa, TLS_SESSION_CACHE_FORMAT_VERSION);
+  serialize_write_uint32(sa, g_hash_table_size(self->sessions));
+
+  g_hash_table_iter_init(&iter, self->sessions);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+      gsize length;
+      const gchar *der = g_bytes_get_data((GBytes *) value, &length);
+
+      serialize_write_cstring(sa, (const gchar *) key, -1);
+      serialize_write_cstring(sa, der, length);
+    }
+  g_mutex_unlock(&self->lock);
+
+  serialize_archive_free(sa);
+}
+
+gboolean
+tls_session_cache_deserialize(TLSSessionCache *self, gchar *data, gsize length)
+{
+  SerializeArchive *sa = serialize_buffer_archive_new(data, length);
+  gboolean success = FALSE;
+  guint8 version;
+  guint32 count;
+
+  if (!serialize_read_uint8(sa, &version) || version != TLS_SESSION_CACHE_FORMAT_VERSION)
+    goto exit;
+
+  if (!serialize_read_uint32(sa, &count))
+    goto exit;
+
+  for (guint32 i = 0; i < count; i++)
+    {
+      gchar *key, *der;
+      gsize der_length;
+
+      if (!serialize_read_cstring(sa, &key, NULL))
+        goto exit;
+      if (!serialize_read_cstring(sa, &der, &der_length))
+        {
+          g_free(key);
+          goto exit;
+        }
+
+      g_mutex_lock(&self->lock);
+      g_hash_table_replace(self->sessions, key, g_bytes_new_take(der, der_length));
+      g_mutex_unlock(&self->lock);
+    }
+  success = TRUE;
+
+exit:
+  serialize_archive_free(sa);
+  return success;
+}
+
+TLSSessionCache *
+tls_session_cache_new(void)
+{
+  TLSSessionCache *self = g_new0(TLSSessionCache, 1);
+
+  g_mutex_init(&self->lock);
+  self->sessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_bytes_unref);
+  return self;
+}
+
+void
+tls_session_cache_free(TLSSessionCache *self)
+{
+  g_hash_table_unref(self->sessions);
+  g_mutex_clear(&self->lock);
+  g_free(self);
+}
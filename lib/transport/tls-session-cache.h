@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef TRANSPORT_TLS_SESSION_CACHE_H_INCLUDED
+#define TRANSPORT_TLS_SESSION_CACHE_H_INCLUDED
+
+#include "syslog-ng.h"
+#include <openssl/ssl.h>
+
+/*
+ * Client side cache of TLS sessions, keyed by the server we connected to.
+ * Sessions are stored in their DER encoded form, so that they can be
+ * serialized as is (e.g. into persist-state) and every lookup returns a
+ * fresh SSL_SESSION instance owned by the caller.
+ */
+typedef struct _TLSSessionCache TLSSessionCache;
+
+void tls_session_cache_store(TLSSessionCache *self, const gchar *key, SSL_SESSION *session);
+SSL_SESSION *tls_session_cache_lookup(TLSSessionCache *self, const gchar *key);
+void tls_session_cache_remove(TLSSessionCache *self, const gchar *key);
+guint tls_session_cache_size(TLSSessionCache *self);
+
+void tls_session_cache_serialize(TLSSessionCache *self, GString *buffer);
+gboolean tls_session_cache_deserialize(TLSSessionCache *self, gchar *data, gsize length);
+
+TLSSessionCache *tls_session_cache_new(void);
+void tls_session_cache_free(TLSSessionCache *self);
+
+#endif
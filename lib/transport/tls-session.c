@@ -540,6 +540,9 @@ tls_session_info_callback(const SSL *ssl, int where, int ret)
           X509_free(cert);
         }
     }
+
+  if (where & SSL_CB_HANDSHAKE_DONE && SSL_session_reused((SSL *) ssl))
+    msg_debug("TLS session resumed", tls_context_format_location_tag(self->ctx));
 }
 
 static gboolean
@@ -590,6 +593,7 @@ tls_session_free(TLSSession *self)
   tls_context_unref(self->ctx);
   if (self->verifier)
     tls_verifier_unref(self->verifier);
+  g_free(self->resumption_key);
   SSL_free(self->ssl);
 
   g_free(self);
@@ -36,6 +36,8 @@ typedef struct _TLSSession
   SSL *ssl;
   TLSContext *ctx;
   TLSVerifier *verifier;
+  /* identifies the server in the client side session cache */
+  gchar *resumption_key;
   struct
   {
     int found;
@@ -38,6 +38,7 @@ _construct_transport(const LogTransportFactory *s, LogTransportStack *stack)
   tls_session_configure_allow_compress(tls_session, self->allow_compress);
 
   tls_session_set_verifier(tls_session, self->tls_verifier);
+  tls_context_resume_session(self->tls_context, tls_session, stack->fd);
 
   return log_transport_tls_new(tls_session, stack->fd);
 }
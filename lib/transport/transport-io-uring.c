@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "transport/transport-io-uring.h"
+#include "transport/transport-socket.h"
+#include "messages.h"
+
+#if SYSLOG_NG_ENABLE_IO_URING
+
+#include <liburing.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * LogTransportIOUring:
+ *
+ * A stream socket transport that receives data through io_uring instead of
+ * recvmsg().  A single multishot recv request is kept armed on the socket,
+ * the kernel picks a buffer from a ring of provided buffers for each
+ * completion, so data is received while LogProtoServer is still busy
+ * processing the previous chunk and a busy connection needs a syscall per
+ * batch of completions instead of a syscall per read.
+ *
+ * Completions are signalled through an eventfd, which is what the
+ * LogReader polls instead of the socket (see
+ * log_transport_stack_get_poll_fd()).  The eventfd is only drained once we
+ * run out of completions, so it stays readable as long as there is data to
+ * be consumed, making it behave like a level triggered socket.
+ *
+ * Needs Linux 6.0 or later (multishot recv).
+ */
+
+#define IO_URING_QUEUE_DEPTH     4
+#define IO_URING_BUFFER_GROUP    0
+#define IO_URING_BUFFERS         8
+#define IO_URING_BUFFER_SIZE     8192
+
+typedef struct _LogTransportIOUring
+{
+  LogTransportSocket super;
+  struct io_uring ring;
+  gboolean ring_initialized;
+  struct io_uring_buf_ring *buf_ring;
+  gchar *buffers;
+  gint event_fd;
+  gboolean recv_armed;
+
+  /* the completion we are consuming from, current_bid is -1 if none */
+  gint current_bid;
+  gsize current_pos;
+  gsize current_len;
+
+  gboolean eof;
+  gint error;
+} LogTransportIOUring;
+
+static inline gchar *
+_buffer(LogTransportIOUring *self, gint bid)
+{
+  return self->buffers + (gsize) bid * IO_URING_BUFFER_SIZE;
+}
+
+static void
+_return_buffer(LogTransportIOUring *self, gint bid)
+{
+  io_uring_buf_ring_add(self->buf_ring, _buffer(self, bid), IO_URING_BUFFER_SIZE, bid,
+                        io_uring_buf_ring_mask(IO_URING_BUFFERS), 0);
+  io_uring_buf_ring_advance(self->buf_ring, 1);
+}
+
+static gboolean
+_arm_recv(LogTransportIOUring *self)
+{
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&self->ring);
+
+  if (!sqe)
+    {
+      self->error = EBUSY;
+      return FALSE;
+    }
+
+  io_uring_prep_recv_multishot(sqe, self->super.super.fd, NULL, 0, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = IO_URING_BUFFER_GROUP;
+
+  gint rc = io_uring_submit(&self->ring);
+  if (rc < 0)
+    {
+      self->error = -rc;
+      return FALSE;
+    }
+
+  self->recv_armed = TRUE;
+  return TRUE;
+}
+
+/* returns TRUE if we have something to report: data, EOF or an error */
+static gboolean
+_reap_completion(LogTransportIOUring *self)
+{
+  struct io_uring_cqe *cqe;
+
+  while (io_uring_peek_cqe(&self->ring, &cqe) == 0)
+    {
+      gint res = cqe->res;
+      guint flags = cqe->flags;
+
+      io_uring_cqe_seen(&self->ring, cqe);
+
+      /* the multishot request terminated, it is rearmed once we run out of
+       * completions (e.g. on ENOBUFS, after we returned the buffers) */
+      if (!(flags & IORING_CQE_F_MORE))
+        self->recv_armed = FALSE;
+
+      if (res > 0)
+        {
+          self->current_bid = flags >> IORING_CQE_BUFFER_SHIFT;
+          self->current_pos = 0;
+          self->current_len = res;
+          return TRUE;
+        }
+      else if (res == 0)
+        {
+          self->eof = TRUE;
+          return TRUE;
+        }
+      else if (res != -ENOBUFS)
+        {
+          self->error = -res;
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+static gboolean
+_fetch_completion(LogTransportIOUring *self)
+{
+  if (_reap_completion(self))
+    return TRUE;
+
+  if (!self->recv_armed && !_arm_recv(self))
+    return TRUE;
+
+  /* nothing to consume: clear the notification and check again, so that a
+   * completion arriving in between is not lost */
+  eventfd_t value;
+  eventfd_read(self->event_fd, &value);
+
+  if (_reap_completion(self))
+    {
+      /* keep the eventfd readable, we may not consume everything in one go */
+      eventfd_write(self->event_fd, 1);
+      return TRUE;
+    }
+  return FALSE;
+}
+
+static gssize
+log_transport_io_uring_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  LogTransportIOUring *self = (LogTransportIOUring *) s;
+
+  if (self->current_bid < 0 && !self->eof && !self->error && !_fetch_completion(self))
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+
+  if (self->current_bid < 0)
+    {
+      if (self->error)
+        {
+          errno = self->error;
+          return -1;
+        }
+      return 0;
+    }
+
+  gsize len = MIN(buflen, self->current_len - self->current_pos);
+  memcpy(buf, _buffer(self, self->current_bid) + self->current_pos, len);
+  self->current_pos += len;
+
+  if (self->current_pos == self->current_len)
+    {
+      _return_buffer(self, self->current_bid);
+      self->current_bid = -1;
+    }
+
+  if (aux)
+    aux->proto = self->super.proto;
+  return len;
+}
+
+static void
+_free_ring(LogTransportIOUring *self)
+{
+  if (self->ring_initialized)
+    {
+      if (self->buf_ring)
+        io_uring_free_buf_ring(&self->ring, self->buf_ring, IO_URING_BUFFERS, IO_URING_BUFFER_GROUP);
+      io_uring_queue_exit(&self->ring);
+    }
+  if (self->event_fd >= 0)
+    close(self->event_fd);
+  g_free(self->buffers);
+}
+
+static void
+log_transport_io_uring_free_method(LogTransport *s)
+{
+  LogTransportIOUring *self = (LogTransportIOUring *) s;
+
+  _free_ring(self);
+  log_transport_stream_socket_free_method(s);
+}
+
+static gboolean
+_setup_ring(LogTransportIOUring *self)
+{
+  self->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (self->event_fd < 0)
+    {
+      self->error = errno;
+      return FALSE;
+    }
+
+  gint rc = io_uring_queue_init(IO_URING_QUEUE_DEPTH, &self->ring, 0);
+  if (rc < 0)
+    {
+      self->error = -rc;
+      return FALSE;
+    }
+  self->ring_initialized = TRUE;
+
+  self->buf_ring = io_uring_setup_buf_ring(&self->ring, IO_URING_BUFFERS, IO_URING_BUFFER_GROUP, 0, &rc);
+  if (!self->buf_ring)
+    {
+      self->error = -rc;
+      return FALSE;
+    }
+
+  self->buffers = g_malloc((gsize) IO_URING_BUFFERS * IO_URING_BUFFER_SIZE);
+  for (gint bid = 0; bid < IO_URING_BUFFERS; bid++)
+    _return_buffer(self, bid);
+
+  rc = io_uring_register_eventfd(&self->ring, self->event_fd);
+  if (rc < 0)
+    {
+      self->error = -rc;
+      return FALSE;
+    }
+
+  return _arm_recv(self);
+}
+
+gboolean
+log_transport_io_uring_is_supported(void)
+{
+  return TRUE;
+}
+
+LogTransport *
+log_transport_io_uring_stream_socket_new(gint fd)
+{
+  LogTransportIOUring *self = g_new0(LogTransportIOUring, 1);
+
+  log_transport_stream_socket_init_instance(&self->super, fd);
+  self->super.super.name = "io-uring-stream-socket";
+  self->super.super.read = log_transport_io_uring_read_method;
+  self->super.super.free_fn = log_transport_io_uring_free_method;
+  self->current_bid = -1;
+  self->event_fd = -1;
+
+  if (!_setup_ring(self))
+    {
+      /* the socket itself is left intact, the caller falls back to the
+       * plain stream socket transport */
+      msg_warning_once("WARNING: error setting up io_uring for a socket, falling back to regular reads",
+                       evt_tag_str("error", g_strerror(self->error)));
+      _free_ring(self);
+      g_free(self);
+      return NULL;
+    }
+
+  self->super.super.poll_fd = self->event_fd;
+  return &self->super.super;
+}
+
+#else
+
+gboolean
+log_transport_io_uring_is_supported(void)
+{
+  return FALSE;
+}
+
+LogTransport *
+log_transport_io_uring_stream_socket_new(gint fd)
+{
+  return NULL;
+}
+
+#endif
@@ -139,6 +139,19 @@ log_transport_stack_get_transport(LogTransportStack *self, gint index)
   return self->transports[index];
 }
 
+/* The fd the owner of the stack needs to poll, which is the fd of the
+ * socket layer unless that delivers its data some other way (e.g. io_uring
+ * completions signalled on an eventfd). */
+static inline gint
+log_transport_stack_get_poll_fd(LogTransportStack *self)
+{
+  LogTransport *socket_transport = self->transports[LOG_TRANSPORT_SOCKET];
+
+  if (socket_transport)
+    return socket_transport->poll_fd;
+  return self->fd;
+}
+
 void log_transport_stack_add_factory(LogTransportStack *self, LogTransportFactory *);
 void log_transport_stack_add_transport(LogTransportStack *self, gint index, LogTransport *);
 gboolean log_transport_stack_switch(LogTransportStack *self, gint index);
@@ -27,11 +27,34 @@
 #include "transport/transport-socket.h"
 
 #include "messages.h"
+#include "apphook.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <errno.h>
 
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send) && defined(BIO_get_ktls_recv)
+#define KTLS_SUPPORTED 1
+
+/* the plain socket I/O path relies on the Linux kTLS interface */
+#if defined(__linux__)
+#define KTLS_PLAIN_IO_SUPPORTED 1
+#include <sys/socket.h>
+#include <linux/tls.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+#define TLS_RECORD_TYPE_ALERT 21
+#define TLS_RECORD_TYPE_HANDSHAKE 22
+#define TLS_RECORD_TYPE_APPLICATION_DATA 23
+#define TLS_ALERT_CLOSE_NOTIFY 0
+#endif
+#endif
+
 const gchar *TLS_TRANSPORT_NAME = "tls";
 
 typedef struct _LogTransportTLS
@@ -39,8 +62,17 @@ typedef struct _LogTransportTLS
   LogTransportSocket super;
   TLSSession *tls_session;
   gboolean sending_shutdown;
+
+  /* kernel TLS offload state, determined once the handshake is over */
+  gboolean ktls_checked;
+  gboolean ktls_send;
+  gboolean ktls_recv;
+  gboolean ssl_write_pending;
 } LogTransportTLS;
 
+static StatsCounterItem *ktls_tx_connections;
+static StatsCounterItem *ktls_rx_connections;
+
 static inline gboolean
 _is_shutdown_sent(gint shutdown_rc)
 {
@@ -93,6 +125,133 @@ log_transport_tls_send_shutdown(LogTransportTLS *self)
   return shutdown_rc;
 }
 
+/*
+ * Kernel TLS offload
+ *
+ * With ktls(yes), OpenSSL hands the session keys over to the kernel after
+ * the handshake, provided that both the negotiated cipher and the kernel
+ * support it.  From then on the kernel encrypts/decrypts the records, so
+ * we can use the socket directly instead of SSL_read()/SSL_write(), saving
+ * the copies through OpenSSL's record buffers.
+ *
+ * Plain reads are only used on the server side: a TLS 1.3 server sends
+ * session tickets after the handshake, which the client needs OpenSSL to
+ * process.  SSL_read() still benefits from the offload there, as OpenSSL
+ * reads through the kernel too.
+ */
+
+static void
+log_transport_tls_check_ktls(LogTransportTLS *self)
+{
+  SSL *ssl = self->tls_session->ssl;
+
+  if (SSL_in_init(ssl))
+    return;
+
+  self->ktls_checked = TRUE;
+
+#ifdef KTLS_SUPPORTED
+  if (!self->tls_session->ctx->ktls)
+    return;
+
+  self->ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl));
+  self->ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(ssl));
+
+  if (self->ktls_send)
+    stats_counter_inc(ktls_tx_connections);
+  if (self->ktls_recv)
+    stats_counter_inc(ktls_rx_connections);
+
+  msg_debug("TLS handshake finished, kernel TLS offload status",
+            evt_tag_int("fd", self->super.super.fd),
+            evt_tag_str("tx", self->ktls_send ? "kernel" : "userspace"),
+            evt_tag_str("rx", self->ktls_recv ? "kernel" : "userspace"),
+            tls_context_format_location_tag(self->tls_session->ctx));
+#endif
+}
+
+#ifdef KTLS_PLAIN_IO_SUPPORTED
+
+static inline gboolean
+_is_ktls_plain_read_possible(LogTransportTLS *self)
+{
+  return self->ktls_recv &&
+         self->tls_session->ctx->mode == TM_SERVER &&
+         !SSL_has_pending(self->tls_session->ssl);
+}
+
+static gssize
+log_transport_tls_handle_ktls_control_record(LogTransportTLS *self, guchar record_type,
+                                             const guchar *record, gssize record_len)
+{
+  gboolean is_alert = (record_type == TLS_RECORD_TYPE_ALERT && record_len >= 2);
+
+  if (is_alert && record[1] == TLS_ALERT_CLOSE_NOTIFY)
+    return (log_transport_tls_send_shutdown(self) >= 0) ? 0 : -1;
+
+  /* anything else (a fatal alert or a post-handshake message like
+   * KeyUpdate) would need OpenSSL's state machine, which is bypassed */
+  msg_error("Unexpected TLS record received on a kernel TLS offloaded connection",
+            evt_tag_int("fd", self->super.super.fd),
+            evt_tag_int("record_type", record_type),
+            evt_tag_int("alert", is_alert ? record[1] : -1),
+            tls_context_format_location_tag(self->tls_session->ctx));
+  errno = ECONNRESET;
+  return -1;
+}
+
+static gssize
+log_transport_tls_ktls_read(LogTransportTLS *self, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  guchar record_type = TLS_RECORD_TYPE_APPLICATION_DATA;
+  gchar ctlbuf[256];
+  struct iovec iov = { .iov_base = buf, .iov_len = buflen };
+  struct msghdr msg = { 0 };
+  gssize rc;
+
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctlbuf;
+  msg.msg_controllen = sizeof(ctlbuf);
+
+  do
+    {
+      rc = recvmsg(self->super.super.fd, &msg, 0);
+    }
+  while (rc == -1 && errno == EINTR);
+
+  if (rc <= 0)
+    return rc;
+
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_TLS && cmsg->cmsg_type == TLS_GET_RECORD_TYPE)
+        record_type = *(guchar *) CMSG_DATA(cmsg);
+      else if (aux && self->super.parse_cmsg)
+        self->super.parse_cmsg(&self->super, cmsg, aux);
+    }
+
+  if (G_UNLIKELY(record_type != TLS_RECORD_TYPE_APPLICATION_DATA))
+    return log_transport_tls_handle_ktls_control_record(self, record_type, buf, rc);
+
+  return rc;
+}
+
+static gssize
+log_transport_tls_ktls_write(LogTransportTLS *self, const gpointer buf, gsize buflen)
+{
+  gssize rc;
+
+  do
+    {
+      rc = send(self->super.super.fd, buf, buflen, 0);
+    }
+  while (rc == -1 && errno == EINTR);
+  return rc;
+}
+
+#endif
+
 static gssize
 log_transport_tls_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
 {
@@ -125,6 +284,20 @@ log_transport_tls_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTr
 
       aux->proto = IPPROTO_TCP;
     }
+
+  if (G_UNLIKELY(!self->ktls_checked))
+    log_transport_tls_check_ktls(self);
+
+#ifdef KTLS_PLAIN_IO_SUPPORTED
+  if (_is_ktls_plain_read_possible(self))
+    {
+      rc = log_transport_tls_ktls_read(self, buf, buflen, aux);
+      if (rc > 0)
+        self->super.super.cond = 0;
+      return rc;
+    }
+#endif
+
   do
     {
       rc = SSL_read(self->tls_session->ssl, buf, buflen);
@@ -190,7 +363,22 @@ log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen
 
   self->super.super.cond = G_IO_OUT;
 
+  if (G_UNLIKELY(!self->ktls_checked))
+    log_transport_tls_check_ktls(self);
+
+#ifdef KTLS_PLAIN_IO_SUPPORTED
+  /* an SSL_write() that returned WANT_* has to be retried with SSL_write() */
+  if (self->ktls_send && !self->ssl_write_pending)
+    {
+      rc = log_transport_tls_ktls_write(self, buf, buflen);
+      if (rc >= 0)
+        self->super.super.cond = 0;
+      return rc;
+    }
+#endif
+
   rc = SSL_write(self->tls_session->ssl, buf, buflen);
+  self->ssl_write_pending = FALSE;
 
   if (rc < 0)
     {
@@ -201,9 +389,11 @@ log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen
           /* although we are writing this fd, libssl wants to read. This
            * happens during renegotiation for example */
           self->super.super.cond = G_IO_IN;
+          self->ssl_write_pending = TRUE;
           errno = EAGAIN;
           break;
         case SSL_ERROR_WANT_WRITE:
+          self->ssl_write_pending = TRUE;
           errno = EAGAIN;
           break;
         case SSL_ERROR_SYSCALL:
@@ -279,6 +469,58 @@ log_transport_tls_free_method(LogTransport *s)
   if (!SSL_in_init(self->tls_session->ssl))
     log_transport_tls_send_shutdown(self);
 
+  if (self->ktls_send)
+    stats_counter_dec(ktls_tx_connections);
+  if (self->ktls_recv)
+    stats_counter_dec(ktls_rx_connections);
+
   tls_session_free(self->tls_session);
   log_transport_stream_socket_free_method(s);
 }
+
+static void
+_format_ktls_stats_key(StatsClusterKey *sc_key, StatsClusterLabel *label, const gchar *direction)
+{
+  *label = stats_cluster_label("direction", direction);
+  stats_cluster_single_key_set(sc_key, "tls_ktls_offloaded_connections", label, 1);
+}
+
+static void
+log_transport_tls_register_stats(void)
+{
+  StatsClusterKey sc_key;
+  StatsClusterLabel label;
+
+  stats_lock();
+  _format_ktls_stats_key(&sc_key, &label, "tx");
+  stats_register_counter(0, &sc_key, SC_TYPE_SINGLE_VALUE, &ktls_tx_connections);
+  _format_ktls_stats_key(&sc_key, &label, "rx");
+  stats_register_counter(0, &sc_key, SC_TYPE_SINGLE_VALUE, &ktls_rx_connections);
+  stats_unlock();
+}
+
+static void
+log_transport_tls_unregister_stats(void)
+{
+  StatsClusterKey sc_key;
+  StatsClusterLabel label;
+
+  stats_lock();
+  _format_ktls_stats_key(&sc_key, &label, "tx");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &ktls_tx_connections);
+  _format_ktls_stats_key(&sc_key, &label, "rx");
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &ktls_rx_connections);
+  stats_unlock();
+}
+
+void
+log_transport_tls_global_init(void)
+{
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) log_transport_tls_register_stats, NULL, AHM_RUN_ONCE);
+}
+
+void
+log_transport_tls_global_deinit(void)
+{
+  log_transport_tls_unregister_stats();
+}
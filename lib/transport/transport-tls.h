@@ -30,4 +30,7 @@
 LogTransport *log_transport_tls_new(TLSSession *tls_session, gint fd);
 TLSSession *log_tansport_tls_get_session(LogTransport *s);
 
+void log_transport_tls_global_init(void);
+void log_transport_tls_global_deinit(void);
+
 #endif
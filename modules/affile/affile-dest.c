@@ -27,6 +27,7 @@
 #include "serialize.h"
 #include "gprocess.h"
 #include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
 #include "mainloop-call.h"
 #include "transport/transport-file.h"
 #include "logproto-file-writer.h"
@@ -448,6 +449,50 @@ affile_dd_set_fsync(LogDriver *s, gboolean use_fsync)
   self->use_fsync = use_fsync;
 }
 
+void
+affile_dd_set_fsync_interval(LogDriver *s, gint fsync_interval)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+
+  self->fsync_interval = fsync_interval;
+}
+
+void
+affile_dd_set_preallocate(LogDriver *s, gsize preallocate)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+
+  self->file_write_options.preallocate = preallocate;
+}
+
+void
+affile_dd_set_drop_cache(LogDriver *s, gboolean drop_cache)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+
+  self->file_write_options.drop_cache = drop_cache;
+}
+
+gboolean
+affile_dd_set_compression(LogDriver *s, const gchar *compression)
+{
+  AFFileDestDriver *self = (AFFileDestDriver *) s;
+  FileCompression value;
+
+  if (!file_compression_lookup(compression, &value))
+    return FALSE;
+
+  if (!file_compression_is_supported(value))
+    {
+      msg_error("The requested compression() is not supported by this build of syslog-ng",
+                evt_tag_str("compression", compression));
+      return FALSE;
+    }
+
+  self->file_write_options.compression = value;
+  return TRUE;
+}
+
 void
 affile_dd_set_time_reap(LogDriver *s, gint time_reap)
 {
@@ -527,6 +572,107 @@ affile_dd_reuse_writer(gpointer key, gpointer value, gpointer user_data)
     }
 }
 
+static void
+affile_dd_init_write_stats_keys(AFFileDestDriver *self, StatsClusterKey *writes, StatsClusterKey *written_bytes,
+                                StatsClusterKey *fsyncs, StatsClusterKey *fsync_latency)
+{
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("id", self->super.super.id),
+    stats_cluster_label("driver", "file"),
+  };
+
+  stats_cluster_single_key_set(writes, "output_file_writes_total", labels, G_N_ELEMENTS(labels));
+  stats_cluster_single_key_set(written_bytes, "output_file_written_bytes_total", labels, G_N_ELEMENTS(labels));
+  stats_cluster_single_key_add_unit(written_bytes, SCU_BYTES);
+  stats_cluster_single_key_set(fsyncs, "output_file_fsyncs_total", labels, G_N_ELEMENTS(labels));
+  stats_cluster_single_key_set(fsync_latency, "output_file_fsync_latency_seconds", labels, G_N_ELEMENTS(labels));
+  stats_cluster_single_key_add_unit(fsync_latency, SCU_NANOSECONDS);
+}
+
+/* bytes per write: written_bytes / writes */
+static void
+affile_dd_register_write_stats(AFFileDestDriver *self)
+{
+  FileWriteOptions *options = &self->file_write_options;
+  StatsClusterKey writes, written_bytes, fsyncs, fsync_latency;
+  gint level = log_pipe_is_internal(&self->super.super.super) ? STATS_LEVEL3 : STATS_LEVEL2;
+
+  affile_dd_init_write_stats_keys(self, &writes, &written_bytes, &fsyncs, &fsync_latency);
+
+  stats_lock();
+  stats_register_counter(level, &writes, SC_TYPE_SINGLE_VALUE, &options->writes);
+  stats_register_counter(level, &written_bytes, SC_TYPE_SINGLE_VALUE, &options->written_bytes);
+  stats_register_counter(level, &fsyncs, SC_TYPE_SINGLE_VALUE, &options->fsyncs);
+  stats_register_counter(level, &fsync_latency, SC_TYPE_SINGLE_VALUE, &options->fsync_latency);
+  stats_unlock();
+}
+
+static void
+affile_dd_unregister_write_stats(AFFileDestDriver *self)
+{
+  FileWriteOptions *options = &self->file_write_options;
+  StatsClusterKey writes, written_bytes, fsyncs, fsync_latency;
+
+  affile_dd_init_write_stats_keys(self, &writes, &written_bytes, &fsyncs, &fsync_latency);
+
+  stats_lock();
+  stats_unregister_counter(&writes, SC_TYPE_SINGLE_VALUE, &options->writes);
+  stats_unregister_counter(&written_bytes, SC_TYPE_SINGLE_VALUE, &options->written_bytes);
+  stats_unregister_counter(&fsyncs, SC_TYPE_SINGLE_VALUE, &options->fsyncs);
+  stats_unregister_counter(&fsync_latency, SC_TYPE_SINGLE_VALUE, &options->fsync_latency);
+  stats_unlock();
+}
+
+static void
+affile_dd_init_write_options(AFFileDestDriver *self)
+{
+  FileWriteOptions *options = &self->file_write_options;
+
+#ifndef SYSLOG_NG_HAVE_FALLOCATE
+  if (options->preallocate)
+    {
+      msg_warning("WARNING: preallocate() is not supported on this platform, ignoring",
+                  log_pipe_location_tag(&self->super.super.super));
+      options->preallocate = 0;
+    }
+#endif
+#ifndef SYSLOG_NG_HAVE_SYNC_FILE_RANGE
+  if (options->drop_cache)
+    {
+      msg_warning("WARNING: drop-cache() is not supported on this platform, ignoring",
+                  log_pipe_location_tag(&self->super.super.super));
+      options->drop_cache = FALSE;
+    }
+#endif
+
+  affile_dd_register_write_stats(self);
+
+  /* fsync(yes) syncs after each write already */
+  if (self->fsync_interval > 0 && !self->use_fsync)
+    {
+      options->sync_group = file_sync_group_new(self->fsync_interval);
+      file_sync_group_set_metrics(options->sync_group, options->fsyncs, options->fsync_latency);
+      file_sync_group_start(options->sync_group);
+    }
+}
+
+/* the writers are deinitialized by now, the files they have written since
+ * the last round are synced by a last one */
+static void
+affile_dd_deinit_write_options(AFFileDestDriver *self)
+{
+  FileWriteOptions *options = &self->file_write_options;
+
+  if (options->sync_group)
+    {
+      file_sync_group_stop(options->sync_group);
+      file_sync_group_unref(options->sync_group);
+      options->sync_group = NULL;
+    }
+
+  affile_dd_unregister_write_stats(self);
+}
 
 static gboolean
 affile_dd_init(LogPipe *s)
@@ -544,6 +690,8 @@ affile_dd_init(LogPipe *s)
   if (affile_dd_get_time_reap(self) == -1)
     affile_dd_set_time_reap(&self->super.super, cfg->time_reap);
 
+  affile_dd_init_write_options(self);
+
   if (self->filename_is_a_template)
     {
       self->writer_hash = cfg_persist_config_fetch(cfg, affile_dd_format_persist_name(s));
@@ -559,6 +707,7 @@ affile_dd_init(LogPipe *s)
           if (!log_pipe_init(&self->single_writer->super))
             {
               log_pipe_unref(&self->single_writer->super);
+              affile_dd_deinit_write_options(self);
               return FALSE;
             }
         }
@@ -640,6 +789,8 @@ affile_dd_deinit(LogPipe *s)
       self->writer_hash = NULL;
     }
 
+  affile_dd_deinit_write_options(self);
+
   if (!log_dest_driver_deinit_method(s))
     return FALSE;
 
@@ -853,7 +1004,8 @@ affile_dd_new(LogTemplate *filename_template, GlobalConfig *cfg)
 
   self->writer_flags |= LW_SOFT_FLOW_CONTROL;
   self->writer_options.stats_source = stats_register_type("file");
-  self->file_opener = file_opener_for_regular_dest_files_new(&self->writer_options, &self->use_fsync);
+  self->file_opener = file_opener_for_regular_dest_files_new(&self->writer_options, &self->use_fsync,
+                                                             &self->file_write_options);
   return &self->super.super;
 }
 
@@ -27,6 +27,7 @@
 #include "driver.h"
 #include "logwriter.h"
 #include "file-opener.h"
+#include "logproto-file-writer.h"
 
 typedef struct _AFFileDestWriter AFFileDestWriter;
 
@@ -39,6 +40,8 @@ typedef struct _AFFileDestDriver
   gboolean filename_is_a_template;
   gboolean template_escape;
   gboolean use_fsync;
+  gint fsync_interval;
+  FileWriteOptions file_write_options;
   FileOpenerOptions file_opener_options;
   FileOpener *file_opener;
   TimeZoneInfo *local_time_zone_info;
@@ -56,6 +59,10 @@ LogDriver *affile_dd_new(LogTemplate *filename_template, GlobalConfig *cfg);
 
 void affile_dd_set_create_dirs(LogDriver *s, gboolean create_dirs);
 void affile_dd_set_fsync(LogDriver *s, gboolean enable);
+void affile_dd_set_fsync_interval(LogDriver *s, gint fsync_interval);
+void affile_dd_set_preallocate(LogDriver *s, gsize preallocate);
+void affile_dd_set_drop_cache(LogDriver *s, gboolean drop_cache);
+gboolean affile_dd_set_compression(LogDriver *s, const gchar *compression);
 void affile_dd_set_overwrite_if_older(LogDriver *s, gint overwrite_if_older);
 void affile_dd_set_symlink_as(LogDriver *s, const gchar *symlink_as);
 void affile_dd_set_local_time_zone(LogDriver *s, const gchar *local_time_zone);
@@ -128,6 +128,16 @@ affile_sd_deinit(LogPipe *s)
   return TRUE;
 }
 
+static gboolean
+affile_sd_pre_config_init(LogPipe *s)
+{
+  AFFileSourceDriver *self = (AFFileSourceDriver *) s;
+
+  if (log_reader_options_is_dedicated_thread_enabled(&self->file_reader_options.reader_options))
+    main_loop_worker_allocate_thread_space(1);
+  return TRUE;
+}
+
 static void
 affile_sd_free(LogPipe *s)
 {
@@ -148,6 +158,7 @@ affile_sd_new_instance(gchar *filename, GlobalConfig *cfg)
   AFFileSourceDriver *self = g_new0(AFFileSourceDriver, 1);
 
   log_src_driver_init_instance(&self->super, cfg);
+  self->super.super.super.pre_config_init = affile_sd_pre_config_init;
   self->super.super.super.init = affile_sd_init;
   self->super.super.super.queue = affile_sd_queue;
   self->super.super.super.deinit = affile_sd_deinit;
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "file-compressor.h"
+#include "messages.h"
+
+#include <string.h>
+
+#if SYSLOG_NG_ENABLE_FILE_GZIP
+
+#include <zlib.h>
+
+/* 15 bits of window, +16 selects the gzip wrapper instead of zlib's */
+#define GZIP_WINDOW_BITS (15 + 16)
+#define GZIP_OUTPUT_CHUNK 16384
+
+typedef struct _GzipCompressor
+{
+  FileCompressor super;
+  z_stream stream;
+} GzipCompressor;
+
+static gboolean
+_gzip_deflate(GzipCompressor *self, const guchar *data, gsize len, gint flush, GByteArray *output)
+{
+  self->stream.next_in = (Bytef *) data;
+  self->stream.avail_in = len;
+
+  while (TRUE)
+    {
+      guint offset = output->len;
+
+      g_byte_array_set_size(output, offset + GZIP_OUTPUT_CHUNK);
+      self->stream.next_out = output->data + offset;
+      self->stream.avail_out = GZIP_OUTPUT_CHUNK;
+
+      gint rc = deflate(&self->stream, flush);
+      g_byte_array_set_size(output, offset + GZIP_OUTPUT_CHUNK - self->stream.avail_out);
+
+      if (rc == Z_STREAM_ERROR)
+        {
+          msg_error("Error compressing destination file with gzip",
+                    evt_tag_str("error", self->stream.msg ? self->stream.msg : "n/a"));
+          return FALSE;
+        }
+
+      /* deflate() only leaves output space unused once it has consumed
+       * all input and produced everything @flush asks for */
+      if (rc == Z_STREAM_END || self->stream.avail_out != 0)
+        return TRUE;
+    }
+}
+
+static gboolean
+_gzip_compress(FileCompressor *s, const guchar *data, gsize len, GByteArray *output)
+{
+  return _gzip_deflate((GzipCompressor *) s, data, len, Z_NO_FLUSH, output);
+}
+
+static gboolean
+_gzip_flush(FileCompressor *s, GByteArray *output)
+{
+  return _gzip_deflate((GzipCompressor *) s, NULL, 0, Z_SYNC_FLUSH, output);
+}
+
+static gboolean
+_gzip_finish(FileCompressor *s, GByteArray *output)
+{
+  GzipCompressor *self = (GzipCompressor *) s;
+
+  if (!_gzip_deflate(self, NULL, 0, Z_FINISH, output))
+    return FALSE;
+
+  /* further data goes to a new gzip member */
+  deflateReset(&self->stream);
+  return TRUE;
+}
+
+static void
+_gzip_free(FileCompressor *s)
+{
+  GzipCompressor *self = (GzipCompressor *) s;
+
+  deflateEnd(&self->stream);
+  g_free(self);
+}
+
+static FileCompressor *
+_gzip_compressor_new(void)
+{
+  GzipCompressor *self = g_new0(GzipCompressor, 1);
+
+  if (deflateInit2(&self->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      msg_error("Error initializing gzip compressor",
+                evt_tag_str("error", self->stream.msg ? self->stream.msg : "n/a"));
+      g_free(self);
+      return NULL;
+    }
+
+  self->super.compress = _gzip_compress;
+  self->super.flush = _gzip_flush;
+  self->super.finish = _gzip_finish;
+  self->super.free_fn = _gzip_free;
+  return &self->super;
+}
+
+#endif
+
+#if SYSLOG_NG_ENABLE_FILE_ZSTD
+
+#include <zstd.h>
+
+typedef struct _ZstdCompressor
+{
+  FileCompressor super;
+  ZSTD_CCtx *cctx;
+} ZstdCompressor;
+
+static gboolean
+_zstd_compress_stream(ZstdCompressor *self, const guchar *data, gsize len, ZSTD_EndDirective mode,
+                      GByteArray *output)
+{
+  ZSTD_inBuffer input = { data, len, 0 };
+  gsize chunk = ZSTD_CStreamOutSize();
+
+  while (TRUE)
+    {
+      guint offset = output->len;
+
+      g_byte_array_set_size(output, offset + chunk);
+      ZSTD_outBuffer out = { output->data + offset, chunk, 0 };
+
+      gsize remaining = ZSTD_compressStream2(self->cctx, &out, &input, mode);
+      g_byte_array_set_size(output, offset + out.pos);
+
+      if (ZSTD_isError(remaining))
+        {
+          msg_error("Error compressing destination file with zstd",
+                    evt_tag_str("error", ZSTD_getErrorName(remaining)));
+          return FALSE;
+        }
+
+      /* flush and end return the amount of data still buffered internally */
+      if (mode == ZSTD_e_continue ? input.pos == input.size : remaining == 0)
+        return TRUE;
+    }
+}
+
+static gboolean
+_zstd_compress(FileCompressor *s, const guchar *data, gsize len, GByteArray *output)
+{
+  return _zstd_compress_stream((ZstdCompressor *) s, data, len, ZSTD_e_continue, output);
+}
+
+static gboolean
+_zstd_flush(FileCompressor *s, GByteArray *output)
+{
+  return _zstd_compress_stream((ZstdCompressor *) s, NULL, 0, ZSTD_e_flush, output);
+}
+
+/* ends the frame, further data goes to a new one */
+static gboolean
+_zstd_finish(FileCompressor *s, GByteArray *output)
+{
+  return _zstd_compress_stream((ZstdCompressor *) s, NULL, 0, ZSTD_e_end, output);
+}
+
+static void
+_zstd_free(FileCompressor *s)
+{
+  ZstdCompressor *self = (ZstdCompressor *) s;
+
+  ZSTD_freeCCtx(self->cctx);
+  g_free(self);
+}
+
+static FileCompressor *
+_zstd_compressor_new(void)
+{
+  ZstdCompressor *self = g_new0(ZstdCompressor, 1);
+
+  self->cctx = ZSTD_createCCtx();
+  if (!self->cctx)
+    {
+      msg_error("Error initializing zstd compressor");
+      g_free(self);
+      return NULL;
+    }
+  ZSTD_CCtx_setParameter(self->cctx, ZSTD_c_checksumFlag, 1);
+
+  self->super.compress = _zstd_compress;
+  self->super.flush = _zstd_flush;
+  self->super.finish = _zstd_finish;
+  self->super.free_fn = _zstd_free;
+  return &self->super;
+}
+
+#endif
+
+gboolean
+file_compression_lookup(const gchar *name, FileCompression *compression)
+{
+  if (strcmp(name, "none") == 0)
+    *compression = FILE_COMPRESSION_NONE;
+  else if (strcmp(name, "gzip") == 0)
+    *compression = FILE_COMPRESSION_GZIP;
+  else if (strcmp(name, "zstd") == 0)
+    *compression = FILE_COMPRESSION_ZSTD;
+  else
+    return FALSE;
+  return TRUE;
+}
+
+gboolean
+file_compression_is_supported(FileCompression compression)
+{
+  switch (compression)
+    {
+    case FILE_COMPRESSION_NONE:
+      return TRUE;
+#if SYSLOG_NG_ENABLE_FILE_GZIP
+    case FILE_COMPRESSION_GZIP:
+      return TRUE;
+#endif
+#if SYSLOG_NG_ENABLE_FILE_ZSTD
+    case FILE_COMPRESSION_ZSTD:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+/* returns NULL for FILE_COMPRESSION_NONE or if the compressor could not be
+ * initialized */
+FileCompressor *
+file_compressor_new(FileCompression compression)
+{
+  switch (compression)
+    {
+#if SYSLOG_NG_ENABLE_FILE_GZIP
+    case FILE_COMPRESSION_GZIP:
+      return _gzip_compressor_new();
+#endif
+#if SYSLOG_NG_ENABLE_FILE_ZSTD
+    case FILE_COMPRESSION_ZSTD:
+      return _zstd_compressor_new();
+#endif
+    default:
+      return NULL;
+    }
+}
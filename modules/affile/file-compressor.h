@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef FILE_COMPRESSOR_H_INCLUDED
+#define FILE_COMPRESSOR_H_INCLUDED
+
+#include "syslog-ng.h"
+
+typedef enum
+{
+  FILE_COMPRESSION_NONE,
+  FILE_COMPRESSION_GZIP,
+  FILE_COMPRESSION_ZSTD,
+} FileCompression;
+
+/*
+ * Streaming compressor of the data written to a destination file.
+ * Compressed output is appended to @output.  flush() makes everything
+ * compressed so far decodable without ending the stream, finish() ends it:
+ * a gzip member or a zstd frame, files consisting of several of these can
+ * be decompressed as a whole.
+ */
+typedef struct _FileCompressor FileCompressor;
+
+struct _FileCompressor
+{
+  gboolean (*compress)(FileCompressor *self, const guchar *data, gsize len, GByteArray *output);
+  gboolean (*flush)(FileCompressor *self, GByteArray *output);
+  gboolean (*finish)(FileCompressor *self, GByteArray *output);
+  void (*free_fn)(FileCompressor *self);
+};
+
+static inline gboolean
+file_compressor_compress(FileCompressor *self, const guchar *data, gsize len, GByteArray *output)
+{
+  return self->compress(self, data, len, output);
+}
+
+static inline gboolean
+file_compressor_flush(FileCompressor *self, GByteArray *output)
+{
+  return self->flush(self, output);
+}
+
+static inline gboolean
+file_compressor_finish(FileCompressor *self, GByteArray *output)
+{
+  return self->finish(self, output);
+}
+
+static inline void
+file_compressor_free(FileCompressor *self)
+{
+  if (self)
+    self->free_fn(self);
+}
+
+gboolean file_compression_lookup(const gchar *name, FileCompression *compression);
+gboolean file_compression_is_supported(FileCompression compression);
+FileCompressor *file_compressor_new(FileCompression compression);
+
+#endif
@@ -99,12 +99,16 @@ _construct_poll_events(FileReader *self, gint fd)
   if (self->options->follow_freq > 0)
     {
       LogProtoFileReaderOptions *proto_opts = file_reader_options_get_log_proto_options(self->options);
+      PollEvents *poll_events;
 
       if (proto_opts->multi_line_options.mode == MLM_NONE)
-        return poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
+        poll_events = poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
       else
-        return poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
-                                               self->options->multi_line_timeout, self);
+        poll_events = poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
+                                                      self->options->multi_line_timeout, self);
+
+      poll_file_changes_set_event_driven(poll_events, self->options->follow_method == FFM_INOTIFY);
+      return poll_events;
     }
   else if (fd >= 0 && _is_fd_pollable(fd))
     return poll_fd_events_new(fd);
@@ -162,6 +166,8 @@ _setup_logreader(LogPipe *s, PollEvents *poll_events, LogProtoServer *proto)
   self->reader = log_reader_new(log_pipe_get_config(s));
   log_pipe_set_options(&self->reader->super.super, &self->super.options);
   log_reader_open(self->reader, proto, poll_events);
+  if (self->reader_thread)
+    log_reader_set_shared_thread(self->reader, self->reader_thread);
 
   StatsClusterKeyBuilder *kb = stats_cluster_key_builder_new();
   stats_cluster_key_builder_add_label(kb, stats_cluster_label("driver", "file"));
@@ -301,9 +307,17 @@ file_reader_free_method(LogPipe *s)
   FileReader *self = (FileReader *) s;
 
   g_assert(!self->reader);
+  log_reader_thread_unref(self->reader_thread);
   g_string_free(self->filename, TRUE);
 }
 
+void
+file_reader_set_reader_thread(FileReader *self, LogReaderThread *reader_thread)
+{
+  log_reader_thread_unref(self->reader_thread);
+  self->reader_thread = log_reader_thread_ref(reader_thread);
+}
+
 void
 file_reader_remove_persist_state(FileReader *self)
 {
@@ -366,6 +380,20 @@ file_reader_options_set_follow_freq(FileReaderOptions *options, gint follow_freq
   options->follow_freq = follow_freq;
 }
 
+gboolean
+file_reader_options_set_follow_method(FileReaderOptions *options, const gchar *follow_method)
+{
+  if (strcmp(follow_method, "poll") == 0)
+    options->follow_method = FFM_POLL;
+#if SYSLOG_NG_HAVE_INOTIFY
+  else if (strcmp(follow_method, "inotify") == 0)
+    options->follow_method = FFM_INOTIFY;
+#endif
+  else
+    return FALSE;
+  return TRUE;
+}
+
 void
 file_reader_options_set_multi_line_timeout(FileReaderOptions *options, gint multi_line_timeout)
 {
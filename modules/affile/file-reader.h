@@ -26,9 +26,16 @@
 #include "logreader.h"
 #include "file-opener.h"
 
+typedef enum
+{
+  FFM_POLL,
+  FFM_INOTIFY,
+} FileFollowMethod;
+
 typedef struct _FileReaderOptions
 {
   gint follow_freq;
+  FileFollowMethod follow_method;
   gint multi_line_timeout;
   gboolean restore_state;
   LogReaderOptions reader_options;
@@ -42,6 +49,8 @@ typedef struct _FileReader
   FileReaderOptions *options;
   FileOpener *opener;
   LogReader *reader;
+  /* shared with other readers of the same driver, NULL if unused */
+  LogReaderThread *reader_thread;
 } FileReader;
 
 static inline LogProtoFileReaderOptions *
@@ -63,11 +72,13 @@ void file_reader_free_method(LogPipe *s);
 void file_reader_queue_method(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options);
 void file_reader_notify_method(LogPipe *s, gint notify_code, gpointer user_data);
 
+void file_reader_set_reader_thread(FileReader *self, LogReaderThread *reader_thread);
 void file_reader_remove_persist_state(FileReader *self);
 void file_reader_stop_follow_file(FileReader *self);
 void file_reader_cue_buffer_flush(FileReader *self);
 
 void file_reader_options_set_follow_freq(FileReaderOptions *options, gint follow_freq);
+gboolean file_reader_options_set_follow_method(FileReaderOptions *options, const gchar *follow_method);
 void file_reader_options_set_multi_line_timeout(FileReaderOptions *options, gint multi_line_timeout);
 
 void file_reader_options_defaults(FileReaderOptions *options);
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "file-sync-group.h"
+#include "mainloop.h"
+#include "mainloop-io-worker.h"
+#include "timeutils/misc.h"
+#include "messages.h"
+#include "atomic.h"
+
+#include <iv.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+struct _FileSyncGroup
+{
+  GAtomicCounter ref_cnt;
+  gint interval;
+  StatsCounterItem *fsyncs;
+  StatsCounterItem *fsync_latency;
+
+  /* protects "pending" and "generation" */
+  GMutex lock;
+  GArray *pending;
+  guint generation;
+
+  /* main thread state */
+  gboolean running;
+  struct iv_timer timer;
+  MainLoopIOWorkerJob io_job;
+};
+
+gboolean
+file_sync_fd(gint fd, StatsCounterItem *fsyncs, StatsCounterItem *fsync_latency)
+{
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  gint rc = fsync(fd);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  stats_counter_inc(fsyncs);
+  stats_counter_set(fsync_latency, timespec_diff_nsec(&end, &start));
+  return rc == 0;
+}
+
+/* registers @fd to be synced in the next round, unless it was already
+ * registered in the round identified by @generation. The fd is duplicated,
+ * so the writer is free to close its own meanwhile. */
+void
+file_sync_group_add_fd(FileSyncGroup *self, gint fd, guint *generation)
+{
+  g_mutex_lock(&self->lock);
+  if (*generation != self->generation)
+    {
+      gint sync_fd = dup(fd);
+
+      if (sync_fd >= 0)
+        {
+          g_array_append_val(self->pending, sync_fd);
+          *generation = self->generation;
+        }
+      else
+        {
+          msg_error("Error duplicating file descriptor for group fsync",
+                    evt_tag_int("fd", fd),
+                    evt_tag_error(EVT_TAG_OSERROR));
+        }
+    }
+  g_mutex_unlock(&self->lock);
+}
+
+static GArray *
+_take_pending(FileSyncGroup *self)
+{
+  g_mutex_lock(&self->lock);
+  GArray *fds = self->pending;
+  self->pending = g_array_new(FALSE, FALSE, sizeof(gint));
+  self->generation++;
+  g_mutex_unlock(&self->lock);
+  return fds;
+}
+
+static void
+_close_fds(GArray *fds)
+{
+  for (guint i = 0; i < fds->len; i++)
+    close(g_array_index(fds, gint, i));
+  g_array_free(fds, TRUE);
+}
+
+/* runs in an I/O worker thread */
+static void
+_sync_fds(gpointer s, gpointer arg)
+{
+  FileSyncGroup *self = (FileSyncGroup *) s;
+  GArray *fds = (GArray *) arg;
+
+  for (guint i = 0; i < fds->len; i++)
+    {
+      gint fd = g_array_index(fds, gint, i);
+
+      if (!file_sync_fd(fd, self->fsyncs, self->fsync_latency))
+        msg_error("Error syncing destination file",
+                  evt_tag_int("fd", fd),
+                  evt_tag_error(EVT_TAG_OSERROR));
+    }
+}
+
+static void
+_arm_timer(FileSyncGroup *self)
+{
+  iv_validate_now();
+  self->timer.expires = iv_now;
+  timespec_add_msec(&self->timer.expires, self->interval);
+  iv_timer_register(&self->timer);
+}
+
+/* returns TRUE if a round was started in an I/O worker */
+static gboolean
+_start_round(FileSyncGroup *self)
+{
+  GArray *fds = _take_pending(self);
+
+  if (fds->len == 0)
+    {
+      g_array_free(fds, TRUE);
+      return FALSE;
+    }
+
+  if (main_loop_io_worker_job_submit(&self->io_job, fds))
+    return TRUE;
+
+  /* the I/O workers are exiting, we are shutting down */
+  _sync_fds(self, fds);
+  _close_fds(fds);
+  return FALSE;
+}
+
+static void
+_round_finished(gpointer s, gpointer arg)
+{
+  FileSyncGroup *self = (FileSyncGroup *) s;
+
+  _close_fds((GArray *) arg);
+
+  /* files written while stopping are synced by a last round */
+  if (!self->running)
+    {
+      _start_round(self);
+      return;
+    }
+  _arm_timer(self);
+}
+
+static void
+_timer_expired(gpointer s)
+{
+  FileSyncGroup *self = (FileSyncGroup *) s;
+
+  if (!_start_round(self))
+    _arm_timer(self);
+}
+
+void
+file_sync_group_start(FileSyncGroup *self)
+{
+  main_loop_assert_main_thread();
+
+  if (self->running)
+    return;
+
+  self->running = TRUE;
+  if (!self->io_job.working)
+    _arm_timer(self);
+}
+
+void
+file_sync_group_stop(FileSyncGroup *self)
+{
+  main_loop_assert_main_thread();
+
+  if (!self->running)
+    return;
+
+  self->running = FALSE;
+  if (iv_timer_registered(&self->timer))
+    iv_timer_unregister(&self->timer);
+
+  if (!self->io_job.working)
+    _start_round(self);
+}
+
+void
+file_sync_group_set_metrics(FileSyncGroup *self, StatsCounterItem *fsyncs, StatsCounterItem *fsync_latency)
+{
+  self->fsyncs = fsyncs;
+  self->fsync_latency = fsync_latency;
+}
+
+FileSyncGroup *
+file_sync_group_new(gint interval)
+{
+  FileSyncGroup *self = g_new0(FileSyncGroup, 1);
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->interval = interval;
+  g_mutex_init(&self->lock);
+  self->pending = g_array_new(FALSE, FALSE, sizeof(gint));
+  self->generation = 1;
+
+  IV_TIMER_INIT(&self->timer);
+  self->timer.cookie = self;
+  self->timer.handler = _timer_expired;
+
+  main_loop_io_worker_job_init(&self->io_job);
+  self->io_job.user_data = self;
+  self->io_job.work = _sync_fds;
+  self->io_job.completion = _round_finished;
+  self->io_job.engage = (void (*)(gpointer)) file_sync_group_ref;
+  self->io_job.release = (void (*)(gpointer)) file_sync_group_unref;
+  return self;
+}
+
+FileSyncGroup *
+file_sync_group_ref(FileSyncGroup *self)
+{
+  g_assert(!self || g_atomic_counter_get(&self->ref_cnt) > 0);
+
+  if (self)
+    g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+void
+file_sync_group_unref(FileSyncGroup *self)
+{
+  g_assert(!self || g_atomic_counter_get(&self->ref_cnt));
+
+  if (self && g_atomic_counter_dec_and_test(&self->ref_cnt))
+    {
+      g_assert(!self->running && !self->io_job.working);
+
+      _close_fds(self->pending);
+      g_mutex_clear(&self->lock);
+      g_free(self);
+    }
+}
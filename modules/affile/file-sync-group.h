@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef FILE_SYNC_GROUP_H_INCLUDED
+#define FILE_SYNC_GROUP_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "stats/stats-counter.h"
+
+/*
+ * Group fsync of the files written by a file() destination: instead of
+ * syncing after each write, writers register the files they have written
+ * since the last round and all of them are synced together every
+ * fsync-interval() milliseconds, in an I/O worker thread.
+ */
+typedef struct _FileSyncGroup FileSyncGroup;
+
+FileSyncGroup *file_sync_group_new(gint interval);
+FileSyncGroup *file_sync_group_ref(FileSyncGroup *self);
+void file_sync_group_unref(FileSyncGroup *self);
+
+void file_sync_group_set_metrics(FileSyncGroup *self, StatsCounterItem *fsyncs, StatsCounterItem *fsync_latency);
+void file_sync_group_start(FileSyncGroup *self);
+void file_sync_group_stop(FileSyncGroup *self);
+
+void file_sync_group_add_fd(FileSyncGroup *self, gint fd, guint *generation);
+
+gboolean file_sync_fd(gint fd, StatsCounterItem *fsyncs, StatsCounterItem *fsync_latency);
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "inotify-file-watch.h"
+#include "messages.h"
+
+#if SYSLOG_NG_HAVE_INOTIFY
+
+#include "tls-support.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <iv.h>
+
+#define INOTIFY_FILE_WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+typedef struct _InotifyDispatcher
+{
+  gint ref_cnt;
+  struct iv_fd inotify_fd;
+  /* wd -> GList of InotifyFileWatch, as the same file may be followed by
+   * more than one reader */
+  GHashTable *watches;
+  GQueue ready;
+} InotifyDispatcher;
+
+TLS_BLOCK_START
+{
+  InotifyDispatcher *current_dispatcher;
+}
+TLS_BLOCK_END;
+
+#define current_dispatcher  __tls_deref(current_dispatcher)
+
+static void
+_queue_ready(InotifyDispatcher *self, InotifyFileWatch *watch, guint32 mask)
+{
+  watch->mask |= mask;
+  if (watch->ready)
+    return;
+
+  watch->ready = TRUE;
+  g_queue_push_tail_link(&self->ready, &watch->ready_link);
+}
+
+static void
+_queue_all_ready(gpointer key, gpointer value, gpointer user_data)
+{
+  InotifyDispatcher *self = (InotifyDispatcher *) user_data;
+
+  for (GList *l = (GList *) value; l; l = l->next)
+    _queue_ready(self, (InotifyFileWatch *) l->data, IN_MODIFY);
+}
+
+static void
+_forget_wd(InotifyDispatcher *self, gint wd)
+{
+  GList *watches = g_hash_table_lookup(self->watches, GINT_TO_POINTER(wd));
+
+  for (GList *l = watches; l; l = l->next)
+    ((InotifyFileWatch *) l->data)->wd = -1;
+
+  g_hash_table_remove(self->watches, GINT_TO_POINTER(wd));
+  g_list_free(watches);
+}
+
+static void
+_process_event(InotifyDispatcher *self, const struct inotify_event *event)
+{
+  if (event->wd < 0)
+    {
+      /* IN_Q_OVERFLOW: events were lost, let everyone check its file */
+      msg_debug("inotify-file-watch: inotify event queue overflowed, checking all followed files");
+      g_hash_table_foreach(self->watches, _queue_all_ready, self);
+      return;
+    }
+
+  GList *watches = g_hash_table_lookup(self->watches, GINT_TO_POINTER(event->wd));
+  for (GList *l = watches; l; l = l->next)
+    _queue_ready(self, (InotifyFileWatch *) l->data, event->mask);
+
+  /* the kernel removed the watch, e.g. the file was deleted */
+  if (event->mask & IN_IGNORED)
+    _forget_wd(self, event->wd);
+}
+
+static void
+_dispatch_ready(InotifyDispatcher *self)
+{
+  GList *link;
+
+  /* handlers may stop or start any watch, including the ones still in the
+   * queue, so we always take the current head */
+  while ((link = g_queue_pop_head_link(&self->ready)))
+    {
+      InotifyFileWatch *watch = (InotifyFileWatch *) link->data;
+      guint32 mask = watch->mask;
+
+      watch->ready = FALSE;
+      watch->mask = 0;
+      watch->handler(watch->cookie, mask);
+    }
+}
+
+static InotifyDispatcher *
+_dispatcher_ref(InotifyDispatcher *self)
+{
+  self->ref_cnt++;
+  return self;
+}
+
+static void
+_dispatcher_unref(InotifyDispatcher *self)
+{
+  if (--self->ref_cnt > 0)
+    return;
+
+  g_assert(g_hash_table_size(self->watches) == 0);
+  g_assert(g_queue_is_empty(&self->ready));
+
+  iv_fd_unregister(&self->inotify_fd);
+  close(self->inotify_fd.fd);
+  g_hash_table_destroy(self->watches);
+
+  if (current_dispatcher == self)
+    current_dispatcher = NULL;
+  g_free(self);
+}
+
+static void
+_read_events(gpointer s)
+{
+  InotifyDispatcher *self = (InotifyDispatcher *) s;
+  gchar buf[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+  _dispatcher_ref(self);
+
+  /* collect the events of all files first, then process the files that
+   * changed in one batch */
+  while (TRUE)
+    {
+      gssize len = read(self->inotify_fd.fd, buf, sizeof(buf));
+
+      if (len < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno != EAGAIN)
+            msg_error("inotify-file-watch: error reading inotify events",
+                      evt_tag_error("error"));
+          break;
+        }
+
+      for (gchar *p = buf; p < buf + len; )
+        {
+          const struct inotify_event *event = (const struct inotify_event *) p;
+
+          _process_event(self, event);
+          p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+  _dispatch_ready(self);
+  _dispatcher_unref(self);
+}
+
+static InotifyDispatcher *
+_dispatcher_new(void)
+{
+  gint fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (fd < 0)
+    {
+      msg_error("inotify-file-watch: could not create inotify object, falling back to polling, "
+                "you may need to increase /proc/sys/fs/inotify/max_user_instances",
+                evt_tag_error("error"));
+      return NULL;
+    }
+
+  InotifyDispatcher *self = g_new0(InotifyDispatcher, 1);
+
+  self->ref_cnt = 1;
+  self->watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_queue_init(&self->ready);
+
+  IV_FD_INIT(&self->inotify_fd);
+  self->inotify_fd.fd = fd;
+  self->inotify_fd.cookie = self;
+  self->inotify_fd.handler_in = _read_events;
+  iv_fd_register(&self->inotify_fd);
+
+  return self;
+}
+
+/* there is one dispatcher per thread, as ivykis objects are bound to the
+ * thread they were registered in */
+static InotifyDispatcher *
+_dispatcher_get(void)
+{
+  if (current_dispatcher)
+    return _dispatcher_ref(current_dispatcher);
+
+  current_dispatcher = _dispatcher_new();
+  return current_dispatcher;
+}
+
+gboolean
+inotify_file_watch_start(InotifyFileWatch *self, gint fd)
+{
+  gchar path[64];
+
+  g_assert(!self->dispatcher);
+
+  InotifyDispatcher *dispatcher = _dispatcher_get();
+  if (!dispatcher)
+    return FALSE;
+
+  /* watch the file we have open, even if it was renamed or replaced since */
+  g_snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+  gint wd = inotify_add_watch(dispatcher->inotify_fd.fd, path, INOTIFY_FILE_WATCH_EVENTS);
+  if (wd < 0)
+    {
+      msg_debug("inotify-file-watch: could not add inotify watch, falling back to polling, "
+                "you may need to increase /proc/sys/fs/inotify/max_user_watches",
+                evt_tag_int("fd", fd),
+                evt_tag_error("error"));
+      _dispatcher_unref(dispatcher);
+      return FALSE;
+    }
+
+  GList *watches = g_hash_table_lookup(dispatcher->watches, GINT_TO_POINTER(wd));
+  g_hash_table_insert(dispatcher->watches, GINT_TO_POINTER(wd), g_list_prepend(watches, self));
+
+  self->wd = wd;
+  self->dispatcher = dispatcher;
+  return TRUE;
+}
+
+void
+inotify_file_watch_stop(InotifyFileWatch *self)
+{
+  InotifyDispatcher *dispatcher = (InotifyDispatcher *) self->dispatcher;
+
+  if (!dispatcher)
+    return;
+
+  if (self->ready)
+    {
+      g_queue_unlink(&dispatcher->ready, &self->ready_link);
+      self->ready = FALSE;
+      self->mask = 0;
+    }
+
+  if (self->wd >= 0)
+    {
+      GList *watches = g_hash_table_lookup(dispatcher->watches, GINT_TO_POINTER(self->wd));
+
+      watches = g_list_remove(watches, self);
+      if (watches)
+        {
+          g_hash_table_insert(dispatcher->watches, GINT_TO_POINTER(self->wd), watches);
+        }
+      else
+        {
+          g_hash_table_remove(dispatcher->watches, GINT_TO_POINTER(self->wd));
+          inotify_rm_watch(dispatcher->inotify_fd.fd, self->wd);
+        }
+      self->wd = -1;
+    }
+
+  self->dispatcher = NULL;
+  _dispatcher_unref(dispatcher);
+}
+
+#else
+
+gboolean
+inotify_file_watch_start(InotifyFileWatch *self, gint fd)
+{
+  return FALSE;
+}
+
+void
+inotify_file_watch_stop(InotifyFileWatch *self)
+{
+}
+
+#endif
+
+void
+inotify_file_watch_init(InotifyFileWatch *self, InotifyFileWatchHandler handler, gpointer cookie)
+{
+  self->wd = -1;
+  self->mask = 0;
+  self->ready = FALSE;
+  self->ready_link.data = self;
+  self->ready_link.prev = self->ready_link.next = NULL;
+  self->dispatcher = NULL;
+  self->handler = handler;
+  self->cookie = cookie;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef INOTIFY_FILE_WATCH_H_INCLUDED
+#define INOTIFY_FILE_WATCH_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Event driven alternative of polling a followed file for changes.
+ *
+ * Watches are registered to an inotify instance shared by all watches of
+ * the current thread.  A single read() of the inotify fd collects the
+ * events of all changed files, and their handlers are then invoked in one
+ * batch, so thousands of idle files cost nothing until they change.
+ */
+typedef void (*InotifyFileWatchHandler)(gpointer cookie, guint32 mask);
+
+typedef struct _InotifyFileWatch
+{
+  gint wd;
+  /* events collected since the last invocation of the handler */
+  guint32 mask;
+  gboolean ready;
+  GList ready_link;
+  gpointer dispatcher;
+
+  InotifyFileWatchHandler handler;
+  gpointer cookie;
+} InotifyFileWatch;
+
+void inotify_file_watch_init(InotifyFileWatch *self, InotifyFileWatchHandler handler, gpointer cookie);
+gboolean inotify_file_watch_start(InotifyFileWatch *self, gint fd);
+void inotify_file_watch_stop(InotifyFileWatch *self);
+
+static inline gboolean
+inotify_file_watch_is_active(InotifyFileWatch *self)
+{
+  return self->dispatcher != NULL;
+}
+
+#endif
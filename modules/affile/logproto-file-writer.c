@@ -29,7 +29,12 @@
 #include <string.h>
 #include <errno.h>
 #include <sys/uio.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+
+/* amount of written data handed over to writeback at once with drop-cache() */
+#define DROP_CACHE_CHUNK (8 * 1024 * 1024)
 
 typedef struct _LogProtoFileWriter
 {
@@ -39,12 +44,128 @@ typedef struct _LogProtoFileWriter
   gint partial_messages;
   gint buf_size;
   gint buf_count;
-  gint fd;
   gsize sum_len;
   gboolean fsync;
+
+  FileWriteOptions write_options;
+  guint sync_generation;
+  /* file offsets, only tracked with preallocate() or drop-cache(), offset
+   * is -1 until the first write */
+  off_t offset;
+  off_t preallocated_end;
+  off_t writeback_start, evict_start;
+  FileCompressor *compressor;
+
   struct iovec buffer[0];
 } LogProtoFileWriter;
 
+static inline gboolean
+_tracks_offset(LogProtoFileWriter *self)
+{
+  return self->write_options.preallocate || self->write_options.drop_cache;
+}
+
+static void
+_preallocate(LogProtoFileWriter *self, gint fd, gsize len)
+{
+#ifdef SYSLOG_NG_HAVE_FALLOCATE
+  if (self->offset + (off_t) len <= self->preallocated_end)
+    return;
+
+  /* FALLOC_FL_KEEP_SIZE: readers of the file do not see the extent until
+   * it is written */
+  gsize extent = MAX(self->write_options.preallocate, len);
+  if (fallocate(fd, FALLOC_FL_KEEP_SIZE, self->offset, extent) < 0)
+    {
+      msg_warning("Error preallocating space for destination file, disabling preallocation",
+                  evt_tag_int("fd", fd),
+                  evt_tag_error(EVT_TAG_OSERROR));
+      self->write_options.preallocate = 0;
+      return;
+    }
+  self->preallocated_end = self->offset + extent;
+#endif
+}
+
+/* Starts the writeback of the data written since the last call, then
+ * waits for the writeback started by the last call, which is usually
+ * complete by then, and drops those pages from the page cache.  This
+ * keeps the amount of dirty and cached pages of the file bounded to two
+ * chunks without making the writer wait for the disk. */
+static void
+_drop_cache(LogProtoFileWriter *self, gint fd)
+{
+#ifdef SYSLOG_NG_HAVE_SYNC_FILE_RANGE
+  if (self->offset < self->writeback_start)
+    {
+      /* truncated by someone else */
+      self->writeback_start = self->evict_start = self->offset;
+      return;
+    }
+
+  if (self->offset - self->writeback_start < DROP_CACHE_CHUNK)
+    return;
+
+  sync_file_range(fd, self->writeback_start, self->offset - self->writeback_start, SYNC_FILE_RANGE_WRITE);
+  if (self->evict_start < self->writeback_start)
+    {
+      off_t len = self->writeback_start - self->evict_start;
+
+      sync_file_range(fd, self->evict_start, len,
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+      posix_fadvise(fd, self->evict_start, len, POSIX_FADV_DONTNEED);
+    }
+  self->evict_start = self->writeback_start;
+  self->writeback_start = self->offset;
+#endif
+}
+
+static void
+_before_write(LogProtoFileWriter *self, gint fd, gsize len)
+{
+  if (!_tracks_offset(self))
+    return;
+
+  if (self->offset < 0)
+    {
+      self->offset = lseek(fd, 0, SEEK_END);
+      if (self->offset < 0)
+        {
+          /* not a seekable file */
+          self->write_options.preallocate = 0;
+          self->write_options.drop_cache = FALSE;
+          return;
+        }
+      self->preallocated_end = self->writeback_start = self->evict_start = self->offset;
+    }
+
+  if (self->write_options.preallocate)
+    _preallocate(self, fd, len);
+}
+
+static void
+_after_write(LogProtoFileWriter *self, gint fd, gsize written)
+{
+  stats_counter_inc(self->write_options.writes);
+  stats_counter_add(self->write_options.written_bytes, written);
+
+  if (self->fsync)
+    file_sync_fd(fd, self->write_options.fsyncs, self->write_options.fsync_latency);
+  else if (self->write_options.sync_group)
+    file_sync_group_add_fd(self->write_options.sync_group, fd, &self->sync_generation);
+
+  if (_tracks_offset(self) && self->offset >= 0)
+    {
+      /* O_APPEND: the position is the end of the file */
+      off_t offset = lseek(fd, 0, SEEK_CUR);
+      if (offset >= 0)
+        self->offset = offset;
+
+      if (self->write_options.drop_cache)
+        _drop_cache(self, fd);
+    }
+}
+
 static inline gboolean
 _flush_partial(LogProtoFileWriter *self, LogProtoStatus *status)
 {
@@ -52,10 +173,11 @@ _flush_partial(LogProtoFileWriter *self, LogProtoStatus *status)
   /* there is still some data from the previous file writing process */
 
   gint len = self->partial_len - self->partial_pos;
+  _before_write(self, transport->fd, len);
   gssize rc = log_transport_write(transport, self->partial + self->partial_pos, len);
 
-  if (rc > 0 && self->fsync)
-    fsync(self->fd);
+  if (rc > 0)
+    _after_write(self, transport->fd, rc);
 
   if (rc < 0)
     {
@@ -127,6 +249,72 @@ _process_partial_write(LogProtoFileWriter *self, gsize written)
   log_proto_client_msg_ack(&self->super, self->buf_count - self->partial_messages);
 }
 
+/* The buffered messages are compressed and flushed at once, so that the
+ * file is decodable up to the last write.  The compressed data is then
+ * written through the partial buffer: the messages are acknowledged once
+ * all of it is out. */
+static LogProtoStatus
+_flush_compressed(LogProtoFileWriter *self)
+{
+  GByteArray *compressed = g_byte_array_sized_new(self->sum_len / 2 + 64);
+  gboolean success = TRUE;
+
+  for (gint i = 0; i < self->buf_count; ++i)
+    {
+      success = success && file_compressor_compress(self->compressor, self->buffer[i].iov_base,
+                                                     self->buffer[i].iov_len, compressed);
+      g_free(self->buffer[i].iov_base);
+    }
+  success = success && file_compressor_flush(self->compressor, compressed);
+
+  gint messages = self->buf_count;
+  self->buf_count = 0;
+  self->sum_len = 0;
+
+  if (!success)
+    {
+      g_byte_array_free(compressed, TRUE);
+      log_proto_client_msg_rewind(&self->super);
+      return LPS_ERROR;
+    }
+
+  self->partial_len = compressed->len;
+  self->partial_pos = 0;
+  self->partial_messages = messages;
+  self->partial = g_byte_array_free(compressed, FALSE);
+
+  LogProtoStatus status;
+  if (!_flush_partial(self, &status) && status == LPS_ERROR)
+    return LPS_ERROR;
+  return LPS_SUCCESS;
+}
+
+/* ends the compressed stream at the end of the file, unless a write is
+ * still pending: the data up to the last complete write remains decodable
+ * in that case, and the pending messages are rewound anyway */
+static void
+_finish_compressed(LogProtoFileWriter *self, LogTransport *transport)
+{
+  if (!transport || self->partial || self->buf_count > 0)
+    return;
+
+  GByteArray *trailer = g_byte_array_new();
+
+  if (file_compressor_finish(self->compressor, trailer) && trailer->len > 0)
+    {
+      _before_write(self, transport->fd, trailer->len);
+      gssize rc = log_transport_write(transport, trailer->data, trailer->len);
+      if (rc > 0)
+        _after_write(self, transport->fd, rc);
+
+      if (rc != (gssize) trailer->len)
+        msg_error("Error finishing the compressed stream of destination file",
+                  evt_tag_int("fd", transport->fd),
+                  evt_tag_error(EVT_TAG_OSERROR));
+    }
+  g_byte_array_free(trailer, TRUE);
+}
+
 /*
  * log_proto_file_writer_flush:
  *
@@ -152,10 +340,22 @@ log_proto_file_writer_flush(LogProtoClient *s)
   if (self->buf_count == 0)
     return LPS_SUCCESS;
 
+  if (self->compressor)
+    return _flush_compressed(self);
+
+  if (self->write_options.compression != FILE_COMPRESSION_NONE)
+    {
+      /* the compressor could not be initialized, never write plain data
+       * to a compressed file */
+      log_proto_client_msg_rewind(&self->super);
+      return LPS_ERROR;
+    }
+
+  _before_write(self, transport->fd, self->sum_len);
   gssize rc = log_transport_writev(transport, self->buffer, self->buf_count);
 
-  if (rc > 0 && self->fsync)
-    fsync(transport->fd);
+  if (rc > 0)
+    _after_write(self, transport->fd, rc);
 
   if (rc < 0)
     {
@@ -246,6 +446,47 @@ log_proto_file_writer_prepare(LogProtoClient *s, gint *fd, GIOCondition *cond, g
   return self->buf_count > 0 || self->partial;
 }
 
+void
+log_proto_file_writer_set_write_options(LogProtoClient *s, const FileWriteOptions *write_options)
+{
+  LogProtoFileWriter *self = (LogProtoFileWriter *)s;
+
+  file_sync_group_unref(self->write_options.sync_group);
+  self->write_options = *write_options;
+  file_sync_group_ref(self->write_options.sync_group);
+
+  file_compressor_free(self->compressor);
+  self->compressor = file_compressor_new(self->write_options.compression);
+}
+
+static void
+log_proto_file_writer_free(LogProtoClient *s)
+{
+  LogProtoFileWriter *self = (LogProtoFileWriter *)s;
+  LogTransport *transport = log_transport_stack_get_active(&self->super.transport_stack);
+  struct stat st;
+
+  if (self->compressor)
+    {
+      _finish_compressed(self, transport);
+      file_compressor_free(self->compressor);
+    }
+
+  /* give back the unused part of the last preallocated extent, unless
+   * someone else has written the file since */
+  if (transport && self->offset >= 0 && self->preallocated_end > self->offset &&
+      fstat(transport->fd, &st) == 0 && st.st_size == self->offset)
+    {
+      if (ftruncate(transport->fd, self->offset) < 0)
+        msg_debug("Error releasing preallocated space of destination file",
+                  evt_tag_int("fd", transport->fd),
+                  evt_tag_error(EVT_TAG_OSERROR));
+    }
+
+  file_sync_group_unref(self->write_options.sync_group);
+  log_proto_client_free_method(s);
+}
+
 LogProtoClient *
 log_proto_file_writer_new(LogTransport *transport, const LogProtoClientOptions *options, gint flush_lines, gint fsync_)
 {
@@ -265,8 +506,10 @@ log_proto_file_writer_new(LogTransport *transport, const LogProtoClientOptions *
   log_proto_client_init(&self->super, transport, options);
   self->buf_size = flush_lines;
   self->fsync = fsync_;
+  self->offset = -1;
   self->super.prepare = log_proto_file_writer_prepare;
   self->super.post = log_proto_file_writer_post;
   self->super.flush = log_proto_file_writer_flush;
+  self->super.free_fn = log_proto_file_writer_free;
   return &self->super;
 }
@@ -25,8 +25,29 @@
 #define LOG_PROTO_FILE_WRITER_H_INCLUDED
 
 #include "logproto/logproto-client.h"
+#include "file-sync-group.h"
+#include "file-compressor.h"
+
+/* write tuning of regular destination files */
+typedef struct _FileWriteOptions
+{
+  /* size of the extents allocated ahead of the writes, 0 to disable */
+  gsize preallocate;
+  /* write back the written data in the background and drop it from the
+   * page cache */
+  gboolean drop_cache;
+  FileSyncGroup *sync_group;
+  /* the file is written as a compressed stream, flushed at each write */
+  FileCompression compression;
+
+  StatsCounterItem *writes;
+  StatsCounterItem *written_bytes;
+  StatsCounterItem *fsyncs;
+  StatsCounterItem *fsync_latency;
+} FileWriteOptions;
 
 LogProtoClient *log_proto_file_writer_new(LogTransport *transport, const LogProtoClientOptions *options,
                                           gint flush_lines, gboolean fsync);
+void log_proto_file_writer_set_write_options(LogProtoClient *s, const FileWriteOptions *write_options);
 
 #endif
@@ -24,6 +24,8 @@
  */
 #include "poll-file-changes.h"
 #include "logpipe.h"
+#include "mainloop.h"
+#include "mainloop-call.h"
 #include "timeutils/misc.h"
 
 #include <sys/types.h>
@@ -40,6 +42,42 @@
 #include <iv_work.h>
 
 
+typedef struct _PollFileChangesNotification
+{
+  LogPipe *control;
+  gint notify_code;
+} PollFileChangesNotification;
+
+static gpointer
+_deliver_notification(gpointer s)
+{
+  PollFileChangesNotification *notification = (PollFileChangesNotification *) s;
+
+  /* the reader may have been closed in the meantime */
+  if (notification->control->flags & PIF_INITIALIZED)
+    log_pipe_notify(notification->control, notification->notify_code, NULL);
+  log_pipe_unref(notification->control);
+  g_free(notification);
+  return NULL;
+}
+
+/* file readers handle these notifications in the main thread, forward them
+ * there when we are polled by a reader running in a thread of its own */
+static void
+poll_file_changes_notify(PollFileChanges *self, gint notify_code)
+{
+  if (main_loop_is_main_thread())
+    {
+      log_pipe_notify(self->control, notify_code, self);
+      return;
+    }
+
+  PollFileChangesNotification *notification = g_new(PollFileChangesNotification, 1);
+  notification->control = log_pipe_ref(self->control);
+  notification->notify_code = notify_code;
+  main_loop_call(_deliver_notification, notification, FALSE);
+}
+
 static inline void
 poll_file_changes_on_read(PollFileChanges *self)
 {
@@ -53,7 +91,7 @@ poll_file_changes_on_file_moved(PollFileChanges *self)
 {
   if (self->on_file_moved)
     self->on_file_moved(self);
-  log_pipe_notify(self->control, NC_FILE_MOVED, self);
+  poll_file_changes_notify(self, NC_FILE_MOVED);
 }
 
 static inline gboolean
@@ -62,7 +100,7 @@ poll_file_changes_on_eof(PollFileChanges *self)
   gboolean result = TRUE;
   if (self->on_eof)
     result = self->on_eof(self);
-  log_pipe_notify(self->control, NC_FILE_EOF, self);
+  poll_file_changes_notify(self, NC_FILE_EOF);
 
   if (self->stop_on_eof)
     return FALSE;
@@ -166,6 +204,52 @@ poll_file_changes_stop_watches(PollEvents *s)
 
   if (iv_timer_registered(&self->follow_timer))
     iv_timer_unregister(&self->follow_timer);
+  inotify_file_watch_stop(&self->file_watch);
+}
+
+/* inotify callback, the file we have open changed */
+static void
+poll_file_changes_on_file_event(gpointer s, guint32 mask)
+{
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  msg_trace("poll-file-changes: inotify event on followed file",
+            evt_tag_str("follow_filename", self->follow_filename),
+            evt_tag_printf("mask", "0x%x", mask));
+  poll_file_changes_check_file(self);
+}
+
+static gboolean
+poll_file_changes_is_followed_file_replaced(PollFileChanges *self, struct stat *st)
+{
+  struct stat followed_st;
+
+  if (!self->follow_filename)
+    return FALSE;
+
+  if (st->st_nlink == 0 || stat(self->follow_filename, &followed_st) < 0)
+    return TRUE;
+  return st->st_ino != followed_st.st_ino || st->st_dev != followed_st.st_dev;
+}
+
+static gboolean
+poll_file_changes_watch_file(PollFileChanges *self)
+{
+  struct stat st;
+
+  if (!self->event_driven)
+    return FALSE;
+
+  if (fstat(self->fd, &st) < 0 || !S_ISREG(st.st_mode))
+    return FALSE;
+
+  /* our watch is on the file we have open, a file created in its place
+   * would not produce any events, so we go back to polling until the
+   * new file is picked up */
+  if (poll_file_changes_is_followed_file_replaced(self, &st))
+    return FALSE;
+
+  return inotify_file_watch_start(&self->file_watch, self->fd);
 }
 
 static void
@@ -218,7 +302,12 @@ poll_file_changes_update_watches(PollEvents *s, GIOCondition cond)
       msg_trace("End of file, following file",
                 evt_tag_str("follow_filename", self->follow_filename));
       if (poll_file_changes_on_eof(self))
-        poll_file_changes_rearm_timer(self, self->follow_freq);
+        {
+          gboolean watching = poll_file_changes_watch_file(self);
+
+          if (!watching || (self->needs_polling && self->needs_polling(self)))
+            poll_file_changes_rearm_timer(self, self->follow_freq);
+        }
     }
   else
     {
@@ -236,11 +325,20 @@ poll_file_changes_stop_on_eof(PollEvents *s)
   self->stop_on_eof = TRUE;
 }
 
+void
+poll_file_changes_set_event_driven(PollEvents *s, gboolean event_driven)
+{
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  self->event_driven = event_driven;
+}
+
 void
 poll_file_changes_free(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
+  inotify_file_watch_stop(&self->file_watch);
   log_pipe_unref(self->control);
   g_free(self->follow_filename);
 }
@@ -261,6 +359,8 @@ poll_file_changes_init_instance(PollFileChanges *self, gint fd, const gchar *fol
   IV_TIMER_INIT(&self->follow_timer);
   self->follow_timer.cookie = self;
   self->follow_timer.handler = poll_file_changes_check_file;
+
+  inotify_file_watch_init(&self->file_watch, poll_file_changes_on_file_event, self);
 }
 
 PollEvents *
@@ -27,6 +27,7 @@
 
 #include "poll-events.h"
 #include "logpipe.h"
+#include "inotify-file-watch.h"
 
 #include <iv.h>
 
@@ -41,10 +42,16 @@ struct _PollFileChanges
   struct iv_timer follow_timer;
   LogPipe *control;
 
+  /* wait for inotify events at EOF instead of checking every follow_freq */
+  gboolean event_driven;
+  InotifyFileWatch file_watch;
+
   gboolean stop_on_eof;
   void (*on_read)(PollFileChanges *);
   gboolean (*on_eof)(PollFileChanges *);
   void (*on_file_moved)(PollFileChanges *);
+  /* TRUE if the file has to be checked periodically even if it does not change */
+  gboolean (*needs_polling)(PollFileChanges *);
 };
 
 PollEvents *poll_file_changes_new(gint fd, const gchar *follow_filename, gint follow_freq, LogPipe *control);
@@ -54,6 +61,7 @@ void poll_file_changes_init_instance(PollFileChanges *self, gint fd, const gchar
 void poll_file_changes_update_watches(PollEvents *s, GIOCondition cond);
 void poll_file_changes_stop_watches(PollEvents *s);
 void poll_file_changes_stop_on_eof(PollEvents *s);
+void poll_file_changes_set_event_driven(PollEvents *s, gboolean event_driven);
 void poll_file_changes_free(PollEvents *s);
 
 #endif
@@ -90,6 +90,15 @@ _is_multi_line_timeout_expired(PollMultilineFileChanges *self)
   return millisecs_since_last_eof > self->multi_line_timeout;
 }
 
+/* a pending timeout has to be checked even if the file does not change */
+static gboolean
+poll_multiline_file_changes_needs_polling(PollFileChanges *s)
+{
+  PollMultilineFileChanges *self = (PollMultilineFileChanges *) s;
+
+  return _is_multi_line_timeout_pending(self);
+}
+
 static gboolean
 poll_multiline_file_changes_on_eof(PollFileChanges *s)
 {
@@ -155,6 +164,7 @@ poll_multiline_file_changes_new(gint fd, const gchar *follow_filename, gint foll
   self->super.on_read = poll_multiline_file_changes_on_read;
   self->super.on_eof = poll_multiline_file_changes_on_eof;
   self->super.on_file_moved = poll_multiline_file_changes_on_file_moved;
+  self->super.needs_polling = poll_multiline_file_changes_needs_polling;
 
   self->super.super.update_watches = poll_file_changes_update_watches;
   self->super.super.stop_watches = poll_multiline_file_changes_stop_watches;
@@ -82,6 +82,7 @@ typedef struct _FileOpenerRegularDestFiles
   FileOpener super;
   const LogWriterOptions *writer_options;
   gboolean *use_fsync;
+  const FileWriteOptions *write_options;
 } FileOpenerRegularDestFiles;
 
 static LogProtoClient *
@@ -89,9 +90,11 @@ _construct_dst_proto(FileOpener *s, LogTransport *transport, LogProtoClientOptio
 {
   FileOpenerRegularDestFiles *self = (FileOpenerRegularDestFiles *) s;
 
-  return log_proto_file_writer_new(transport, proto_options,
-                                   self->writer_options->flush_lines,
-                                   *self->use_fsync);
+  LogProtoClient *proto = log_proto_file_writer_new(transport, proto_options,
+                                                    self->writer_options->flush_lines,
+                                                    *self->use_fsync);
+  log_proto_file_writer_set_write_options(proto, self->write_options);
+  return proto;
 }
 
 static LogTransport *
@@ -101,7 +104,8 @@ _construct_transport(FileOpener *s, gint fd)
 }
 
 FileOpener *
-file_opener_for_regular_dest_files_new(const LogWriterOptions *writer_options, gboolean *use_fsync)
+file_opener_for_regular_dest_files_new(const LogWriterOptions *writer_options, gboolean *use_fsync,
+                                       const FileWriteOptions *write_options)
 {
   FileOpenerRegularDestFiles *self = g_new0(FileOpenerRegularDestFiles, 1);
 
@@ -110,5 +114,6 @@ file_opener_for_regular_dest_files_new(const LogWriterOptions *writer_options, g
   self->super.construct_dst_proto = _construct_dst_proto;
   self->writer_options = writer_options;
   self->use_fsync = use_fsync;
+  self->write_options = write_options;
   return &self->super;
 }
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "poll-file-changes.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "logpipe.h"
+#include "timeutils/misc.h"
+
+#include <glib/gstdio.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <iv.h>
+
+/*
+ * Follows a large number of mostly idle files, appending a line to some of
+ * them periodically, and measures the CPU time spent and the latency
+ * between writing a file and getting the read callback for it.
+ */
+
+#define MAX_FILES         10000
+#define FOLLOW_FREQ       1000
+#define WRITE_INTERVAL    5
+#define ACTIVE_FILES      100
+#define RUNTIME           5000
+
+typedef struct _FollowBenchmark FollowBenchmark;
+
+typedef struct _FollowedFile
+{
+  FollowBenchmark *benchmark;
+  gint fd;
+  gint write_fd;
+  PollEvents *poll_events;
+  gint64 written_at;
+} FollowedFile;
+
+struct _FollowBenchmark
+{
+  gchar *dir;
+  LogPipe *control;
+  FollowedFile *files;
+  gint num_files;
+  gint next_write;
+
+  struct iv_timer write_timer;
+  struct iv_timer stop_timer;
+
+  gint64 writes;
+  gint64 reads;
+  gint64 latency_sum;
+  gint64 latency_max;
+};
+
+static gint
+_get_max_files(void)
+{
+  struct rlimit limit;
+
+  if (getrlimit(RLIMIT_NOFILE, &limit) < 0)
+    return 256;
+
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  getrlimit(RLIMIT_NOFILE, &limit);
+
+  /* each file is open twice: once for reading and once for writing */
+  return MIN(MAX_FILES, (gint) (MIN(limit.rlim_cur, 65536) - 64) / 2);
+}
+
+static void
+_on_read(gpointer user_data)
+{
+  FollowedFile *file = (FollowedFile *) user_data;
+  FollowBenchmark *benchmark = file->benchmark;
+
+  lseek(file->fd, 0, SEEK_END);
+  if (file->written_at)
+    {
+      gint64 latency = g_get_monotonic_time() - file->written_at;
+
+      benchmark->reads++;
+      benchmark->latency_sum += latency;
+      benchmark->latency_max = MAX(benchmark->latency_max, latency);
+      file->written_at = 0;
+    }
+  poll_events_update_watches(file->poll_events, G_IO_IN);
+}
+
+static void
+_rearm_timer(struct iv_timer *timer, glong delay)
+{
+  iv_validate_now();
+  timer->expires = iv_now;
+  timespec_add_msec(&timer->expires, delay);
+  iv_timer_register(timer);
+}
+
+static void
+_write_next_file(gpointer s)
+{
+  FollowBenchmark *self = (FollowBenchmark *) s;
+  /* only the first ACTIVE_FILES files are ever written, the rest stay idle */
+  FollowedFile *file = &self->files[self->next_write];
+  const gchar line[] = "Jan  1 00:00:00 localhost program[1234]: a message written to an active file\n";
+
+  self->next_write = (self->next_write + 1) % MIN(ACTIVE_FILES, self->num_files);
+
+  cr_assert(write(file->write_fd, line, sizeof(line) - 1) == sizeof(line) - 1);
+  if (!file->written_at)
+    file->written_at = g_get_monotonic_time();
+  self->writes++;
+
+  _rearm_timer(&self->write_timer, WRITE_INTERVAL);
+}
+
+static void
+_stop(gpointer s)
+{
+  FollowBenchmark *self = (FollowBenchmark *) s;
+
+  if (iv_timer_registered(&self->write_timer))
+    iv_timer_unregister(&self->write_timer);
+  iv_quit();
+}
+
+static void
+_setup_files(FollowBenchmark *self, gboolean event_driven)
+{
+  self->num_files = _get_max_files();
+  self->files = g_new0(FollowedFile, self->num_files);
+
+  for (gint i = 0; i < self->num_files; i++)
+    {
+      FollowedFile *file = &self->files[i];
+      gchar *filename = g_strdup_printf("%s/file-%05d.log", self->dir, i);
+
+      file->benchmark = self;
+      file->write_fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0600);
+      cr_assert(file->write_fd >= 0, "error creating file %s", filename);
+      file->fd = open(filename, O_RDONLY);
+      cr_assert(file->fd >= 0, "error opening file %s", filename);
+
+      file->poll_events = poll_file_changes_new(file->fd, filename, FOLLOW_FREQ, self->control);
+      poll_file_changes_set_event_driven(file->poll_events, event_driven);
+      poll_events_set_callback(file->poll_events, _on_read, file);
+      poll_events_update_watches(file->poll_events, G_IO_IN);
+      g_free(filename);
+    }
+}
+
+static void
+_teardown_files(FollowBenchmark *self)
+{
+  for (gint i = 0; i < self->num_files; i++)
+    {
+      FollowedFile *file = &self->files[i];
+      gchar *filename = g_strdup_printf("%s/file-%05d.log", self->dir, i);
+
+      poll_events_stop_watches(file->poll_events);
+      poll_events_free(file->poll_events);
+      close(file->fd);
+      close(file->write_fd);
+      unlink(filename);
+      g_free(filename);
+    }
+  g_free(self->files);
+}
+
+static gdouble
+_get_cpu_time_usec(void)
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec * 1e6 + usage.ru_utime.tv_usec +
+         usage.ru_stime.tv_sec * 1e6 + usage.ru_stime.tv_usec;
+}
+
+static void
+_run_benchmark(const gchar *name, gboolean event_driven)
+{
+  FollowBenchmark self = { 0 };
+
+  self.dir = g_dir_make_tmp("test_file_follow_perf_XXXXXX", NULL);
+  cr_assert(self.dir);
+  self.control = log_pipe_new(configuration);
+
+  _setup_files(&self, event_driven);
+
+  IV_TIMER_INIT(&self.write_timer);
+  self.write_timer.cookie = &self;
+  self.write_timer.handler = _write_next_file;
+  _rearm_timer(&self.write_timer, WRITE_INTERVAL);
+
+  IV_TIMER_INIT(&self.stop_timer);
+  self.stop_timer.cookie = &self;
+  self.stop_timer.handler = _stop;
+  _rearm_timer(&self.stop_timer, RUNTIME);
+
+  gdouble cpu_start = _get_cpu_time_usec();
+  iv_main();
+  gdouble cpu_time = _get_cpu_time_usec() - cpu_start;
+
+  printf("      %-10s files: %6d, writes: %6" G_GINT64_FORMAT ", reads: %6" G_GINT64_FORMAT
+         ", cpu: %6.2f%%, avg latency: %8.3f ms, max latency: %8.3f ms\n",
+         name, self.num_files, self.writes, self.reads,
+         cpu_time / (RUNTIME * 10.0),
+         self.reads ? self.latency_sum / (self.reads * 1000.0) : 0.0,
+         self.latency_max / 1000.0);
+
+  _teardown_files(&self);
+  log_pipe_unref(self.control);
+  g_rmdir(self.dir);
+  g_free(self.dir);
+}
+
+Test(file_follow_perf, test_follow_idle_files_performance)
+{
+  _run_benchmark("poll", FALSE);
+#if SYSLOG_NG_HAVE_INOTIFY
+  _run_benchmark("inotify", TRUE);
+#endif
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(file_follow_perf, .init = setup, .fini = teardown);
@@ -24,9 +24,18 @@
 #include "libtest/mock-transport.h"
 
 #include "logproto-file-writer.h"
+#include "transport/transport-file.h"
 #include "logmsg/logmsg.h"
 #include "apphook.h"
 
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if SYSLOG_NG_ENABLE_FILE_GZIP
+#include <zlib.h>
+#endif
+
 
 static void _ack_callback(gint num_acked, gpointer user_data);
 
@@ -162,6 +171,117 @@ Test(file_writer, batches_of_messages_are_flushed_even_if_the_underlying_transpo
   log_proto_client_free(fw);
 }
 
+Test(file_writer, writes_and_written_bytes_are_counted)
+{
+  const gint BATCH_SIZE = 10;
+  StatsCounterItem writes = {0};
+  StatsCounterItem written_bytes = {0};
+  FileWriteOptions write_options = { .writes = &writes, .written_bytes = &written_bytes };
+  LogProtoClient *fw = log_proto_file_writer_new(transport, &options, BATCH_SIZE, FALSE);
+
+  log_proto_file_writer_set_write_options(fw, &write_options);
+  log_proto_client_set_client_flow_control(fw, &flow_control_funcs);
+  for (gint i = 0; i < 3; i++)
+    {
+      status = log_proto_client_post(fw, msg, (guchar *) g_strdup(payload), strlen(payload) + 1, &consumed);
+      cr_assert(status == LPS_SUCCESS);
+    }
+
+  status = log_proto_client_flush(fw);
+  cr_assert(status == LPS_SUCCESS);
+
+  cr_assert_eq(stats_counter_get(&writes), 1);
+  cr_assert_eq(stats_counter_get(&written_bytes), 3 * (strlen(payload) + 1));
+
+  log_proto_client_free(fw);
+}
+
+Test(file_writer, preallocated_space_is_not_visible_in_the_file_size)
+{
+  gchar filename[] = "test_file_writer_preallocate.XXXXXX";
+  gint fd = mkstemp(filename);
+  cr_assert(fd >= 0);
+  cr_assert(fcntl(fd, F_SETFL, O_APPEND) == 0);
+
+  FileWriteOptions write_options = { .preallocate = 1024 * 1024 };
+  LogProtoClient *fw = log_proto_file_writer_new(log_transport_file_new(fd), &options, 1, FALSE);
+
+  log_proto_file_writer_set_write_options(fw, &write_options);
+  log_proto_client_set_client_flow_control(fw, &flow_control_funcs);
+  for (gint i = 0; i < 5; i++)
+    {
+      status = log_proto_client_post(fw, msg, (guchar *) g_strdup(payload), strlen(payload) + 1, &consumed);
+      cr_assert(status == LPS_SUCCESS);
+    }
+
+  struct stat st;
+  cr_assert(stat(filename, &st) == 0);
+  cr_assert_eq(st.st_size, 5 * (strlen(payload) + 1));
+
+  log_proto_client_free(fw);
+
+  cr_assert(stat(filename, &st) == 0);
+  cr_assert_eq(st.st_size, 5 * (strlen(payload) + 1));
+  unlink(filename);
+}
+
+#if SYSLOG_NG_ENABLE_FILE_GZIP
+
+static gsize
+_gunzip_file(const gchar *filename, guchar *output, gsize output_size)
+{
+  gchar *compressed;
+  gsize compressed_len;
+  z_stream stream = {0};
+
+  cr_assert(g_file_get_contents(filename, &compressed, &compressed_len, NULL));
+  cr_assert(inflateInit2(&stream, 15 + 16) == Z_OK);
+  stream.next_in = (Bytef *) compressed;
+  stream.avail_in = compressed_len;
+  stream.next_out = output;
+  stream.avail_out = output_size;
+  cr_assert_eq(inflate(&stream, Z_FINISH), Z_STREAM_END);
+  cr_assert_eq(stream.avail_in, 0, "trailing data after the gzip stream");
+
+  gsize len = output_size - stream.avail_out;
+  inflateEnd(&stream);
+  g_free(compressed);
+  return len;
+}
+
+Test(file_writer, gzip_compressed_output_is_decodable_and_acked_once_written)
+{
+  gchar filename[] = "test_file_writer_gzip.XXXXXX";
+  gint fd = mkstemp(filename);
+  cr_assert(fd >= 0);
+
+  FileWriteOptions write_options = { .compression = FILE_COMPRESSION_GZIP };
+  LogProtoClient *fw = log_proto_file_writer_new(log_transport_file_new(fd), &options, 2, FALSE);
+
+  messages_acked = 0;
+  log_proto_file_writer_set_write_options(fw, &write_options);
+  log_proto_client_set_client_flow_control(fw, &flow_control_funcs);
+  for (gint i = 0; i < 5; i++)
+    {
+      status = log_proto_client_post(fw, msg, (guchar *) g_strdup(payload), strlen(payload) + 1, &consumed);
+      cr_assert(status == LPS_SUCCESS);
+    }
+  cr_assert_eq(messages_acked, 4);
+  cr_assert(log_proto_client_flush(fw) == LPS_SUCCESS);
+  cr_assert_eq(messages_acked, 5);
+
+  log_proto_client_free(fw);
+
+  guchar decompressed[1024];
+  gsize len = _gunzip_file(filename, decompressed, sizeof(decompressed));
+  cr_assert_eq(len, 5 * (strlen(payload) + 1));
+  for (gint i = 0; i < 5; i++)
+    cr_assert_str_eq((gchar *) decompressed + i * (strlen(payload) + 1), payload);
+  unlink(filename);
+}
+
+#endif
+
 static void
 startup(void)
 {
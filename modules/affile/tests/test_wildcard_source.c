@@ -210,3 +210,13 @@ ParameterizedTest(struct LegacyWildcardTestParams *params, wildcard_source, test
 
   log_pipe_unref(&driver->super.super.super);
 }
+
+Test(wildcard_source, test_readers)
+{
+  cr_assert(_parse_config("base-dir(/test_non_existent_dir)"
+                          "filename-pattern(*.log)"
+                          "readers(4)"));
+  LogExprNode *expr_node = cfg_tree_get_object(&configuration->tree, ENC_SOURCE, "s_test");
+  WildcardSourceDriver *driver = (WildcardSourceDriver *)expr_node->children->children->object;
+  cr_assert_eq(driver->num_readers, 4);
+}
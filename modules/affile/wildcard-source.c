@@ -54,6 +54,93 @@ _check_required_options(WildcardSourceDriver *self)
   return TRUE;
 }
 
+/*
+ * Reader threads
+ *
+ * With readers(N), files are placed on one of the N reader threads when
+ * their reader is created, and stay there until it is removed: messages of
+ * a single file are always read in order by the same thread.  The thread
+ * is picked from two candidates derived from the hash of the path, taking
+ * the one following fewer files, which keeps the threads balanced as files
+ * come and go without ever moving a file that is being followed.
+ */
+
+static gint
+_pick_reader_thread(WildcardSourceDriver *self, const gchar *full_path)
+{
+  guint hash = g_str_hash(full_path);
+  gint first = hash % self->num_readers;
+  gint second = ((hash * 0x9E3779B1) >> 16) % self->num_readers;
+
+  if (self->reader_thread_files[second] < self->reader_thread_files[first])
+    return second;
+  return first;
+}
+
+static void
+_assign_reader_thread(WildcardSourceDriver *self, FileReader *reader)
+{
+  if (!self->reader_threads)
+    return;
+
+  gint index = _pick_reader_thread(self, reader->filename->str);
+
+  self->reader_thread_files[index]++;
+  file_reader_set_reader_thread(reader, self->reader_threads[index]);
+}
+
+static void
+_release_reader_thread(WildcardSourceDriver *self, FileReader *reader)
+{
+  if (!self->reader_threads || !reader->reader_thread)
+    return;
+
+  for (gint i = 0; i < self->num_readers; i++)
+    {
+      if (self->reader_threads[i] == reader->reader_thread)
+        {
+          self->reader_thread_files[i]--;
+          break;
+        }
+    }
+  file_reader_set_reader_thread(reader, NULL);
+}
+
+static void
+_start_reader_threads(WildcardSourceDriver *self)
+{
+  if (self->num_readers == 0)
+    return;
+
+  self->reader_threads = g_new0(LogReaderThread *, self->num_readers);
+  self->reader_thread_files = g_new0(gint, self->num_readers);
+  for (gint i = 0; i < self->num_readers; i++)
+    {
+      gint cpu = log_reader_options_pick_cpu(&self->file_reader_options.reader_options);
+
+      self->reader_threads[i] = log_reader_thread_new("wildcard-reader", cpu);
+      log_reader_thread_start(self->reader_threads[i]);
+    }
+}
+
+/* the threads exit once the readers attached to them are stopped */
+static void
+_stop_reader_threads(WildcardSourceDriver *self)
+{
+  if (!self->reader_threads)
+    return;
+
+  for (gint i = 0; i < self->num_readers; i++)
+    {
+      log_reader_thread_stop(self->reader_threads[i]);
+      log_reader_thread_unref(self->reader_threads[i]);
+    }
+  g_free(self->reader_threads);
+  g_free(self->reader_thread_files);
+  self->reader_threads = NULL;
+  self->reader_thread_files = NULL;
+}
+
 static void
 _remove_file_reader(FileReader *reader, gpointer user_data)
 {
@@ -65,6 +152,7 @@ _remove_file_reader(FileReader *reader, gpointer user_data)
 
   log_pipe_deinit(&reader->super);
   file_reader_remove_persist_state(reader);
+  _release_reader_thread(self, reader);
 
   log_pipe_ref(&reader->super);
   if (g_hash_table_remove(self->file_readers, reader->filename->str))
@@ -120,6 +208,7 @@ _create_file_reader(WildcardSourceDriver *self, const gchar *full_path)
   log_pipe_set_options(&reader->super.super, &self->super.super.super.options);
 
   wildcard_file_reader_on_deleted_file_eof(reader, _remove_file_reader, self);
+  _assign_reader_thread(self, &reader->super);
 
   log_pipe_append(&reader->super.super, &self->super.super.super);
   if (!log_pipe_init(&reader->super.super))
@@ -127,6 +216,7 @@ _create_file_reader(WildcardSourceDriver *self, const gchar *full_path)
       msg_warning("wildcard-file(): file reader initialization failed",
                   evt_tag_str("filename", full_path),
                   evt_tag_str("source_driver", self->super.super.group));
+      _release_reader_thread(self, &reader->super);
       log_pipe_unref(&reader->super.super);
     }
   else
@@ -344,9 +434,13 @@ _init(LogPipe *s)
     return FALSE;
 
   _init_opener_options(self, cfg);
+  _start_reader_threads(self);
 
   if (!_add_directory_monitor(self, self->base_dir))
-    return FALSE;
+    {
+      _stop_reader_threads(self);
+      return FALSE;
+    }
 
   return TRUE;
 }
@@ -367,6 +461,7 @@ _deinit(LogPipe *s)
   g_pattern_spec_free(self->compiled_pattern);
   g_hash_table_foreach(self->file_readers, _deinit_reader, NULL);
   g_hash_table_remove_all(self->directory_monitors);
+  _stop_reader_threads(self);
   return TRUE;
 }
 
@@ -420,6 +515,14 @@ wildcard_sd_set_max_files(LogDriver *s, guint32 max_files)
   self->max_files = max_files;
 }
 
+void
+wildcard_sd_set_readers(LogDriver *s, gint num_readers)
+{
+  WildcardSourceDriver *self = (WildcardSourceDriver *)s;
+
+  self->num_readers = num_readers;
+}
+
 /* to validate init-time uniqueness */
 static inline const gchar *
 _format_persist_name(const LogPipe *s)
@@ -435,6 +538,19 @@ _format_persist_name(const LogPipe *s)
   return persist_name;
 }
 
+static gboolean
+_pre_config_init(LogPipe *s)
+{
+  WildcardSourceDriver *self = (WildcardSourceDriver *)s;
+
+  if (self->num_readers > 0)
+    main_loop_worker_allocate_thread_space(self->num_readers);
+  /* one reader thread per followed file in the dedicated-thread() mode */
+  else if (log_reader_options_is_dedicated_thread_enabled(&self->file_reader_options.reader_options))
+    main_loop_worker_allocate_thread_space(self->max_files);
+  return TRUE;
+}
+
 static void
 _free(LogPipe *s)
 {
@@ -459,6 +575,7 @@ wildcard_sd_new(GlobalConfig *cfg)
   log_src_driver_init_instance(&self->super, cfg);
 
   self->super.super.super.free_fn = _free;
+  self->super.super.super.pre_config_init = _pre_config_init;
   self->super.super.super.init = _init;
   self->super.super.super.deinit = _deinit;
   self->super.super.super.generate_persist_name = _format_persist_name;
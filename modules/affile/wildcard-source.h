@@ -51,6 +51,12 @@ typedef struct _WildcardSourceDriver
   FileOpener *file_opener;
 
   PendingFileList *waiting_list;
+
+  /* readers(): the followed files are spread over this many reader
+   * threads, each file being read by a single one of them */
+  gint num_readers;
+  LogReaderThread **reader_threads;
+  gint *reader_thread_files;
 } WildcardSourceDriver;
 
 LogDriver *wildcard_sd_new(GlobalConfig *cfg);
@@ -60,6 +66,7 @@ void wildcard_sd_set_filename_pattern(LogDriver *s, const gchar *filename_patter
 void wildcard_sd_set_recursive(LogDriver *s, gboolean recursive);
 gboolean wildcard_sd_set_monitor_method(LogDriver *s, const gchar *method);
 void wildcard_sd_set_max_files(LogDriver *s, guint32 max_files);
+void wildcard_sd_set_readers(LogDriver *s, gint num_readers);
 
 gboolean affile_is_legacy_wildcard_source(const gchar *filename);
 LogDriver *wildcard_sd_legacy_new(const gchar *filename, GlobalConfig *cfg);
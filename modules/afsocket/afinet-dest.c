@@ -425,11 +425,47 @@ _libnet_destroy_when_spoof_source_enabled(AFInetDestDriver *self)
 #endif
 }
 
+static gchar *
+_format_tls_sessions_persist_name(AFInetDestDriver *self)
+{
+  return g_strdup_printf("%s.tls_sessions", log_pipe_get_persist_name(&self->super.super.super.super));
+}
+
+static void
+_load_tls_sessions(AFInetDestDriver *self)
+{
+  TLSContext *tls_context = ((TransportMapperInet *) self->super.transport_mapper)->tls_context;
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super.super);
+
+  if (!tls_context || !cfg->state)
+    return;
+
+  gchar *persist_name = _format_tls_sessions_persist_name(self);
+  tls_context_load_session_state(tls_context, cfg->state, persist_name);
+  g_free(persist_name);
+}
+
+static void
+_save_tls_sessions(AFInetDestDriver *self)
+{
+  TLSContext *tls_context = ((TransportMapperInet *) self->super.transport_mapper)->tls_context;
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super.super);
+
+  if (!tls_context || !cfg->state)
+    return;
+
+  gchar *persist_name = _format_tls_sessions_persist_name(self);
+  tls_context_save_session_state(tls_context, cfg->state, persist_name);
+  g_free(persist_name);
+}
+
 static gboolean
 afinet_dd_deinit(LogPipe *s)
 {
   AFInetDestDriver *self = (AFInetDestDriver *) s;
 
+  _save_tls_sessions(self);
+
   if (_is_failover_used(self))
     afinet_dd_failover_deinit(self->failover);
 
@@ -448,6 +484,8 @@ afinet_dd_init(LogPipe *s)
     self->super.connections_kept_alive_across_reloads = TRUE;
 #endif
 
+  _load_tls_sessions(self);
+
   if (!afsocket_dd_init(s))
     return FALSE;
 
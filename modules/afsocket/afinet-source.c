@@ -96,11 +96,30 @@ afinet_sd_setup_addresses(AFSocketSourceDriver *s)
   return TRUE;
 }
 
+/* session ticket keys are kept in persist-state, so that clients can
+ * resume their sessions after a reload or restart */
+static void
+_load_tls_ticket_keys(AFInetSourceDriver *self)
+{
+  TLSContext *tls_context = ((TransportMapperInet *) self->super.transport_mapper)->tls_context;
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super.super);
+
+  if (!tls_context || !cfg->state)
+    return;
+
+  gchar *persist_name = g_strdup_printf("%s.tls_ticket_keys",
+                                        log_pipe_get_persist_name(&self->super.super.super.super));
+  tls_context_load_session_state(tls_context, cfg->state, persist_name);
+  g_free(persist_name);
+}
+
 gboolean
 afinet_sd_init(LogPipe *s)
 {
   AFInetSourceDriver *self = (AFInetSourceDriver *) s;
 
+  _load_tls_ticket_keys(self);
+
   if (!afsocket_sd_init_method(&self->super.super.super.super))
     return FALSE;
 
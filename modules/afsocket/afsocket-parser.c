@@ -68,6 +68,8 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "allow_compress",     KW_ALLOW_COMPRESS },
   { "ocsp_stapling_verify", KW_OCSP_STAPLING_VERIFY },
   { "openssl_conf_cmds",  KW_CONF_CMDS},
+  { "ktls",               KW_KTLS },
+  { "session_resumption", KW_SESSION_RESUMPTION },
 
   { "localip",            KW_LOCALIP },
   { "ip",                 KW_IP },
@@ -108,6 +110,7 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "dynamic_window_size", KW_DYNAMIC_WINDOW_SIZE },
   { "dynamic_window_stats_freq", KW_DYNAMIC_WINDOW_STATS_FREQ },
   { "dynamic_window_realloc_ticks", KW_DYNAMIC_WINDOW_REALLOC_TICKS },
+  { "io_uring",           KW_IO_URING },
   { NULL }
 };
 
@@ -42,8 +42,19 @@ typedef struct _AFSocketSetupSocketSignalData
   gboolean failure;
 } AFSocketSetupSocketSignalData;
 
+typedef struct _AFSocketQueueFillLevelSignalData
+{
+  /* filled in by the source driver: the socket it receives on (-1 if
+   * there is none) and the fill level of its readers' window in percent,
+   * the highest one if there are multiple connections */
+  gint sock;
+  gint fill_level;
+} AFSocketQueueFillLevelSignalData;
+
 #define signal_afsocket_setup_socket SIGNAL(afsocket, setup_socket, AFSocketSetupSocketSignalData *)
 
+#define signal_afsocket_queue_fill_level SIGNAL(afsocket, queue_fill_level, AFSocketQueueFillLevelSignalData *)
+
 #define signal_afsocket_tls_certificate_validation SIGNAL(afsocket, tls_certificate_validation, AFSocketTLSCertificateValidationSignalData *)
 
 #endif
@@ -169,7 +169,8 @@ afsocket_sc_init(LogPipe *s)
 
       self->reader = log_reader_new(s->cfg);
       log_pipe_set_options(&self->reader->super.super, &self->super.options);
-      log_reader_open(self->reader, proto, poll_fd_events_new(self->sock));
+      log_reader_open(self->reader, proto,
+                      poll_fd_events_new(log_transport_stack_get_poll_fd(&proto->transport_stack)));
       log_reader_set_peer_addr(self->reader, self->peer_addr);
       log_reader_set_local_addr(self->reader, self->local_addr);
     }
@@ -1074,6 +1075,39 @@ afsocket_sd_open_socket(AFSocketSourceDriver *self, gint *sock)
   return !signal_data.failure;
 }
 
+static gint
+_connection_fill_level(AFSocketSourceConnection *conn)
+{
+  LogSource *source = &conn->reader->super;
+  gsize full_window_size = source->full_window_size;
+
+  if (full_window_size == 0)
+    return 0;
+
+  gsize free_window = window_size_counter_get(&source->window_size, NULL);
+  if (free_window >= full_window_size)
+    return 0;
+
+  return (gint) ((full_window_size - free_window) * 100 / full_window_size);
+}
+
+static void
+_slot_queue_fill_level(AFSocketSourceDriver *self, AFSocketQueueFillLevelSignalData *data)
+{
+  data->sock = self->listen_fd.fd;
+  data->fill_level = 0;
+
+  for (GList *l = self->connections; l; l = l->next)
+    {
+      AFSocketSourceConnection *conn = (AFSocketSourceConnection *) l->data;
+
+      /* datagram sources receive on the socket of their single connection */
+      if (data->sock == -1)
+        data->sock = conn->sock;
+      data->fill_level = MAX(data->fill_level, _connection_fill_level(conn));
+    }
+}
+
 static gboolean
 _sd_open_stream(AFSocketSourceDriver *self)
 {
@@ -1359,6 +1393,17 @@ afsocket_sd_notify(LogPipe *s, gint notify_code, gpointer user_data)
     }
 }
 
+static gboolean
+afsocket_sd_pre_config_init(LogPipe *s)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) s;
+
+  /* one reader thread per connection in the dedicated-thread() mode */
+  if (log_reader_options_is_dedicated_thread_enabled(&self->reader_options))
+    main_loop_worker_allocate_thread_space(atomic_gssize_get(&self->max_connections));
+  return TRUE;
+}
+
 void
 afsocket_sd_free_method(LogPipe *s)
 {
@@ -1381,6 +1426,7 @@ afsocket_sd_init_instance(AFSocketSourceDriver *self,
   log_src_driver_init_instance(&self->super, cfg);
 
   self->super.super.super.queue = afsocket_sd_queue;
+  self->super.super.super.pre_config_init = afsocket_sd_pre_config_init;
   self->super.super.super.init = afsocket_sd_init_method;
   self->super.super.super.deinit = afsocket_sd_deinit_method;
   self->super.super.super.free_fn = afsocket_sd_free_method;
@@ -1399,5 +1445,6 @@ afsocket_sd_init_instance(AFSocketSourceDriver *self,
   self->reader_options.super.stats_source = transport_mapper->stats_source;
   self->activate_listener = TRUE;
 
+  CONNECT(self->super.super.signal_slot_connector, signal_afsocket_queue_fill_level, _slot_queue_fill_level, self);
   afsocket_sd_init_watches(self);
 }
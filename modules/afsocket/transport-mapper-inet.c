@@ -31,6 +31,7 @@
 #include "transport/transport-haproxy.h"
 #include "transport/transport-socket.h"
 #include "transport/transport-udp-socket.h"
+#include "transport/transport-io-uring.h"
 #include "secret-storage/secret-storage.h"
 
 #include <sys/types.h>
@@ -75,6 +76,43 @@ transport_mapper_inet_validate_tls_options(TransportMapperInet *self)
   return TRUE;
 }
 
+static gboolean
+_is_io_uring_usable(TransportMapperInet *self)
+{
+  if (!self->io_uring)
+    return FALSE;
+
+  if (self->super.sock_type != SOCK_STREAM)
+    {
+      msg_warning("WARNING: io-uring() is only supported for stream transports, ignoring",
+                  evt_tag_str("transport", self->super.transport));
+      return FALSE;
+    }
+  if (self->tls_context)
+    {
+      /* the TLS transport reads the socket directly */
+      msg_warning("WARNING: io-uring() is not supported with TLS, ignoring",
+                  evt_tag_str("transport", self->super.transport));
+      return FALSE;
+    }
+  if (!log_transport_io_uring_is_supported())
+    {
+      msg_warning("WARNING: io-uring() was requested, but syslog-ng was compiled without io_uring support, ignoring");
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+transport_mapper_inet_validate_options(TransportMapperInet *self)
+{
+  if (!transport_mapper_inet_validate_tls_options(self))
+    return FALSE;
+
+  self->io_uring = _is_io_uring_usable(self);
+  return TRUE;
+}
+
 static gboolean
 transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *cfg)
 {
@@ -83,7 +121,20 @@ transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *c
   if (!transport_mapper_apply_transport_method(s, cfg))
     return FALSE;
 
-  return transport_mapper_inet_validate_tls_options(self);
+  return transport_mapper_inet_validate_options(self);
+}
+
+static LogTransport *
+_construct_stream_socket_transport(TransportMapperInet *self, gint fd)
+{
+  if (self->io_uring)
+    {
+      LogTransport *transport = log_transport_io_uring_stream_socket_new(fd);
+
+      if (transport)
+        return transport;
+    }
+  return log_transport_stream_socket_new(fd);
 }
 
 static gboolean
@@ -92,7 +143,7 @@ _setup_socket_transport(TransportMapperInet *self, LogTransportStack *stack)
   log_transport_stack_add_transport(stack, LOG_TRANSPORT_SOCKET,
                                     self->super.sock_type == SOCK_DGRAM
                                     ? log_transport_udp_socket_new(stack->fd)
-                                    : log_transport_stream_socket_new(stack->fd));
+                                    : _construct_stream_socket_transport(self, stack->fd));
   return TRUE;
 }
 
@@ -433,7 +484,7 @@ transport_mapper_network_apply_transport(TransportMapper *s, GlobalConfig *cfg)
 
   g_assert(self->server_port != 0);
 
-  if (!transport_mapper_inet_validate_tls_options(self))
+  if (!transport_mapper_inet_validate_options(self))
     return FALSE;
 
   return TRUE;
@@ -541,7 +592,7 @@ transport_mapper_syslog_apply_transport(TransportMapper *s, GlobalConfig *cfg)
     }
   g_assert(self->server_port != 0);
 
-  if (!transport_mapper_inet_validate_tls_options(self))
+  if (!transport_mapper_inet_validate_options(self))
     return FALSE;
 
   return TRUE;
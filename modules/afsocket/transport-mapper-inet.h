@@ -37,6 +37,7 @@ typedef struct _TransportMapperInet
   gboolean allow_tls;
   gboolean require_tls_when_has_tls_context;
   gboolean proxied;
+  gboolean io_uring;
   TLSContext *tls_context;
   TLSVerifier *tls_verifier;
   gpointer secret_store_cb_data;
@@ -52,6 +53,14 @@ transport_mapper_inet_set_allow_compress(TransportMapper *s, gboolean value)
     self->flags &= ~TMI_ALLOW_COMPRESS;
 }
 
+static inline void
+transport_mapper_inet_set_io_uring(TransportMapper *s, gboolean value)
+{
+  TransportMapperInet *self = (TransportMapperInet *) s;
+
+  self->io_uring = value;
+}
+
 static inline gint
 transport_mapper_inet_get_server_port(const TransportMapper *self)
 {
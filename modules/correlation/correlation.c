@@ -26,43 +26,56 @@
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 
+static inline CorrelationStateShard *
+_get_shard(CorrelationState *self, const CorrelationKey *key)
+{
+  guint hash = correlation_key_hash(key);
+
+  /* the scope is stored in the topmost bits of the hash, fold them in */
+  return &self->shards[(hash ^ (hash >> 16)) % CORRELATION_STATE_NUM_SHARDS];
+}
+
 void
-correlation_state_tx_begin(CorrelationState *self)
+correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_lock(&self->lock);
+  g_mutex_lock(&_get_shard(self, key)->lock);
 }
 
 void
-correlation_state_tx_end(CorrelationState *self)
+correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_unlock(&self->lock);
+  g_mutex_unlock(&_get_shard(self, key)->lock);
 }
 
 CorrelationContext *
 correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key)
 {
-  return g_hash_table_lookup(self->state, key);
+  return g_hash_table_lookup(_get_shard(self, key)->state, key);
 }
 
 void
 correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   g_assert(context->timer == NULL);
 
-  g_hash_table_insert(self->state, &context->key, context);
-  context->timer = timer_wheel_add_timer(self->timer_wheel, timeout, self->expire_callback,
+  g_hash_table_insert(shard->state, &context->key, context);
+  context->timer = timer_wheel_add_timer(shard->timer_wheel, timeout, self->expire_callback,
                                          correlation_context_ref(context), (GDestroyNotify) correlation_context_unref);
 }
 
 void
 correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   /* NOTE: in expire callbacks our timer is already deleted and thus it is
    * set to NULL in which case we don't need to remove it again.  */
 
   if (context->timer)
-    timer_wheel_del_timer(self->timer_wheel, context->timer);
-  g_hash_table_remove(self->state, &context->key);
+    timer_wheel_del_timer(shard->timer_wheel, context->timer);
+  g_hash_table_remove(shard->state, &context->key);
 }
 
 void
@@ -70,26 +83,62 @@ correlation_state_tx_update_context(CorrelationState *self, CorrelationContext *
 {
   g_assert(context->timer != NULL);
 
-  timer_wheel_mod_timer(self->timer_wheel, context->timer, timeout);
+  timer_wheel_mod_timer(_get_shard(self, &context->key)->timer_wheel, context->timer, timeout);
+}
+
+static void
+_set_shards_time(CorrelationState *self, guint64 new_time, gpointer caller_context)
+{
+  for (gint i = 0; i < CORRELATION_STATE_NUM_SHARDS; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_lock(&shard->lock);
+      timer_wheel_set_time(shard->timer_wheel, new_time, caller_context);
+      g_mutex_unlock(&shard->lock);
+    }
+}
+
+/* Moves the global time forward to new_time, returns FALSE if some other
+ * thread has already got there, in which case the shards need not be
+ * touched.  This keeps the per-message set_time() calls lock free in the
+ * common case, when the time has not changed since the last message. */
+static gboolean
+_forward_time(CorrelationState *self, guint64 new_time)
+{
+  gssize current;
+
+  do
+    {
+      current = atomic_gssize_get(&self->now);
+      if ((guint64) current >= new_time)
+        return FALSE;
+    }
+  while (!atomic_gssize_compare_and_exchange(&self->now, current, (gssize) new_time));
+  return TRUE;
 }
 
 void
 correlation_state_expire_all(CorrelationState *self, gpointer caller_context)
 {
-  g_mutex_lock(&self->lock);
-  timer_wheel_expire_all(self->timer_wheel, caller_context);
-  g_mutex_unlock(&self->lock);
+  for (gint i = 0; i < CORRELATION_STATE_NUM_SHARDS; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_lock(&shard->lock);
+      timer_wheel_expire_all(shard->timer_wheel, caller_context);
+      g_mutex_unlock(&shard->lock);
+    }
 }
 
 void
 correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context)
 {
-  guint64  new_time;
+  guint64 new_time;
 
-  g_mutex_lock(&self->lock);
-  new_time = timer_wheel_get_time(self->timer_wheel) + timeout;
-  timer_wheel_set_time(self->timer_wheel, new_time, caller_context);
-  g_mutex_unlock(&self->lock);
+  new_time = correlation_state_get_time(self) + timeout;
+  if (_forward_time(self, new_time))
+    _set_shards_time(self, new_time, caller_context);
 }
 
 void
@@ -103,20 +152,22 @@ correlation_state_set_time(CorrelationState *self, guint64 sec, gpointer caller_
    * correlation engine too much. */
 
   get_cached_realtime(&now);
+
+  g_mutex_lock(&self->tick_lock);
   self->last_tick = now;
+  g_mutex_unlock(&self->tick_lock);
 
   if (sec < now.tv_sec)
     now.tv_sec = sec;
 
-  g_mutex_lock(&self->lock);
-  timer_wheel_set_time(self->timer_wheel, now.tv_sec, caller_context);
-  g_mutex_unlock(&self->lock);
+  if (_forward_time(self, now.tv_sec))
+    _set_shards_time(self, now.tv_sec, caller_context);
 }
 
 guint64
 correlation_state_get_time(CorrelationState *self)
 {
-  return timer_wheel_get_time(self->timer_wheel);
+  return (guint64) atomic_gssize_get(&self->now);
 }
 
 gboolean
@@ -124,9 +175,9 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
 {
   struct timespec now;
   glong diff;
-  gboolean updated = FALSE;
+  guint64 new_time = 0;
 
-  g_mutex_lock(&self->lock);
+  g_mutex_lock(&self->tick_lock);
   get_cached_realtime(&now);
   diff = timespec_diff_usec(&now, &self->last_tick);
 
@@ -134,12 +185,11 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
     {
       glong diff_sec = (glong)(diff / 1e6);
 
-      timer_wheel_set_time(self->timer_wheel, timer_wheel_get_time(self->timer_wheel) + diff_sec, caller_context);
+      new_time = correlation_state_get_time(self) + diff_sec;
       /* update last_tick, take the fraction of the seconds not calculated into this update into account */
 
       self->last_tick = now;
       timespec_add_usec(&self->last_tick, - (glong)(diff - diff_sec * 1e6));
-      updated = TRUE;
     }
   else if (diff < 0)
     {
@@ -149,20 +199,41 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
        */
       self->last_tick = now;
     }
-  g_mutex_unlock(&self->lock);
-  return updated;
+  g_mutex_unlock(&self->tick_lock);
+
+  if (new_time && _forward_time(self, new_time))
+    {
+      _set_shards_time(self, new_time, caller_context);
+      return TRUE;
+    }
+  return FALSE;
 }
 
+/* The associated data is shared by all timer wheels, it is owned by the
+ * first one and destroyed along with it. */
+void
+correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data, GDestroyNotify assoc_data_free)
+{
+  timer_wheel_set_associated_data(self->shards[0].timer_wheel, assoc_data, assoc_data_free);
+  for (gint i = 1; i < CORRELATION_STATE_NUM_SHARDS; i++)
+    timer_wheel_set_associated_data(self->shards[i].timer_wheel, assoc_data, NULL);
+}
 
 CorrelationState *
 correlation_state_new(TWCallbackFunc expire_callback)
 {
   CorrelationState *self = g_new0(CorrelationState, 1);
 
-  g_mutex_init(&self->lock);
-  self->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
-                                      (GDestroyNotify) correlation_context_unref);
-  self->timer_wheel = timer_wheel_new();
+  for (gint i = 0; i < CORRELATION_STATE_NUM_SHARDS; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_init(&shard->lock);
+      shard->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
+                                           (GDestroyNotify) correlation_context_unref);
+      shard->timer_wheel = timer_wheel_new();
+    }
+  g_mutex_init(&self->tick_lock);
   get_cached_realtime(&self->last_tick);
   g_atomic_counter_set(&self->ref_cnt, 1);
   self->expire_callback = expire_callback;
@@ -172,10 +243,18 @@ correlation_state_new(TWCallbackFunc expire_callback)
 void
 _free(CorrelationState *self)
 {
-  if (self->state)
-    g_hash_table_destroy(self->state);
-  timer_wheel_free(self->timer_wheel);
-  g_mutex_clear(&self->lock);
+  /* wheels are freed in reverse order, so that the associated data owned
+   * by the first one is destroyed last */
+  for (gint i = CORRELATION_STATE_NUM_SHARDS - 1; i >= 0; i--)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      if (shard->state)
+        g_hash_table_destroy(shard->state);
+      timer_wheel_free(shard->timer_wheel);
+      g_mutex_clear(&shard->lock);
+    }
+  g_mutex_clear(&self->tick_lock);
   g_free(self);
 }
 
@@ -28,19 +28,37 @@
 #include "correlation-context.h"
 #include "timerwheel.h"
 #include "timeutils/unixtime.h"
+#include "atomic-gssize.h"
 
-typedef struct _CorrelationState
+#define CORRELATION_STATE_NUM_SHARDS 16
+
+/* Contexts are distributed among shards based on the hash of their key,
+ * each shard having its own lock and timer wheel.  A transaction
+ * (tx_begin/tx_end) locks the shard of a single key, so all tx_* calls
+ * within a transaction must refer to contexts with the same key.  Expire
+ * callbacks are invoked with the lock of the expiring context's shard
+ * held. */
+typedef struct _CorrelationStateShard
 {
-  GAtomicCounter ref_cnt;
   GMutex lock;
   GHashTable *state;
   TimerWheel *timer_wheel;
+} CorrelationStateShard;
+
+typedef struct _CorrelationState
+{
+  GAtomicCounter ref_cnt;
+  CorrelationStateShard shards[CORRELATION_STATE_NUM_SHARDS];
   TWCallbackFunc expire_callback;
+
+  /* the highest time any of the shards has been advanced to */
+  atomic_gssize now;
+  GMutex tick_lock;
   struct timespec last_tick;
 } CorrelationState;
 
-void correlation_state_tx_begin(CorrelationState *self);
-void correlation_state_tx_end(CorrelationState *self);
+void correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key);
+void correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key);
 CorrelationContext *correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key);
 void correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout);
 void correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context);
@@ -51,6 +69,7 @@ guint64 correlation_state_get_time(CorrelationState *self);
 gboolean correlation_state_timer_tick(CorrelationState *self, gpointer caller_context);
 void correlation_state_expire_all(CorrelationState *self, gpointer caller_context);
 void correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context);
+void correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data, GDestroyNotify assoc_data_free);
 
 void correlation_state_init_instance(CorrelationState *self);
 void correlation_state_deinit_instance(CorrelationState *self);
@@ -30,6 +30,7 @@
 #include "pdb-context.h"
 #include "pdb-ratelimit.h"
 #include "pdb-lookup-params.h"
+#include "pdb-file.h"
 #include "correlation.h"
 #include "logmsg/logmsg.h"
 #include "template/templates.h"
@@ -57,6 +58,10 @@ typedef struct _PDBProcessParams
   gpointer emitted_messages[EXPECTED_NUMBER_OF_MESSAGES_EMITTED];
   GPtrArray *emitted_messages_overflow;
   gint num_emitted_messages;
+  /* contexts started by create-context actions, stored once the lock of
+   * the triggering context's shard is released, see
+   * _flush_created_contexts() */
+  GPtrArray *created_contexts;
 } PDBProcessParams;
 
 struct _PatternDB
@@ -65,6 +70,7 @@ struct _PatternDB
   PDBRuleSet *ruleset;
   CorrelationState *correlation;
   LogTemplate *program_template;
+  GMutex rate_limits_lock;
   GHashTable *rate_limits;
   PatternDBEmitFunc emit;
   gpointer emit_data;
@@ -132,6 +138,28 @@ _flush_emitted_messages(PatternDB *self, PDBProcessParams *process_params)
     }
 }
 
+/* Contexts created by create-context actions may belong to a different
+ * shard of the correlation state than the one locked while executing the
+ * action, so they are stored here, without holding any shard locks, to
+ * avoid lock ordering issues between shards. */
+static void
+_flush_created_contexts(PatternDB *self, PDBProcessParams *process_params)
+{
+  if (!process_params->created_contexts)
+    return;
+
+  for (gint i = 0; i < process_params->created_contexts->len; i++)
+    {
+      PDBContext *context = g_ptr_array_index(process_params->created_contexts, i);
+
+      correlation_state_tx_begin(self->correlation, &context->super.key);
+      correlation_state_tx_store_context(self->correlation, &context->super, context->rule->context.timeout);
+      correlation_state_tx_end(self->correlation, &context->super.key);
+    }
+  g_ptr_array_free(process_params->created_contexts, TRUE);
+  process_params->created_contexts = NULL;
+}
+
 /*
  * Timing
  * ======
@@ -181,6 +209,7 @@ _is_action_within_rate_limit(PatternDB *db, PDBProcessParams *process_params)
   CorrelationKey key;
   PDBRateLimit *rl;
   guint64 now;
+  gboolean within_limit = FALSE;
 
   if (action->rate == 0)
     return TRUE;
@@ -188,6 +217,7 @@ _is_action_within_rate_limit(PatternDB *db, PDBProcessParams *process_params)
   g_string_printf(buffer, "%s:%d", rule->rule_id, action->id);
   correlation_key_init(&key, rule->context.scope, msg, buffer->str);
 
+  g_mutex_lock(&db->rate_limits_lock);
   rl = g_hash_table_lookup(db->rate_limits, &key);
   if (!rl)
     {
@@ -224,9 +254,10 @@ _is_action_within_rate_limit(PatternDB *db, PDBProcessParams *process_params)
   if (rl->buckets)
     {
       rl->buckets--;
-      return TRUE;
+      within_limit = TRUE;
     }
-  return FALSE;
+  g_mutex_unlock(&db->rate_limits_lock);
+  return within_limit;
 }
 
 static gboolean
@@ -319,12 +350,15 @@ _execute_action_create_context(PatternDB *db, PDBProcessParams *process_params)
 
   correlation_key_init(&key, syn_context->scope, context_msg, buffer->str);
   new_context = pdb_context_new(&key);
-  correlation_state_tx_store_context(db->correlation, &new_context->super, rule->context.timeout);
   g_string_free(buffer, FALSE);
 
   g_ptr_array_add(new_context->super.messages, context_msg);
 
   new_context->rule = pdb_rule_ref(rule);
+
+  if (!process_params->created_contexts)
+    process_params->created_contexts = g_ptr_array_new();
+  g_ptr_array_add(process_params->created_contexts, new_context);
 }
 
 static void
@@ -376,12 +410,12 @@ _execute_rule_actions(PatternDB *db, PDBProcessParams *process_params, PDBAction
  * PatternDB
  *********************************************************/
 
-/* NOTE: this function requires PatternDB reader/writer lock to be
- * write-locked.
+/* NOTE: this function requires the lock of the correlation state shard
+ * owning the context to be held.
  *
- * Currently, it is, as timer_wheel_set_time() is only called with that
- * precondition, and timer-wheel callbacks are only called from within
- * timer_wheel_set_time().
+ * Currently, it is, as the correlation state only calls
+ * timer_wheel_set_time() with that precondition, and timer-wheel callbacks
+ * are only called from within timer_wheel_set_time().
  */
 
 static void
@@ -426,6 +460,7 @@ pattern_db_timer_tick(PatternDB *self)
       msg_debug("Advancing patterndb current time because of timer tick",
                 evt_tag_long("utc", correlation_state_get_time(self->correlation)));
     }
+  _flush_created_contexts(self, &process_params);
   _flush_emitted_messages(self, &process_params);
 }
 
@@ -445,22 +480,51 @@ pattern_db_advance_time(PatternDB *self, gint timeout)
   PDBProcessParams process_params= {0};
 
   correlation_state_advance_time(self->correlation, timeout, &process_params);
+  _flush_created_contexts(self, &process_params);
   _flush_emitted_messages(self, &process_params);
 }
 
+/* The rules embed templates and filters compiled against the
+ * configuration, so the current ruleset can only be kept if it belongs to
+ * the same configuration and was loaded from identical content. */
+static gboolean
+_is_ruleset_up_to_date(PatternDB *self, GlobalConfig *cfg, const gchar *checksum)
+{
+  return self->ruleset && checksum &&
+         self->ruleset->cfg == cfg &&
+         g_strcmp0(self->ruleset->checksum, checksum) == 0;
+}
+
 gboolean
 pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_file)
 {
   PDBRuleSet *new_ruleset;
+  gchar *checksum;
+
+  /* hashing the file is much cheaper than parsing it and compiling the
+   * patterns, templates and filters within */
+  checksum = pdb_file_checksum(pdb_file, NULL);
+  if (_is_ruleset_up_to_date(self, cfg, checksum))
+    {
+      msg_debug("Pattern database content unchanged, keeping the loaded ruleset",
+                evt_tag_str("file", pdb_file),
+                evt_tag_str("checksum", checksum));
+      g_free(checksum);
+      return TRUE;
+    }
 
   new_ruleset = pdb_rule_set_new(self->prefix);
   if (!pdb_rule_set_load(new_ruleset, cfg, pdb_file, NULL))
     {
+      g_free(checksum);
       pdb_rule_set_free(new_ruleset);
       return FALSE;
     }
   else
     {
+      new_ruleset->checksum = checksum;
+      pdb_rule_set_compile(new_ruleset);
+
       g_mutex_lock(&self->ruleset_lock);
       if (self->ruleset)
         pdb_rule_set_free(self->ruleset);
@@ -517,7 +581,8 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   LogMessage *msg = process_params->msg;
   GString *buffer = g_string_sized_new(32);
 
-  correlation_state_tx_begin(self->correlation);
+  /* rules without a context only touch the rate limits, which have their
+   * own lock, so no correlation state shard needs to be locked */
   if (rule->context.id_template)
     {
       CorrelationKey key;
@@ -526,6 +591,7 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
       log_msg_set_value(msg, context_id_handle, buffer->str, -1);
 
       correlation_key_init(&key, rule->context.scope, msg, buffer->str);
+      correlation_state_tx_begin(self->correlation, &key);
       context = (PDBContext *) correlation_state_tx_lookup_context(self->correlation, &key);
       if (!context)
         {
@@ -570,7 +636,8 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   _execute_rule_actions(self, process_params, RAT_MATCH);
 
   pdb_rule_unref(rule);
-  correlation_state_tx_end(self->correlation);
+  if (context)
+    correlation_state_tx_end(self->correlation, &context->super.key);
 
   if (context)
     log_msg_write_protect(msg);
@@ -584,6 +651,7 @@ _pattern_db_advance_time_and_flush_expired(PatternDB *self, LogMessage *msg)
   PDBProcessParams process_params = {0};
 
   _advance_time_based_on_message(self, &process_params, &msg->timestamps[LM_TS_STAMP]);
+  _flush_created_contexts(self, &process_params);
   _flush_emitted_messages(self, &process_params);
 }
 
@@ -609,6 +677,7 @@ _pattern_db_process(PatternDB *self, PDBLookupParams *lookup, GArray *dbg_list)
   if (process_params->rule)
     _pattern_db_process_matching_rule(self, process_params);
 
+  _flush_created_contexts(self, process_params);
   _flush_emitted_messages(self, process_params);
 
   return process_params->rule != NULL;
@@ -648,6 +717,7 @@ pattern_db_expire_state(PatternDB *self)
   PDBProcessParams process_params = {0};
 
   correlation_state_expire_all(self->correlation, &process_params);
+  _flush_created_contexts(self, &process_params);
   _flush_emitted_messages(self, &process_params);
 
 }
@@ -658,7 +728,7 @@ _init_state(PatternDB *self)
   self->rate_limits = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
                                             (GDestroyNotify) pdb_rate_limit_free);
   self->correlation = correlation_state_new(pattern_db_expire_entry);
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, self, NULL);
+  correlation_state_set_associated_data(self->correlation, self, NULL);
 }
 
 static void
@@ -687,6 +757,7 @@ pattern_db_new(const gchar *prefix)
   self->prefix = g_strdup(prefix);
   self->ruleset = pdb_rule_set_new(self->prefix);
   g_mutex_init(&self->ruleset_lock);
+  g_mutex_init(&self->rate_limits_lock);
   _init_state(self);
   return self;
 }
@@ -700,6 +771,7 @@ pattern_db_free(PatternDB *self)
     pdb_rule_set_free(self->ruleset);
   _destroy_state(self);
   g_mutex_clear(&self->ruleset_lock);
+  g_mutex_clear(&self->rate_limits_lock);
   g_free(self);
 }
 
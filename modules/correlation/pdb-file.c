@@ -81,6 +81,37 @@ exit:
   return result;
 }
 
+/* returns the SHA-256 checksum of the file content as a hex string */
+gchar *
+pdb_file_checksum(const gchar *pdbfile, GError **error)
+{
+  FILE *pdb;
+  GChecksum *checksum;
+  guchar buff[4096];
+  gsize bytes_read;
+  gchar *result = NULL;
+
+  pdb = fopen(pdbfile, "r");
+  if (!pdb)
+    {
+      g_set_error(error, PDB_ERROR, PDB_ERROR_FAILED, "Error opening file %s (%s)", pdbfile, g_strerror(errno));
+      return NULL;
+    }
+
+  checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  while ((bytes_read = fread(buff, 1, sizeof(buff), pdb)) != 0)
+    g_checksum_update(checksum, buff, bytes_read);
+
+  if (ferror(pdb))
+    g_set_error(error, PDB_ERROR, PDB_ERROR_FAILED, "Error reading file %s (%s)", pdbfile, g_strerror(errno));
+  else
+    result = g_strdup(g_checksum_get_string(checksum));
+
+  g_checksum_free(checksum);
+  fclose(pdb);
+  return result;
+}
+
 static const gchar *
 _get_xsddir_in_build(void)
 {
@@ -27,6 +27,7 @@
 #include "syslog-ng.h"
 
 gint pdb_file_detect_version(const gchar *pdbfile, GError **error);
+gchar *pdb_file_checksum(const gchar *pdbfile, GError **error);
 gboolean pdb_file_validate(const gchar *filename, GError **error);
 gboolean pdb_file_validate_in_tests(const gchar *filename, GError **error);
 GPtrArray *pdb_get_filenames(const gchar *dir_path, gboolean recursive, gchar *pattern, GError **error);
@@ -1197,6 +1197,7 @@ pdb_rule_set_load(PDBRuleSet *self, GlobalConfig *cfg, const gchar *config, GLis
   memset(&state, 0x0, sizeof(state));
 
   state.ruleset = self;
+  self->cfg = cfg;
   state.root_program = pdb_program_new();
   state.load_examples = !!examples;
   state.ruleset_patterns = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) pdb_program_unref);
@@ -29,6 +29,15 @@
  *   - Parser -> programs -> rules -> patterns
  */
 
+/* Builds the compact representation of the rules tree, which must not
+ * change afterwards. */
+void
+pdb_program_compile(PDBProgram *self)
+{
+  if (!self->compiled_rules)
+    self->compiled_rules = r_compact_tree_new(self->rules);
+}
+
 PDBProgram *
 pdb_program_new(void)
 {
@@ -53,6 +62,7 @@ pdb_program_unref(PDBProgram *s)
 
   if (--self->ref_cnt == 0)
     {
+      r_compact_tree_free(self->compiled_rules);
       if (self->rules)
         r_free_node(self->rules, (void (*)(void *)) pdb_rule_unref);
 
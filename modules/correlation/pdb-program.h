@@ -37,8 +37,11 @@ typedef struct _PDBProgram
   guint ref_cnt;
   gchar *pdb_location;
   RNode *rules;
+  /* lookup optimized copy of rules, see pdb_program_compile() */
+  RCompactTree *compiled_rules;
 } PDBProgram;
 
+void pdb_program_compile(PDBProgram *self);
 PDBProgram *pdb_program_new(void);
 PDBProgram *pdb_program_ref(PDBProgram *self);
 void pdb_program_unref(PDBProgram *s);
@@ -96,7 +96,10 @@ pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_li
 
   program_value = _calculate_program(lookup, msg, &program_len);
   prg_matches = g_array_new(FALSE, TRUE, sizeof(RParserMatch));
-  node = r_find_node(rule_set->programs, (gchar *) program_value, program_len, prg_matches);
+  if (rule_set->compiled_programs)
+    node = r_compact_find_node(rule_set->compiled_programs, (gchar *) program_value, program_len, prg_matches);
+  else
+    node = r_find_node(rule_set->programs, (gchar *) program_value, program_len, prg_matches);
 
   if (node)
     {
@@ -130,6 +133,8 @@ pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_li
 
           if (G_UNLIKELY(dbg_list))
             msg_node = r_find_node_dbg(program->rules, (gchar *) message, message_len, matches, dbg_list);
+          else if (program->compiled_rules)
+            msg_node = r_compact_find_node(program->compiled_rules, (gchar *) message, message_len, matches);
           else
             msg_node = r_find_node(program->rules, (gchar *) message, message_len, matches);
 
@@ -173,6 +178,33 @@ pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_li
 }
 
 
+static void
+_compile_programs(RNode *node)
+{
+  if (node->value)
+    pdb_program_compile((PDBProgram *) node->value);
+
+  for (gint i = 0; i < node->num_children; i++)
+    _compile_programs(node->children[i]);
+  for (gint i = 0; i < node->num_pchildren; i++)
+    _compile_programs(node->pchildren[i]);
+}
+
+/*
+ * Builds the compact, lookup optimized representation of the radix trees
+ * once the ruleset is completely loaded.  The ruleset must not be
+ * modified afterwards.
+ */
+void
+pdb_rule_set_compile(PDBRuleSet *self)
+{
+  if (!self->programs || self->compiled_programs)
+    return;
+
+  _compile_programs(self->programs);
+  self->compiled_programs = r_compact_tree_new(self->programs);
+}
+
 PDBRuleSet *
 pdb_rule_set_new(const gchar *prefix)
 {
@@ -185,11 +217,13 @@ pdb_rule_set_new(const gchar *prefix)
 void
 pdb_rule_set_free(PDBRuleSet *self)
 {
+  r_compact_tree_free(self->compiled_programs);
   if (self->programs)
     r_free_node(self->programs, (GDestroyNotify) pdb_program_unref);
   g_free(self->version);
   g_free(self->pub_date);
   g_free(self->prefix);
+  g_free(self->checksum);
   g_free(self);
 }
 
@@ -32,13 +32,20 @@
 typedef struct _PDBRuleSet
 {
   RNode *programs;
+  /* lookup optimized copy of programs, see pdb_rule_set_compile() */
+  RCompactTree *compiled_programs;
   gchar *version;
   gchar *pub_date;
   gchar *prefix;
   gboolean is_empty;
+  /* the configuration the templates and filters of the rules are bound to */
+  GlobalConfig *cfg;
+  /* checksum of the pdb file the ruleset was loaded from */
+  gchar *checksum;
 } PDBRuleSet;
 
 PDBRule *pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_list);
+void pdb_rule_set_compile(PDBRuleSet *self);
 PDBRuleSet *pdb_rule_set_new(const gchar *prefix);
 void pdb_rule_set_free(PDBRuleSet *self);
 
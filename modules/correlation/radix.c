@@ -1260,15 +1260,14 @@ _truncate_debug_info(RFindNodeState *state, gint truncated_size)
 }
 
 static void
-_find_matching_literal_prefix(RNode *root, gchar *key, gint keylen,
-                              gint *literal_prefix_inputlen,
-                              gint *literal_prefix_radixlen)
+_find_matching_literal_prefix_of_key(const gchar *radix_key, gint radix_keylen, gchar *key, gint keylen,
+                                     gint *literal_prefix_inputlen,
+                                     gint *literal_prefix_radixlen)
 {
-  gint current_node_key_length = root->keylen;
   gint input_length;
   gint radix_length;
 
-  if (current_node_key_length < 1)
+  if (radix_keylen < 1)
     radix_length = input_length = 0;
   else
     {
@@ -1281,14 +1280,14 @@ _find_matching_literal_prefix(RNode *root, gchar *key, gint keylen,
        * speed things up, but db-parser() seems fast enough as it is.
        */
       input_length = radix_length = 0;
-      while (input_length < keylen && radix_length < current_node_key_length)
+      while (input_length < keylen && radix_length < radix_keylen)
         {
-          if (key[input_length] == '\r' && root->key[radix_length] == '\n')
+          if (key[input_length] == '\r' && radix_key[radix_length] == '\n')
             {
               /* skip CR from input if the radix contains a newline */
               input_length++;
             }
-          if (key[input_length] != root->key[radix_length])
+          if (key[input_length] != radix_key[radix_length])
             break;
 
           input_length++;
@@ -1299,6 +1298,15 @@ _find_matching_literal_prefix(RNode *root, gchar *key, gint keylen,
   *literal_prefix_radixlen = radix_length;
 }
 
+static void
+_find_matching_literal_prefix(RNode *root, gchar *key, gint keylen,
+                              gint *literal_prefix_inputlen,
+                              gint *literal_prefix_radixlen)
+{
+  _find_matching_literal_prefix_of_key(root->key, root->keylen, key, keylen,
+                                       literal_prefix_inputlen, literal_prefix_radixlen);
+}
+
 static RNode *
 _find_child_by_remaining_key(RFindNodeState *state, RNode *root, gchar *remaining_key, gint remaining_keylen)
 {
@@ -1596,6 +1604,272 @@ r_find_all_applicable_nodes(RNode *root, gchar *key, gint keylen, RNodeGetValueF
   return (gchar **) g_ptr_array_free(result, FALSE);
 }
 
+/**************************************************************
+ * Compact, read-only radix tree
+ **************************************************************/
+
+/* keys up to this size are stored inline, which keeps an RCompactNode
+ * within a single 64 byte cache line on 64 bit platforms */
+#define R_COMPACT_INLINE_KEY_SIZE 16
+
+typedef struct _RCompactNode
+{
+  const gchar *key;
+  gint keylen;
+  /* index of the first literal and parser child in RCompactTree->nodes */
+  guint32 children;
+  guint32 pchildren;
+  guint32 num_children;
+  guint32 num_pchildren;
+  RParserNode *parser;
+  /* the node in the original tree, returned by lookups */
+  RNode *node;
+  gchar inline_key[R_COMPACT_INLINE_KEY_SIZE];
+} RCompactNode;
+
+struct _RCompactTree
+{
+  RCompactNode *nodes;
+  /* the first character of the key of each node, indexed the same way as
+   * nodes, the literal children of a node are adjacent */
+  gchar *first_chars;
+  gchar *key_pool;
+  guint num_nodes;
+};
+
+static RNode *_compact_find_node_recursively(RFindNodeState *state, RCompactTree *tree, RCompactNode *root,
+                                             gchar *key, gint keylen);
+
+static RNode *
+_compact_find_child_by_remaining_key(RFindNodeState *state, RCompactTree *tree, RCompactNode *root,
+                                     gchar *remaining_key, gint remaining_keylen)
+{
+  const gchar *first_chars;
+  const gchar *candidate;
+
+  if (remaining_keylen >= 2 && remaining_key[0] == '\r' && remaining_key[1] == '\n')
+    {
+      remaining_key++;
+      remaining_keylen--;
+    }
+
+  /* the first characters of the children are unique, memchr() is
+   * vectorized by the libc, which is faster than a binary search for the
+   * typical number of children */
+  first_chars = &tree->first_chars[root->children];
+  candidate = memchr(first_chars, remaining_key[0], root->num_children);
+  if (candidate)
+    return _compact_find_node_recursively(state, tree, &tree->nodes[root->children + (candidate - first_chars)],
+                                          remaining_key, remaining_keylen);
+  return NULL;
+}
+
+static RNode *
+_compact_try_parse_with_a_given_child(RFindNodeState *state, RCompactTree *tree, RCompactNode *child_node,
+                                      gint matches_slot_index, gchar *remaining_key, gint remaining_keylen)
+{
+  RParserNode *parser_node = child_node->parser;
+  RParserMatch *match_slot = NULL;
+  gint extracted_match_len;
+  RNode *ret = NULL;
+
+  match_slot = _clear_match_slot(state, matches_slot_index);
+
+  if (_pnode_try_parse(parser_node, remaining_key, &extracted_match_len, match_slot))
+    {
+      ret = _compact_find_node_recursively(state, tree, child_node, remaining_key + extracted_match_len,
+                                           remaining_keylen - extracted_match_len);
+
+      /* we have to look up "match_slot" again as the GArray may have
+       * moved the data in case the lookup expanded it above */
+      match_slot = _get_match_slot(state, matches_slot_index);
+      if (match_slot)
+        {
+          if (ret)
+            _fixup_match_offsets(state, parser_node, extracted_match_len, remaining_key, match_slot);
+          else
+            _clear_match_content(match_slot);
+        }
+    }
+  return ret;
+}
+
+static RNode *
+_compact_find_child_by_parser(RFindNodeState *state, RCompactTree *tree, RCompactNode *root,
+                              gchar *remaining_key, gint remaining_keylen)
+{
+  gint matches_slot_index;
+  RNode *ret = NULL;
+
+  matches_slot_index = _alloc_slot_in_matches(state);
+  for (guint i = 0; !ret && i < root->num_pchildren; i++)
+    ret = _compact_try_parse_with_a_given_child(state, tree, &tree->nodes[root->pchildren + i], matches_slot_index,
+                                                remaining_key, remaining_keylen);
+
+  if (!ret && state->stored_matches)
+    {
+      /* the values in the stored_matches array has already been freed if we come here */
+      _reset_matches_to_original_state(state, matches_slot_index);
+    }
+  return ret;
+}
+
+/* same as _find_node_recursively(), without debug info and the collection
+ * of applicable nodes, which are served by the original tree */
+static RNode *
+_compact_find_node_recursively(RFindNodeState *state, RCompactTree *tree, RCompactNode *root, gchar *key, gint keylen)
+{
+  gint literal_prefix_inputlen, literal_prefix_radixlen;
+
+  _find_matching_literal_prefix_of_key(root->key, root->keylen, key, keylen,
+                                       &literal_prefix_inputlen,
+                                       &literal_prefix_radixlen);
+
+  if (literal_prefix_inputlen == keylen && (literal_prefix_radixlen == root->keylen || root->keylen == -1))
+    {
+      /* key completely consumed by the literal */
+      if (root->node->value)
+        return root->node;
+    }
+  else if ((root->keylen < 1) || (literal_prefix_inputlen < keylen && literal_prefix_radixlen >= root->keylen))
+    {
+      /* we matched the key partially, go on with child nodes */
+      RNode *ret;
+      gchar *remaining_key = key + literal_prefix_inputlen;
+      gint remaining_keylen = keylen - literal_prefix_inputlen;
+
+      /* prefer a literal match over parsers */
+      ret = _compact_find_child_by_remaining_key(state, tree, root, remaining_key, remaining_keylen);
+
+      /* then try parsers in order */
+      if (!ret)
+        ret = _compact_find_child_by_parser(state, tree, root, remaining_key, remaining_keylen);
+
+      if (!ret && root->node->value)
+        {
+          if (!state->require_complete_match)
+            return root->node;
+          state->partial_match_found = TRUE;
+        }
+
+      return ret;
+    }
+
+  return NULL;
+}
+
+RNode *
+r_compact_find_node(RCompactTree *self, gchar *key, gint keylen, GArray *stored_matches)
+{
+  RFindNodeState state =
+  {
+    .require_complete_match = TRUE,
+    .whole_key = key,
+    .stored_matches = stored_matches,
+  };
+  RNode *ret;
+
+  ret = _compact_find_node_recursively(&state, self, &self->nodes[0], key, keylen);
+  if (!ret && state.partial_match_found)
+    {
+      state.require_complete_match = FALSE;
+      ret = _compact_find_node_recursively(&state, self, &self->nodes[0], key, keylen);
+    }
+  return ret;
+}
+
+static guint
+_count_nodes(RNode *node, gsize *key_pool_size)
+{
+  guint count = 1;
+
+  if (node->keylen > R_COMPACT_INLINE_KEY_SIZE)
+    *key_pool_size += node->keylen;
+
+  for (gint i = 0; i < node->num_children; i++)
+    count += _count_nodes(node->children[i], key_pool_size);
+  for (gint i = 0; i < node->num_pchildren; i++)
+    count += _count_nodes(node->pchildren[i], key_pool_size);
+  return count;
+}
+
+static void
+_compact_node_init(RCompactNode *cnode, RNode *node, gchar **key_pool_pos)
+{
+  cnode->node = node;
+  cnode->parser = node->parser;
+  cnode->keylen = node->keylen;
+
+  if (node->keylen > R_COMPACT_INLINE_KEY_SIZE)
+    {
+      memcpy(*key_pool_pos, node->key, node->keylen);
+      cnode->key = *key_pool_pos;
+      *key_pool_pos += node->keylen;
+    }
+  else
+    {
+      if (node->keylen > 0)
+        memcpy(cnode->inline_key, node->key, node->keylen);
+      cnode->key = cnode->inline_key;
+    }
+}
+
+RCompactTree *
+r_compact_tree_new(RNode *root)
+{
+  RCompactTree *self = g_new0(RCompactTree, 1);
+  gsize key_pool_size = 0;
+  gchar *key_pool_pos;
+  RNode **order;
+  guint next = 1;
+
+  self->num_nodes = _count_nodes(root, &key_pool_size);
+  self->nodes = g_new0(RCompactNode, self->num_nodes);
+  self->first_chars = g_new0(gchar, self->num_nodes);
+  self->key_pool = g_malloc(key_pool_size);
+  key_pool_pos = self->key_pool;
+
+  /* breadth-first traversal, the children of each node are appended to
+   * the end of the array as their parent is visited, which makes them
+   * adjacent */
+  order = g_new(RNode *, self->num_nodes);
+  order[0] = root;
+  for (guint i = 0; i < next; i++)
+    {
+      RNode *node = order[i];
+      RCompactNode *cnode = &self->nodes[i];
+
+      _compact_node_init(cnode, node, &key_pool_pos);
+      self->first_chars[i] = node->keylen > 0 ? node->key[0] : 0;
+
+      cnode->children = next;
+      cnode->num_children = node->num_children;
+      for (gint j = 0; j < node->num_children; j++)
+        order[next++] = node->children[j];
+
+      cnode->pchildren = next;
+      cnode->num_pchildren = node->num_pchildren;
+      for (gint j = 0; j < node->num_pchildren; j++)
+        order[next++] = node->pchildren[j];
+    }
+  g_assert(next == self->num_nodes);
+  g_free(order);
+
+  return self;
+}
+
+void
+r_compact_tree_free(RCompactTree *self)
+{
+  if (!self)
+    return;
+
+  g_free(self->nodes);
+  g_free(self->first_chars);
+  g_free(self->key_pool);
+  g_free(self);
+}
+
 /**
  * r_new_node:
  */
@@ -102,6 +102,15 @@ struct _RNode
   RNode **pchildren;
 };
 
+/* Compiled, read-only representation of a finished radix tree, optimized
+ * for lookups.  The nodes are stored in a single array in breadth-first
+ * order, so that the children of a node are adjacent, the first
+ * characters of the literal children are stored in a separate byte array
+ * to make child selection a single memchr(), short keys are stored
+ * inline in the node.  Lookups return the nodes of the original tree,
+ * which has to outlive the compiled one. */
+typedef struct _RCompactTree RCompactTree;
+
 typedef struct _RDebugInfo
 {
   RNode *node;
@@ -161,4 +170,8 @@ RNode *r_find_node(RNode *root, gchar *key, gint keylen, GArray *matches);
 RNode *r_find_node_dbg(RNode *root, gchar *key, gint keylen, GArray *matches, GArray *dbg_list);
 gchar **r_find_all_applicable_nodes(RNode *root, gchar *key, gint keylen, RNodeGetValueFunc value_func);
 
+RCompactTree *r_compact_tree_new(RNode *root);
+void r_compact_tree_free(RCompactTree *self);
+RNode *r_compact_find_node(RCompactTree *self, gchar *key, gint keylen, GArray *matches);
+
 #endif
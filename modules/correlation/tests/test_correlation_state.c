@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "correlation.h"
+
+#include <string.h>
+
+#define NUM_CONTEXTS 1000
+
+static gint num_expired;
+
+static void
+_expire_callback(TimerWheel *wheel, guint64 now, gpointer user_data, gpointer caller_context)
+{
+  CorrelationContext *context = user_data;
+  CorrelationState *state = (CorrelationState *) timer_wheel_get_associated_data(wheel);
+
+  context->timer = NULL;
+  correlation_state_tx_remove_context(state, context);
+  num_expired++;
+}
+
+static void
+_init_key(CorrelationKey *key, gint i)
+{
+  memset(key, 0, sizeof(*key));
+  key->scope = RCS_GLOBAL;
+  key->session_id = g_strdup_printf("session%d", i);
+}
+
+static CorrelationState *
+_create_state_with_contexts(gint timeout)
+{
+  CorrelationState *state = correlation_state_new(_expire_callback);
+
+  correlation_state_set_associated_data(state, state, NULL);
+  for (gint i = 0; i < NUM_CONTEXTS; i++)
+    {
+      CorrelationKey key;
+
+      _init_key(&key, i);
+      CorrelationContext *context = correlation_context_new(&key);
+
+      correlation_state_tx_begin(state, &context->key);
+      correlation_state_tx_store_context(state, context, timeout);
+      correlation_state_tx_end(state, &context->key);
+    }
+  return state;
+}
+
+static CorrelationContext *
+_lookup(CorrelationState *state, gint i)
+{
+  CorrelationKey key;
+  CorrelationContext *context;
+
+  _init_key(&key, i);
+  correlation_state_tx_begin(state, &key);
+  context = correlation_state_tx_lookup_context(state, &key);
+  correlation_state_tx_end(state, &key);
+  g_free(key.session_id);
+  return context;
+}
+
+Test(correlation_state, test_contexts_are_distributed_among_shards)
+{
+  CorrelationState *state = _create_state_with_contexts(10);
+  gint used_shards = 0;
+
+  for (gint i = 0; i < NUM_CONTEXTS; i++)
+    cr_assert_not_null(_lookup(state, i), "context not found, i=%d", i);
+
+  for (gint i = 0; i < CORRELATION_STATE_NUM_SHARDS; i++)
+    {
+      if (g_hash_table_size(state->shards[i].state) > 0)
+        used_shards++;
+    }
+  cr_assert_gt(used_shards, 1, "contexts should be spread over multiple shards");
+
+  correlation_state_unref(state);
+}
+
+Test(correlation_state, test_advancing_time_expires_contexts_in_all_shards)
+{
+  CorrelationState *state = _create_state_with_contexts(10);
+
+  num_expired = 0;
+  correlation_state_advance_time(state, 5, NULL);
+  cr_assert_eq(num_expired, 0);
+  cr_assert_eq(correlation_state_get_time(state), 5);
+
+  correlation_state_advance_time(state, 6, NULL);
+  cr_assert_eq(num_expired, NUM_CONTEXTS);
+  cr_assert_eq(correlation_state_get_time(state), 11);
+
+  for (gint i = 0; i < NUM_CONTEXTS; i++)
+    cr_assert_null(_lookup(state, i), "context should have been expired, i=%d", i);
+
+  correlation_state_unref(state);
+}
+
+Test(correlation_state, test_time_does_not_go_backwards)
+{
+  CorrelationState *state = _create_state_with_contexts(10);
+
+  num_expired = 0;
+  correlation_state_set_time(state, 100, NULL);
+  cr_assert_eq(correlation_state_get_time(state), 100);
+  cr_assert_eq(num_expired, NUM_CONTEXTS);
+
+  correlation_state_set_time(state, 50, NULL);
+  cr_assert_eq(correlation_state_get_time(state), 100);
+
+  correlation_state_unref(state);
+}
+
+Test(correlation_state, test_expire_all_keeps_current_time)
+{
+  CorrelationState *state = _create_state_with_contexts(10);
+
+  num_expired = 0;
+  correlation_state_expire_all(state, NULL);
+  cr_assert_eq(num_expired, NUM_CONTEXTS);
+  cr_assert_eq(correlation_state_get_time(state), 0);
+
+  correlation_state_unref(state);
+}
@@ -541,6 +541,24 @@ Test(pattern_db, test_patterndb_loads_a_syntactically_complete_xml_properly)
   g_free(filename);
 }
 
+Test(pattern_db, test_patterndb_reload_keeps_ruleset_if_content_is_unchanged)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+  PDBRuleSet *ruleset = pattern_db_get_ruleset(patterndb);
+
+  cr_assert(pattern_db_reload_ruleset(patterndb, configuration, filename));
+  cr_assert_eq(pattern_db_get_ruleset(patterndb), ruleset, "unchanged ruleset should not be reloaded");
+
+  g_file_set_contents(filename, pdb_complete_syntax, strlen(pdb_complete_syntax), NULL);
+  cr_assert(pattern_db_reload_ruleset(patterndb, configuration, filename));
+  cr_assert_neq(pattern_db_get_ruleset(patterndb), ruleset, "changed ruleset should be reloaded");
+  assert_msg_matches_and_has_tag(patterndb, "simple-message", ".classifier.system", TRUE);
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
 Test(pattern_db, pdbtest_patterndb_message_property_inheritance_enabled)
 {
   gchar *filename;
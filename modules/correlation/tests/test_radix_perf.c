@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/stopwatch.h"
+
+#include "apphook.h"
+#include "radix.h"
+#include "test_radix_corpus.h"
+
+#include <string.h>
+
+#define NUM_ITERATIONS 1000
+#define NUM_SYNTHETIC_RULES 20000
+
+static void
+_insert_pattern(RNode *root, const gchar *pattern)
+{
+  /* NOTE: r_insert_node() modifies its input */
+  gchar *dup = g_strdup(pattern);
+
+  r_insert_node(root, dup, (gpointer) pattern, NULL, NULL, NULL);
+  g_free(dup);
+}
+
+static RNode *
+_build_tree_from_corpus(GPtrArray *keys)
+{
+  RNode *root = r_new_node("", NULL);
+  GHashTable *inserted = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for (gint i = 0; i < G_N_ELEMENTS(radix_test_corpus); i++)
+    {
+      RadixTestParam *param = &radix_test_corpus[i];
+
+      for (gint j = 0; param->node_to_insert[j]; j++)
+        {
+          if (g_hash_table_contains(inserted, param->node_to_insert[j]))
+            continue;
+
+          _insert_pattern(root, param->node_to_insert[j]);
+          g_hash_table_add(inserted, (gpointer) param->node_to_insert[j]);
+        }
+      g_ptr_array_add(keys, g_strdup(param->key));
+    }
+  g_hash_table_unref(inserted);
+  return root;
+}
+
+/* resembles a large pattern database: lots of rules sharing a few common
+ * prefixes, mixing literals and parsers */
+static RNode *
+_build_synthetic_tree(GPtrArray *keys, GPtrArray *patterns)
+{
+  RNode *root = r_new_node("", NULL);
+
+  for (gint i = 0; i < NUM_SYNTHETIC_RULES; i++)
+    {
+      gchar *pattern = g_strdup_printf("service%d: connection %d from @IPv4:ip@ port @NUMBER:port@ user=@ESTRING:user: @done",
+                                       i % 100, i);
+
+      g_ptr_array_add(patterns, pattern);
+      _insert_pattern(root, pattern);
+
+      if (i % 10 == 0)
+        g_ptr_array_add(keys, g_strdup_printf("service%d: connection %d from 10.0.0.%d port %d user=bob done",
+                                              i % 100, i, i % 256, i));
+    }
+  return root;
+}
+
+static void
+_clear_matches(GArray *matches)
+{
+  for (gsize i = 0; i < matches->len; i++)
+    g_free(g_array_index(matches, RParserMatch, i).match);
+  g_array_set_size(matches, 1);
+}
+
+static void
+_assert_lookups_are_identical(RNode *root, RCompactTree *compact, GPtrArray *keys)
+{
+  for (gint i = 0; i < keys->len; i++)
+    {
+      gchar *key = g_ptr_array_index(keys, i);
+
+      cr_assert_eq(r_find_node(root, key, strlen(key), NULL), r_compact_find_node(compact, key, strlen(key), NULL),
+                   "lookup results differ, key=%s", key);
+    }
+}
+
+static void
+_perftest_lookups(RNode *root, GPtrArray *keys, const gchar *corpus)
+{
+  RCompactTree *compact = r_compact_tree_new(root);
+  GArray *matches = g_array_new(FALSE, TRUE, sizeof(RParserMatch));
+
+  _assert_lookups_are_identical(root, compact, keys);
+
+  g_array_set_size(matches, 1);
+  start_stopwatch();
+  for (gint i = 0; i < NUM_ITERATIONS; i++)
+    {
+      for (gint k = 0; k < keys->len; k++)
+        {
+          gchar *key = g_ptr_array_index(keys, k);
+
+          r_find_node(root, key, strlen(key), matches);
+          _clear_matches(matches);
+        }
+    }
+  stop_stopwatch_and_display_result(NUM_ITERATIONS * keys->len, "radix lookups, %s, pointer tree", corpus);
+
+  start_stopwatch();
+  for (gint i = 0; i < NUM_ITERATIONS; i++)
+    {
+      for (gint k = 0; k < keys->len; k++)
+        {
+          gchar *key = g_ptr_array_index(keys, k);
+
+          r_compact_find_node(compact, key, strlen(key), matches);
+          _clear_matches(matches);
+        }
+    }
+  stop_stopwatch_and_display_result(NUM_ITERATIONS * keys->len, "radix lookups, %s, compact tree", corpus);
+
+  g_array_free(matches, TRUE);
+  r_compact_tree_free(compact);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  app_shutdown();
+}
+
+TestSuite(radix_perf, .init = setup, .fini = teardown);
+
+Test(radix_perf, test_lookup_speed_with_test_corpus)
+{
+  GPtrArray *keys = g_ptr_array_new_with_free_func(g_free);
+  RNode *root = _build_tree_from_corpus(keys);
+
+  _perftest_lookups(root, keys, "test_radix corpus");
+
+  r_free_node(root, NULL);
+  g_ptr_array_free(keys, TRUE);
+}
+
+Test(radix_perf, test_lookup_speed_with_large_tree)
+{
+  GPtrArray *keys = g_ptr_array_new_with_free_func(g_free);
+  GPtrArray *patterns = g_ptr_array_new_with_free_func(g_free);
+  RNode *root = _build_synthetic_tree(keys, patterns);
+
+  _perftest_lookups(root, keys, "20k rules");
+
+  r_free_node(root, NULL);
+  g_ptr_array_free(keys, TRUE);
+  g_ptr_array_free(patterns, TRUE);
+}
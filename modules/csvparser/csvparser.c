@@ -196,8 +196,8 @@ _process_column_on_invalid_type_cast(CSVParser *self, LogMessageValueType *curre
 }
 
 static gboolean
-_process_column(CSVParser *self, CSVScanner *scanner, LogMessage *msg, CSVParserColumn *current_column,
-                GString *key_scratch)
+_process_column(CSVParser *self, CSVScanner *scanner, LogMessage *msg, LogMessageValueSource *source,
+                CSVParserColumn *current_column, GString *key_scratch)
 {
 
   LogMessageValueType current_column_type = current_column->type;
@@ -228,18 +228,22 @@ _process_column(CSVParser *self, CSVScanner *scanner, LogMessage *msg, CSVParser
 
   if (should_set_value)
     {
-      log_msg_set_value_by_name_with_type(msg,
-                                          _key_formatter(key_scratch, current_column->name, self->prefix_len),
-                                          csv_scanner_get_current_value(scanner),
-                                          csv_scanner_get_current_value_len(scanner),
-                                          current_column_type);
+      const gchar *value = csv_scanner_get_current_value_slice(scanner);
+
+      if (!value)
+        value = current_value;
+
+      NVHandle handle = log_msg_get_value_handle(_key_formatter(key_scratch, current_column->name, self->prefix_len));
+      log_msg_set_value_from_source_with_type(msg, handle, source, value,
+                                              csv_scanner_get_current_value_len(scanner),
+                                              current_column_type);
     }
   return TRUE;
 
 }
 
 static gboolean
-_iterate_columns(CSVParser *self, CSVScanner *scanner, LogMessage *msg)
+_iterate_columns(CSVParser *self, CSVScanner *scanner, LogMessage *msg, LogMessageValueSource *source)
 {
   GString *key_scratch = scratch_buffers_alloc();
   GList *column_l = self->columns;
@@ -253,7 +257,7 @@ _iterate_columns(CSVParser *self, CSVScanner *scanner, LogMessage *msg)
       if (self->columns)
         {
           CSVParserColumn *current_column = column_l->data;
-          if (!_process_column(self, scanner, msg, current_column, key_scratch))
+          if (!_process_column(self, scanner, msg, source, current_column, key_scratch))
             {
               return FALSE;
             }
@@ -287,9 +291,13 @@ csv_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_o
   CSVScanner scanner;
   csv_scanner_init(&scanner, &self->options, input);
 
+  /* columns that need no unescaping reference $MSG instead of being copied */
+  LogMessageValueSource source;
+  log_msg_value_source_init(&source, msg, LM_V_MESSAGE, input, input_len);
+
   gboolean result = TRUE;
 
-  if (!_iterate_columns(self, &scanner, msg))
+  if (!_iterate_columns(self, &scanner, msg, &source))
     result = FALSE;
   if (!csv_scanner_is_scan_complete(&scanner))
     result = FALSE;
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+
+/* keep in sync with EBPF_REUSEPORT_MAX_SOCKETS in ebpf-reuseport-group.h */
+#define MAX_SOCKETS 256
+
+int number_of_sockets;
+
+/* fill level (in percent) at which the reader of a socket is considered
+ * saturated by load_aware() */
+int load_threshold;
+
+/* slot -> socket, populated from userspace */
+struct
+{
+  __uint(type, BPF_MAP_TYPE_REUSEPORT_SOCKARRAY);
+  __uint(max_entries, MAX_SOCKETS);
+  __type(key, __u32);
+  __type(value, __u64);
+} sockets SEC(".maps");
+
+/* slot -> fill level of the reader of the socket in percent, updated
+ * periodically from userspace */
+struct
+{
+  __uint(type, BPF_MAP_TYPE_ARRAY);
+  __uint(max_entries, MAX_SOCKETS);
+  __type(key, __u32);
+  __type(value, __u32);
+} socket_load SEC(".maps");
+
+static __always_inline int
+_select_slot(struct sk_reuseport_md *reuse, __u32 slot)
+{
+  /* if the slot is empty, nothing is selected and the kernel falls back to
+   * its own hash based selection */
+  bpf_sk_select_reuseport(reuse, &sockets, &slot, 0);
+  return SK_PASS;
+}
+
+static __always_inline __u32
+_flow_slot(struct sk_reuseport_md *reuse)
+{
+  /* reuse->hash is computed from the source and destination address/port,
+   * so the packets of a flow are always steered to the same slot */
+  return reuse->hash % (__u32) number_of_sockets;
+}
+
+SEC("sk_reuseport")
+int flow_hash(struct sk_reuseport_md *reuse)
+{
+  if (number_of_sockets <= 0)
+    return SK_PASS;
+
+  return _select_slot(reuse, _flow_slot(reuse));
+}
+
+SEC("sk_reuseport")
+int load_aware(struct sk_reuseport_md *reuse)
+{
+  if (number_of_sockets <= 0)
+    return SK_PASS;
+
+  __u32 slot = _flow_slot(reuse);
+  __u32 *load = bpf_map_lookup_elem(&socket_load, &slot);
+
+  if (!load || *load < (__u32) load_threshold)
+    return _select_slot(reuse, slot);
+
+  /* the reader of the flow's socket can't keep up: steer the packet to the
+   * least loaded socket instead, ordering within the flow is lost only
+   * while the preferred reader is saturated */
+  __u32 least_loaded_slot = slot;
+  __u32 least_load = *load;
+
+  for (__u32 i = 0; i < MAX_SOCKETS; i++)
+    {
+      if (i >= (__u32) number_of_sockets)
+        break;
+
+      __u32 key = i;
+      load = bpf_map_lookup_elem(&socket_load, &key);
+      if (load && *load < least_load)
+        {
+          least_loaded_slot = i;
+          least_load = *load;
+        }
+    }
+
+  return _select_slot(reuse, least_loaded_slot);
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "ebpf-reuseport-group.h"
+#include "gsocket.h"
+#include "messages.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <bpf/bpf.h>
+
+#ifndef SO_COOKIE
+#define SO_COOKIE 57
+#endif
+
+struct _EBPFReusePortGroup
+{
+  GAtomicCounter ref_cnt;
+  gchar *name;
+  struct balance_kern *balance;
+};
+
+#include "balance.skel.c"
+
+/*
+ * name -> EBPFReusePortGroup, only accessed from the main thread.
+ *
+ * The registry holds a reference to each group for as long as it has
+ * sockets, so that sockets kept open across a reload (which are not set up
+ * again) find the group of their programs.
+ */
+static GHashTable *reuseport_groups;
+
+static gchar *
+_format_group_name(gint sock)
+{
+  gint sock_type;
+  socklen_t len = sizeof(sock_type);
+
+  if (getsockopt(sock, SOL_SOCKET, SO_TYPE, &sock_type, &len) < 0)
+    return NULL;
+
+  GSockAddr *local_addr = g_socket_get_local_name(sock);
+  if (!local_addr)
+    return NULL;
+
+  gchar buf[MAX_SOCKADDR_STRING];
+  g_sockaddr_format(local_addr, buf, sizeof(buf), GSA_FULL);
+  g_sockaddr_unref(local_addr);
+
+  return g_strdup_printf("%s,%s", sock_type == SOCK_STREAM ? "stream" : "dgram", buf);
+}
+
+static gboolean
+_group_has_sockets(EBPFReusePortGroup *self)
+{
+  gint map_fd = bpf_map__fd(self->balance->maps.sockets);
+
+  for (guint32 slot = 0; slot < EBPF_REUSEPORT_MAX_SOCKETS; slot++)
+    {
+      guint64 cookie;
+
+      if (bpf_map_lookup_elem(map_fd, &slot, &cookie) == 0)
+        return TRUE;
+    }
+  return FALSE;
+}
+
+/* sockets are removed from the groups by the kernel when they are closed */
+static void
+_collect_unused_groups(void)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init(&iter, reuseport_groups);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+      EBPFReusePortGroup *group = (EBPFReusePortGroup *) value;
+
+      if (g_atomic_counter_get(&group->ref_cnt) == 1 && !_group_has_sockets(group))
+        {
+          g_hash_table_iter_remove(&iter);
+          ebpf_reuseport_group_unref(group);
+        }
+    }
+}
+
+static EBPFReusePortGroup *
+_group_new(gchar *name)
+{
+  struct balance_kern *balance = balance_kern__open_and_load();
+
+  if (!balance)
+    {
+      msg_error("ebpf-reuseport(): Unable to load eBPF program to the kernel",
+                evt_tag_str("group", name));
+      return NULL;
+    }
+
+  EBPFReusePortGroup *self = g_new0(EBPFReusePortGroup, 1);
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->name = name;
+  self->balance = balance;
+  return self;
+}
+
+static EBPFReusePortGroup *
+_lookup_group(gint sock, gchar **name)
+{
+  *name = _format_group_name(sock);
+
+  if (!*name)
+    {
+      msg_error("ebpf-reuseport(): Unable to query the local address of the socket",
+                evt_tag_int("sock", sock),
+                evt_tag_error("error"));
+      return NULL;
+    }
+
+  if (!reuseport_groups)
+    return NULL;
+
+  return g_hash_table_lookup(reuseport_groups, *name);
+}
+
+/* returns a new reference to the group of the bound socket, or NULL if
+ * there is no such group yet */
+EBPFReusePortGroup *
+ebpf_reuseport_group_lookup(gint sock)
+{
+  gchar *name;
+  EBPFReusePortGroup *self = _lookup_group(sock, &name);
+
+  g_free(name);
+  return self ? ebpf_reuseport_group_ref(self) : NULL;
+}
+
+/* returns a new reference to the group of the bound socket, creating the
+ * group if needed */
+EBPFReusePortGroup *
+ebpf_reuseport_group_get(gint sock)
+{
+  gchar *name;
+  EBPFReusePortGroup *self = _lookup_group(sock, &name);
+
+  if (self)
+    {
+      g_free(name);
+      return ebpf_reuseport_group_ref(self);
+    }
+
+  if (!name)
+    return NULL;
+
+  if (!reuseport_groups)
+    reuseport_groups = g_hash_table_new(g_str_hash, g_str_equal);
+  _collect_unused_groups();
+
+  self = _group_new(name);
+  if (!self)
+    {
+      g_free(name);
+      return NULL;
+    }
+
+  g_hash_table_insert(reuseport_groups, self->name, self);
+  return ebpf_reuseport_group_ref(self);
+}
+
+void
+ebpf_reuseport_group_set_options(EBPFReusePortGroup *self, gint number_of_sockets, gint load_threshold)
+{
+  self->balance->bss->number_of_sockets = number_of_sockets;
+  self->balance->bss->load_threshold = load_threshold;
+}
+
+gint
+ebpf_reuseport_group_get_flow_hash_program(EBPFReusePortGroup *self)
+{
+  return bpf_program__fd(self->balance->progs.flow_hash);
+}
+
+gint
+ebpf_reuseport_group_get_load_aware_program(EBPFReusePortGroup *self)
+{
+  return bpf_program__fd(self->balance->progs.load_aware);
+}
+
+static gint
+_lookup_socket_slot(gint map_fd, gint sock)
+{
+  guint64 cookie;
+  socklen_t len = sizeof(cookie);
+
+  if (getsockopt(sock, SOL_SOCKET, SO_COOKIE, &cookie, &len) < 0)
+    return -1;
+
+  for (guint32 slot = 0; slot < EBPF_REUSEPORT_MAX_SOCKETS; slot++)
+    {
+      guint64 slot_cookie;
+
+      if (bpf_map_lookup_elem(map_fd, &slot, &slot_cookie) == 0 && slot_cookie == cookie)
+        return slot;
+    }
+  return -1;
+}
+
+/*
+ * Returns the slot of the socket in the group, adding it to the first free
+ * slot if it is not there yet.  Sockets are removed from their slot by the
+ * kernel when they are closed, while sockets kept open across reloads are
+ * found by their cookie.
+ *
+ * NOTE: stream sockets can only be added once they are listening.
+ */
+gint
+ebpf_reuseport_group_register_socket(EBPFReusePortGroup *self, gint sock)
+{
+  gint map_fd = bpf_map__fd(self->balance->maps.sockets);
+  gint slot = _lookup_socket_slot(map_fd, sock);
+
+  if (slot >= 0)
+    return slot;
+
+  guint64 value = sock;
+  for (guint32 free_slot = 0; free_slot < EBPF_REUSEPORT_MAX_SOCKETS; free_slot++)
+    {
+      if (bpf_map_update_elem(map_fd, &free_slot, &value, BPF_NOEXIST) == 0)
+        {
+          ebpf_reuseport_group_set_load(self, free_slot, 0);
+          msg_debug("ebpf-reuseport(): socket added to reuseport group",
+                    evt_tag_str("group", self->name),
+                    evt_tag_int("sock", sock),
+                    evt_tag_int("slot", free_slot));
+          return free_slot;
+        }
+      if (errno != EEXIST)
+        {
+          msg_debug("ebpf-reuseport(): unable to add socket to reuseport group",
+                    evt_tag_str("group", self->name),
+                    evt_tag_int("sock", sock),
+                    evt_tag_error("error"));
+          return -1;
+        }
+    }
+
+  msg_error("ebpf-reuseport(): too many sockets in reuseport group",
+            evt_tag_str("group", self->name),
+            evt_tag_int("max_sockets", EBPF_REUSEPORT_MAX_SOCKETS));
+  return -1;
+}
+
+void
+ebpf_reuseport_group_set_load(EBPFReusePortGroup *self, gint slot, gint fill_level)
+{
+  guint32 key = slot;
+  guint32 value = fill_level;
+
+  bpf_map_update_elem(bpf_map__fd(self->balance->maps.socket_load), &key, &value, BPF_ANY);
+}
+
+EBPFReusePortGroup *
+ebpf_reuseport_group_ref(EBPFReusePortGroup *self)
+{
+  g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+/* the programs stay attached to the sockets, together with their maps,
+ * even if the group is freed */
+void
+ebpf_reuseport_group_unref(EBPFReusePortGroup *self)
+{
+  if (!self || !g_atomic_counter_dec_and_test(&self->ref_cnt))
+    return;
+
+  balance_kern__destroy(self->balance);
+  g_free(self->name);
+  g_free(self);
+}
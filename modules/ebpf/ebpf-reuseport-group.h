@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef EBPF_REUSEPORT_GROUP_H_INCLUDED
+#define EBPF_REUSEPORT_GROUP_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/* keep in sync with MAX_SOCKETS in balance.kern.c */
+#define EBPF_REUSEPORT_MAX_SOCKETS 256
+
+/*
+ * The sockets listening on the same address (each of them opened by a
+ * separate source driver) form a reuseport group in the kernel.  The
+ * flow-hash and load-aware programs select sockets from a map of the
+ * group, which is shared by the ebpf() plugin instances of these drivers.
+ */
+typedef struct _EBPFReusePortGroup EBPFReusePortGroup;
+
+EBPFReusePortGroup *ebpf_reuseport_group_get(gint sock);
+EBPFReusePortGroup *ebpf_reuseport_group_lookup(gint sock);
+void ebpf_reuseport_group_set_options(EBPFReusePortGroup *self, gint number_of_sockets, gint load_threshold);
+gint ebpf_reuseport_group_get_flow_hash_program(EBPFReusePortGroup *self);
+gint ebpf_reuseport_group_get_load_aware_program(EBPFReusePortGroup *self);
+
+gint ebpf_reuseport_group_register_socket(EBPFReusePortGroup *self, gint sock);
+void ebpf_reuseport_group_set_load(EBPFReusePortGroup *self, gint slot, gint fill_level);
+
+EBPFReusePortGroup *ebpf_reuseport_group_ref(EBPFReusePortGroup *self);
+void ebpf_reuseport_group_unref(EBPFReusePortGroup *self);
+
+#endif
@@ -20,13 +20,36 @@
  *
  */
 #include "ebpf-reuseport.h"
+#include "ebpf-reuseport-group.h"
 #include "modules/afsocket/afsocket-signals.h"
+#include "timeutils/misc.h"
+
+#include <iv.h>
+#include <string.h>
+
+/* how often the fill level of the readers is propagated to the kernel */
+#define EBPF_REUSEPORT_LOAD_UPDATE_MSECS 100
+
+typedef enum
+{
+  EBPF_REUSEPORT_RANDOM,
+  EBPF_REUSEPORT_FLOW_HASH,
+  EBPF_REUSEPORT_LOAD_AWARE,
+} EBPFReusePortMode;
 
 typedef struct _EBPFReusePort
 {
   LogDriverPlugin super;
   struct random_kern *random;
   gint number_of_sockets;
+  EBPFReusePortMode mode;
+  gint load_threshold;
+
+  /* flow-hash and load-aware modes */
+  LogDriver *driver;
+  EBPFReusePortGroup *group;
+  gint slot;
+  struct iv_timer load_update_timer;
 } EBPFReusePort;
 
 #include "random.skel.c"
@@ -38,9 +61,112 @@ ebpf_reuseport_set_sockets(LogDriverPlugin *s, gint number_of_sockets)
   self->number_of_sockets = number_of_sockets;
 }
 
+gboolean
+ebpf_reuseport_set_mode(LogDriverPlugin *s, const gchar *mode)
+{
+  EBPFReusePort *self = (EBPFReusePort *) s;
+
+  if (strcmp(mode, "random") == 0)
+    self->mode = EBPF_REUSEPORT_RANDOM;
+  else if (strcmp(mode, "flow-hash") == 0 || strcmp(mode, "flow_hash") == 0)
+    self->mode = EBPF_REUSEPORT_FLOW_HASH;
+  else if (strcmp(mode, "load-aware") == 0 || strcmp(mode, "load_aware") == 0)
+    self->mode = EBPF_REUSEPORT_LOAD_AWARE;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+ebpf_reuseport_set_load_threshold(LogDriverPlugin *s, gint load_threshold)
+{
+  EBPFReusePort *self = (EBPFReusePort *) s;
+  self->load_threshold = load_threshold;
+}
+
+static void
+_set_group(EBPFReusePort *self, EBPFReusePortGroup *group)
+{
+  ebpf_reuseport_group_unref(self->group);
+  self->group = group;
+  self->slot = -1;
+}
+
+/*
+ * The socket is registered in its group lazily from this timer: stream
+ * sockets can only be added once they are listening, and sockets kept open
+ * across a reload are not set up again, so we have to look up their group
+ * here.
+ */
+static void
+_update_socket_load(gpointer s)
+{
+  EBPFReusePort *self = (EBPFReusePort *) s;
+  AFSocketQueueFillLevelSignalData data = { .sock = -1, .fill_level = 0 };
+
+  EMIT(self->driver->signal_slot_connector, signal_afsocket_queue_fill_level, &data);
+
+  if (!self->group && data.sock != -1)
+    {
+      _set_group(self, ebpf_reuseport_group_lookup(data.sock));
+      if (self->group)
+        ebpf_reuseport_group_set_options(self->group, self->number_of_sockets, self->load_threshold);
+    }
+
+  if (self->group && data.sock != -1)
+    {
+      if (self->slot < 0)
+        self->slot = ebpf_reuseport_group_register_socket(self->group, data.sock);
+
+      if (self->slot >= 0 && self->mode == EBPF_REUSEPORT_LOAD_AWARE)
+        ebpf_reuseport_group_set_load(self->group, self->slot, data.fill_level);
+    }
+
+  iv_validate_now();
+  self->load_update_timer.expires = iv_now;
+  timespec_add_msec(&self->load_update_timer.expires, EBPF_REUSEPORT_LOAD_UPDATE_MSECS);
+  iv_timer_register(&self->load_update_timer);
+}
+
+static void
+_setup_balancing_socket(EBPFReusePort *self, AFSocketSetupSocketSignalData *data)
+{
+  EBPFReusePortGroup *group = ebpf_reuseport_group_get(data->sock);
+  if (!group)
+    goto error;
+
+  _set_group(self, group);
+  ebpf_reuseport_group_set_options(group, self->number_of_sockets, self->load_threshold);
+
+  int bpf_fd = self->mode == EBPF_REUSEPORT_LOAD_AWARE
+               ? ebpf_reuseport_group_get_load_aware_program(group)
+               : ebpf_reuseport_group_get_flow_hash_program(group);
+
+  if (setsockopt(data->sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, &bpf_fd, sizeof(bpf_fd)) < 0)
+    {
+      msg_error("ebpf-reuseport(): setsockopt(SO_ATTACH_REUSEPORT_EBPF) returned error",
+                evt_tag_errno("error", errno));
+      goto error;
+    }
+
+  msg_debug("ebpf-reuseport(): eBPF reuseport group balancer applied",
+            evt_tag_int("sock", data->sock),
+            evt_tag_str("mode", self->mode == EBPF_REUSEPORT_LOAD_AWARE ? "load-aware" : "flow-hash"));
+  return;
+error:
+  data->failure = TRUE;
+}
+
 static void
 _slot_setup_socket(EBPFReusePort *self, AFSocketSetupSocketSignalData *data)
 {
+  if (self->mode != EBPF_REUSEPORT_RANDOM)
+    {
+      _setup_balancing_socket(self, data);
+      return;
+    }
+
   int bpf_fd = bpf_program__fd(self->random->progs.random_choice);
   if (bpf_fd < 0)
     {
@@ -68,13 +194,29 @@ _attach(LogDriverPlugin *s, LogDriver *driver)
 {
   EBPFReusePort *self = (EBPFReusePort *)s;
 
-  self->random = random_kern__open_and_load();
-  if (!self->random)
+  if (self->mode == EBPF_REUSEPORT_RANDOM)
+    {
+      self->random = random_kern__open_and_load();
+      if (!self->random)
+        {
+          msg_error("ebpf-reuseport(): Unable to load eBPF program to the kernel");
+          return FALSE;
+        }
+      self->random->bss->number_of_sockets = self->number_of_sockets;
+    }
+  else
     {
-      msg_error("ebpf-reuseport(): Unable to load eBPF program to the kernel");
-      return FALSE;
+      if (self->number_of_sockets > EBPF_REUSEPORT_MAX_SOCKETS)
+        {
+          msg_error("ebpf-reuseport(): the number of sockets is too large for the flow-hash and load-aware modes",
+                    evt_tag_int("sockets", self->number_of_sockets),
+                    evt_tag_int("max_sockets", EBPF_REUSEPORT_MAX_SOCKETS));
+          return FALSE;
+        }
+
+      self->driver = driver;
+      _update_socket_load(self);
     }
-  self->random->bss->number_of_sockets = self->number_of_sockets;
 
   SignalSlotConnector *ssc = driver->signal_slot_connector;
   CONNECT(ssc, signal_afsocket_setup_socket, _slot_setup_socket, self);
@@ -89,6 +231,11 @@ _detach(LogDriverPlugin *s, LogDriver *driver)
 
   SignalSlotConnector *ssc = driver->signal_slot_connector;
   DISCONNECT(ssc, signal_afsocket_setup_socket, _slot_setup_socket, self);
+
+  if (iv_timer_registered(&self->load_update_timer))
+    iv_timer_unregister(&self->load_update_timer);
+
+  _set_group(self, NULL);
 }
 
 static void
@@ -98,6 +245,7 @@ _free(LogDriverPlugin *s)
 
   if (self->random)
     random_kern__destroy(self->random);
+  ebpf_reuseport_group_unref(self->group);
   log_driver_plugin_free_method(s);
 }
 
@@ -111,6 +259,13 @@ ebpf_reuseport_new(void)
   self->super.detach = _detach;
   self->super.free_fn = _free;
   self->number_of_sockets = 0;
+  self->mode = EBPF_REUSEPORT_RANDOM;
+  self->load_threshold = 80;
+  self->slot = -1;
+
+  IV_TIMER_INIT(&self->load_update_timer);
+  self->load_update_timer.cookie = self;
+  self->load_update_timer.handler = _update_socket_load;
 
   return &self->super;
 }
@@ -26,6 +26,8 @@
 #include "driver.h"
 
 void ebpf_reuseport_set_sockets(LogDriverPlugin *s, gint number_of_sockets);
+gboolean ebpf_reuseport_set_mode(LogDriverPlugin *s, const gchar *mode);
+void ebpf_reuseport_set_load_threshold(LogDriverPlugin *s, gint load_threshold);
 LogDriverPlugin *ebpf_reuseport_new(void);
 
 #endif
@@ -32,153 +32,40 @@
 #include "filterx/filterx-object-istype.h"
 #include "filterx/filterx-ref.h"
 #include "scratch-buffers.h"
-#include "utf8utils.h"
+#include "json-writer.h"
 
-static gboolean _format_and_append_value(FilterXObject *value, GString *result);
-
-static void
-_append_comma_if_needed(GString *result)
-{
-  if (result->len &&
-      result->str[result->len - 1] != '[' &&
-      result->str[result->len - 1] != '{' &&
-      result->str[result->len - 1] != ':')
-    {
-      g_string_append_c(result, ',');
-    }
-}
-
-static gboolean
-_append_literal(const gchar *value, gsize len, GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append_len(result, value, len);
-  return TRUE;
-}
-
-static gboolean
-_format_and_append_null(GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append(result, "null");
-  return TRUE;
-}
-
-static gboolean
-_format_and_append_boolean(gboolean value, GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append(result, value ? "true" : "false");
-  return TRUE;
-}
-
-static gboolean
-_format_and_append_integer(gint64 value, GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append_printf(result, "%" G_GINT64_FORMAT, value);
-  return TRUE;
-}
-
-static gboolean
-_format_and_append_double(gdouble value, GString *result)
-{
-  _append_comma_if_needed(result);
-
-  gsize init_len = result->len;
-  g_string_set_size(result, init_len + G_ASCII_DTOSTR_BUF_SIZE);
-  g_ascii_dtostr(result->str + init_len, G_ASCII_DTOSTR_BUF_SIZE, value);
-  g_string_set_size(result, strchr(result->str + init_len, '\0') - result->str);
-  return TRUE;
-}
-
-static inline gsize
-_get_base64_encoded_size(gsize len)
-{
-  return (len / 3 + 1) * 4 + 4;
-}
-
-static gboolean
-_format_and_append_bytes(const gchar *value, gssize value_len, GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '"');
-
-  gint encode_state = 0;
-  gint encode_save = 0;
-  gsize init_len = result->len;
-
-  /* expand the buffer and add space for the base64 encoded string */
-  g_string_set_size(result, init_len + _get_base64_encoded_size(value_len));
-  gsize out_len = g_base64_encode_step((const guchar *) value, value_len, FALSE, result->str + init_len,
-                                       &encode_state, &encode_save);
-  g_string_set_size(result, init_len + out_len + _get_base64_encoded_size(0));
-
-#if !GLIB_CHECK_VERSION(2, 54, 0)
-  /* See modules/basicfuncs/str-funcs.c: tf_base64encode() */
-  if (((unsigned char *) &encode_save)[0] == 1)
-    ((unsigned char *) &encode_save)[2] = 0;
-#endif
-
-  out_len += g_base64_encode_close(FALSE, result->str + init_len + out_len, &encode_state, &encode_save);
-  g_string_set_size(result, init_len + out_len);
-
-  g_string_append_c(result, '"');
-  return TRUE;
-}
-
-static gboolean
-_format_and_append_protobuf(const gchar *value, gssize value_len, GString *result)
-{
-  return _format_and_append_bytes(value, value_len, result);
-}
-
-static gboolean
-_format_and_append_string(const gchar *value, gssize value_len, GString *result)
-{
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '"');
-  append_unsafe_utf8_as_escaped(result, value, value_len, "\"", "\\u%04x", "\\\\x%02x");
-  g_string_append_c(result, '"');
-  return TRUE;
-}
+static gboolean _format_and_append_value(FilterXObject *value, JSONWriter *writer);
 
 static gboolean
 _format_and_append_dict_elem(FilterXObject *key, FilterXObject *value, gpointer user_data)
 {
-  GString *result = (GString *) user_data;
+  JSONWriter *writer = (JSONWriter *) user_data;
 
   const gchar *key_str;
   gsize key_str_len;
   if (!filterx_object_extract_string_ref(key, &key_str, &key_str_len))
     return FALSE;
 
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '"');
-  append_unsafe_utf8_as_escaped(result, key_str, key_str_len, "\"", "\\u%04x", "\\\\x%02x");
-  g_string_append(result, "\":");
-
-  return _format_and_append_value(value, result);
+  json_writer_append_key(writer, key_str, key_str_len);
+  return _format_and_append_value(value, writer);
 }
 
 static gboolean
-_format_and_append_dict(FilterXObject *value, GString *result)
+_format_and_append_dict(FilterXObject *value, JSONWriter *writer)
 {
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '{');
+  json_writer_begin_object(writer);
 
-  if (!filterx_dict_iter(value, _format_and_append_dict_elem, (gpointer) result))
+  if (!filterx_dict_iter(value, _format_and_append_dict_elem, (gpointer) writer))
     return FALSE;
 
-  g_string_append_c(result, '}');
+  json_writer_end_object(writer);
   return TRUE;
 }
 
 static gboolean
-_format_and_append_list(FilterXObject *value, GString *result)
+_format_and_append_list(FilterXObject *value, JSONWriter *writer)
 {
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '[');
+  json_writer_begin_array(writer);
 
   guint64 list_len;
   gboolean len_success = filterx_object_len(value, &list_len);
@@ -188,39 +75,33 @@ _format_and_append_list(FilterXObject *value, GString *result)
   for (guint64 i = 0; i < list_len; i++)
     {
       FilterXObject *elem = filterx_list_get_subscript(value, i);
-      gboolean success = _format_and_append_value(elem, result);
+      gboolean success = _format_and_append_value(elem, writer);
       filterx_object_unref(elem);
 
       if (!success)
         return FALSE;
     }
 
-  g_string_append_c(result, ']');
+  json_writer_end_array(writer);
   return TRUE;
 }
 
 static gboolean
-_repr_append(FilterXObject *value, GString *result)
+_repr_append(FilterXObject *value, JSONWriter *writer)
 {
   ScratchBuffersMarker marker;
   GString *repr = scratch_buffers_alloc_and_mark(&marker);
 
   gboolean success = filterx_object_repr(value, repr);
-  if (!success)
-    goto exit;
-
-  _append_comma_if_needed(result);
-  g_string_append_c(result, '"');
-  append_unsafe_utf8_as_escaped(result, repr->str, repr->len, "\"", "\\u%04x", "\\\\x%02x");
-  g_string_append_c(result, '"');
+  if (success)
+    json_writer_append_string(writer, repr->str, repr->len);
 
-exit:
   scratch_buffers_reclaim_marked(marker);
   return success;
 }
 
 static gboolean
-_format_and_append_value(FilterXObject *value, GString *result)
+_format_and_append_value(FilterXObject *value, JSONWriter *writer)
 {
   if (filterx_object_is_type(value, &FILTERX_TYPE_NAME(message_value)) &&
       (filterx_message_value_get_type(value) == LM_VT_JSON ||
@@ -229,54 +110,70 @@ _format_and_append_value(FilterXObject *value, GString *result)
     {
       gsize len;
       const gchar *str = filterx_message_value_get_value(value, &len);
-      return _append_literal(str, len, result);
+      json_writer_append_literal(writer, str, len);
+      return TRUE;
     }
 
   const gchar *json_literal = filterx_json_to_json_literal(value);
   if (json_literal)
     {
-      _append_comma_if_needed(result);
-      g_string_append(result, json_literal);
+      json_writer_append_literal(writer, json_literal, -1);
       return TRUE;
     }
 
   if (filterx_object_extract_null(value))
-    return _format_and_append_null(result);
+    {
+      json_writer_append_null(writer);
+      return TRUE;
+    }
 
   gboolean b;
   if (filterx_object_extract_boolean(value, &b))
-    return _format_and_append_boolean(b, result);
+    {
+      json_writer_append_boolean(writer, b);
+      return TRUE;
+    }
 
   gint64 i;
   if (filterx_object_extract_integer(value, &i))
-    return _format_and_append_integer(i, result);
+    {
+      json_writer_append_int(writer, i);
+      return TRUE;
+    }
 
   gdouble d;
   if (filterx_object_extract_double(value, &d))
-    return _format_and_append_double(d, result);
+    {
+      json_writer_append_double(writer, d);
+      return TRUE;
+    }
 
   const gchar *str;
   gsize str_len;
 
-  if (filterx_object_extract_bytes_ref(value, &str, &str_len))
-    return _format_and_append_bytes(str, str_len, result);
-
-  if (filterx_object_extract_protobuf_ref(value, &str, &str_len))
-    return _format_and_append_protobuf(str, str_len, result);
+  if (filterx_object_extract_bytes_ref(value, &str, &str_len) ||
+      filterx_object_extract_protobuf_ref(value, &str, &str_len))
+    {
+      json_writer_append_base64(writer, str, str_len);
+      return TRUE;
+    }
 
   if (filterx_object_extract_string_ref(value, &str, &str_len))
-    return _format_and_append_string(str, str_len, result);
+    {
+      json_writer_append_string(writer, str, str_len);
+      return TRUE;
+    }
 
   FilterXObject *value_unwrapped = filterx_ref_unwrap_ro(value);
   if (filterx_object_is_type(value_unwrapped, &FILTERX_TYPE_NAME(dict)))
-    return _format_and_append_dict(value_unwrapped, result);
+    return _format_and_append_dict(value_unwrapped, writer);
 
   if (filterx_object_is_type(value_unwrapped, &FILTERX_TYPE_NAME(list)))
-    return _format_and_append_list(value_unwrapped, result);
+    return _format_and_append_list(value_unwrapped, writer);
 
   /* FIXME: handle datetime based on object-datetime.c:_convert_unix_time_to_string() */
 
-  return _repr_append(value, result);
+  return _repr_append(value, writer);
 }
 
 static FilterXObject *
@@ -285,8 +182,10 @@ _format_json(FilterXObject *arg)
   FilterXObject *result = NULL;
   ScratchBuffersMarker marker;
   GString *result_string = scratch_buffers_alloc_and_mark(&marker);
+  JSONWriter writer;
 
-  if (!_format_and_append_value(arg, result_string))
+  json_writer_init(&writer, result_string);
+  if (!_format_and_append_value(arg, &writer))
     goto exit;
 
   result = filterx_string_new(result_string->str, result_string->len);
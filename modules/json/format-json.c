@@ -29,10 +29,9 @@
 #include "cfg.h"
 #include "value-pairs/cmdline.h"
 #include "syslog-ng.h"
-#include "utf8utils.h"
 #include "scanner/list-scanner/list-scanner.h"
 #include "scratch-buffers.h"
-#include "str-format.h"
+#include "json-writer.h"
 
 typedef struct _TFJsonState
 {
@@ -118,18 +117,10 @@ tf_json_prepare(LogTemplateFunction *self, gpointer s, LogTemplate *parent,
 
 typedef struct
 {
-  gboolean need_comma;
-  GString *buffer;
+  JSONWriter writer;
   const LogTemplateOptions *template_options;
 } json_state_t;
 
-static inline void
-tf_json_append_escaped(GString *dest, const gchar *str, gssize str_len)
-{
-  /* RFC8259 specifies only \uXXXX escaping */
-  append_unsafe_utf8_as_escaped(dest, str, str_len, "\"", "\\u%04x", "\\\\x%02x");
-}
-
 static gboolean
 tf_json_obj_start(const gchar *name,
                   const gchar *prefix, gpointer *prefix_data,
@@ -138,19 +129,9 @@ tf_json_obj_start(const gchar *name,
 {
   json_state_t *state = (json_state_t *)user_data;
 
-  if (state->need_comma)
-    g_string_append_c(state->buffer, ',');
-
   if (name)
-    {
-      g_string_append_c(state->buffer, '"');
-      tf_json_append_escaped(state->buffer, name, -1);
-      g_string_append(state->buffer, "\":{");
-    }
-  else
-    g_string_append_c(state->buffer, '{');
-
-  state->need_comma = FALSE;
+    json_writer_append_key(&state->writer, name, -1);
+  json_writer_begin_object(&state->writer);
 
   return FALSE;
 }
@@ -163,133 +144,27 @@ tf_json_obj_end(const gchar *name,
 {
   json_state_t *state = (json_state_t *)user_data;
 
-  g_string_append_c(state->buffer, '}');
-
-  state->need_comma = TRUE;
+  json_writer_end_object(&state->writer);
 
   return FALSE;
 }
 
 static void
-tf_json_append_key(const gchar *name, json_state_t *state)
-{
-  if (state->need_comma)
-    g_string_append_c(state->buffer, ',');
-
-  g_string_append_c(state->buffer, '"');
-  tf_json_append_escaped(state->buffer, name, -1);
-  g_string_append_c(state->buffer, '"');
-
-}
-
-static void
-tf_json_append_value(const gchar *name, const gchar *value, gsize value_len,
-                     json_state_t *state, gboolean quoted)
-{
-  tf_json_append_key(name, state);
-
-  if (quoted)
-    g_string_append(state->buffer, ":\"");
-  else
-    g_string_append_c(state->buffer, ':');
-
-  tf_json_append_escaped(state->buffer, value, value_len);
-
-  if (quoted)
-    g_string_append_c(state->buffer, '"');
-}
-
-static inline gsize
-_get_base64_encoded_size(gsize len)
-{
-  return (len / 3 + 1) * 4 + 4;
-}
-
-static void
-tf_json_append_value_base64_encode(const gchar *name, const gchar *value, gsize value_len, json_state_t *state)
-{
-  tf_json_append_key(name, state);
-  g_string_append(state->buffer, ":\"");
-
-  gint encode_state = 0;
-  gint encode_save = 0;
-  gsize init_len = state->buffer->len;
-
-  /* expand the buffer and add space for the base64 encoded string */
-  g_string_set_size(state->buffer, init_len + _get_base64_encoded_size(value_len));
-  gsize out_len = g_base64_encode_step((const guchar *) value, value_len, FALSE, state->buffer->str + init_len,
-                                       &encode_state, &encode_save);
-  g_string_set_size(state->buffer, init_len + out_len + _get_base64_encoded_size(0));
-
-#if !GLIB_CHECK_VERSION(2, 54, 0)
-  /* See modules/basicfuncs/str-funcs.c: tf_base64encode() */
-  if (((unsigned char *) &encode_save)[0] == 1)
-    ((unsigned char *) &encode_save)[2] = 0;
-#endif
-
-  out_len += g_base64_encode_close(FALSE, state->buffer->str + init_len + out_len, &encode_state, &encode_save);
-  g_string_set_size(state->buffer, init_len + out_len);
-
-  g_string_append_c(state->buffer, '"');
-}
-
-static void
-tf_json_append_literal(const gchar *name, const gchar *value, gsize value_len,
-                       json_state_t *state)
-{
-  tf_json_append_key(name, state);
-
-  g_string_append_c(state->buffer, ':');
-  g_string_append_len(state->buffer, value, value_len);
-}
-
-static void
-tf_json_append_list(const gchar *name, const gchar *value, gsize value_len,
-                    json_state_t *state)
+tf_json_append_list(const gchar *value, gsize value_len, json_state_t *state)
 {
-  tf_json_append_key(name, state);
-
-  g_string_append_c(state->buffer, ':');
-  g_string_append_c(state->buffer, '[');
-
   ListScanner scanner;
-  gboolean first = TRUE;
+
+  json_writer_begin_array(&state->writer);
 
   list_scanner_init(&scanner);
   list_scanner_input_string(&scanner, value, value_len);
   while (list_scanner_scan_next(&scanner))
-    {
-      if (!first)
-        g_string_append_c(state->buffer, ',');
-      else
-        first = FALSE;
-      g_string_append_c(state->buffer, '"');
-      tf_json_append_escaped(state->buffer, list_scanner_get_current_value(&scanner), -1);
-      g_string_append_c(state->buffer, '"');
-    }
-
+    json_writer_append_string(&state->writer, list_scanner_get_current_value(&scanner), -1);
   list_scanner_deinit(&scanner);
-  g_string_append_c(state->buffer, ']');
-}
 
-/* RFC8259 numbers: '+' sign, leading zeros are not allowed. */
-static inline void
-tf_json_append_double(const gchar *name, gdouble d, json_state_t *state)
-{
-  gchar double_buf[G_ASCII_DTOSTR_BUF_SIZE];
-  g_ascii_dtostr(double_buf, G_N_ELEMENTS(double_buf), d);
-  tf_json_append_value(name, double_buf, -1, state, FALSE);
+  json_writer_end_array(&state->writer);
 }
 
-static inline void
-tf_json_append_int(const gchar *name, gint64 i, json_state_t *state)
-{
-  GString *int_buf = scratch_buffers_alloc();
-  format_int64_padded(int_buf, 0, 0, 10, i);
-  tf_json_append_value(name, int_buf->str, int_buf->len, state, FALSE);
-}
-
-
 static gboolean
 tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_state_t *state, const gchar *value,
                               const gssize value_len, const gboolean on_error, gboolean *drop)
@@ -301,13 +176,16 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
     case LM_VT_STRING:
     case LM_VT_DATETIME:
     default:
-      tf_json_append_value(name, value, value_len, state, TRUE);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_string(&state->writer, value, value_len);
       return TRUE;
     case LM_VT_JSON:
-      tf_json_append_literal(name, value, value_len, state);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_literal(&state->writer, value, value_len);
       return TRUE;
     case LM_VT_LIST:
-      tf_json_append_list(name, value, value_len, state);
+      json_writer_append_key(&state->writer, name, -1);
+      tf_json_append_list(value, value_len, state);
       return TRUE;
     case LM_VT_INTEGER:
     {
@@ -319,7 +197,8 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
         {
           if ((on_error & ON_ERROR_FALLBACK_TO_STRING))
             {
-              tf_json_append_value(name, v, v_len, state, TRUE);
+              json_writer_append_key(&state->writer, name, -1);
+              json_writer_append_string(&state->writer, v, v_len);
               return TRUE;
             }
 
@@ -327,7 +206,8 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
           return FALSE;
         }
 
-      tf_json_append_int(name, i64, state);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_int(&state->writer, i64);
       return TRUE;
     }
     case LM_VT_DOUBLE:
@@ -340,7 +220,8 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
         {
           if ((on_error & ON_ERROR_FALLBACK_TO_STRING))
             {
-              tf_json_append_value(name, v, v_len, state, TRUE);
+              json_writer_append_key(&state->writer, name, -1);
+              json_writer_append_string(&state->writer, v, v_len);
               return TRUE;
             }
 
@@ -348,7 +229,8 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
           return FALSE;
         }
 
-      tf_json_append_double(name, d, state);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_double(&state->writer, d);
       return TRUE;
     }
     case LM_VT_BOOLEAN:
@@ -361,7 +243,8 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
         {
           if ((on_error & ON_ERROR_FALLBACK_TO_STRING))
             {
-              tf_json_append_value(name, v, v_len, state, TRUE);
+              json_writer_append_key(&state->writer, name, -1);
+              json_writer_append_string(&state->writer, v, v_len);
               return TRUE;
             }
 
@@ -369,18 +252,19 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
           return FALSE;
         }
 
-      v = b ? "true" : "false";
-      v_len = -1;
-      tf_json_append_value(name, v, v_len, state, FALSE);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_boolean(&state->writer, b);
       return TRUE;
     }
     case LM_VT_BYTES:
     case LM_VT_PROTOBUF:
-      tf_json_append_value_base64_encode(name, value, value_len, state);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_base64(&state->writer, value, value_len);
       return TRUE;
     case LM_VT_NULL:
     {
-      tf_json_append_value(name, "null", -1, state, FALSE);
+      json_writer_append_key(&state->writer, name, -1);
+      json_writer_append_null(&state->writer);
       return TRUE;
     }
     }
@@ -395,9 +279,7 @@ tf_json_value(const gchar *name, const gchar *prefix,
   json_state_t *state = (json_state_t *)user_data;
   gboolean drop;
 
-  if (tf_json_append_with_type_hint(name, type, state, value, value_len, state->template_options->on_error, &drop))
-    state->need_comma = TRUE;
-
+  tf_json_append_with_type_hint(name, type, state, value, value_len, state->template_options->on_error, &drop);
   return drop;
 }
 
@@ -406,10 +288,12 @@ tf_json_append(TFJsonState *state, GString *result, LogMessage *msg, LogTemplate
 {
   json_state_t invocation_state;
 
-  invocation_state.need_comma = FALSE;
-  invocation_state.buffer = result;
+  json_writer_init(&invocation_state.writer, result);
   invocation_state.template_options = options->opts;
 
+  /* the formatted document is usually about the size of the payload */
+  json_writer_reserve(&invocation_state.writer, msg->payload->used);
+
   return value_pairs_walk(state->vp,
                           tf_json_obj_start, tf_json_value, tf_json_obj_end,
                           msg, options, state->key_delimiter, &invocation_state);
@@ -449,9 +333,7 @@ tf_flat_json_value(const gchar *name,
   json_state_t *state = (json_state_t *) user_data;
   gboolean drop;
 
-  if (tf_json_append_with_type_hint(name, type, state, value, value_len, state->template_options->on_error, &drop))
-    state->need_comma = TRUE;
-
+  tf_json_append_with_type_hint(name, type, state, value, value_len, state->template_options->on_error, &drop);
   return drop;
 }
 
@@ -466,18 +348,20 @@ tf_flat_json_append(TFJsonState *state, GString *result, LogMessage *msg, LogTem
 {
   json_state_t invocation_state;
 
-  invocation_state.need_comma = FALSE;
-  invocation_state.buffer = result;
+  json_writer_init(&invocation_state.writer, result);
   invocation_state.template_options = options->opts;
 
-  g_string_append_c(invocation_state.buffer, '{');
+  /* the formatted document is usually about the size of the payload */
+  json_writer_reserve(&invocation_state.writer, msg->payload->used);
+
+  json_writer_begin_object(&invocation_state.writer);
 
   gboolean success = value_pairs_foreach_sorted(state->vp,
                                                 tf_flat_json_value,
                                                 (GCompareFunc) tf_flat_value_pairs_sort, msg, options,
                                                 &invocation_state);
 
-  g_string_append_c(invocation_state.buffer, '}');
+  json_writer_end_object(&invocation_state.writer);
 
   return success;
 }
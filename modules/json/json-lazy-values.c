@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "json-lazy-values.h"
+#include "logmsg/nvtable.h"
+
+#include <string.h>
+
+/*
+ * json-parser(lazy(yes)) does not set the name-value pairs it extracts one
+ * by one, instead it stores the input together with its tape in a single
+ * LM_VT_BYTES value:
+ *
+ *   [JSONLazyHeader][JSONTapeEntry x num_entries][input]
+ *
+ * Lookups that miss the payload find the name on the tape and format that
+ * single value, while log_msg_values_foreach() (and thus value-pairs and
+ * format-json) enumerates all of them.  The storage is an ordinary value of
+ * the message, so it is shared by clones and survives serialization.
+ */
+
+#define JSON_LAZY_MAX_STORAGES 16
+
+typedef struct _JSONLazyHeader
+{
+  guint32 num_entries;
+  guint32 input_len;
+} JSONLazyHeader;
+
+struct _JSONLazyStorage
+{
+  NVHandle handle;
+  gchar *prefix;
+  gsize prefix_len;
+  gchar key_delimiter;
+};
+
+/* storages are allocated from the main thread as json-parser() instances
+ * are initialized and are kept until the process exits, just like
+ * NVHandles, lookups read them in parallel, see log_msg_register_lazy_values() */
+static JSONLazyStorage storages[JSON_LAZY_MAX_STORAGES];
+static gint num_storages;
+
+static gboolean
+_load_tape(JSONLazyStorage *storage, const LogMessage *msg, JSONTape *tape)
+{
+  JSONLazyHeader header;
+  gssize len;
+
+  /* not log_msg_get_value(), that would recurse into the lazy lookup */
+  const gchar *blob = nv_table_get_value(msg->payload, storage->handle, &len, NULL);
+  if (!blob || len < (gssize) sizeof(header))
+    return FALSE;
+
+  memcpy(&header, blob, sizeof(header));
+  gsize entries_len = (gsize) header.num_entries * sizeof(JSONTapeEntry);
+  if ((gsize) len != sizeof(header) + entries_len + header.input_len || header.num_entries == 0)
+    return FALSE;
+
+  const gchar *entries = blob + sizeof(header);
+  json_tape_init_from_data(tape, entries + entries_len, entries, header.num_entries);
+  return TRUE;
+}
+
+static const gchar *
+_get_key(const JSONTape *tape, const JSONTapeEntry *key, GString *buffer, gsize *key_len)
+{
+  if (!(key->flags & JSON_TAPE_ENTRY_ESCAPED))
+    {
+      *key_len = key->len;
+      return tape->input + key->ofs;
+    }
+
+  g_string_truncate(buffer, 0);
+  json_tape_append_string(tape, key, buffer);
+  *key_len = buffer->len;
+  return buffer->str;
+}
+
+/* Returns the index of the value @name refers to within the object at
+ * @index, or 0 if there is none.  In case of duplicate names the last one
+ * wins, just like when json-parser() sets them in document order.
+ */
+static guint32
+_find_value(JSONLazyStorage *storage, const JSONTape *tape, guint32 index,
+            const gchar *name, gsize name_len, GString *buffer)
+{
+  JSONTapeEntry object = json_tape_get_entry(tape, index);
+  guint32 found = 0;
+  guint32 i = index + 1;
+
+  while (i < object.next)
+    {
+      JSONTapeEntry key = json_tape_get_entry(tape, i);
+      JSONTapeEntry value = json_tape_get_entry(tape, i + 1);
+      gsize key_len;
+      const gchar *key_str = _get_key(tape, &key, buffer, &key_len);
+
+      if (key_len <= name_len && memcmp(key_str, name, key_len) == 0)
+        {
+          if (value.type != JSON_TAPE_OBJECT)
+            {
+              if (key_len == name_len)
+                found = i + 1;
+            }
+          else if (key_len < name_len && name[key_len] == storage->key_delimiter)
+            {
+              guint32 nested = _find_value(storage, tape, i + 1,
+                                           name + key_len + 1, name_len - key_len - 1,
+                                           buffer);
+              if (nested)
+                found = nested;
+            }
+        }
+      i = value.next;
+    }
+  return found;
+}
+
+static void
+_format_value(const JSONTape *tape, guint32 index, GString *value, LogMessageValueType *type)
+{
+  JSONTapeEntry entry = json_tape_get_entry(tape, index);
+
+  if (json_tape_format_scalar(tape, &entry, value, type))
+    return;
+
+  /* only arrays of strings are stored lazily, the rest is serialized by json-c */
+  json_tape_format_string_array(tape, index, value);
+  *type = LM_VT_LIST;
+}
+
+static guint32
+_lookup(JSONLazyStorage *storage, const JSONTape *tape, const gchar *name, gsize name_len, GString *buffer)
+{
+  if (name_len < storage->prefix_len || memcmp(name, storage->prefix, storage->prefix_len) != 0)
+    return 0;
+
+  return _find_value(storage, tape, 0, name + storage->prefix_len, name_len - storage->prefix_len, buffer);
+}
+
+static gboolean
+_get_value(LogMessageLazyValues *s, const LogMessage *msg, NVHandle handle,
+           GString *value, LogMessageValueType *type)
+{
+  gint n = g_atomic_int_get(&num_storages);
+  gssize name_len;
+  const gchar *name = log_msg_get_value_name(handle, &name_len);
+
+  for (gint i = 0; i < n; i++)
+    {
+      JSONLazyStorage *storage = &storages[i];
+      JSONTape tape;
+
+      if (!_load_tape(storage, msg, &tape))
+        continue;
+
+      guint32 index = _lookup(storage, &tape, name, name_len, value);
+      if (index)
+        {
+          _format_value(&tape, index, value, type);
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+typedef struct _JSONLazyForeachState
+{
+  JSONLazyStorage *storage;
+  const JSONTape *tape;
+  GString *name;
+  GString *value;
+  GString *buffer;
+  NVTableForeachFunc func;
+  gpointer user_data;
+} JSONLazyForeachState;
+
+static gboolean
+_foreach_leaf(JSONLazyForeachState *state, guint32 index)
+{
+  LogMessageValueType type;
+
+  /* overridden by a later member with the same name */
+  if (_lookup(state->storage, state->tape, state->name->str, state->name->len, state->buffer) != index)
+    return FALSE;
+
+  _format_value(state->tape, index, state->value, &type);
+  return state->func(log_msg_get_value_handle(state->name->str), state->name->str,
+                     state->value->str, state->value->len, type, state->user_data);
+}
+
+static gboolean
+_foreach_member(JSONLazyForeachState *state, guint32 index)
+{
+  JSONTapeEntry object = json_tape_get_entry(state->tape, index);
+  guint32 i = index + 1;
+
+  while (i < object.next)
+    {
+      JSONTapeEntry key = json_tape_get_entry(state->tape, i);
+      JSONTapeEntry value = json_tape_get_entry(state->tape, i + 1);
+      gsize name_len = state->name->len;
+      gboolean stop;
+
+      json_tape_append_string(state->tape, &key, state->name);
+      if (value.type == JSON_TAPE_OBJECT)
+        {
+          g_string_append_c(state->name, state->storage->key_delimiter);
+          stop = _foreach_member(state, i + 1);
+        }
+      else
+        {
+          stop = _foreach_leaf(state, i + 1);
+        }
+      g_string_truncate(state->name, name_len);
+
+      if (stop)
+        return TRUE;
+      i = value.next;
+    }
+  return FALSE;
+}
+
+static gboolean
+_foreach(LogMessageLazyValues *s, const LogMessage *msg, NVTableForeachFunc func, gpointer user_data)
+{
+  gint n = g_atomic_int_get(&num_storages);
+  gboolean stop = FALSE;
+
+  /* not scratch buffers: the callbacks allocate their own, which we must not reclaim */
+  JSONLazyForeachState state =
+  {
+    .name = g_string_sized_new(128),
+    .value = g_string_sized_new(256),
+    .buffer = g_string_sized_new(128),
+    .func = func,
+    .user_data = user_data,
+  };
+
+  for (gint i = 0; i < n && !stop; i++)
+    {
+      JSONTape tape;
+
+      if (!_load_tape(&storages[i], msg, &tape))
+        continue;
+
+      state.storage = &storages[i];
+      state.tape = &tape;
+      g_string_assign(state.name, storages[i].prefix);
+      stop = _foreach_member(&state, 0);
+    }
+
+  g_string_free(state.name, TRUE);
+  g_string_free(state.value, TRUE);
+  g_string_free(state.buffer, TRUE);
+  return stop;
+}
+
+static LogMessageLazyValues json_lazy_values =
+{
+  .get_value = _get_value,
+  .foreach = _foreach,
+};
+
+/*
+ * Storing
+ */
+
+typedef struct _JSONLazyOverrideState
+{
+  JSONLazyStorage *storage;
+  const JSONTape *tape;
+  GString *buffer;
+  GArray *handles;
+} JSONLazyOverrideState;
+
+static gboolean
+_collect_overridden_value(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entry, gpointer user_data)
+{
+  JSONLazyOverrideState *state = (JSONLazyOverrideState *) user_data;
+  gssize name_len;
+  const gchar *name = log_msg_get_value_name(handle, &name_len);
+
+  if (_lookup(state->storage, state->tape, name, name_len, state->buffer))
+    g_array_append_val(state->handles, handle);
+  return FALSE;
+}
+
+/* Values already in the payload (even if unset) would take precedence over
+ * the lazy ones, while json-parser() is expected to overwrite them.  Those
+ * are few, so we simply set them right away.
+ */
+static void
+_set_overridden_values(JSONLazyStorage *storage, LogMessage *msg, const JSONTape *tape)
+{
+  JSONLazyOverrideState state =
+  {
+    .storage = storage,
+    .tape = tape,
+    .buffer = g_string_sized_new(128),
+    .handles = g_array_new(FALSE, FALSE, sizeof(NVHandle)),
+  };
+  LogMessageValueType type;
+
+  nv_table_foreach_entry(msg->payload, _collect_overridden_value, &state);
+
+  for (guint i = 0; i < state.handles->len; i++)
+    {
+      NVHandle handle = g_array_index(state.handles, NVHandle, i);
+      gssize name_len;
+      const gchar *name = log_msg_get_value_name(handle, &name_len);
+      guint32 index = _lookup(storage, tape, name, name_len, state.buffer);
+
+      _format_value(tape, index, state.buffer, &type);
+      log_msg_set_value_with_type(msg, handle, state.buffer->str, state.buffer->len, type);
+    }
+
+  g_array_free(state.handles, TRUE);
+  g_string_free(state.buffer, TRUE);
+}
+
+void
+json_lazy_values_store(JSONLazyStorage *storage, LogMessage *msg, const JSONTape *tape, gsize input_len)
+{
+  JSONLazyHeader header =
+  {
+    .num_entries = json_tape_get_num_entries(tape),
+    .input_len = input_len,
+  };
+  gsize entries_len = header.num_entries * sizeof(JSONTapeEntry);
+  GString *blob = g_string_sized_new(sizeof(header) + entries_len + input_len);
+
+  g_string_append_len(blob, (const gchar *) &header, sizeof(header));
+  g_string_append_len(blob, tape->entries, entries_len);
+  g_string_append_len(blob, tape->input, input_len);
+
+  _set_overridden_values(storage, msg, tape);
+  log_msg_set_value_with_type(msg, storage->handle, blob->str, blob->len, LM_VT_BYTES);
+  msg->flags |= LF_LAZY_VALUES;
+
+  g_string_free(blob, TRUE);
+}
+
+gboolean
+json_lazy_values_is_stored(JSONLazyStorage *storage, const LogMessage *msg)
+{
+  return nv_table_is_value_set(msg->payload, storage->handle);
+}
+
+JSONLazyStorage *
+json_lazy_values_get_storage(const gchar *prefix, gchar key_delimiter)
+{
+  gint n = g_atomic_int_get(&num_storages);
+
+  if (!prefix)
+    prefix = "";
+
+  for (gint i = 0; i < n; i++)
+    {
+      if (storages[i].key_delimiter == key_delimiter && strcmp(storages[i].prefix, prefix) == 0)
+        return &storages[i];
+    }
+
+  if (n == JSON_LAZY_MAX_STORAGES)
+    return NULL;
+
+  if (n == 0)
+    log_msg_register_lazy_values(&json_lazy_values);
+
+  JSONLazyStorage *storage = &storages[n];
+  gchar *storage_name = g_strdup_printf("._json_lazy(%s%c)", prefix, key_delimiter);
+
+  storage->prefix = g_strdup(prefix);
+  storage->prefix_len = strlen(prefix);
+  storage->key_delimiter = key_delimiter;
+  storage->handle = log_msg_get_lazy_storage_handle(storage_name);
+  g_free(storage_name);
+
+  g_atomic_int_set(&num_storages, n + 1);
+  return storage;
+}
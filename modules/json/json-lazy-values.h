@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef JSON_LAZY_VALUES_H_INCLUDED
+#define JSON_LAZY_VALUES_H_INCLUDED
+
+#include "json-tape.h"
+
+typedef struct _JSONLazyStorage JSONLazyStorage;
+
+JSONLazyStorage *json_lazy_values_get_storage(const gchar *prefix, gchar key_delimiter);
+void json_lazy_values_store(JSONLazyStorage *storage, LogMessage *msg, const JSONTape *tape, gsize input_len);
+gboolean json_lazy_values_is_stored(JSONLazyStorage *storage, const LogMessage *msg);
+
+#endif
@@ -35,6 +35,7 @@ static CfgLexerKeyword json_parser_keywords[] =
   { "marker",               KW_MARKER,  },
   { "extract_prefix",       KW_EXTRACT_PREFIX, },
   { "key_delimiter",        KW_KEY_DELIMITER, },
+  { "lazy",                 KW_LAZY, },
   { NULL }
 };
 
@@ -23,6 +23,8 @@
 #define JSON_C_VER_013 (13 << 8)
 
 #include "json-parser.h"
+#include "json-tape.h"
+#include "json-lazy-values.h"
 #include "dot-notation.h"
 #include "scratch-buffers.h"
 #include "str-repr/encode.h"
@@ -44,6 +46,8 @@ typedef struct _JSONParser
   gint marker_len;
   gchar *extract_prefix;
   gchar key_delimiter;
+  gboolean lazy;
+  JSONLazyStorage *lazy_storage;
 } JSONParser;
 
 void
@@ -82,6 +86,14 @@ json_parser_set_key_delimiter(LogParser *s, gchar delimiter)
   self->key_delimiter = delimiter;
 }
 
+void
+json_parser_set_lazy(LogParser *s, gboolean lazy)
+{
+  JSONParser *self = (JSONParser *) s;
+
+  self->lazy = lazy;
+}
+
 static void
 json_parser_store_value(JSONParser *self,
                         const gchar *prefix, const gchar *obj_key,
@@ -317,6 +329,170 @@ json_parser_extract(JSONParser *self, struct json_object *jso, LogMessage *msg)
   return FALSE;
 }
 
+/*
+ * Tape based processing
+ *
+ * The same name-value pairs are produced as with json-c above, but straight
+ * from a JSONTape, without building and freeing a DOM for each message.
+ * Whenever the tape cannot represent the input exactly as json-c does, we
+ * fall back to json-c.
+ */
+
+static void
+json_parser_process_tape_object(JSONParser *self, JSONTape *tape, guint32 index,
+                                const gchar *prefix, LogMessageValueSource *source,
+                                LogMessage *msg);
+
+/* strings without escapes are stored as references to the input if
+ * possible, see log_msg_set_value_from_source() */
+static void
+json_parser_store_tape_string(JSONParser *self, JSONTape *tape, JSONTapeEntry *entry,
+                              const gchar *prefix, const gchar *obj_key,
+                              LogMessageValueSource *source, LogMessage *msg)
+{
+  NVHandle handle;
+
+  if (prefix)
+    {
+      GString *key = scratch_buffers_alloc();
+
+      g_string_assign(key, prefix);
+      g_string_append(key, obj_key);
+      handle = log_msg_get_value_handle(key->str);
+    }
+  else
+    handle = log_msg_get_value_handle(obj_key);
+  log_msg_set_value_from_source(msg, handle, source, tape->input + entry->ofs, entry->len);
+}
+
+static void
+json_parser_process_tape_attribute(JSONParser *self, JSONTape *tape, guint32 index,
+                                   const gchar *prefix, const gchar *obj_key,
+                                   LogMessageValueSource *source, LogMessage *msg)
+{
+  JSONTapeEntry entry = json_tape_get_entry(tape, index);
+
+  if (entry.type == JSON_TAPE_STRING && !(entry.flags & JSON_TAPE_ENTRY_ESCAPED))
+    {
+      json_parser_store_tape_string(self, tape, &entry, prefix, obj_key, source, msg);
+      return;
+    }
+
+  GString *value = scratch_buffers_alloc();
+  LogMessageValueType type = LM_VT_STRING;
+
+  if (json_tape_format_scalar(tape, &entry, value, &type))
+    {
+      json_parser_store_value(self, prefix, obj_key, value, type, msg);
+      return;
+    }
+
+  if (entry.type == JSON_TAPE_OBJECT)
+    {
+      GString *key = value;
+
+      if (prefix)
+        g_string_assign(key, prefix);
+      g_string_append(key, obj_key);
+      g_string_append_c(key, self->key_delimiter);
+      json_parser_process_tape_object(self, tape, index, key->str, source, msg);
+      return;
+    }
+
+  /* json_parser_can_process_tape() only lets arrays of strings through */
+  json_tape_format_string_array(tape, index, value);
+  json_parser_store_value(self, prefix, obj_key, value, LM_VT_LIST, msg);
+}
+
+static void
+json_parser_process_tape_object(JSONParser *self, JSONTape *tape, guint32 index,
+                                const gchar *prefix, LogMessageValueSource *source,
+                                LogMessage *msg)
+{
+  JSONTapeEntry object = json_tape_get_entry(tape, index);
+  guint32 i = index + 1;
+
+  /* members are key/value entry pairs */
+  while (i < object.next)
+    {
+      JSONTapeEntry key_entry = json_tape_get_entry(tape, i);
+      ScratchBuffersMarker marker;
+      GString *key = scratch_buffers_alloc_and_mark(&marker);
+
+      json_tape_append_string(tape, &key_entry, key);
+      json_parser_process_tape_attribute(self, tape, i + 1, prefix, key->str, source, msg);
+      scratch_buffers_reclaim_marked(marker);
+
+      i = json_tape_get_entry(tape, i + 1).next;
+    }
+}
+
+static void
+json_parser_process_tape_array(JSONParser *self, JSONTape *tape, guint32 index, LogMessage *msg)
+{
+  JSONTapeEntry array = json_tape_get_entry(tape, index);
+  guint32 i = index + 1;
+  gint n;
+
+  log_msg_unset_match(msg, 0);
+  for (n = 0; i < array.next && n < LOGMSG_MAX_MATCHES; n++)
+    {
+      JSONTapeEntry el = json_tape_get_entry(tape, i);
+      GString *element_value = scratch_buffers_alloc();
+      LogMessageValueType element_type;
+
+      json_tape_format_scalar(tape, &el, element_value, &element_type);
+      log_msg_set_match_with_type(msg, n + 1, element_value->str, element_value->len, element_type);
+      i = el.next;
+    }
+  log_msg_truncate_matches(msg, n + 1);
+}
+
+/* json-c serializes non-string arrays and compound match values, we only
+ * handle what can be emitted without a serializer */
+static gboolean
+json_parser_can_process_tape(JSONTape *tape)
+{
+  JSONTapeEntry root = json_tape_get_entry(tape, 0);
+
+  if (root.type == JSON_TAPE_ARRAY && (root.flags & JSON_TAPE_ENTRY_HAS_CONTAINERS))
+    return FALSE;
+
+  for (guint32 i = 1; i < json_tape_get_num_entries(tape); i++)
+    {
+      JSONTapeEntry entry = json_tape_get_entry(tape, i);
+
+      if (entry.type == JSON_TAPE_ARRAY && !(entry.flags & JSON_TAPE_ENTRY_ONLY_STRINGS))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+json_parser_process_with_tape(JSONParser *self, LogMessage **pmsg, const LogPathOptions *path_options,
+                              const gchar *input, gsize input_len)
+{
+  JSONTape tape;
+
+  json_tape_init(&tape, scratch_buffers_alloc());
+  if (!json_tape_parse(&tape, input, input_len) || !json_parser_can_process_tape(&tape))
+    return FALSE;
+
+  log_msg_make_writable(pmsg, path_options);
+  if (json_tape_get_entry(&tape, 0).type == JSON_TAPE_ARRAY)
+    json_parser_process_tape_array(self, &tape, 0, *pmsg);
+  else if (self->lazy_storage && !json_lazy_values_is_stored(self->lazy_storage, *pmsg))
+    json_lazy_values_store(self->lazy_storage, *pmsg, &tape, input_len);
+  else
+    {
+      LogMessageValueSource source;
+
+      log_msg_value_source_init(&source, *pmsg, LM_V_MESSAGE, input, input_len);
+      json_parser_process_tape_object(self, &tape, 0, self->prefix, &source, *pmsg);
+    }
+  return TRUE;
+}
+
 #ifndef JSON_C_VERSION
 const char *
 json_tokener_error_desc(enum json_tokener_error err)
@@ -348,11 +524,19 @@ json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_
           return FALSE;
         }
       input += self->marker_len;
+      input_len -= self->marker_len;
 
-      while (isspace(*input))
-        input++;
+      while (input_len > 0 && isspace(*input))
+        {
+          input++;
+          input_len--;
+        }
     }
 
+  /* extract-prefix() needs the DOM */
+  if (!self->extract_prefix && json_parser_process_with_tape(self, pmsg, path_options, input, input_len))
+    return TRUE;
+
   tok = json_tokener_new();
   jso = json_tokener_parse_ex(tok, input, input_len);
   if (tok->err != json_tokener_success || !jso)
@@ -391,10 +575,37 @@ json_parser_clone(LogPipe *s)
   json_parser_set_marker(cloned, self->marker);
   json_parser_set_extract_prefix(cloned, self->extract_prefix);
   json_parser_set_key_delimiter(cloned, self->key_delimiter);
+  json_parser_set_lazy(cloned, self->lazy);
 
   return &cloned->super;
 }
 
+static gboolean
+json_parser_init(LogPipe *s)
+{
+  JSONParser *self = (JSONParser *) s;
+
+  self->lazy_storage = NULL;
+  if (self->lazy)
+    {
+      if (self->extract_prefix)
+        {
+          msg_warning("json-parser(): lazy(yes) is not supported together with extract-prefix(), ignoring",
+                      log_pipe_location_tag(s));
+        }
+      else
+        {
+          self->lazy_storage = json_lazy_values_get_storage(self->prefix, self->key_delimiter);
+          if (!self->lazy_storage)
+            msg_warning("json-parser(): too many distinct prefix() values used with lazy(yes), "
+                        "falling back to extracting all values",
+                        evt_tag_str("prefix", self->prefix),
+                        log_pipe_location_tag(s));
+        }
+    }
+  return log_parser_init_method(s);
+}
+
 static void
 json_parser_free(LogPipe *s)
 {
@@ -412,6 +623,7 @@ json_parser_new(GlobalConfig *cfg)
   JSONParser *self = g_new0(JSONParser, 1);
 
   log_parser_init_instance(&self->super, cfg);
+  self->super.super.init = json_parser_init;
   self->super.super.free_fn = json_parser_free;
   self->super.super.clone = json_parser_clone;
   self->super.process = json_parser_process;
@@ -0,0 +1,682 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "json-tape.h"
+#include "str-repr/encode.h"
+#include "scratch-buffers.h"
+
+/*
+ * The tape parser refuses (and leaves the job to json-c):
+ *   - anything beyond the JSON grammar that json-c tolerates in non-strict
+ *     mode (comments, trailing commas, case-insensitive literals, leading
+ *     zeroes, etc.), except single quoted strings which are common enough,
+ *   - documents nested close to json-c's default depth limit,
+ *   - integers that might not fit into 64 bits,
+ *   - \u0000 and unpaired surrogates, raw control characters in strings,
+ *   - root values that are not objects or arrays,
+ *   - objects that have a duplicate key with a container value: json-c
+ *     keeps the last value only, which cannot be emulated when walking
+ *     the members in order.
+ *
+ * Content after the root value is ignored, the same way as
+ * json_tokener_parse_ex() does.
+ */
+
+#define JSON_TAPE_MAX_DEPTH      30
+#define JSON_TAPE_MAX_INT_DIGITS 18
+
+typedef struct _JSONTapeParser
+{
+  JSONTape *tape;
+  const gchar *p;
+  const gchar *end;
+  gint depth;
+} JSONTapeParser;
+
+/* characters that terminate the fast scanning of a string */
+static const guint8 json_tape_string_stop_chars[256] =
+{
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  ['"'] = 1,
+  ['\''] = 1,
+  ['\\'] = 1,
+};
+
+static inline JSONTapeEntry *
+_get_entry(JSONTapeParser *self, guint32 index)
+{
+  return &((JSONTapeEntry *) self->tape->storage->str)[index];
+}
+
+static inline guint32
+_get_num_entries(JSONTapeParser *self)
+{
+  return self->tape->storage->len / sizeof(JSONTapeEntry);
+}
+
+static guint32
+_append_entry(JSONTapeParser *self, guint8 type, guint8 flags, const gchar *start, gsize len)
+{
+  guint32 index = _get_num_entries(self);
+
+  g_string_set_size(self->tape->storage, (index + 1) * sizeof(JSONTapeEntry));
+
+  JSONTapeEntry *entry = _get_entry(self, index);
+  entry->type = type;
+  entry->flags = flags;
+  entry->ofs = start - self->tape->input;
+  entry->len = len;
+  entry->next = index + 1;
+  return index;
+}
+
+static inline void
+_skip_whitespace(JSONTapeParser *self)
+{
+  while (self->p < self->end &&
+         (*self->p == ' ' || *self->p == '\n' || *self->p == '\r' || *self->p == '\t'))
+    self->p++;
+}
+
+static inline gboolean
+_is_value_terminator(JSONTapeParser *self)
+{
+  if (self->p >= self->end)
+    return TRUE;
+
+  switch (*self->p)
+    {
+    case ',':
+    case ']':
+    case '}':
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+_scan_hex4(const gchar *p, gunichar *result)
+{
+  gunichar value = 0;
+
+  for (gint i = 0; i < 4; i++)
+    {
+      gint digit = g_ascii_xdigit_value(p[i]);
+      if (digit < 0)
+        return FALSE;
+      value = (value << 4) | digit;
+    }
+  *result = value;
+  return TRUE;
+}
+
+/* p points to \u, returns the number of bytes consumed or 0 if refused */
+static gsize
+_scan_unicode_escape(const gchar *p, const gchar *end, gunichar *result)
+{
+  gunichar high, low;
+
+  if (end - p < 6 || !_scan_hex4(p + 2, &high) || high == 0)
+    return 0;
+
+  if (high >= 0xDC00 && high <= 0xDFFF)
+    return 0;
+
+  if (high < 0xD800 || high > 0xDBFF)
+    {
+      *result = high;
+      return 6;
+    }
+
+  if (end - p < 12 || p[6] != '\\' || p[7] != 'u' || !_scan_hex4(p + 8, &low))
+    return 0;
+
+  if (low < 0xDC00 || low > 0xDFFF)
+    return 0;
+
+  *result = 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+  return 12;
+}
+
+static gboolean
+_parse_escape(JSONTapeParser *self)
+{
+  gunichar c;
+  gsize consumed;
+
+  if (self->end - self->p < 2)
+    return FALSE;
+
+  switch (self->p[1])
+    {
+    case '"':
+    case '\\':
+    case '/':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+      self->p += 2;
+      return TRUE;
+    case 'u':
+      consumed = _scan_unicode_escape(self->p, self->end, &c);
+      self->p += consumed;
+      return consumed > 0;
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+_parse_string(JSONTapeParser *self)
+{
+  gchar quote = *self->p;
+  const gchar *start = ++self->p;
+  guint8 flags = 0;
+
+  while (self->p < self->end)
+    {
+      guchar c = *self->p;
+
+      if (G_LIKELY(!json_tape_string_stop_chars[c]))
+        {
+          self->p++;
+          continue;
+        }
+
+      if (c == quote)
+        {
+          _append_entry(self, JSON_TAPE_STRING, flags, start, self->p - start);
+          self->p++;
+          return TRUE;
+        }
+
+      if (c == '\\')
+        {
+          if (!_parse_escape(self))
+            return FALSE;
+          flags |= JSON_TAPE_ENTRY_ESCAPED;
+          continue;
+        }
+
+      if (c < 0x20)
+        return FALSE;
+
+      /* the quote character not used by this string */
+      self->p++;
+    }
+  return FALSE;
+}
+
+static gboolean
+_scan_digits(JSONTapeParser *self, gint *num_digits)
+{
+  const gchar *start = self->p;
+
+  while (self->p < self->end && g_ascii_isdigit(*self->p))
+    self->p++;
+
+  if (num_digits)
+    *num_digits = self->p - start;
+  return self->p > start;
+}
+
+static gboolean
+_parse_number(JSONTapeParser *self)
+{
+  const gchar *start = self->p;
+  guint8 type = JSON_TAPE_INT;
+  gint num_digits;
+
+  if (*self->p == '-')
+    self->p++;
+
+  if (self->p >= self->end)
+    return FALSE;
+
+  if (*self->p == '0')
+    {
+      self->p++;
+      num_digits = 1;
+    }
+  else if (!_scan_digits(self, &num_digits))
+    return FALSE;
+
+  if (self->p < self->end && *self->p == '.')
+    {
+      self->p++;
+      type = JSON_TAPE_DOUBLE;
+      if (!_scan_digits(self, NULL))
+        return FALSE;
+    }
+
+  if (self->p < self->end && (*self->p == 'e' || *self->p == 'E'))
+    {
+      self->p++;
+      type = JSON_TAPE_DOUBLE;
+      if (self->p < self->end && (*self->p == '+' || *self->p == '-'))
+        self->p++;
+      if (!_scan_digits(self, NULL))
+        return FALSE;
+    }
+
+  if (type == JSON_TAPE_INT && num_digits > JSON_TAPE_MAX_INT_DIGITS)
+    return FALSE;
+
+  if (!_is_value_terminator(self))
+    return FALSE;
+
+  _append_entry(self, type, 0, start, self->p - start);
+  return TRUE;
+}
+
+static gboolean
+_parse_literal(JSONTapeParser *self, const gchar *literal, gsize literal_len, guint8 type)
+{
+  if ((gsize)(self->end - self->p) < literal_len || memcmp(self->p, literal, literal_len) != 0)
+    return FALSE;
+
+  _append_entry(self, type, 0, self->p, literal_len);
+  self->p += literal_len;
+  return _is_value_terminator(self);
+}
+
+static gboolean
+_keys_equal(JSONTapeParser *self, const JSONTapeEntry *a, const JSONTapeEntry *b)
+{
+  return a->len == b->len && memcmp(self->tape->input + a->ofs, self->tape->input + b->ofs, a->len) == 0;
+}
+
+/* only called for objects with container members, which are rare enough
+ * not to bother with anything smarter than a quadratic scan */
+static gboolean
+_has_duplicate_container_key(JSONTapeParser *self, guint32 object_index)
+{
+  guint32 end = _get_entry(self, object_index)->next;
+
+  for (guint32 i = object_index + 1; i < end; i = _get_entry(self, i + 1)->next)
+    {
+      JSONTapeEntry *key = _get_entry(self, i);
+
+      /* escaped keys are not normalized, be conservative */
+      if (key->flags & JSON_TAPE_ENTRY_ESCAPED)
+        return TRUE;
+
+      guint8 value_type = _get_entry(self, i + 1)->type;
+      if (value_type != JSON_TAPE_OBJECT && value_type != JSON_TAPE_ARRAY)
+        continue;
+
+      for (guint32 j = object_index + 1; j < end; j = _get_entry(self, j + 1)->next)
+        {
+          if (j != i && _keys_equal(self, key, _get_entry(self, j)))
+            return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+static gboolean _parse_value(JSONTapeParser *self);
+
+static inline gboolean
+_is_container(JSONTapeParser *self, guint32 index)
+{
+  guint8 type = _get_entry(self, index)->type;
+
+  return type == JSON_TAPE_OBJECT || type == JSON_TAPE_ARRAY;
+}
+
+static gboolean
+_parse_object(JSONTapeParser *self)
+{
+  guint32 index = _append_entry(self, JSON_TAPE_OBJECT, 0, self->p, 0);
+  guint8 flags = 0;
+
+  self->p++;
+  _skip_whitespace(self);
+  if (self->p < self->end && *self->p == '}')
+    {
+      self->p++;
+      return TRUE;
+    }
+
+  while (TRUE)
+    {
+      _skip_whitespace(self);
+      if (self->p >= self->end || (*self->p != '"' && *self->p != '\''))
+        return FALSE;
+      if (!_parse_string(self))
+        return FALSE;
+
+      _skip_whitespace(self);
+      if (self->p >= self->end || *self->p != ':')
+        return FALSE;
+      self->p++;
+
+      _skip_whitespace(self);
+      guint32 value_index = _get_num_entries(self);
+      if (!_parse_value(self))
+        return FALSE;
+      if (_is_container(self, value_index))
+        flags |= JSON_TAPE_ENTRY_HAS_CONTAINERS;
+
+      _skip_whitespace(self);
+      if (self->p >= self->end)
+        return FALSE;
+      if (*self->p == '}')
+        break;
+      if (*self->p != ',')
+        return FALSE;
+      self->p++;
+    }
+  self->p++;
+
+  JSONTapeEntry *object = _get_entry(self, index);
+  object->flags = flags;
+  object->next = _get_num_entries(self);
+
+  if ((flags & JSON_TAPE_ENTRY_HAS_CONTAINERS) && _has_duplicate_container_key(self, index))
+    return FALSE;
+  return TRUE;
+}
+
+static gboolean
+_parse_array(JSONTapeParser *self)
+{
+  guint32 index = _append_entry(self, JSON_TAPE_ARRAY, 0, self->p, 0);
+  guint8 flags = JSON_TAPE_ENTRY_ONLY_STRINGS;
+
+  self->p++;
+  _skip_whitespace(self);
+  if (self->p < self->end && *self->p == ']')
+    {
+      self->p++;
+      _get_entry(self, index)->flags = flags;
+      return TRUE;
+    }
+
+  while (TRUE)
+    {
+      _skip_whitespace(self);
+      guint32 element_index = _get_num_entries(self);
+      if (!_parse_value(self))
+        return FALSE;
+
+      guint8 element_type = _get_entry(self, element_index)->type;
+      if (element_type != JSON_TAPE_STRING)
+        flags &= ~JSON_TAPE_ENTRY_ONLY_STRINGS;
+      if (element_type == JSON_TAPE_OBJECT || element_type == JSON_TAPE_ARRAY)
+        flags |= JSON_TAPE_ENTRY_HAS_CONTAINERS;
+
+      _skip_whitespace(self);
+      if (self->p >= self->end)
+        return FALSE;
+      if (*self->p == ']')
+        break;
+      if (*self->p != ',')
+        return FALSE;
+      self->p++;
+    }
+  self->p++;
+
+  JSONTapeEntry *array = _get_entry(self, index);
+  array->flags = flags;
+  array->next = _get_num_entries(self);
+  return TRUE;
+}
+
+static gboolean
+_parse_container(JSONTapeParser *self)
+{
+  gboolean success;
+
+  if (++self->depth > JSON_TAPE_MAX_DEPTH)
+    return FALSE;
+
+  if (*self->p == '{')
+    success = _parse_object(self);
+  else
+    success = _parse_array(self);
+
+  self->depth--;
+  return success;
+}
+
+static gboolean
+_parse_value(JSONTapeParser *self)
+{
+  if (self->p >= self->end)
+    return FALSE;
+
+  switch (*self->p)
+    {
+    case '{':
+    case '[':
+      return _parse_container(self);
+    case '"':
+    case '\'':
+      return _parse_string(self);
+    case 't':
+      return _parse_literal(self, "true", 4, JSON_TAPE_TRUE);
+    case 'f':
+      return _parse_literal(self, "false", 5, JSON_TAPE_FALSE);
+    case 'n':
+      return _parse_literal(self, "null", 4, JSON_TAPE_NULL);
+    case '-':
+      return _parse_number(self);
+    default:
+      if (g_ascii_isdigit(*self->p))
+        return _parse_number(self);
+      return FALSE;
+    }
+}
+
+gboolean
+json_tape_parse(JSONTape *self, const gchar *input, gsize input_len)
+{
+  JSONTapeParser parser =
+  {
+    .tape = self,
+    .p = input,
+    .end = input + input_len,
+  };
+
+  if (input_len >= G_MAXUINT32)
+    return FALSE;
+
+  self->input = input;
+  g_string_truncate(self->storage, 0);
+
+  _skip_whitespace(&parser);
+  if (parser.p >= parser.end || (*parser.p != '{' && *parser.p != '['))
+    return FALSE;
+
+  if (!_parse_container(&parser))
+    return FALSE;
+
+  self->entries = self->storage->str;
+  self->num_entries = _get_num_entries(&parser);
+  return TRUE;
+}
+
+/*
+ * Value accessors
+ */
+
+static void
+_append_unescaped(GString *result, const gchar *p, const gchar *end)
+{
+  while (p < end)
+    {
+      const gchar *backslash = memchr(p, '\\', end - p);
+      if (!backslash)
+        {
+          g_string_append_len(result, p, end - p);
+          return;
+        }
+
+      g_string_append_len(result, p, backslash - p);
+      p = backslash;
+
+      gunichar c;
+      switch (p[1])
+        {
+        case 'b':
+          g_string_append_c(result, '\b');
+          break;
+        case 'f':
+          g_string_append_c(result, '\f');
+          break;
+        case 'n':
+          g_string_append_c(result, '\n');
+          break;
+        case 'r':
+          g_string_append_c(result, '\r');
+          break;
+        case 't':
+          g_string_append_c(result, '\t');
+          break;
+        case 'u':
+          /* validated by _parse_escape() */
+          p += _scan_unicode_escape(p, end, &c);
+          g_string_append_unichar(result, c);
+          continue;
+        default:
+          g_string_append_c(result, p[1]);
+          break;
+        }
+      p += 2;
+    }
+}
+
+void
+json_tape_append_string(const JSONTape *self, const JSONTapeEntry *entry, GString *result)
+{
+  const gchar *value = self->input + entry->ofs;
+
+  if (entry->flags & JSON_TAPE_ENTRY_ESCAPED)
+    _append_unescaped(result, value, value + entry->len);
+  else
+    g_string_append_len(result, value, entry->len);
+}
+
+/* numbers are always followed by a terminator character, so the strto*()
+ * functions below stop at the end of the token */
+gint64
+json_tape_get_int64(const JSONTape *self, const JSONTapeEntry *entry)
+{
+  return g_ascii_strtoll(self->input + entry->ofs, NULL, 10);
+}
+
+gdouble
+json_tape_get_double(const JSONTape *self, const JSONTapeEntry *entry)
+{
+  return g_ascii_strtod(self->input + entry->ofs, NULL);
+}
+
+/*
+ * Formatting values the same way as json-parser() does with json-c
+ */
+
+gboolean
+json_tape_format_scalar(const JSONTape *self, const JSONTapeEntry *entry,
+                        GString *value, LogMessageValueType *type)
+{
+  switch (entry->type)
+    {
+    case JSON_TAPE_TRUE:
+      g_string_assign(value, "true");
+      *type = LM_VT_BOOLEAN;
+      return TRUE;
+    case JSON_TAPE_FALSE:
+      g_string_assign(value, "false");
+      *type = LM_VT_BOOLEAN;
+      return TRUE;
+    case JSON_TAPE_DOUBLE:
+      g_string_printf(value, "%f", json_tape_get_double(self, entry));
+      *type = LM_VT_DOUBLE;
+      return TRUE;
+    case JSON_TAPE_INT:
+      g_string_printf(value, "%"PRId64, json_tape_get_int64(self, entry));
+      *type = LM_VT_INTEGER;
+      return TRUE;
+    case JSON_TAPE_STRING:
+      g_string_truncate(value, 0);
+      json_tape_append_string(self, entry, value);
+      *type = LM_VT_STRING;
+      return TRUE;
+    case JSON_TAPE_NULL:
+      /* see json_parser_extract_string_from_simple_json_object() */
+      g_string_truncate(value, 0);
+      *type = LM_VT_NULL;
+      return TRUE;
+    default:
+      break;
+    }
+  return FALSE;
+}
+
+/* the array at @index must have the JSON_TAPE_ENTRY_ONLY_STRINGS flag */
+void
+json_tape_format_string_array(const JSONTape *self, guint32 index, GString *value)
+{
+  JSONTapeEntry array = json_tape_get_entry(self, index);
+  ScratchBuffersMarker marker;
+  GString *element_value = scratch_buffers_alloc_and_mark(&marker);
+
+  g_string_truncate(value, 0);
+  for (guint32 i = index + 1; i < array.next; i++)
+    {
+      JSONTapeEntry el = json_tape_get_entry(self, i);
+
+      g_string_truncate(element_value, 0);
+      json_tape_append_string(self, &el, element_value);
+      if (i != index + 1)
+        g_string_append_c(value, ',');
+      str_repr_encode_append(value, element_value->str, element_value->len, NULL);
+    }
+  scratch_buffers_reclaim_marked(marker);
+}
+
+void
+json_tape_init_from_data(JSONTape *self, const gchar *input, const gchar *entries, guint32 num_entries)
+{
+  self->input = input;
+  self->entries = entries;
+  self->num_entries = num_entries;
+  self->storage = NULL;
+}
+
+void
+json_tape_init(JSONTape *self, GString *storage)
+{
+  self->input = NULL;
+  self->entries = NULL;
+  self->num_entries = 0;
+  self->storage = storage;
+}
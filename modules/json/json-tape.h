@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef JSON_TAPE_H_INCLUDED
+#define JSON_TAPE_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "logmsg/logmsg.h"
+
+#include <string.h>
+
+/*
+ * JSONTape is a flat, DOM-less representation of a JSON document.
+ *
+ * json_tape_parse() validates the input in a single pass and records one
+ * entry for each value (and for each object key) in document order.
+ * Containers know the index of the entry following their last member, so
+ * consumers can walk or skip them without any further allocation.  Values
+ * are not copied: entries point back into the input, which therefore has
+ * to outlive the tape.
+ *
+ * The tape only accepts a strict subset of what json-c accepts and
+ * deliberately fails on anything where the two could disagree (see
+ * json-tape.c for the list), callers are expected to fall back to json-c
+ * in that case.
+ */
+
+typedef enum
+{
+  JSON_TAPE_OBJECT,
+  JSON_TAPE_ARRAY,
+  JSON_TAPE_STRING,
+  JSON_TAPE_INT,
+  JSON_TAPE_DOUBLE,
+  JSON_TAPE_TRUE,
+  JSON_TAPE_FALSE,
+  JSON_TAPE_NULL,
+} JSONTapeEntryType;
+
+/* the string contains escape sequences */
+#define JSON_TAPE_ENTRY_ESCAPED         0x01
+/* the array only has string elements (or no elements at all) */
+#define JSON_TAPE_ENTRY_ONLY_STRINGS    0x02
+/* the container has at least one container member */
+#define JSON_TAPE_ENTRY_HAS_CONTAINERS  0x04
+
+typedef struct _JSONTapeEntry
+{
+  guint8 type;
+  guint8 flags;
+  /* offset and length of the raw token, strings without the quotes */
+  guint32 ofs;
+  guint32 len;
+  /* index of the entry following this value, including its members */
+  guint32 next;
+} JSONTapeEntry;
+
+typedef struct _JSONTape
+{
+  const gchar *input;
+  const gchar *entries;
+  guint32 num_entries;
+  /* the entries are built here by json_tape_parse() */
+  GString *storage;
+} JSONTape;
+
+/* entries are returned by value, as a tape stored in a LogMessage (see
+ * json-lazy-values.c) is not necessarily aligned */
+static inline JSONTapeEntry
+json_tape_get_entry(const JSONTape *self, guint32 index)
+{
+  JSONTapeEntry entry;
+
+  memcpy(&entry, self->entries + index * sizeof(JSONTapeEntry), sizeof(entry));
+  return entry;
+}
+
+static inline guint32
+json_tape_get_num_entries(const JSONTape *self)
+{
+  return self->num_entries;
+}
+
+void json_tape_append_string(const JSONTape *self, const JSONTapeEntry *entry, GString *result);
+gint64 json_tape_get_int64(const JSONTape *self, const JSONTapeEntry *entry);
+gdouble json_tape_get_double(const JSONTape *self, const JSONTapeEntry *entry);
+
+gboolean json_tape_format_scalar(const JSONTape *self, const JSONTapeEntry *entry,
+                                 GString *value, LogMessageValueType *type);
+void json_tape_format_string_array(const JSONTape *self, guint32 index, GString *value);
+
+gboolean json_tape_parse(JSONTape *self, const gchar *input, gsize input_len);
+void json_tape_init(JSONTape *self, GString *storage);
+void json_tape_init_from_data(JSONTape *self, const gchar *input, const gchar *entries, guint32 num_entries);
+
+#endif
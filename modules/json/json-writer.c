@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "json-writer.h"
+#include "utf8utils.h"
+#include "str-format.h"
+
+#include <string.h>
+
+/*
+ * String escaping
+ *
+ * Most of the data we format is printable ASCII that is copied as is, so
+ * we look for characters that need attention 8 bytes at a time and copy
+ * the safe runs in one go.  Control characters, quotes and backslashes are
+ * escaped right here, while NUL characters, utf8 and invalid sequences are
+ * left to append_unsafe_utf8_as_escaped() to keep its exact output.
+ */
+
+#define BYTES_ONES   G_GUINT64_CONSTANT(0x0101010101010101)
+#define BYTES_HIGHS  G_GUINT64_CONSTANT(0x8080808080808080)
+
+static const gchar *control_escapes[32] =
+{
+  NULL, "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+  "\\b", "\\t", "\\n", "\\u000b", "\\f", "\\r", "\\u000e", "\\u000f",
+  "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+  "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+};
+
+static inline guint64
+_block_has_zero_byte(guint64 block)
+{
+  return (block - BYTES_ONES) & ~block;
+}
+
+/* may report false positives, but only in bytes that follow a real one */
+static inline gboolean
+_block_needs_escaping(guint64 block)
+{
+  return (((block - BYTES_ONES * 0x20) |
+          _block_has_zero_byte(block ^ (BYTES_ONES * '"')) |
+          _block_has_zero_byte(block ^ (BYTES_ONES * '\\')) |
+          block) & BYTES_HIGHS) != 0;
+}
+
+static inline gboolean
+_is_safe_char(guchar c)
+{
+  return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+static inline const gchar *
+_skip_safe_chars(const gchar *p, const gchar *end)
+{
+  guint64 block;
+
+  while (end - p >= (gssize) sizeof(block))
+    {
+      memcpy(&block, p, sizeof(block));
+      if (_block_needs_escaping(block))
+        break;
+      p += sizeof(block);
+    }
+
+  while (p < end && _is_safe_char(*p))
+    p++;
+  return p;
+}
+
+void
+json_writer_append_escaped(GString *dest, const gchar *str, gssize str_len)
+{
+  if (str_len < 0)
+    str_len = strlen(str);
+
+  const gchar *end = str + str_len;
+  const gchar *p = str;
+
+  while (p < end)
+    {
+      const gchar *safe_start = p;
+
+      p = _skip_safe_chars(p, end);
+      if (p > safe_start)
+        g_string_append_len(dest, safe_start, p - safe_start);
+      if (p == end)
+        break;
+
+      guchar c = *p;
+      if (c == '"')
+        {
+          g_string_append_len(dest, "\\\"", 2);
+          p++;
+        }
+      else if (c == '\\')
+        {
+          g_string_append_len(dest, "\\\\", 2);
+          p++;
+        }
+      else if (c != 0 && c < 0x20)
+        {
+          g_string_append(dest, control_escapes[c]);
+          p++;
+        }
+      else
+        {
+          /* utf8 sequences never contain ASCII characters, so cutting the
+           * run at the next one does not change how it is decoded */
+          const gchar *run_start = p;
+
+          while (p < end && ((guchar) *p >= 0x80 || *p == 0))
+            p++;
+
+          /* RFC8259 specifies only \uXXXX escaping */
+          append_unsafe_utf8_as_escaped(dest, run_start, p - run_start, "\"", "\\u%04x", "\\\\x%02x");
+        }
+    }
+}
+
+/*
+ * Structure
+ */
+
+static inline void
+_begin_element(JSONWriter *self)
+{
+  if (self->need_comma)
+    g_string_append_c(self->buffer, ',');
+}
+
+static inline void
+_end_element(JSONWriter *self)
+{
+  self->need_comma = TRUE;
+}
+
+void
+json_writer_begin_object(JSONWriter *self)
+{
+  _begin_element(self);
+  g_string_append_c(self->buffer, '{');
+  self->need_comma = FALSE;
+}
+
+void
+json_writer_end_object(JSONWriter *self)
+{
+  g_string_append_c(self->buffer, '}');
+  _end_element(self);
+}
+
+void
+json_writer_begin_array(JSONWriter *self)
+{
+  _begin_element(self);
+  g_string_append_c(self->buffer, '[');
+  self->need_comma = FALSE;
+}
+
+void
+json_writer_end_array(JSONWriter *self)
+{
+  g_string_append_c(self->buffer, ']');
+  _end_element(self);
+}
+
+void
+json_writer_append_key(JSONWriter *self, const gchar *name, gssize name_len)
+{
+  _begin_element(self);
+  g_string_append_c(self->buffer, '"');
+  json_writer_append_escaped(self->buffer, name, name_len);
+  g_string_append_len(self->buffer, "\":", 2);
+
+  /* the value follows without a separator */
+  self->need_comma = FALSE;
+}
+
+/*
+ * Values
+ */
+
+void
+json_writer_append_string(JSONWriter *self, const gchar *value, gssize value_len)
+{
+  _begin_element(self);
+  g_string_append_c(self->buffer, '"');
+  json_writer_append_escaped(self->buffer, value, value_len);
+  g_string_append_c(self->buffer, '"');
+  _end_element(self);
+}
+
+void
+json_writer_append_literal(JSONWriter *self, const gchar *value, gssize value_len)
+{
+  _begin_element(self);
+  g_string_append_len(self->buffer, value, value_len);
+  _end_element(self);
+}
+
+void
+json_writer_append_int(JSONWriter *self, gint64 value)
+{
+  _begin_element(self);
+  format_int64_padded(self->buffer, 0, 0, 10, value);
+  _end_element(self);
+}
+
+void
+json_writer_append_double(JSONWriter *self, gdouble value)
+{
+  _begin_element(self);
+
+  gsize init_len = self->buffer->len;
+  g_string_set_size(self->buffer, init_len + G_ASCII_DTOSTR_BUF_SIZE);
+  g_ascii_dtostr(self->buffer->str + init_len, G_ASCII_DTOSTR_BUF_SIZE, value);
+  g_string_set_size(self->buffer, init_len + strlen(self->buffer->str + init_len));
+
+  _end_element(self);
+}
+
+void
+json_writer_append_boolean(JSONWriter *self, gboolean value)
+{
+  if (value)
+    json_writer_append_literal(self, "true", 4);
+  else
+    json_writer_append_literal(self, "false", 5);
+}
+
+void
+json_writer_append_null(JSONWriter *self)
+{
+  json_writer_append_literal(self, "null", 4);
+}
+
+static inline gsize
+_get_base64_encoded_size(gsize len)
+{
+  return (len / 3 + 1) * 4 + 4;
+}
+
+void
+json_writer_append_base64(JSONWriter *self, const gchar *value, gsize value_len)
+{
+  GString *buffer = self->buffer;
+
+  _begin_element(self);
+  g_string_append_c(buffer, '"');
+
+  gint encode_state = 0;
+  gint encode_save = 0;
+  gsize init_len = buffer->len;
+
+  /* expand the buffer and add space for the base64 encoded string */
+  g_string_set_size(buffer, init_len + _get_base64_encoded_size(value_len));
+  gsize out_len = g_base64_encode_step((const guchar *) value, value_len, FALSE, buffer->str + init_len,
+                                       &encode_state, &encode_save);
+  g_string_set_size(buffer, init_len + out_len + _get_base64_encoded_size(0));
+
+#if !GLIB_CHECK_VERSION(2, 54, 0)
+  /* See modules/basicfuncs/str-funcs.c: tf_base64encode() */
+  if (((unsigned char *) &encode_save)[0] == 1)
+    ((unsigned char *) &encode_save)[2] = 0;
+#endif
+
+  out_len += g_base64_encode_close(FALSE, buffer->str + init_len + out_len, &encode_state, &encode_save);
+  g_string_set_size(buffer, init_len + out_len);
+
+  g_string_append_c(buffer, '"');
+  _end_element(self);
+}
+
+/* Makes sure that @len more bytes can be appended without reallocation. */
+void
+json_writer_reserve(JSONWriter *self, gsize len)
+{
+  gsize init_len = self->buffer->len;
+
+  if (self->buffer->allocated_len > init_len + len)
+    return;
+
+  g_string_set_size(self->buffer, init_len + len);
+  g_string_truncate(self->buffer, init_len);
+}
+
+void
+json_writer_init(JSONWriter *self, GString *buffer)
+{
+  self->buffer = buffer;
+  self->need_comma = FALSE;
+}
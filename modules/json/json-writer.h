@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef JSON_WRITER_H_INCLUDED
+#define JSON_WRITER_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * JSONWriter produces a compact JSON document into a GString, element by
+ * element, without building any intermediate representation.  It keeps
+ * track of the separators, the caller only has to emit keys and values in
+ * order.  Both $(format-json) and the format_json() FilterX function use
+ * it, so their output follows the same rules:
+ *
+ *   - strings are escaped as per append_unsafe_utf8_as_escaped() with
+ *     \uXXXX for control characters and \\xXX for invalid utf8 sequences
+ *   - bytes are base64 encoded
+ *   - numbers are emitted without a '+' sign or leading zeros (RFC8259)
+ */
+typedef struct _JSONWriter
+{
+  GString *buffer;
+  gboolean need_comma;
+} JSONWriter;
+
+void json_writer_init(JSONWriter *self, GString *buffer);
+void json_writer_reserve(JSONWriter *self, gsize len);
+
+void json_writer_begin_object(JSONWriter *self);
+void json_writer_end_object(JSONWriter *self);
+void json_writer_begin_array(JSONWriter *self);
+void json_writer_end_array(JSONWriter *self);
+void json_writer_append_key(JSONWriter *self, const gchar *name, gssize name_len);
+
+void json_writer_append_string(JSONWriter *self, const gchar *value, gssize value_len);
+void json_writer_append_literal(JSONWriter *self, const gchar *value, gssize value_len);
+void json_writer_append_int(JSONWriter *self, gint64 value);
+void json_writer_append_double(JSONWriter *self, gdouble value);
+void json_writer_append_boolean(JSONWriter *self, gboolean value);
+void json_writer_append_null(JSONWriter *self);
+void json_writer_append_base64(JSONWriter *self, const gchar *value, gsize value_len);
+
+void json_writer_append_escaped(GString *dest, const gchar *str, gssize str_len);
+
+#endif
@@ -25,6 +25,7 @@
 
 #include "json-parser.h"
 #include "apphook.h"
+#include "cfg.h"
 
 static LogMessage *
 parse_json_into_log_message_no_check(const gchar *json, LogParser *json_parser)
@@ -66,6 +67,57 @@ assert_json_parser_fails(const gchar *json, LogParser *json_parser)
   cr_assert_null(msg, "expected json-parser failure and it returned success, json=%s", json);
 }
 
+static LogMessage *
+parse_json_lazily_into_log_message(LogMessage *msg, const gchar *json, const gchar *prefix)
+{
+  GlobalConfig *cfg = cfg_new_snippet();
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogParser *json_parser = json_parser_new(cfg);
+
+  json_parser_set_prefix(json_parser, prefix);
+  json_parser_set_lazy(json_parser, TRUE);
+  cr_assert(log_pipe_init(&json_parser->super));
+
+  log_msg_set_value(msg, LM_V_MESSAGE, json, -1);
+  cr_assert(log_parser_process_message(json_parser, &msg, &path_options),
+            "expected json-parser success and it returned failure, json=%s", json);
+
+  log_pipe_deinit(&json_parser->super);
+  log_pipe_unref(&json_parser->super);
+  cfg_free(cfg);
+  return msg;
+}
+
+static gboolean
+_append_name_value(NVHandle handle, const gchar *name, const gchar *value, gssize value_len,
+                   LogMessageValueType type, gpointer user_data)
+{
+  GPtrArray *result = (GPtrArray *) user_data;
+
+  g_ptr_array_add(result, g_strdup_printf("%s=%.*s", name, (gint) value_len, value));
+  return FALSE;
+}
+
+static gint
+_compare_strings(gconstpointer a, gconstpointer b)
+{
+  return strcmp(*(const gchar **) a, *(const gchar **) b);
+}
+
+static gchar *
+format_sorted_values(LogMessage *msg)
+{
+  GPtrArray *values = g_ptr_array_new_with_free_func(g_free);
+
+  log_msg_values_foreach(msg, _append_name_value, values);
+  g_ptr_array_sort(values, _compare_strings);
+  g_ptr_array_add(values, NULL);
+
+  gchar *result = g_strjoinv(";", (gchar **) values->pdata);
+  g_ptr_array_free(values, TRUE);
+  return result;
+}
+
 void setup(void)
 {
   app_startup();
@@ -283,3 +335,121 @@ Test(json_parser, test_json_parser_works_with_templates)
   log_msg_unref(msg);
   log_pipe_unref(&json_parser->super);
 }
+
+Test(json_parser, test_json_parser_decodes_escape_sequences)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  msg = parse_json_into_log_message("{\"escaped\": \"line1\\nline2 \\\"quoted\\\" \\u00e1 \\ud83d\\ude00\","
+                                    " \"esc\\u0061ped_key\": \"value\","
+                                    " \"array\": [\"a b\", \"c\"]}",
+                                    json_parser);
+  assert_log_message_value_and_type_by_name(msg, "escaped", "line1\nline2 \"quoted\" á \xf0\x9f\x98\x80", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, "escaped_key", "value", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, "array", "\"a b\",c", LM_VT_LIST);
+  log_msg_unref(msg);
+  log_pipe_unref(&json_parser->super);
+}
+
+Test(json_parser, test_json_parser_keeps_the_last_value_of_duplicate_keys)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  msg = parse_json_into_log_message("{\"a\": 1, \"b\": 2, \"a\": 3, \"obj\": {\"x\": 1}, \"obj\": {\"y\": 2}}", json_parser);
+  assert_log_message_value_and_type_by_name(msg, "a", "3", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, "b", "2", LM_VT_INTEGER);
+  assert_log_message_value_unset_by_name(msg, "obj.x");
+  assert_log_message_value_and_type_by_name(msg, "obj.y", "2", LM_VT_INTEGER);
+  log_msg_unref(msg);
+  log_pipe_unref(&json_parser->super);
+}
+
+Test(json_parser, test_json_parser_extracts_top_level_scalar_array_elements_into_matches)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  msg = parse_json_into_log_message("[\"foo\", 42, 1.5, false, null]", json_parser);
+  assert_log_message_value_and_type_by_name(msg, "1", "foo", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, "2", "42", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, "3", "1.500000", LM_VT_DOUBLE);
+  assert_log_message_value_and_type_by_name(msg, "4", "false", LM_VT_BOOLEAN);
+  assert_log_message_value_and_type_by_name(msg, "5", "", LM_VT_NULL);
+  cr_assert(msg->num_matches == 6);
+  log_msg_unref(msg);
+  log_pipe_unref(&json_parser->super);
+}
+
+Test(json_parser, test_json_parser_falls_back_to_json_c_when_needed)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  msg = parse_json_into_log_message("{\"bigint\": 1234567890123456789, \"intarray\": [1, 2]}", json_parser);
+  assert_log_message_value_and_type_by_name(msg, "bigint", "1234567890123456789", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, "intarray", "[1,2]", LM_VT_JSON);
+  log_msg_unref(msg);
+  log_pipe_unref(&json_parser->super);
+}
+
+Test(json_parser, test_json_parser_lazy_values_are_resolved_on_access)
+{
+  LogMessage *msg = parse_json_lazily_into_log_message(log_msg_new_empty(),
+                                                       "{\"str\": \"foo\", \"esc\": \"a\\nb\","
+                                                       " \"obj\": {\"dbl\": 1.5, \"int\": 42, \"nested\": {\"t\": true}},"
+                                                       " \"array\": [\"a b\", \"c\"], \"null\": null}",
+                                                       ".json.");
+
+  cr_assert(msg->flags & LF_LAZY_VALUES);
+  assert_log_message_value_and_type_by_name(msg, ".json.str", "foo", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, ".json.esc", "a\nb", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, ".json.obj.dbl", "1.500000", LM_VT_DOUBLE);
+  assert_log_message_value_and_type_by_name(msg, ".json.obj.int", "42", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, ".json.obj.nested.t", "true", LM_VT_BOOLEAN);
+  assert_log_message_value_and_type_by_name(msg, ".json.array", "\"a b\",c", LM_VT_LIST);
+  assert_log_message_value_and_type_by_name(msg, ".json.null", "", LM_VT_NULL);
+  assert_log_message_value_unset_by_name(msg, ".json.obj");
+  assert_log_message_value_unset_by_name(msg, ".json.nonexistent");
+  assert_log_message_value_unset_by_name(msg, "str");
+  log_msg_unref(msg);
+}
+
+Test(json_parser, test_json_parser_lazy_values_overwrite_existing_values)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  log_msg_set_value_by_name(msg, "overwritten", "old", -1);
+  log_msg_set_value_by_name(msg, "kept", "old", -1);
+  log_msg_unset_value_by_name(msg, "unset");
+
+  msg = parse_json_lazily_into_log_message(msg, "{\"overwritten\": \"new\", \"unset\": \"new\", \"other\": 1}", NULL);
+  assert_log_message_value_by_name(msg, "overwritten", "new");
+  assert_log_message_value_by_name(msg, "unset", "new");
+  assert_log_message_value_by_name(msg, "kept", "old");
+
+  log_msg_set_value_by_name(msg, "other", "set-after-parsing", -1);
+  assert_log_message_value_by_name(msg, "other", "set-after-parsing");
+  log_msg_unref(msg);
+}
+
+Test(json_parser, test_json_parser_lazy_values_are_enumerated_like_extracted_ones)
+{
+  const gchar *json = "{\"a\": 1, \"b\": {\"c\": \"x\", \"d\": [\"y\"]}, \"a\": 2, \"b.c\": \"z\", \"e\\u0066\": {}}";
+  LogParser *json_parser = json_parser_new(NULL);
+  LogMessage *eager = parse_json_into_log_message(json, json_parser);
+  LogMessage *lazy = parse_json_lazily_into_log_message(log_msg_new_empty(), json, NULL);
+
+  gchar *expected = format_sorted_values(eager);
+  gchar *actual = format_sorted_values(lazy);
+  cr_assert_str_eq(actual, expected);
+  cr_assert_str_eq(actual, "MESSAGE=" "{\"a\": 1, \"b\": {\"c\": \"x\", \"d\": [\"y\"]}, \"a\": 2, \"b.c\": \"z\", \"e\\u0066\": {}}"
+                   ";a=2;b.c=z;b.d=y");
+
+  g_free(expected);
+  g_free(actual);
+  log_msg_unref(eager);
+  log_msg_unref(lazy);
+  log_pipe_unref(&json_parser->super);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+
+#include "json-tape.h"
+
+static GString *storage;
+
+static void
+_assert_tape_parse_fails(const gchar *json)
+{
+  JSONTape tape;
+
+  json_tape_init(&tape, storage);
+  cr_assert_not(json_tape_parse(&tape, json, strlen(json)), "expected tape parsing to fail, json=%s", json);
+}
+
+static void
+_parse(JSONTape *tape, const gchar *json)
+{
+  json_tape_init(tape, storage);
+  cr_assert(json_tape_parse(tape, json, strlen(json)), "expected tape parsing to succeed, json=%s", json);
+}
+
+static void
+_assert_string_entry(JSONTape *tape, guint32 index, const gchar *expected)
+{
+  JSONTapeEntry entry = json_tape_get_entry(tape, index);
+  GString *value = g_string_new("");
+
+  cr_assert_eq(entry.type, JSON_TAPE_STRING);
+  json_tape_append_string(tape, &entry, value);
+  cr_assert_str_eq(value->str, expected);
+  g_string_free(value, TRUE);
+}
+
+Test(json_tape, test_entries_are_recorded_in_document_order)
+{
+  JSONTape tape;
+
+  _parse(&tape, "{\"a\": {\"b\": 1, \"c\": -1.5e3}, \"d\": [\"x\", \"y\"], \"e\": true, \"f\": false, \"g\": null}");
+
+  cr_assert_eq(json_tape_get_num_entries(&tape), 17);
+  cr_assert_eq(json_tape_get_entry(&tape, 0).type, JSON_TAPE_OBJECT);
+  cr_assert_eq(json_tape_get_entry(&tape, 0).next, 17);
+  cr_assert(json_tape_get_entry(&tape, 0).flags & JSON_TAPE_ENTRY_HAS_CONTAINERS);
+
+  _assert_string_entry(&tape, 1, "a");
+  cr_assert_eq(json_tape_get_entry(&tape, 2).type, JSON_TAPE_OBJECT);
+  cr_assert_eq(json_tape_get_entry(&tape, 2).next, 7);
+  _assert_string_entry(&tape, 3, "b");
+  cr_assert_eq(json_tape_get_entry(&tape, 4).type, JSON_TAPE_INT);
+  JSONTapeEntry entry = json_tape_get_entry(&tape, 4);
+  cr_assert_eq(json_tape_get_int64(&tape, &entry), 1);
+  _assert_string_entry(&tape, 5, "c");
+  cr_assert_eq(json_tape_get_entry(&tape, 6).type, JSON_TAPE_DOUBLE);
+  entry = json_tape_get_entry(&tape, 6);
+  cr_assert_float_eq(json_tape_get_double(&tape, &entry), -1500.0, 1e-9);
+
+  _assert_string_entry(&tape, 7, "d");
+  cr_assert_eq(json_tape_get_entry(&tape, 8).type, JSON_TAPE_ARRAY);
+  cr_assert_eq(json_tape_get_entry(&tape, 8).next, 11);
+  cr_assert(json_tape_get_entry(&tape, 8).flags & JSON_TAPE_ENTRY_ONLY_STRINGS);
+  _assert_string_entry(&tape, 9, "x");
+  _assert_string_entry(&tape, 10, "y");
+
+  cr_assert_eq(json_tape_get_entry(&tape, 12).type, JSON_TAPE_TRUE);
+  cr_assert_eq(json_tape_get_entry(&tape, 14).type, JSON_TAPE_FALSE);
+  cr_assert_eq(json_tape_get_entry(&tape, 16).type, JSON_TAPE_NULL);
+}
+
+Test(json_tape, test_escape_sequences_are_decoded)
+{
+  JSONTape tape;
+
+  _parse(&tape, "[\"plain\", \"\\\"q\\\\\\/\\b\\f\\n\\r\\t\", \"\\u00e1rv\\u00edzt\\u0171r\\u0151\", \"\\ud83d\\ude00\", 'single \"quoted\"']");
+
+  cr_assert_not(json_tape_get_entry(&tape, 1).flags & JSON_TAPE_ENTRY_ESCAPED);
+  _assert_string_entry(&tape, 1, "plain");
+  cr_assert(json_tape_get_entry(&tape, 2).flags & JSON_TAPE_ENTRY_ESCAPED);
+  _assert_string_entry(&tape, 2, "\"q\\/\b\f\n\r\t");
+  _assert_string_entry(&tape, 3, "árvíztűrő");
+  _assert_string_entry(&tape, 4, "\xf0\x9f\x98\x80");
+  _assert_string_entry(&tape, 5, "single \"quoted\"");
+}
+
+Test(json_tape, test_content_after_the_root_value_is_ignored)
+{
+  JSONTape tape;
+
+  _parse(&tape, "  {\"a\": \"b\"} trailing garbage");
+  cr_assert_eq(json_tape_get_num_entries(&tape), 3);
+}
+
+Test(json_tape, test_inputs_json_c_might_interpret_differently_are_refused)
+{
+  _assert_tape_parse_fails("");
+  _assert_tape_parse_fails("\"string\"");
+  _assert_tape_parse_fails("42");
+  _assert_tape_parse_fails("{\"a\": 1,}");
+  _assert_tape_parse_fails("{\"a\": True}");
+  _assert_tape_parse_fails("{\"a\": 01}");
+  _assert_tape_parse_fails("{\"a\": 1.}");
+  _assert_tape_parse_fails("{\"a\": 1 /* comment */}");
+  _assert_tape_parse_fails("{\"a\": 12345678901234567890}");
+  _assert_tape_parse_fails("{\"a\": \"\\u0000\"}");
+  _assert_tape_parse_fails("{\"a\": \"\\ud83d\"}");
+  _assert_tape_parse_fails("{\"a\": \"\\ude00\"}");
+  _assert_tape_parse_fails("{\"a\": \"\\x41\"}");
+  _assert_tape_parse_fails("{\"a\": \"raw\nnewline\"}");
+  _assert_tape_parse_fails("{\"a\": \"unterminated}");
+  _assert_tape_parse_fails("{\"a\": {\"b\": 1}, \"a\": 2}");
+  _assert_tape_parse_fails("[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]");
+}
+
+Test(json_tape, test_duplicate_scalar_keys_are_accepted)
+{
+  JSONTape tape;
+
+  _parse(&tape, "{\"a\": 1, \"b\": {}, \"a\": 2}");
+}
+
+static void
+setup(void)
+{
+  storage = g_string_new("");
+}
+
+static void
+teardown(void)
+{
+  g_string_free(storage, TRUE);
+}
+
+TestSuite(json_tape, .init = setup, .fini = teardown);
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+
+#include "json-writer.h"
+#include "utf8utils.h"
+
+static void
+_assert_escaped_like_utf8utils(const gchar *str, gssize str_len)
+{
+  GString *expected = g_string_new("");
+  GString *escaped = g_string_new("");
+
+  append_unsafe_utf8_as_escaped(expected, str, str_len, "\"", "\\u%04x", "\\\\x%02x");
+  json_writer_append_escaped(escaped, str, str_len);
+  cr_assert_eq(escaped->len, expected->len, "escaped length mismatch, expected=%s, actual=%s",
+               expected->str, escaped->str);
+  cr_assert_arr_eq(escaped->str, expected->str, expected->len);
+
+  g_string_free(expected, TRUE);
+  g_string_free(escaped, TRUE);
+}
+
+Test(json_writer, test_escaping_is_identical_to_append_unsafe_utf8_as_escaped)
+{
+  const gchar *inputs[] =
+  {
+    "",
+    "plain ascii text that is longer than a single block",
+    "\"quoted\" and \\backslashed\\",
+    "\b\f\n\r\t\x01\x1f\x7f",
+    "line1\nline2\nline3 with a much longer tail after the newline",
+    "árvíztűrőtükörfúrógép",
+    "\xc2\xbf \xc2\xb6 \xc2\xa9 \xc2\xb1",
+    "invalid \xad\xc3 utf8 \xf0\x9f sequences",
+    "truncated at the end \xe2\x82",
+    "12345678\"12345678\\1234567\n",
+    NULL
+  };
+
+  for (gint i = 0; inputs[i]; i++)
+    {
+      _assert_escaped_like_utf8utils(inputs[i], -1);
+      _assert_escaped_like_utf8utils(inputs[i], strlen(inputs[i]));
+    }
+
+  _assert_escaped_like_utf8utils("embedded\0nul character", 22);
+  _assert_escaped_like_utf8utils("\xc3\0", 2);
+}
+
+Test(json_writer, test_structure_is_separated_properly)
+{
+  GString *result = g_string_new("");
+  JSONWriter writer;
+
+  json_writer_init(&writer, result);
+  json_writer_begin_object(&writer);
+  json_writer_append_key(&writer, "str", -1);
+  json_writer_append_string(&writer, "foo\"bar", -1);
+  json_writer_append_key(&writer, "obj", -1);
+  json_writer_begin_object(&writer);
+  json_writer_end_object(&writer);
+  json_writer_append_key(&writer, "list", 4);
+  json_writer_begin_array(&writer);
+  json_writer_append_int(&writer, G_MININT64);
+  json_writer_append_double(&writer, 1.5);
+  json_writer_append_boolean(&writer, FALSE);
+  json_writer_append_null(&writer);
+  json_writer_begin_array(&writer);
+  json_writer_end_array(&writer);
+  json_writer_append_literal(&writer, "{\"a\":1}", -1);
+  json_writer_end_array(&writer);
+  json_writer_append_key(&writer, "bytes", -1);
+  json_writer_append_base64(&writer, "\4\5\6\7", 4);
+  json_writer_end_object(&writer);
+
+  cr_assert_str_eq(result->str,
+                   "{\"str\":\"foo\\\"bar\",\"obj\":{},"
+                   "\"list\":[-9223372036854775808,1.5,false,null,[],{\"a\":1}],"
+                   "\"bytes\":\"BAUGBw==\"}");
+  g_string_free(result, TRUE);
+}
+
+Test(json_writer, test_reserve_keeps_the_contents)
+{
+  GString *result = g_string_new("prefix");
+  JSONWriter writer;
+
+  json_writer_init(&writer, result);
+  json_writer_reserve(&writer, 4096);
+  cr_assert_geq(result->allocated_len, 4096 + 6);
+  cr_assert_str_eq(result->str, "prefix");
+
+  json_writer_append_int(&writer, 42);
+  cr_assert_str_eq(result->str, "prefix42");
+  g_string_free(result, TRUE);
+}
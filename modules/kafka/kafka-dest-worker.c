@@ -241,6 +241,108 @@ _publish_message(KafkaDestWorker *self, LogMessage *msg)
   return TRUE;
 }
 
+/*
+ * Batched produce: formatted messages are collected per topic and submitted
+ * using a single rd_kafka_produce_batch() call at flush time.  Payload
+ * ownership is transferred to librdkafka (RD_KAFKA_MSG_F_FREE), keys are
+ * copied by librdkafka, so we only keep those until the batch is submitted.
+ */
+
+static void
+_release_batch_entries(GArray *batch)
+{
+  for (guint i = 0; i < batch->len; i++)
+    {
+      rd_kafka_message_t *rkmessage = &g_array_index(batch, rd_kafka_message_t, i);
+
+      g_free(rkmessage->key);
+      g_free(rkmessage->payload);
+    }
+  g_array_set_size(batch, 0);
+}
+
+static void
+_free_batch(GArray *batch)
+{
+  _release_batch_entries(batch);
+  g_array_free(batch, TRUE);
+}
+
+static GArray *
+_lookup_batch(KafkaDestWorker *self, rd_kafka_topic_t *topic)
+{
+  KafkaDestDriver *owner = (KafkaDestDriver *) self->super.owner;
+  GArray *batch = g_hash_table_lookup(self->batches, topic);
+
+  if (!batch)
+    {
+      batch = g_array_sized_new(FALSE, TRUE, sizeof(rd_kafka_message_t), owner->super.batch_lines);
+      g_hash_table_insert(self->batches, topic, batch);
+    }
+  return batch;
+}
+
+static void
+_add_message_to_batch(KafkaDestWorker *self, LogMessage *msg)
+{
+  rd_kafka_topic_t *topic = kafka_dest_worker_calculate_topic(self, msg);
+  GArray *batch = _lookup_batch(self, topic);
+  rd_kafka_message_t rkmessage = { 0 };
+
+  rkmessage.len = self->message->len;
+  rkmessage.payload = g_string_steal(self->message);
+  if (self->key->len)
+    {
+      rkmessage.key_len = self->key->len;
+      rkmessage.key = g_strndup(self->key->str, self->key->len);
+    }
+  g_array_append_val(batch, rkmessage);
+}
+
+static gboolean
+_produce_batch(KafkaDestWorker *self, rd_kafka_topic_t *topic, GArray *batch)
+{
+  KafkaDestDriver *owner = (KafkaDestDriver *) self->super.owner;
+  rd_kafka_message_t *rkmessages = (rd_kafka_message_t *) batch->data;
+  gint batch_len = batch->len;
+  rd_kafka_resp_err_t first_error = RD_KAFKA_RESP_ERR_NO_ERROR;
+
+  gint accepted = rd_kafka_produce_batch(topic, RD_KAFKA_PARTITION_UA, RD_KAFKA_MSG_F_FREE, rkmessages, batch_len);
+
+  for (gint i = 0; i < batch_len; i++)
+    {
+      if (rkmessages[i].err == RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+          /* librdkafka owns the payload from now on */
+          rkmessages[i].payload = NULL;
+        }
+      else if (first_error == RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+          first_error = rkmessages[i].err;
+        }
+    }
+  _release_batch_entries(batch);
+
+  if (accepted != batch_len)
+    {
+      msg_error("kafka: failed to publish message batch",
+                evt_tag_str("topic", rd_kafka_topic_name(topic)),
+                evt_tag_int("batch_size", batch_len),
+                evt_tag_int("accepted", accepted),
+                evt_tag_str("error", rd_kafka_err2str(first_error)),
+                evt_tag_str("driver", owner->super.super.super.id),
+                log_pipe_location_tag(&owner->super.super.super.super));
+      return FALSE;
+    }
+
+  msg_debug("kafka: message batch published",
+            evt_tag_str("topic", rd_kafka_topic_name(topic)),
+            evt_tag_int("batch_size", batch_len),
+            evt_tag_str("driver", owner->super.super.super.id),
+            log_pipe_location_tag(&owner->super.super.super.super));
+  return TRUE;
+}
+
 static void
 _update_drain_timer(KafkaDestWorker *self)
 {
@@ -299,6 +401,42 @@ kafka_dest_worker_insert(LogThreadedDestWorker *s, LogMessage *msg)
   return LTR_SUCCESS;
 }
 
+static LogThreadedResult
+kafka_dest_worker_batch_insert(LogThreadedDestWorker *s, LogMessage *msg)
+{
+  KafkaDestWorker *self = (KafkaDestWorker *)s;
+
+  _format_message_and_key(self, msg);
+  _add_message_to_batch(self, msg);
+
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+kafka_dest_worker_batch_flush(LogThreadedDestWorker *s, LogThreadedFlushMode expedite)
+{
+  KafkaDestWorker *self = (KafkaDestWorker *)s;
+  gboolean success = TRUE;
+  GHashTableIter iter;
+  gpointer topic, batch;
+
+  g_hash_table_iter_init(&iter, self->batches);
+  while (g_hash_table_iter_next(&iter, &topic, &batch))
+    {
+      if (((GArray *) batch)->len == 0)
+        continue;
+
+      /* rejected messages (e.g. a full librdkafka queue) cause the whole
+       * batch to be retried, the ones already accepted may be delivered
+       * twice, in line with our at-least-once semantics */
+      if (!_produce_batch(self, (rd_kafka_topic_t *) topic, (GArray *) batch))
+        success = FALSE;
+    }
+
+  _drain_responses(self);
+  return success ? LTR_SUCCESS : LTR_RETRY;
+}
+
 static LogThreadedResult
 kafka_dest_worker_transactional_insert(LogThreadedDestWorker *s, LogMessage *msg)
 {
@@ -370,6 +508,7 @@ kafka_dest_worker_free(LogThreadedDestWorker *s)
   g_string_free(self->key, TRUE);
   g_string_free(self->message, TRUE);
   g_string_free(self->topic_name_buffer, TRUE);
+  g_hash_table_unref(self->batches);
   log_threaded_dest_worker_free_method(s);
 }
 
@@ -436,6 +575,11 @@ _set_methods(KafkaDestWorker *self)
           self->super.insert = kafka_dest_worker_transactional_insert;
         }
     }
+  else if (owner->super.batch_lines > 0)
+    {
+      self->super.insert = kafka_dest_worker_batch_insert;
+      self->super.flush = kafka_dest_worker_batch_flush;
+    }
   else
     {
       self->super.insert = kafka_dest_worker_insert;
@@ -458,6 +602,7 @@ kafka_dest_worker_new(LogThreadedDestDriver *o, gint worker_index)
   self->key = g_string_sized_new(0);
   self->message = g_string_sized_new(1024);
   self->topic_name_buffer = g_string_sized_new(256);
+  self->batches = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) _free_batch);
 
   return &self->super;
 }
@@ -34,6 +34,10 @@ typedef struct _KafkaDestWorker
   GString *key;
   GString *message;
   GString *topic_name_buffer;
+
+  /* rd_kafka_topic_t -> GArray of rd_kafka_message_t, used by the batched
+   * (non-transactional) produce path */
+  GHashTable *batches;
 } KafkaDestWorker;
 
 LogThreadedDestWorker *kafka_dest_worker_new(LogThreadedDestDriver *owner, gint worker_index);
@@ -35,5 +35,9 @@ rd_kafka_topic_t *kafka_dest_worker_get_literal_topic(KafkaDestWorker *self);
 rd_kafka_topic_t *kafka_dest_worker_calculate_topic(KafkaDestWorker *self, LogMessage *msg);
 gboolean kafka_dd_init(LogPipe *s);
 
+void kafka_log_callback(const rd_kafka_t *rkt, int level, const char *fac, const char *msg);
+gboolean kafka_conf_set_prop(rd_kafka_conf_t *conf, const gchar *name, const gchar *value);
+gboolean kafka_apply_config_props(rd_kafka_conf_t *conf, GList *props, const gchar **protected_properties);
+
 #endif
 
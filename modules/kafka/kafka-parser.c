@@ -44,6 +44,8 @@ static CfgLexerKeyword kafka_keywords[] =
   { "sync_send",      KW_SYNC_SEND},
   { "bootstrap_servers", KW_BOOTSTRAP_SERVERS },
   { "poll_timeout",   KW_POLL_TIMEOUT },
+  { "group_id",       KW_GROUP_ID },
+  { "fetch_limit",    KW_FETCH_LIMIT },
   { "kafka_c",        KW_KAFKA },   /* compatibility with incubator naming */
   { NULL }
 };
@@ -35,6 +35,11 @@ static Plugin kafka_plugins[] =
     .name = "kafka_c",
     .parser = &kafka_parser,
   },
+  {
+    .type = LL_CONTEXT_SOURCE,
+    .name = "kafka_c",
+    .parser = &kafka_parser,
+  },
 };
 
 gboolean
@@ -48,7 +53,7 @@ const ModuleInfo module_info =
 {
   .canonical_name = "kafka",
   .version = SYSLOG_NG_VERSION,
-  .description = "The kafka module provides native librdkafka based Kafka support for syslog-ng.",
+  .description = "The kafka module provides native librdkafka based Kafka source and destination support for syslog-ng.",
   .core_revision = SYSLOG_NG_SOURCE_REVISION,
   .plugins = kafka_plugins,
   .plugins_len = G_N_ELEMENTS(kafka_plugins),
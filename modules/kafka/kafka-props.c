@@ -23,9 +23,11 @@
  *
  */
 #include "kafka-props.h"
+#include "kafka-internal.h"
 #include "messages.h"
 #include "str-utils.h"
 #include <stdio.h>
+#include <string.h>
 #include <stdlib.h>
 
 KafkaProperty *
@@ -53,3 +55,60 @@ kafka_property_list_free(GList *l)
 
   g_list_free(l);
 }
+
+void
+kafka_log_callback(const rd_kafka_t *rkt, int level, const char *fac, const char *msg)
+{
+  gchar *buf = g_strdup_printf("librdkafka: %s(%d): %s", fac, level, msg);
+  msg_event_send(msg_event_create(level, buf, NULL));
+  g_free(buf);
+}
+
+gboolean
+kafka_conf_set_prop(rd_kafka_conf_t *conf, const gchar *name, const gchar *value)
+{
+  gchar errbuf[1024];
+
+  msg_debug("kafka: setting librdkafka config property",
+            evt_tag_str("name", name),
+            evt_tag_str("value", value));
+  if (rd_kafka_conf_set(conf, name, value, errbuf, sizeof(errbuf)) < 0)
+    {
+      msg_error("kafka: error setting librdkafka config property",
+                evt_tag_str("name", name),
+                evt_tag_str("value", value),
+                evt_tag_str("error", errbuf));
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+_is_property_protected(const gchar *property_name, const gchar **protected_properties)
+{
+  for (gint i = 0; protected_properties[i]; i++)
+    {
+      if (strcmp(property_name, protected_properties[i]) == 0)
+        {
+          msg_warning("kafka: protected config properties cannot be overridden",
+                      evt_tag_str("name", property_name));
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+gboolean
+kafka_apply_config_props(rd_kafka_conf_t *conf, GList *props, const gchar **protected_properties)
+{
+  GList *ll;
+
+  for (ll = props; ll != NULL; ll = g_list_next(ll))
+    {
+      KafkaProperty *kp = ll->data;
+      if (!_is_property_protected(kp->name, protected_properties))
+        if (!kafka_conf_set_prop(conf, kp->name, kp->value))
+          return FALSE;
+    }
+  return TRUE;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "kafka-source-driver.h"
+#include "kafka-source-worker.h"
+#include "kafka-props.h"
+#include "kafka-internal.h"
+#include "ack-tracker/ack_tracker_factory.h"
+#include "string-list.h"
+
+/*
+ * Configuration
+ */
+
+void
+kafka_sd_set_topics(LogDriver *d, GList *topics)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  string_list_free(self->topics);
+  self->topics = topics;
+}
+
+void
+kafka_sd_merge_config(LogDriver *d, GList *props)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  self->config = g_list_concat(self->config, props);
+}
+
+void
+kafka_sd_set_bootstrap_servers(LogDriver *d, const gchar *bootstrap_servers)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  g_free(self->bootstrap_servers);
+  self->bootstrap_servers = g_strdup(bootstrap_servers);
+}
+
+void
+kafka_sd_set_group_id(LogDriver *d, const gchar *group_id)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  g_free(self->group_id);
+  self->group_id = g_strdup(group_id);
+}
+
+void
+kafka_sd_set_fetch_limit(LogDriver *d, gint fetch_limit)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  self->fetch_limit = fetch_limit;
+}
+
+void
+kafka_sd_set_poll_timeout(LogDriver *d, gint poll_timeout)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)d;
+
+  self->poll_timeout = poll_timeout;
+}
+
+/* methods */
+
+static gchar *
+_join_topics(GList *topics)
+{
+  GString *joined = g_string_new("");
+
+  for (GList *l = topics; l; l = l->next)
+    {
+      if (joined->len)
+        g_string_append_c(joined, ',');
+      g_string_append(joined, (const gchar *) l->data);
+    }
+  return g_string_free(joined, FALSE);
+}
+
+static void
+_format_stats_key(LogThreadedSourceDriver *s, StatsClusterKeyBuilder *kb)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)s;
+  gchar *topics = _join_topics(self->topics);
+
+  stats_cluster_key_builder_add_legacy_label(kb, stats_cluster_label("driver", "kafka"));
+  stats_cluster_key_builder_add_legacy_label(kb, stats_cluster_label("topic", topics));
+
+  g_free(topics);
+}
+
+static const gchar *
+_format_persist_name(const LogPipe *s)
+{
+  const KafkaSourceDriver *self = (const KafkaSourceDriver *)s;
+  static gchar persist_name[1024];
+
+  if (s->persist_name)
+    {
+      g_snprintf(persist_name, sizeof(persist_name), "kafka-source.%s", s->persist_name);
+    }
+  else
+    {
+      gchar *topics = _join_topics(self->topics);
+      g_snprintf(persist_name, sizeof(persist_name), "kafka-source(%s,%s)", self->group_id, topics);
+      g_free(topics);
+    }
+  return persist_name;
+}
+
+static const gchar *protected_properties[] =
+{
+  "bootstrap.servers",
+  "metadata.broker.list",
+  "group.id",
+  "enable.auto.offset.store",
+  NULL
+};
+
+rd_kafka_t *
+kafka_sd_construct_consumer(KafkaSourceDriver *self)
+{
+  rd_kafka_t *client;
+  rd_kafka_conf_t *conf;
+  gchar errbuf[1024];
+
+  conf = rd_kafka_conf_new();
+  if (!kafka_conf_set_prop(conf, "metadata.broker.list", self->bootstrap_servers) ||
+      !kafka_conf_set_prop(conf, "group.id", self->group_id) ||
+      /* offsets are only stored once the messages are acknowledged */
+      !kafka_conf_set_prop(conf, "enable.auto.offset.store", "false") ||
+      !kafka_apply_config_props(conf, self->config, protected_properties))
+    {
+      rd_kafka_conf_destroy(conf);
+      return NULL;
+    }
+
+  rd_kafka_conf_set_log_cb(conf, kafka_log_callback);
+  client = rd_kafka_new(RD_KAFKA_CONSUMER, conf, errbuf, sizeof(errbuf));
+  if (!client)
+    {
+      msg_error("kafka: error constructing the kafka consumer object",
+                evt_tag_str("group_id", self->group_id),
+                evt_tag_str("error", errbuf),
+                evt_tag_str("driver", self->super.super.super.id),
+                log_pipe_location_tag(&self->super.super.super.super));
+      rd_kafka_conf_destroy(conf);
+      return NULL;
+    }
+
+  /* route the main event queue into the consumer queue, so that a single
+   * rd_kafka_consume_batch_queue() serves rebalance and error events too */
+  rd_kafka_poll_set_consumer(client);
+  return client;
+}
+
+static LogThreadedSourceWorker *
+_construct_worker(LogThreadedSourceDriver *s, gint worker_index)
+{
+  return kafka_source_worker_new(s, worker_index);
+}
+
+gboolean
+kafka_sd_init(LogPipe *s)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)s;
+
+  if (!self->topics)
+    {
+      msg_error("kafka: the topic() argument is required for kafka sources",
+                evt_tag_str("driver", self->super.super.super.id),
+                log_pipe_location_tag(&self->super.super.super.super));
+      return FALSE;
+    }
+  if (!self->bootstrap_servers)
+    {
+      msg_error("kafka: the bootstrap-servers() option is required for kafka sources",
+                evt_tag_str("driver", self->super.super.super.id),
+                log_pipe_location_tag(&self->super.super.super.super));
+      return FALSE;
+    }
+
+  if (!log_threaded_source_driver_init_method(s))
+    return FALSE;
+
+  msg_verbose("kafka: Kafka source initialized",
+              evt_tag_str("group_id", self->group_id),
+              evt_tag_int("workers", self->super.num_workers),
+              evt_tag_int("fetch_limit", self->fetch_limit),
+              evt_tag_str("driver", self->super.super.super.id),
+              log_pipe_location_tag(&self->super.super.super.super));
+  return TRUE;
+}
+
+static void
+kafka_sd_free(LogPipe *s)
+{
+  KafkaSourceDriver *self = (KafkaSourceDriver *)s;
+
+  string_list_free(self->topics);
+  kafka_property_list_free(self->config);
+  g_free(self->bootstrap_servers);
+  g_free(self->group_id);
+
+  log_threaded_source_driver_free_method(s);
+}
+
+/*
+ * Plugin glue.
+ */
+
+LogDriver *
+kafka_sd_new(GlobalConfig *cfg)
+{
+  KafkaSourceDriver *self = g_new0(KafkaSourceDriver, 1);
+
+  log_threaded_source_driver_init_instance(&self->super, cfg);
+  log_threaded_source_driver_set_transport_name(&self->super, "kafka");
+
+  self->super.super.super.super.init = kafka_sd_init;
+  self->super.super.super.super.free_fn = kafka_sd_free;
+  self->super.super.super.super.generate_persist_name = _format_persist_name;
+
+  self->super.format_stats_key = _format_stats_key;
+  self->super.worker_construct = _construct_worker;
+
+  /* batches are closed after each poll, see _worker_run() */
+  self->super.auto_close_batches = FALSE;
+  self->super.worker_options.ack_tracker_factory = consecutive_ack_tracker_factory_new();
+
+  self->group_id = g_strdup("syslog-ng");
+  self->fetch_limit = 1000;
+  self->poll_timeout = 1000;
+
+  return &self->super.super.super;
+}
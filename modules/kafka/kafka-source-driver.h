@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef KAFKA_SOURCE_DRIVER_H_INCLUDED
+#define KAFKA_SOURCE_DRIVER_H_INCLUDED
+
+#include "logthrsource/logthrsourcedrv.h"
+#include <librdkafka/rdkafka.h>
+
+typedef struct _KafkaSourceDriver
+{
+  LogThreadedSourceDriver super;
+
+  GList *topics;
+  GList *config;
+  gchar *bootstrap_servers;
+  gchar *group_id;
+  gint fetch_limit;
+  gint poll_timeout;
+} KafkaSourceDriver;
+
+void kafka_sd_set_topics(LogDriver *d, GList *topics);
+void kafka_sd_merge_config(LogDriver *d, GList *props);
+void kafka_sd_set_bootstrap_servers(LogDriver *d, const gchar *bootstrap_servers);
+void kafka_sd_set_group_id(LogDriver *d, const gchar *group_id);
+void kafka_sd_set_fetch_limit(LogDriver *d, gint fetch_limit);
+void kafka_sd_set_poll_timeout(LogDriver *d, gint poll_timeout);
+
+rd_kafka_t *kafka_sd_construct_consumer(KafkaSourceDriver *self);
+gboolean kafka_sd_init(LogPipe *s);
+
+LogDriver *kafka_sd_new(GlobalConfig *cfg);
+
+#endif
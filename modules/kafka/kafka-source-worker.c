@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "kafka-source-worker.h"
+#include "kafka-source-driver.h"
+#include "ack-tracker/ack_tracker.h"
+#include "messages.h"
+
+typedef struct _KafkaPendingOffset
+{
+  guint64 seq;
+  const gchar *topic;
+  gint32 partition;
+  gint64 offset;
+} KafkaPendingOffset;
+
+typedef struct _KafkaSourceBookmark
+{
+  KafkaSourceWorker *worker;
+  guint64 seq;
+} KafkaSourceBookmark;
+
+static NVHandle handle_kafka_topic;
+static NVHandle handle_kafka_partition;
+static NVHandle handle_kafka_offset;
+static NVHandle handle_kafka_key;
+
+/*
+ * Offset tracking
+ *
+ * Each posted message gets a sequence number and its topic/partition/offset
+ * is queued in posting order.  The consecutive ack tracker saves the bookmark
+ * of the last message of each continuously acknowledged range, at which
+ * point every queued entry up to that sequence number can be stored for
+ * commit: we pick the highest offset per partition and pass them to
+ * rd_kafka_offsets_store(), the actual commit is done by librdkafka's
+ * auto-commit (or on consumer close).
+ */
+
+void
+kafka_source_worker_store_offsets(KafkaSourceWorker *self, guint64 acked_seq)
+{
+  rd_kafka_topic_partition_list_t *offsets = rd_kafka_topic_partition_list_new(4);
+
+  g_mutex_lock(&self->pending_lock);
+  while (!g_queue_is_empty(&self->pending_offsets))
+    {
+      KafkaPendingOffset *pending = g_queue_peek_head(&self->pending_offsets);
+      if (pending->seq > acked_seq)
+        break;
+
+      g_queue_pop_head(&self->pending_offsets);
+
+      rd_kafka_topic_partition_t *tp = rd_kafka_topic_partition_list_find(offsets, pending->topic, pending->partition);
+      if (!tp)
+        tp = rd_kafka_topic_partition_list_add(offsets, pending->topic, pending->partition);
+
+      /* the committed offset is the offset of the next message to consume */
+      tp->offset = pending->offset + 1;
+      g_free(pending);
+    }
+
+  if (self->kafka && offsets->cnt > 0)
+    {
+      rd_kafka_resp_err_t err = rd_kafka_offsets_store(self->kafka, offsets);
+
+      /* partitions revoked by a rebalance are reported here, those will be
+       * redelivered to their new owner */
+      if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        msg_debug("kafka: failed to store offsets of acknowledged messages",
+                  evt_tag_str("error", rd_kafka_err2str(err)),
+                  evt_tag_str("driver", self->super.control->super.super.id),
+                  evt_tag_int("worker_index", self->super.worker_index));
+    }
+  g_mutex_unlock(&self->pending_lock);
+
+  rd_kafka_topic_partition_list_destroy(offsets);
+}
+
+static void
+_save_bookmark(Bookmark *bookmark)
+{
+  KafkaSourceBookmark *bookmark_data = (KafkaSourceBookmark *) &bookmark->container;
+
+  kafka_source_worker_store_offsets(bookmark_data->worker, bookmark_data->seq);
+}
+
+static void
+_track_offset(KafkaSourceWorker *self, rd_kafka_message_t *rkmessage)
+{
+  KafkaPendingOffset *pending = g_new(KafkaPendingOffset, 1);
+
+  pending->seq = self->next_seq++;
+  pending->topic = g_intern_string(rd_kafka_topic_name(rkmessage->rkt));
+  pending->partition = rkmessage->partition;
+  pending->offset = rkmessage->offset;
+
+  g_mutex_lock(&self->pending_lock);
+  g_queue_push_tail(&self->pending_offsets, pending);
+  g_mutex_unlock(&self->pending_lock);
+
+  Bookmark *bookmark = ack_tracker_request_bookmark(self->super.super.ack_tracker);
+  KafkaSourceBookmark *bookmark_data = (KafkaSourceBookmark *) &bookmark->container;
+
+  bookmark_data->worker = self;
+  bookmark_data->seq = pending->seq;
+  bookmark->save = _save_bookmark;
+}
+
+/*
+ * Worker thread
+ */
+
+static void
+_set_message_metadata(LogMessage *msg, rd_kafka_message_t *rkmessage)
+{
+  gchar buf[32];
+
+  log_msg_set_value(msg, handle_kafka_topic, rd_kafka_topic_name(rkmessage->rkt), -1);
+
+  g_snprintf(buf, sizeof(buf), "%" G_GINT32_FORMAT, rkmessage->partition);
+  log_msg_set_value_with_type(msg, handle_kafka_partition, buf, -1, LM_VT_INTEGER);
+
+  g_snprintf(buf, sizeof(buf), "%" G_GINT64_FORMAT, rkmessage->offset);
+  log_msg_set_value_with_type(msg, handle_kafka_offset, buf, -1, LM_VT_INTEGER);
+
+  if (rkmessage->key)
+    log_msg_set_value(msg, handle_kafka_key, rkmessage->key, rkmessage->key_len);
+}
+
+static void
+_process_message(KafkaSourceWorker *self, rd_kafka_message_t *rkmessage)
+{
+  if (rkmessage->err != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+      if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF)
+        return;
+
+      msg_error("kafka: error while consuming messages",
+                evt_tag_str("topic", rkmessage->rkt ? rd_kafka_topic_name(rkmessage->rkt) : "n/a"),
+                evt_tag_str("error", rd_kafka_message_errstr(rkmessage)),
+                evt_tag_str("driver", self->super.control->super.super.id),
+                evt_tag_int("worker_index", self->super.worker_index));
+      return;
+    }
+
+  LogMessage *msg = log_msg_new_empty();
+
+  if (rkmessage->payload)
+    log_msg_set_value(msg, LM_V_MESSAGE, rkmessage->payload, rkmessage->len);
+  _set_message_metadata(msg, rkmessage);
+
+  _track_offset(self, rkmessage);
+  log_threaded_source_worker_blocking_post(&self->super, msg);
+}
+
+/* runs in a dedicated thread */
+static void
+_worker_run(LogThreadedSourceWorker *s)
+{
+  KafkaSourceWorker *self = (KafkaSourceWorker *) s;
+  KafkaSourceDriver *owner = (KafkaSourceDriver *) s->control;
+
+  while (!g_atomic_counter_get(&self->exit_requested))
+    {
+      gssize count = rd_kafka_consume_batch_queue(self->consumer_queue, owner->poll_timeout,
+                                                  self->rkmessages, owner->fetch_limit);
+      if (count < 0)
+        {
+          msg_error("kafka: error polling the consumer queue",
+                    evt_tag_str("error", rd_kafka_err2str(rd_kafka_last_error())),
+                    evt_tag_str("driver", owner->super.super.super.id),
+                    evt_tag_int("worker_index", self->super.worker_index));
+          continue;
+        }
+
+      for (gssize i = 0; i < count; i++)
+        {
+          _process_message(self, self->rkmessages[i]);
+          rd_kafka_message_destroy(self->rkmessages[i]);
+        }
+
+      if (count > 0)
+        log_threaded_source_worker_close_batch(s);
+    }
+}
+
+static void
+_worker_request_exit(LogThreadedSourceWorker *s)
+{
+  KafkaSourceWorker *self = (KafkaSourceWorker *) s;
+
+  g_atomic_counter_set(&self->exit_requested, TRUE);
+  if (self->consumer_queue)
+    rd_kafka_queue_yield(self->consumer_queue);
+}
+
+static void
+_destroy_consumer(KafkaSourceWorker *self)
+{
+  if (!self->kafka)
+    return;
+
+  rd_kafka_queue_destroy(self->consumer_queue);
+  self->consumer_queue = NULL;
+
+  /* commits the offsets stored so far */
+  rd_kafka_consumer_close(self->kafka);
+
+  g_mutex_lock(&self->pending_lock);
+  rd_kafka_destroy(self->kafka);
+  self->kafka = NULL;
+  g_mutex_unlock(&self->pending_lock);
+}
+
+static void
+_worker_thread_deinit(LogThreadedSourceWorker *s)
+{
+  KafkaSourceWorker *self = (KafkaSourceWorker *) s;
+
+  _destroy_consumer(self);
+}
+
+static gboolean
+_subscribe(KafkaSourceWorker *self)
+{
+  KafkaSourceDriver *owner = (KafkaSourceDriver *) self->super.control;
+  rd_kafka_topic_partition_list_t *subscription = rd_kafka_topic_partition_list_new(g_list_length(owner->topics));
+
+  for (GList *l = owner->topics; l; l = l->next)
+    rd_kafka_topic_partition_list_add(subscription, (const gchar *) l->data, RD_KAFKA_PARTITION_UA);
+
+  rd_kafka_resp_err_t err = rd_kafka_subscribe(self->kafka, subscription);
+  rd_kafka_topic_partition_list_destroy(subscription);
+
+  if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+      msg_error("kafka: error subscribing to topics",
+                evt_tag_str("error", rd_kafka_err2str(err)),
+                evt_tag_str("driver", owner->super.super.super.id),
+                log_pipe_location_tag(&owner->super.super.super.super));
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+_worker_init(LogPipe *s)
+{
+  KafkaSourceWorker *self = (KafkaSourceWorker *) s;
+  KafkaSourceDriver *owner = (KafkaSourceDriver *) self->super.control;
+
+  if (!log_source_init(s))
+    return FALSE;
+
+  /* every worker is a member of the same consumer group, so the partitions
+   * of the subscribed topics are distributed among them by the broker */
+  self->kafka = kafka_sd_construct_consumer(owner);
+  if (!self->kafka)
+    return FALSE;
+
+  if (!_subscribe(self))
+    {
+      rd_kafka_destroy(self->kafka);
+      self->kafka = NULL;
+      return FALSE;
+    }
+
+  self->consumer_queue = rd_kafka_queue_get_consumer(self->kafka);
+  self->rkmessages = g_renew(rd_kafka_message_t *, self->rkmessages, owner->fetch_limit);
+  g_atomic_counter_set(&self->exit_requested, FALSE);
+  return TRUE;
+}
+
+static void
+_worker_free(LogPipe *s)
+{
+  KafkaSourceWorker *self = (KafkaSourceWorker *) s;
+
+  _destroy_consumer(self);
+  g_queue_foreach(&self->pending_offsets, (GFunc) g_free, NULL);
+  g_queue_clear(&self->pending_offsets);
+  g_mutex_clear(&self->pending_lock);
+  g_free(self->rkmessages);
+
+  log_threaded_source_worker_free(s);
+}
+
+LogThreadedSourceWorker *
+kafka_source_worker_new(LogThreadedSourceDriver *o, gint worker_index)
+{
+  KafkaSourceWorker *self = g_new0(KafkaSourceWorker, 1);
+
+  log_threaded_source_worker_init_instance(&self->super, o, worker_index);
+
+  self->super.super.super.init = _worker_init;
+  self->super.super.super.free_fn = _worker_free;
+  self->super.run = _worker_run;
+  self->super.request_exit = _worker_request_exit;
+  self->super.thread_deinit = _worker_thread_deinit;
+
+  g_mutex_init(&self->pending_lock);
+  g_queue_init(&self->pending_offsets);
+
+  handle_kafka_topic = log_msg_get_value_handle(".kafka.topic");
+  handle_kafka_partition = log_msg_get_value_handle(".kafka.partition");
+  handle_kafka_offset = log_msg_get_value_handle(".kafka.offset");
+  handle_kafka_key = log_msg_get_value_handle(".kafka.key");
+
+  return &self->super;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef KAFKA_SOURCE_WORKER_H_INCLUDED
+#define KAFKA_SOURCE_WORKER_H_INCLUDED
+
+#include "logthrsource/logthrsourcedrv.h"
+#include "atomic.h"
+#include <librdkafka/rdkafka.h>
+
+typedef struct _KafkaSourceWorker
+{
+  LogThreadedSourceWorker super;
+  GAtomicCounter exit_requested;
+
+  rd_kafka_t *kafka;
+  rd_kafka_queue_t *consumer_queue;
+  rd_kafka_message_t **rkmessages;
+
+  /* offsets of the messages we posted, in posting order, waiting for their
+   * acknowledgement before being stored for commit */
+  GMutex pending_lock;
+  GQueue pending_offsets;
+  guint64 next_seq;
+} KafkaSourceWorker;
+
+void kafka_source_worker_store_offsets(KafkaSourceWorker *self, guint64 acked_seq);
+
+LogThreadedSourceWorker *kafka_source_worker_new(LogThreadedSourceDriver *owner, gint worker_index);
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024 Axoflow
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/grab-logging.h"
+
+#include "apphook.h"
+#include "kafka-source-driver.h"
+#include "kafka-source-worker.h"
+#include "kafka-props.h"
+#include "string-list.h"
+
+#include <librdkafka/rdkafka.h>
+
+static LogDriver *
+_construct_driver(const gchar *bootstrap_servers, const gchar *topic)
+{
+  LogDriver *driver = kafka_sd_new(configuration);
+
+  if (bootstrap_servers)
+    kafka_sd_set_bootstrap_servers(driver, bootstrap_servers);
+  if (topic)
+    kafka_sd_set_topics(driver, string_vargs_to_list(topic, NULL));
+
+  /* the mock cluster makes sure we are not trying to reach a real broker */
+  kafka_sd_merge_config(driver, g_list_prepend(NULL, kafka_property_new("test.mock.num.brokers", "1")));
+  return driver;
+}
+
+Test(kafka_source, test_topic_is_mandatory)
+{
+  LogDriver *driver = _construct_driver("localhost:9092", NULL);
+
+  cr_assert_not(kafka_sd_init(&driver->super));
+  assert_grabbed_log_contains("kafka: the topic() argument is required for kafka sources");
+
+  log_pipe_unref(&driver->super);
+}
+
+Test(kafka_source, test_bootstrap_server_is_mandatory)
+{
+  LogDriver *driver = _construct_driver(NULL, "test-topic");
+
+  cr_assert_not(kafka_sd_init(&driver->super));
+  assert_grabbed_log_contains("kafka: the bootstrap-servers() option is required for kafka sources");
+
+  log_pipe_unref(&driver->super);
+}
+
+Test(kafka_source, test_every_worker_has_its_own_consumer)
+{
+  LogDriver *driver = _construct_driver("test-host:9092", "test-topic");
+  KafkaSourceDriver *self = (KafkaSourceDriver *) driver;
+
+  log_threaded_source_driver_set_num_workers(driver, 3);
+  cr_assert(kafka_sd_init(&driver->super));
+
+  for (gint i = 0; i < self->super.num_workers; i++)
+    {
+      KafkaSourceWorker *worker = (KafkaSourceWorker *) self->super.workers[i];
+
+      cr_assert_not_null(worker->kafka);
+      for (gint j = 0; j < i; j++)
+        cr_assert_neq(worker->kafka, ((KafkaSourceWorker *) self->super.workers[j])->kafka);
+    }
+
+  log_pipe_deinit(&driver->super);
+  log_pipe_unref(&driver->super);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  start_grabbing_messages();
+}
+
+static void
+teardown(void)
+{
+  stop_grabbing_messages();
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(kafka_source, .init = setup, .fini = teardown);
@@ -108,21 +108,29 @@ _process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, co
   KVScanner kv_scanner;
   kv_parser_init_scanner(self, &kv_scanner);
   GString *formatted_key = scratch_buffers_alloc();
+  LogMessageValueSource source;
 
   log_msg_make_writable(pmsg, path_options);
   msg_trace("kv-parser message processing started",
             evt_tag_str("input", input),
             evt_tag_str("prefix", self->prefix),
             evt_tag_msg_reference(*pmsg));
+
+  /* values that need no unescaping reference $MSG instead of being copied */
+  log_msg_value_source_init(&source, *pmsg, LM_V_MESSAGE, input, input_len);
+
   /* FIXME: input length */
   kv_scanner_input(&kv_scanner, input);
   while (kv_scanner_scan_next(&kv_scanner))
     {
+      const gchar *value = kv_scanner_get_current_value_slice(&kv_scanner);
+
+      if (!value)
+        value = kv_scanner_get_current_value(&kv_scanner);
 
-      /* FIXME: value length */
-      log_msg_set_value_by_name(*pmsg,
-                                _get_formatted_key(self, kv_scanner_get_current_key(&kv_scanner), formatted_key),
-                                kv_scanner_get_current_value(&kv_scanner), -1);
+      NVHandle handle = log_msg_get_value_handle(_get_formatted_key(self, kv_scanner_get_current_key(&kv_scanner),
+                                                 formatted_key));
+      log_msg_set_value_from_source(*pmsg, handle, &source, value, kv_scanner_get_current_value_len(&kv_scanner));
     }
   if (self->stray_words_value_name)
     log_msg_set_value_by_name(*pmsg,
@@ -107,6 +107,29 @@ Test(kv_parser, test_using_template_to_parse_input)
   log_msg_unref(msg);
 }
 
+static gboolean
+_is_value_indirect(LogMessage *msg, const gchar *name)
+{
+  NVEntry *entry = nv_table_get_entry(msg->payload, log_msg_get_value_handle(name), NULL, NULL);
+
+  cr_assert_not_null(entry, "value is not set: %s", name);
+  return entry->indirect;
+}
+
+Test(kv_parser, test_values_without_escapes_reference_the_message)
+{
+  LogMessage *msg;
+
+  msg = parse_kv_into_log_message("foo=bar quoted=\"with space\" escaped=\"a\\\"b\"");
+  assert_log_message_value_by_name(msg, "foo", "bar");
+  cr_assert(_is_value_indirect(msg, "foo"));
+  assert_log_message_value_by_name(msg, "quoted", "with space");
+  cr_assert(_is_value_indirect(msg, "quoted"));
+  assert_log_message_value_by_name(msg, "escaped", "a\"b");
+  cr_assert_not(_is_value_indirect(msg, "escaped"));
+  log_msg_unref(msg);
+}
+
 Test(kv_parser, test_audit)
 {
   LogMessage *msg;